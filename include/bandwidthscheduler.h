@@ -0,0 +1,52 @@
+#ifndef PODBOAT_BANDWIDTHSCHEDULER_H_
+#define PODBOAT_BANDWIDTHSCHEDULER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+
+namespace podboat {
+
+class Download;
+
+/// \brief Shares a total bandwidth budget between running downloads.
+///
+/// Every download has a token bucket, measured in bytes. refill() hands out
+/// the budget accumulated since the previous call evenly between the
+/// downloads; whatever doesn't fit into a full bucket goes to the others, so
+/// a download that can't use its share doesn't waste it. A download may
+/// receive data as long as its bucket isn't empty.
+///
+/// A rate of 0 means there is no limit.
+class BandwidthScheduler {
+public:
+	explicit BandwidthScheduler(double bytes_per_second);
+
+	bool limited() const
+	{
+		return rate > 0;
+	}
+
+	/// Starts (or stops) giving `download` a share of the budget. Adding
+	/// a download twice is harmless.
+	void add(const Download* download);
+	void remove(const Download* download);
+
+	/// Hands out the budget accumulated since the previous call. The first
+	/// call only starts the clock.
+	void refill(std::chrono::steady_clock::time_point now);
+
+	bool may_receive(const Download* download) const;
+	void consume(const Download* download, std::size_t bytes);
+
+private:
+	double rate;
+	/// How many tokens a single bucket holds at most.
+	double capacity;
+	std::map<const Download*, double> buckets;
+	std::chrono::steady_clock::time_point last_refill;
+};
+
+} // namespace podboat
+
+#endif /* PODBOAT_BANDWIDTHSCHEDULER_H_ */
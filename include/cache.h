@@ -1,15 +1,20 @@
 #ifndef NEWSBOAT_CACHE_H_
 #define NEWSBOAT_CACHE_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <sqlite3.h>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "configcontainer.h"
 
 namespace newsboat {
 
+struct Description;
 class RssFeed;
 class RssIgnores;
 class RssItem;
@@ -39,6 +44,17 @@ const SchemaVersion unknown_version = {0, 0};
 
 using schema_patches = std::map<SchemaVersion, std::vector<std::string>>;
 
+struct FeedSummary {
+	std::string title;
+	std::string link;
+	bool is_rtl;
+	unsigned int total_count;
+	unsigned int unread_count;
+	time_t latest_item_timestamp;
+};
+
+using FeedSummaries = std::unordered_map<std::string, FeedSummary>;
+
 class Cache {
 public:
 	Cache(const std::string& cachefile, ConfigContainer* c);
@@ -47,6 +63,19 @@ public:
 		bool reset_unread);
 	std::shared_ptr<RssFeed> internalize_rssfeed(std::string rssurl,
 		RssIgnores* ign);
+	/// Reads metadata and item counts of all cached feeds in a single query.
+	FeedSummaries fetch_feed_summaries();
+	/// When the oldest article counted by fetch_feed_summaries() expires,
+	/// which changes the counts. 0 if no article expires.
+	time_t fetch_next_expiry();
+	/// Creates a feed that only holds its metadata and item counts, taken
+	/// from `summaries`. Its items can be loaded later on with
+	/// internalize_items().
+	std::shared_ptr<RssFeed> internalize_rssfeed_summary(
+		const std::string& rssurl,
+		const FeedSummaries& summaries);
+	/// Loads items of a feed created by internalize_rssfeed_summary().
+	void internalize_items(std::shared_ptr<RssFeed> feed, RssIgnores* ign);
 	void update_rssitem_unread_and_enqueued(std::shared_ptr<RssItem> item,
 		const std::string& feedurl);
 	void update_rssitem_unread_and_enqueued(RssItem* item,
@@ -63,7 +92,10 @@ public:
 	std::unordered_set<std::string> search_in_items(
 		const std::string& querystr,
 		const std::unordered_set<std::string>& guids);
-	void mark_all_read(const std::string& feedurl = "");
+	/// Marks the articles of \a feedurl (or of all feeds, if it's empty)
+	/// read.
+	/// \return the GUIDs of the articles that were unread.
+	std::vector<std::string> mark_all_read(const std::string& feedurl = "");
 	void mark_all_read(std::shared_ptr<RssFeed> feed);
 	void update_rssitem_flags(RssItem* item);
 	void fetch_lastmodified(const std::string& uri,
@@ -72,19 +104,64 @@ public:
 	void update_lastmodified(const std::string& uri,
 		time_t t,
 		const std::string& etag);
+	/// Where the last sync of a remote API feed left off, in a format only
+	/// the API understands. Empty if the feed hasn't been synced yet.
+	std::string fetch_sync_cursor(const std::string& feedurl);
+	void update_sync_cursor(const std::string& feedurl,
+		const std::string& cursor);
+	/// Marks the feed's articles listed in \a unread_guids as unread, and
+	/// all of its other articles as read. Articles in \a pending_guids keep
+	/// their state: it hasn't been sent to the server yet.
+	void sync_unread_state(const std::string& feedurl,
+		const std::unordered_set<std::string>& unread_guids,
+		const std::unordered_set<std::string>& pending_guids = {});
 	void mark_item_deleted(const std::string& guid, bool b);
 	void remove_old_deleted_items(RssFeed* feed);
 	void mark_items_read_by_guid(const std::vector<std::string>& guids);
 	std::vector<std::string> get_read_item_guids();
 	void fetch_descriptions(RssFeed* feed);
-	std::string fetch_description(const RssItem& item);
+	Description fetch_description(const RssItem& item);
+
+	// Retention is enforced in small batches by CacheMaintenance, so that
+	// neither startup nor any other user-facing operation waits for it.
+	// Each of these returns the number of rows deleted; 0 means there is
+	// nothing left to do.
+
+	/// Deletes at most `limit` articles older than `keep-articles-days`.
+	unsigned int delete_old_articles(unsigned int limit);
+	/// Deletes at most `limit` of the articles which were dropped while
+	/// internalizing feeds because they exceeded `max-items`.
+	unsigned int delete_overflow_items(unsigned int limit);
+	/// Sets a function to be called whenever internalizing a feed leaves
+	/// work for delete_overflow_items(). It's called with the cache locked,
+	/// so it mustn't use the cache itself. Pass an empty function to unset.
+	void set_overflow_listener(std::function<void()> listener);
+	/// If `cleanup-on-quit` is enabled, deletes at most `limit` articles of
+	/// feeds that aren't in `feedurls`; once none are left, deletes those
+	/// feeds, too.
+	unsigned int delete_unreachable_feeds(
+		const std::vector<std::string>& feedurls,
+		unsigned int limit);
+
+	/// Number of SQL statements executed by all Cache objects while they
+	/// were counted.
+	static std::uint64_t executed_statements();
+	/// Starts or stops counting statements of all Cache objects, including
+	/// ones opened later on. Counting goes on until every call with true
+	/// is matched by one with false.
+	static void set_statement_counting(bool enabled);
 
 private:
 	SchemaVersion get_schema_version();
 	void populate_tables();
 	void set_pragmas();
-	void delete_item_unlocked(const std::shared_ptr<RssItem>& item);
-	void clean_old_articles();
+	void internalize_items_unlocked(std::shared_ptr<RssFeed> feed,
+		RssIgnores* ign);
+	/// Returns an SQL condition, starting with "AND", that leaves out
+	/// articles older than `keep-articles-days`. They're only deleted by
+	/// CacheMaintenance, so until then, every query that loads articles has
+	/// to skip them. Returns a single space if nothing expires.
+	std::string unexpired_condition(const std::string& pubdate_column);
 	void update_rssitem_unlocked(std::shared_ptr<RssItem> item,
 		const std::string& feedurl,
 		bool reset_unread);
@@ -112,6 +189,12 @@ private:
 	sqlite3* db;
 	ConfigContainer* cfg;
 	std::recursive_mutex mtx;
+	/// GUIDs of articles to be deleted by delete_overflow_items(). A set,
+	/// because a feed that's internalized again before they're deleted
+	/// drops the same articles again. Guarded by `mtx`.
+	std::unordered_set<std::string> overflow_guids;
+	/// Guarded by `mtx`.
+	std::function<void()> overflow_listener;
 };
 
 } // namespace newsboat
@@ -0,0 +1,75 @@
+#ifndef NEWSBOAT_CACHEMAINTENANCE_H_
+#define NEWSBOAT_CACHEMAINTENANCE_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace newsboat {
+
+class Cache;
+
+/// \brief Enforces cache retention settings in the background.
+///
+/// Deletes articles older than `keep-articles-days`, articles exceeding
+/// `max-items`, and (with `cleanup-on-quit`) articles of feeds that are no
+/// longer subscribed to. Work is done in small batches with pauses in
+/// between, so the cache is never locked for long. Once idle, it waits for
+/// feeds to exceed `max-items` again. Anything left undone when the
+/// maintenance is stopped is picked up the next time.
+class CacheMaintenance {
+public:
+	explicit CacheMaintenance(Cache& cache);
+	~CacheMaintenance();
+
+	CacheMaintenance(const CacheMaintenance&) = delete;
+	CacheMaintenance& operator=(const CacheMaintenance&) = delete;
+
+	/// Starts working in a background thread. \a feedurls are the URLs of
+	/// all feeds the user is subscribed to.
+	void start(const std::vector<std::string>& feedurls);
+
+	/// Replaces the URLs of the feeds the user is subscribed to, e.g. after
+	/// the urls file was reloaded. Returns once no batch uses the old ones.
+	void set_feedurls(const std::vector<std::string>& urls);
+
+	/// Waits until all the work is done, without pausing between batches,
+	/// and stops.
+	void finish();
+
+	/// Stops after the current batch, and waits for that.
+	void stop();
+
+	/// Does a single batch of work.
+	/// \return false if there was nothing left to do.
+	bool run_batch();
+
+	/// Number of rows deleted by a single batch.
+	static const unsigned int BATCH_SIZE = 500;
+
+private:
+	void run();
+	void join();
+	/// Makes the worker look for work again once it's idle.
+	void wake();
+
+	Cache& cache;
+	std::thread thread;
+
+	/// Held while a batch runs, so that feeds aren't deleted by a list of
+	/// URLs that is out of date.
+	std::mutex feedurls_mtx;
+	std::vector<std::string> feedurls;
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool stop_requested;
+	bool hurry;
+	bool wake_requested;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_CACHEMAINTENANCE_H_ */
@@ -87,6 +87,17 @@ public:
 
 	nonstd::optional<Level> log_level() const;
 
+	/// If `true`, Newsboat should measure the phases of its startup.
+	bool profile_startup() const;
+
+	/// If non-null, the startup profile should be written to this filepath
+	/// as JSON rather than printed on exit.
+	nonstd::optional<std::string> profile_startup_file() const;
+
+	/// If non-null, timings of ScopeMeasure objects should be written to
+	/// this filepath in Chrome's trace-event format.
+	nonstd::optional<std::string> trace_file() const;
+
 	/// Returns the reference to the Rust object.
 	///
 	/// This is only meant to be used in situations when one wants to pass
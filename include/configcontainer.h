@@ -1,7 +1,9 @@
 #ifndef NEWSBOAT_CONFIGCONTAINER_H_
 #define NEWSBOAT_CONFIGCONTAINER_H_
 
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -56,6 +58,27 @@ struct ArticleSortStrategy {
 	}
 };
 
+/// \brief Typed copy of the settings that are read in hot loops.
+///
+/// ConfigContainer publishes a new snapshot every time a setting changes; a
+/// published snapshot is never modified, so it can be read without locking
+/// and without parsing the settings again.
+struct ConfigSnapshot {
+	/// Increases with every published snapshot.
+	std::uint64_t version = 0;
+
+	std::string articlelist_format;
+	std::string datetime_format;
+	std::string feedlist_format;
+	bool ignore_mode_download = false;
+	unsigned int keep_articles_days = 0;
+	bool mark_as_read_on_hover = false;
+	unsigned int max_items = 0;
+	bool show_read_articles = true;
+	bool show_read_feeds = true;
+	ArticleSortStrategy article_sort_strategy;
+};
+
 class ConfigContainer : public ConfigActionHandler {
 public:
 	ConfigContainer();
@@ -75,11 +98,23 @@ public:
 	FeedSortStrategy get_feed_sort_strategy() const;
 	ArticleSortStrategy get_article_sort_strategy() const;
 
+	/// Current values of the settings in ConfigSnapshot. The returned
+	/// snapshot doesn't change if settings are changed afterwards; take a new
+	/// one at the start of each pass over the data.
+	std::shared_ptr<const ConfigSnapshot> snapshot() const;
+
 	static const std::string PARTIAL_FILE_SUFFIX;
 
 private:
+	/// Must be called with `config_data_mtx` held.
+	void publish_snapshot();
+
 	std::map<std::string, ConfigData> config_data;
 	mutable std::recursive_mutex config_data_mtx;
+
+	/// Only accessed through std::atomic_load() and std::atomic_store().
+	std::shared_ptr<const ConfigSnapshot> current_snapshot;
+	std::uint64_t snapshot_version = 0;
 };
 
 } // namespace newsboat
@@ -2,8 +2,10 @@
 #define NEWSBOAT_CONTROLLER_H_
 
 #include <libxml/tree.h>
+#include <thread>
 
 #include "cache.h"
+#include "cachemaintenance.h"
 #include "colormanager.h"
 #include "configcontainer.h"
 #include "configparser.h"
@@ -16,6 +18,8 @@
 #include "reloader.h"
 #include "remoteapi.h"
 #include "rssignores.h"
+#include "startupprofiler.h"
+#include "syncqueue.h"
 #include "urlreader.h"
 
 namespace newsboat {
@@ -49,6 +53,10 @@ public:
 		rsscache->mark_all_read(feed);
 	}
 	void mark_all_read(const std::vector<std::string>& item_guids);
+	/// Sends read state and flag changes to the remote API right away,
+	/// so that a reload doesn't undo them. Does nothing while the server is
+	/// failing and the changes wait for a retry.
+	void send_pending_changes();
 	bool get_refresh_on_start() const
 	{
 		return refresh_on_start;
@@ -102,6 +110,12 @@ public:
 		return api;
 	}
 
+	/// Null unless changes are sent to a remote API.
+	SyncQueue* get_sync_queue()
+	{
+		return sync_queue.get();
+	}
+
 	RegexManager& get_regexmanager()
 	{
 		return rxman;
@@ -126,6 +140,16 @@ private:
 	void import_read_information(const std::string& readinfofile);
 	void export_read_information(const std::string& readinfofile);
 
+	std::string feedlist_snapshot_file() const;
+	void write_feedlist_snapshot();
+
+	void write_timing_stats();
+	void handle_timing_stats_signal();
+	void stop_handling_timing_stats_signal();
+
+	void begin_startup_phase(const std::string& name);
+	void report_startup_profile(const CliArgsParser& args);
+
 	View* v;
 	UrlReader* urlcfg;
 	Cache* rsscache;
@@ -145,6 +169,11 @@ private:
 	ConfigPaths& configpaths;
 
 	std::unique_ptr<Reloader> reloader;
+	std::unique_ptr<CacheMaintenance> cache_maintenance;
+	std::unique_ptr<StartupProfiler> startup_profiler;
+	std::unique_ptr<SyncQueue> sync_queue;
+	/// Writes the timing statistics on SIGUSR1.
+	std::thread timing_stats_thread;
 
 	QueueManager queueManager;
 };
@@ -0,0 +1,69 @@
+#ifndef NEWSBOAT_DESCRIPTIONBUDGET_H_
+#define NEWSBOAT_DESCRIPTIONBUDGET_H_
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace newsboat {
+
+class RssItem;
+
+/// \brief Keeps the memory used by loaded article descriptions within a
+/// limit.
+///
+/// Items report every description they load or use. Once the total size
+/// exceeds the limit, descriptions of the least recently used items are
+/// dropped; those items read them back from the cache when they're needed
+/// again.
+class DescriptionBudget {
+public:
+	struct Stats {
+		std::size_t used_bytes;
+		std::size_t limit_bytes;
+		std::size_t descriptions;
+		std::size_t evictions;
+	};
+
+	DescriptionBudget() = default;
+	DescriptionBudget(const DescriptionBudget&) = delete;
+	DescriptionBudget& operator=(const DescriptionBudget&) = delete;
+
+	/// The budget shared by all items of the process.
+	static DescriptionBudget& instance();
+
+	/// Sets the limit in bytes, evicting descriptions if necessary. 0 means
+	/// no limit.
+	void set_limit(std::size_t bytes);
+
+	/// Records that \a item holds a description of \a bytes bytes, and marks
+	/// it as the most recently used one.
+	void touch(RssItem& item, std::size_t bytes);
+
+	/// Stops tracking \a item, e.g. because it dropped its description or is
+	/// being destroyed.
+	void forget(const RssItem& item);
+
+	Stats stats() const;
+
+private:
+	struct Entry {
+		RssItem* item;
+		std::size_t bytes;
+	};
+
+	void evict_unlocked();
+
+	mutable std::mutex mtx;
+	/// Most recently used items come first.
+	std::list<Entry> lru;
+	std::unordered_map<const RssItem*, std::list<Entry>::iterator> entries;
+	std::size_t used_bytes = 0;
+	std::size_t limit_bytes = 0;
+	std::size_t evictions = 0;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_DESCRIPTIONBUDGET_H_ */
@@ -16,7 +16,8 @@ enum class DlStatus {
 	ALREADY_DOWNLOADED,
 	READY,
 	PLAYED,
-	RENAME_FAILED
+	RENAME_FAILED,
+	PAUSED
 };
 
 class Download {
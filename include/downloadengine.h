@@ -0,0 +1,165 @@
+#ifndef PODBOAT_DOWNLOADENGINE_H_
+#define PODBOAT_DOWNLOADENGINE_H_
+
+#include <chrono>
+#include <curl/curl.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bandwidthscheduler.h"
+#include "download.h"
+
+namespace newsboat {
+class ConfigContainer;
+}
+
+namespace podboat {
+
+/// \brief Progress of a running transfer, as published by DownloadEngine.
+struct TransferProgress {
+	const Download* download;
+	std::string url;
+	/// Bytes received in this transfer, and the size of what's being
+	/// transferred (0 if unknown). Neither includes `offset`.
+	double downloaded;
+	double total;
+	/// Size of the partial file the transfer resumed from.
+	unsigned long offset;
+	double kbps;
+};
+
+/// \brief Runs all Podboat downloads from a single thread.
+///
+/// Transfers are driven by one curl_multi handle, so they share its
+/// connection cache. Download objects are only ever touched by the thread
+/// that owns them (the UI): it starts, pauses, resumes and cancels transfers
+/// through the engine, and picks up progress and outcomes with poll().
+/// Progress is published as an immutable snapshot, so reading it never holds
+/// up the transfers.
+class DownloadEngine {
+public:
+	/// Appended to the partial file's name to get the name of the file that
+	/// records how far each segment of a segmented download got.
+	static const std::string RESUME_MAP_SUFFIX;
+
+	explicit DownloadEngine(newsboat::ConfigContainer& cfg);
+
+	/// Stops all transfers, leaving their partial files behind so that they
+	/// can be resumed later.
+	~DownloadEngine();
+
+	DownloadEngine(const DownloadEngine&) = delete;
+	DownloadEngine& operator=(const DownloadEngine&) = delete;
+
+	/// Starts downloading `dl.url()` to `dl.filename()`, resuming from the
+	/// partial file if there is one. Does nothing if the download is already
+	/// running.
+	///
+	/// If the server accepts byte ranges and the file is large enough, the
+	/// download is split into segments which are fetched in parallel (see
+	/// `download-segments`). If the server then answers the range requests
+	/// with the whole file, the download goes on as a single stream.
+	void start(const Download& dl);
+	void pause(const Download& dl);
+	void resume(const Download& dl);
+
+	/// Stops the transfer; its partial file is kept. If the transfer
+	/// finishes before the engine gets to it, its outcome is dropped, so
+	/// that the download stays cancelled.
+	void cancel(const Download& dl);
+
+	/// Updates progress and status of the running downloads among
+	/// `downloads`.
+	void poll(std::vector<Download>& downloads);
+
+	std::shared_ptr<const std::vector<TransferProgress>> progress() const;
+
+private:
+	struct Segment;
+	struct Transfer;
+
+	enum class CommandType { START, PAUSE, RESUME, CANCEL, QUIT };
+
+	struct Command {
+		CommandType type;
+		const Download* download;
+		std::string url;
+		std::string filename;
+	};
+
+	struct Result {
+		const Download* download;
+		std::string url;
+		DlStatus status;
+		std::string message;
+	};
+
+	static size_t write_data(char* buffer, size_t size, size_t nmemb,
+		void* userp);
+	static size_t header_callback(char* buffer, size_t size, size_t nitems,
+		void* userp);
+	static int progress_callback(void* clientp, curl_off_t dltotal,
+		curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+
+	void send(Command command);
+	void run();
+	/// Returns `true` if the engine should quit.
+	bool handle_commands();
+	void begin_transfer(const Download* download, const std::string& url,
+		const std::string& filename);
+	Segment& add_segment(Transfer& transfer, curl_off_t start, curl_off_t end,
+		curl_off_t pos, bool ranged);
+	void start_segment(Segment& segment);
+	void handle_headers(Transfer& transfer);
+	/// Returns `false` if the file is too small to be split.
+	bool split_transfer(Transfer& transfer);
+	void finish_segment(CURL* easy, CURLcode result);
+	/// Drops the segments of a transfer whose server turned out to ignore
+	/// byte ranges, and has the first one fetch the rest of the file.
+	void unsplit_transfer(Transfer& transfer);
+	void complete_transfer(std::unique_ptr<Transfer> transfer);
+	void fail_transfer(std::unique_ptr<Transfer> transfer,
+		const std::string& message);
+	void remove_transfer(Transfer& transfer);
+	void post_result(const Transfer& transfer, DlStatus status,
+		const std::string& message = {});
+	void publish_progress();
+	void save_resume_maps();
+	/// Refills the bandwidth budget and wakes up the segments that were
+	/// waiting for it.
+	void throttle();
+
+	newsboat::ConfigContainer& cfg;
+	CURLM* multi;
+
+	/// Only accessed by the engine's thread.
+	BandwidthScheduler scheduler;
+	std::map<const Download*, std::unique_ptr<Transfer>> transfers;
+	bool transfers_changed = false;
+	std::chrono::steady_clock::time_point last_published;
+	std::chrono::steady_clock::time_point last_saved;
+
+	std::mutex queues_mtx;
+	std::vector<Command> commands;
+	std::vector<Result> results;
+	/// Downloads with a CANCEL command that the engine hasn't handled yet,
+	/// once per command.
+	std::multiset<const Download*> cancelling;
+
+	/// Written to whenever a command is queued, to wake up the engine.
+	int wakeup_pipe[2];
+
+	/// Only accessed through std::atomic_load() and std::atomic_store().
+	std::shared_ptr<const std::vector<TransferProgress>> current_progress;
+
+	std::thread thread;
+};
+
+} // namespace podboat
+
+#endif /* PODBOAT_DOWNLOADENGINE_H_ */
@@ -1,6 +1,8 @@
 #ifndef NEWSBOAT_FEEDBINAPI_H_
 #define NEWSBOAT_FEEDBINAPI_H_
 
+#include <functional>
+
 #include "remoteapi.h"
 #include "rss/feed.h"
 #include "3rd-party/json.hpp"
@@ -21,11 +23,16 @@ public:
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feedurl) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids) override;
+	bool mark_articles_unread(const std::vector<std::string>& guids) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
 	rsspp::Feed fetch_feed(const std::string& id);
-	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& cached_handle);
+	/// Only fetches entries created since \a sync_cursor, unless it's
+	/// empty. Updates \a sync_cursor if the entries were fetched.
+	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& cached_handle,
+		std::string& sync_cursor);
 
 private:
 	virtual nlohmann::json run_op(const std::string& path,
@@ -35,6 +42,13 @@ private:
 		const nlohmann::json& req_data,
 		CurlHandle& cached_handle,
 		const HTTPMethod method = HTTPMethod::GET);
+	/// Like run_op(), but passes the elements of the array that is returned
+	/// to \a on_element as they're parsed, rather than returning them.
+	nlohmann::json run_op(const std::string& path,
+		const nlohmann::json& req_data,
+		CurlHandle& cached_handle,
+		const HTTPMethod method,
+		const std::function<void(nlohmann::json&& element)>& on_element);
 	bool star_article(const std::string& guid, bool star);
 	bool mark_entries_read(const std::vector<std::string>& ids, bool read);
 	TaggedFeedUrl feed_from_json(const nlohmann::json& jfeed,
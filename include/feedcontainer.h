@@ -10,7 +10,9 @@
 
 namespace newsboat {
 
+class Cache;
 class RssFeed;
+class RssIgnores;
 
 class FeedContainer {
 public:
@@ -41,9 +43,35 @@ public:
 
 	void replace_feed(unsigned int pos, std::shared_ptr<RssFeed> feed);
 
+	/// \brief Enables loading items of feeds only when they're needed.
+	///
+	/// Items of feeds that only hold a summary (see RssFeed::items_loaded())
+	/// are read from `cache` by load_feed_items(). After that, the least
+	/// recently used feeds are unloaded again until at most
+	/// `max_loaded_items` items are held in memory; 0 means no limit.
+	void enable_lazy_loading(Cache* cache, RssIgnores* ignores,
+		unsigned int max_loaded_items);
+	/// Makes sure that the feed's items are in memory. Does nothing unless
+	/// lazy loading is enabled.
+	void load_feed_items(std::shared_ptr<RssFeed> feed);
+	/// Refills `query_feed` with the items that match its query. Only the
+	/// feeds whose items could match are loaded; afterwards, the limit on
+	/// loaded items is enforced as in load_feed_items().
+	void update_query_feed(std::shared_ptr<RssFeed> query_feed);
+
 private:
+	void load_feed_items_unlocked(const std::shared_ptr<RssFeed>& feed);
+	void load_query_feed_sources_unlocked(const RssFeed& query_feed);
+	void unload_unused_feed_items_unlocked(const std::shared_ptr<RssFeed>&
+		keep);
+
 	std::vector<std::shared_ptr<RssFeed>> feeds;
 	mutable std::mutex feeds_mutex;
+
+	Cache* lazy_cache = nullptr;
+	RssIgnores* lazy_ignores = nullptr;
+	unsigned int max_loaded_items = 0;
+	unsigned long use_counter = 0;
 };
 } // namespace newsboat
 
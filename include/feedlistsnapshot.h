@@ -0,0 +1,70 @@
+#ifndef NEWSBOAT_FEEDLISTSNAPSHOT_H_
+#define NEWSBOAT_FEEDLISTSNAPSHOT_H_
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+#include "3rd-party/optional.hpp"
+
+#include "cache.h"
+
+namespace newsboat {
+
+class ConfigContainer;
+
+/// \brief Snapshot of the feed list, used to start up without querying the
+/// cache.
+///
+/// The file holds the summary of each feed (see Cache::fetch_feed_summaries())
+/// as it was when Newsboat last quit. It's only used if neither the cache, the
+/// urls file nor the settings that affect the counts changed since then, and
+/// no counted article has expired in the meantime.
+///
+/// Layout (native byte order): a fixed header, followed by one record per
+/// feed. Each record is a fixed-size part followed by the feed's URL, title
+/// and link, without terminators.
+class FeedListSnapshot {
+public:
+	/// What the snapshot has to match in order to be used.
+	struct Key {
+		/// SQLite's file change counter, which is bumped by every
+		/// transaction that modifies the cache.
+		std::uint32_t cache_generation;
+		std::int64_t urls_mtime;
+		/// Hash of `max-items`, `keep-articles-days` and `ignore-mode`.
+		std::uint64_t config_hash;
+
+		bool operator==(const Key& other) const
+		{
+			return cache_generation == other.cache_generation
+				&& urls_mtime == other.urls_mtime
+				&& config_hash == other.config_hash;
+		}
+	};
+
+	static const std::uint32_t VERSION = 2;
+
+	/// Key for the current state of the given files and settings. If either
+	/// file can't be read, the key won't match any snapshot.
+	static Key current_key(const std::string& cache_file,
+		const std::string& url_file,
+		const ConfigContainer& cfg);
+
+	/// Writes \a summaries to \a path, replacing the file atomically. The
+	/// snapshot is only valid until \a expires (see
+	/// Cache::fetch_next_expiry()); 0 means forever.
+	/// \return false if the file couldn't be written.
+	static bool write(const std::string& path, const Key& key,
+		const FeedSummaries& summaries, time_t expires);
+
+	/// Reads summaries from \a path, unless the file is missing, malformed,
+	/// of a different version, was written for a different \a key, or
+	/// expired before \a now.
+	static nonstd::optional<FeedSummaries> read(const std::string& path,
+		const Key& key, time_t now);
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_FEEDLISTSNAPSHOT_H_ */
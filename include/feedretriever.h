@@ -12,31 +12,45 @@ class ConfigContainer;
 class CurlHandle;
 class RemoteApi;
 class RssIgnores;
+class SyncQueue;
 
 class FeedRetriever {
 public:
+	/// Articles with read state changes still pending in \a sync_queue keep
+	/// their state when a remote API reports the read state of a feed.
 	FeedRetriever(ConfigContainer& cfg, Cache& ch, RssIgnores* ign = nullptr,
-		RemoteApi* api = nullptr, CurlHandle* easyhandle = nullptr);
+		RemoteApi* api = nullptr, CurlHandle* easyhandle = nullptr,
+		SyncQueue* sync_queue = nullptr);
 
 	rsspp::Feed retrieve(const std::string& uri);
 
+	/// Where the last sync of remote API feed \a uri left off, or an empty
+	/// string if it has to be fetched in full.
+	std::string fetch_sync_cursor(const std::string& uri);
+
 private:
-	rsspp::Feed fetch_ttrss(const std::string& feed_id);
+	rsspp::Feed fetch_ttrss(const std::string& uri, const std::string& feed_id);
 	rsspp::Feed fetch_newsblur(const std::string& feed_id);
 	rsspp::Feed fetch_ocnews(const std::string& feed_id);
 	rsspp::Feed fetch_miniflux(const std::string& feed_id);
 	rsspp::Feed fetch_freshrss(const std::string& feed_id);
-	rsspp::Feed fetch_feedbin(const std::string& feed_id);
+	rsspp::Feed fetch_feedbin(const std::string& uri, const std::string& feed_id);
+	rsspp::Feed fetch_inoreader(const std::string& uri);
 	rsspp::Feed download_http(const std::string& uri);
 	rsspp::Feed get_execplugin(const std::string& plugin);
 	rsspp::Feed download_filterplugin(const std::string& filter, const std::string& uri);
 	rsspp::Feed parse_file(const std::string& file);
+	/// Stores where an incremental sync of \a uri left off, and the read
+	/// state of the articles it didn't fetch.
+	void save_sync_state(const std::string& uri, const rsspp::Feed& f,
+		const std::string& cursor);
 
 	ConfigContainer& cfg;
 	Cache& ch;
 	RssIgnores* ign;
 	RemoteApi* api;
 	CurlHandle* easyhandle;
+	SyncQueue* sync_queue;
 };
 
 } // namespace newsboat
@@ -29,6 +29,7 @@ enum class CommandType {
 	SOURCE,
 	DUMPCONFIG,
 	EXEC,
+	STATS,
 	UNKNOWN,	/// Unknown/non-existing command. Tokenized input is stored in Command.args
 	INVALID, 	/// differs from UNKNOWN in that no input was parsed
 };
@@ -1,7 +1,15 @@
 #ifndef NEWSBOAT_FRESHRSSAPI_H_
 #define NEWSBOAT_FRESHRSSAPI_H_
 
+#include <cstdint>
+#include <functional>
 #include <libxml/tree.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "cache.h"
 #include "remoteapi.h"
@@ -24,11 +32,22 @@ public:
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feedurl) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids) override;
+	bool mark_articles_unread(const std::vector<std::string>& guids) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
+	/// Fetches the articles added to all feeds since the oldest of
+	/// \a sync_cursors in a few large requests, unless `freshrss-bulk-sync`
+	/// is off. fetch_feed() then hands them out instead of asking the
+	/// server again.
+	void prefetch_feeds(const std::map<std::string, std::string>& sync_cursors)
+	override;
 	rsspp::Feed fetch_feed(const std::string& id);
-	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& cached_handle);
+	/// Only fetches items added since \a sync_cursor, unless it's empty.
+	/// Updates \a sync_cursor if the items were fetched.
+	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& cached_handle,
+		std::string& sync_cursor);
 
 private:
 	std::vector<std::string> get_tags(xmlNode* node);
@@ -37,15 +56,44 @@ private:
 	std::string retrieve_auth();
 	std::string post_content(const std::string& url,
 		const std::string& postdata);
+	/// If \a on_item is set, the elements of `items` are passed to it as
+	/// they're parsed, rather than returned.
+	nlohmann::json fetch_json(const std::string& url, CurlHandle& cached_handle,
+		const std::function<void(nlohmann::json&& item)>& on_item = nullptr);
+	/// Lists the GUIDs of all unread items in the (escaped) \a stream.
+	/// \return nullptr if the list couldn't be fetched or is incomplete.
+	std::shared_ptr<const std::unordered_set<std::string>> fetch_unread_guids(
+			const std::string& stream, CurlHandle& cached_handle);
+	/// Fetches the items of a stream, and passes each of them to \a add_item.
+	/// Sets \a newest_item to the timestamp of the newest item, in
+	/// microseconds.
+	/// \return false if some page of the stream couldn't be fetched.
+	bool fetch_stream(const std::string& query,
+		CurlHandle& cached_handle,
+		bool follow_continuation,
+		uint64_t& newest_item,
+		std::function<void(const nlohmann::json& entry, rsspp::Item item)> add_item);
+	bool take_prefetched(const std::string& id, rsspp::Feed& feed,
+		std::string& sync_cursor);
 	bool star_article(const std::string& guid, bool star);
 	bool share_article(const std::string& guid, bool share);
-	bool mark_article_read_with_token(const std::string& guid,
+	bool mark_articles_read_with_token(const std::vector<std::string>& guids,
 		bool read,
 		const std::string& token);
 	std::string auth;
 	std::string auth_header;
 	bool token_expired;
 	std::string token;
+
+	struct PrefetchedFeed {
+		/// The feed's cursor at the time of the prefetch.
+		std::string sync_cursor;
+		std::vector<rsspp::Item> items;
+	};
+	std::mutex prefetch_mtx;
+	std::map<std::string, PrefetchedFeed> prefetched;
+	std::shared_ptr<const std::unordered_set<std::string>> prefetched_unread;
+	std::string prefetched_cursor;
 };
 
 } // namespace newsboat
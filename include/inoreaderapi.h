@@ -2,6 +2,8 @@
 #define NEWSBOAT_INOREADERAPI_H_
 
 #include <libxml/tree.h>
+#include <memory>
+#include <unordered_set>
 
 #include "cache.h"
 #include "remoteapi.h"
@@ -11,16 +13,24 @@ namespace newsboat {
 
 class InoreaderApi : public RemoteApi {
 public:
-	explicit InoreaderApi(ConfigContainer& c);
+	/// \a server is only ever changed by tests.
+	explicit InoreaderApi(ConfigContainer& c,
+		const std::string& server = "https://inoreader.com");
 	virtual ~InoreaderApi() = default;
 	virtual bool authenticate();
 	virtual std::vector<TaggedFeedUrl> get_subscribed_urls();
 	virtual void add_custom_headers(curl_slist** custom_headers);
 	virtual bool mark_all_read(const std::string& feedurl);
 	virtual bool mark_article_read(const std::string& guid, bool read);
+	virtual bool mark_articles_read(const std::vector<std::string>& guids);
+	virtual bool mark_articles_unread(const std::vector<std::string>& guids);
 	virtual bool update_article_flags(const std::string& inoflags,
 		const std::string& newflags,
 		const std::string& guid);
+	/// Lists the GUIDs of all unread articles in the feed at \a feedurl.
+	/// \return nullptr if the list couldn't be fetched or is incomplete.
+	std::shared_ptr<const std::unordered_set<std::string>> fetch_unread_guids(
+			const std::string& feedurl);
 
 private:
 	std::vector<std::string> get_tags(xmlNode* node);
@@ -29,8 +39,10 @@ private:
 		const std::string& postdata);
 	bool star_article(const std::string& guid, bool star);
 	bool share_article(const std::string& guid, bool share);
+	bool edit_read_state(const std::vector<std::string>& guids, bool read);
 	curl_slist* add_app_headers(curl_slist* headers);
 
+	const std::string server;
 	std::string auth;
 	std::string auth_header;
 };
@@ -0,0 +1,56 @@
+#ifndef NEWSBOAT_INTERNEDSTRING_H_
+#define NEWSBOAT_INTERNEDSTRING_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace newsboat {
+
+/// \brief Immutable string whose storage is shared with every other
+/// InternedString holding the same value.
+///
+/// Meant for per-item values that repeat across many items (feed URLs, MIME
+/// types, authors): each distinct value is stored once per process, and
+/// comparing two InternedStrings for equality is a pointer comparison.
+class InternedString {
+public:
+	InternedString();
+	explicit InternedString(const std::string& value);
+
+	const std::string& str() const
+	{
+		return *value;
+	}
+
+	bool empty() const
+	{
+		return value->empty();
+	}
+
+	friend bool operator==(const InternedString& a, const InternedString& b)
+	{
+		return a.value == b.value;
+	}
+	friend bool operator!=(const InternedString& a, const InternedString& b)
+	{
+		return !(a == b);
+	}
+
+	/// Number of distinct values currently held by the pool.
+	static std::size_t pool_size();
+
+	/// Estimated bytes used by the values held by the pool.
+	static std::size_t pool_memory_usage();
+
+	/// Drops values that are no longer referenced by any InternedString.
+	/// This also happens automatically as the pool grows.
+	static void purge_unused();
+
+private:
+	std::shared_ptr<const std::string> value;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_INTERNEDSTRING_H_ */
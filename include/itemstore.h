@@ -0,0 +1,174 @@
+#ifndef NEWSBOAT_ITEMSTORE_H_
+#define NEWSBOAT_ITEMSTORE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <vector>
+
+namespace newsboat {
+
+/// \brief Refers to one item's slot in the ItemStore.
+struct ItemHandle {
+	std::uint32_t slot;
+};
+
+/// \brief Holds the fields of all items that are scanned in bulk: dates,
+/// sizes, indices and unread/enqueued/deleted state.
+///
+/// The fields are kept in separate arrays (a "struct of arrays"), so that
+/// counting unread items or sorting by date reads contiguous memory instead
+/// of following a pointer to each RssItem. Arrays are allocated in fixed-size
+/// blocks that never move, which lets readers access slots without locking;
+/// only allocating and releasing slots takes the store's mutex.
+class ItemStore {
+public:
+	ItemStore() = default;
+	ItemStore(const ItemStore&) = delete;
+	ItemStore& operator=(const ItemStore&) = delete;
+
+	/// The store shared by all items of the process.
+	static ItemStore& instance();
+
+	/// Returns a slot for a new item, which is unread and has all other
+	/// fields zeroed.
+	ItemHandle allocate();
+	/// Returns the slot to the store. \a handle must not be used afterwards.
+	void release(ItemHandle handle);
+
+	time_t pub_date(ItemHandle handle) const
+	{
+		return block(handle).pub_date[offset(handle)];
+	}
+	void set_pub_date(ItemHandle handle, time_t t)
+	{
+		block(handle).pub_date[offset(handle)] = t;
+	}
+
+	unsigned int size(ItemHandle handle) const
+	{
+		return block(handle).size[offset(handle)];
+	}
+	void set_size(ItemHandle handle, unsigned int size)
+	{
+		block(handle).size[offset(handle)] = size;
+	}
+
+	unsigned int index(ItemHandle handle) const
+	{
+		return block(handle).index[offset(handle)];
+	}
+	void set_index(ItemHandle handle, unsigned int index)
+	{
+		block(handle).index[offset(handle)] = index;
+	}
+
+	bool unread(ItemHandle handle) const
+	{
+		return test(handle, UNREAD);
+	}
+	void set_unread(ItemHandle handle, bool value)
+	{
+		assign(handle, UNREAD, value);
+	}
+
+	bool enqueued(ItemHandle handle) const
+	{
+		return test(handle, ENQUEUED);
+	}
+	void set_enqueued(ItemHandle handle, bool value)
+	{
+		assign(handle, ENQUEUED, value);
+	}
+
+	bool deleted(ItemHandle handle) const
+	{
+		return test(handle, DELETED);
+	}
+	void set_deleted(ItemHandle handle, bool value)
+	{
+		assign(handle, DELETED, value);
+	}
+
+	bool override_unread(ItemHandle handle) const
+	{
+		return test(handle, OVERRIDE_UNREAD);
+	}
+	void set_override_unread(ItemHandle handle, bool value)
+	{
+		assign(handle, OVERRIDE_UNREAD, value);
+	}
+
+	/// Takes the item's own lock. It waits by spinning, so it's only meant
+	/// for critical sections that copy or swap a pointer; don't allocate,
+	/// take other locks or do I/O while holding it.
+	void lock(ItemHandle handle);
+	void unlock(ItemHandle handle);
+
+	/// Number of slots that are currently in use.
+	std::size_t item_count() const;
+
+	/// Estimated bytes used by the store, including unused slots.
+	std::size_t memory_usage() const;
+
+	/// Bytes each item occupies in the store.
+	static constexpr std::size_t BYTES_PER_ITEM = sizeof(time_t)
+		+ 2 * sizeof(unsigned int) + sizeof(std::uint8_t);
+
+private:
+	enum : std::uint8_t {
+		UNREAD = 1 << 0,
+		ENQUEUED = 1 << 1,
+		DELETED = 1 << 2,
+		OVERRIDE_UNREAD = 1 << 3,
+		LOCKED = 1 << 4,
+	};
+
+	static constexpr unsigned int BLOCK_BITS = 14;
+	static constexpr std::uint32_t BLOCK_SIZE = 1u << BLOCK_BITS;
+	static constexpr std::uint32_t MAX_BLOCKS = 1u << 14;
+
+	struct Block {
+		time_t pub_date[BLOCK_SIZE];
+		unsigned int size[BLOCK_SIZE];
+		unsigned int index[BLOCK_SIZE];
+		std::atomic<std::uint8_t> state[BLOCK_SIZE];
+	};
+
+	Block& block(ItemHandle handle) const
+	{
+		return *blocks[handle.slot >> BLOCK_BITS].load(std::memory_order_acquire);
+	}
+	static std::uint32_t offset(ItemHandle handle)
+	{
+		return handle.slot & (BLOCK_SIZE - 1);
+	}
+
+	bool test(ItemHandle handle, std::uint8_t bit) const
+	{
+		return block(handle).state[offset(handle)].load(std::memory_order_relaxed)
+			& bit;
+	}
+	void assign(ItemHandle handle, std::uint8_t bit, bool value)
+	{
+		auto& state = block(handle).state[offset(handle)];
+		if (value) {
+			state.fetch_or(bit, std::memory_order_relaxed);
+		} else {
+			state.fetch_and(static_cast<std::uint8_t>(~bit), std::memory_order_relaxed);
+		}
+	}
+
+	mutable std::mutex mtx;
+	std::vector<std::uint32_t> free_slots;
+	std::uint32_t next_slot = 0;
+	std::uint32_t block_count = 0;
+	// Blocks are published once and never freed, so readers don't need mtx.
+	std::atomic<Block*> blocks[MAX_BLOCKS] = {};
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_ITEMSTORE_H_ */
@@ -0,0 +1,31 @@
+#ifndef NEWSBOAT_JSONSTREAM_H_
+#define NEWSBOAT_JSONSTREAM_H_
+
+#include <functional>
+#include <string>
+
+#include "3rd-party/json.hpp"
+
+namespace newsboat {
+
+namespace jsonstream {
+
+/// Parses \a input like nlohmann::json::parse(), except that the elements of
+/// the array under the top-level \a key are passed to \a on_element one by
+/// one, as soon as each of them has been parsed, and are left out of the
+/// result. If \a key is empty, \a input itself is expected to be an array.
+///
+/// This way, a reply with thousands of articles never exists as a whole in
+/// memory, only the text of it and the article that is being converted.
+///
+/// Throws nlohmann::json::parse_error if \a input isn't valid JSON, and
+/// passes on any exception thrown by \a on_element.
+nlohmann::json parse(const std::string& input,
+	const std::string& key,
+	const std::function<void(nlohmann::json&& element)>& on_element);
+
+} // namespace jsonstream
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_JSONSTREAM_H_ */
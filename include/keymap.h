@@ -108,6 +108,7 @@ enum Operation {
 	OP_PB_LESSDL,
 	OP_PB_PLAY,
 	OP_PB_MARK_FINISHED,
+	OP_PB_TOGGLE_PAUSE,
 	OP_PB_MAX,
 
 	OP_SK_MIN = 1500,
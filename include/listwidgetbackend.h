@@ -1,6 +1,7 @@
 #ifndef NEWSBOAT_LISTWIDGETBACKEND_H_
 #define NEWSBOAT_LISTWIDGETBACKEND_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <map>
@@ -17,7 +18,7 @@ public:
 	ListWidgetBackend(const std::string& list_name, const std::string& context,
 		Stfl::Form& form, RegexManager& rxman);
 	ListWidgetBackend(const std::string& list_name, Stfl::Form& form);
-	virtual ~ListWidgetBackend() = default;
+	virtual ~ListWidgetBackend();
 
 	void stfl_replace_list(std::string stfl);
 
@@ -28,12 +29,16 @@ public:
 	void invalidate_list_content(std::uint32_t num_lines,
 		std::function<std::string(std::uint32_t, std::uint32_t)> get_line_method);
 
+	/// Estimated bytes held by the line caches of all lists.
+	static std::size_t line_cache_memory_usage();
+
 protected:
 	virtual void on_list_changed() = 0;
 	void update_position(std::uint32_t pos, std::uint32_t scroll_offset);
 
 private:
 	void render();
+	void clear_line_cache();
 
 	const std::string list_name;
 	Stfl::Form& form;
@@ -41,6 +46,7 @@ private:
 	std::uint32_t num_lines;
 	std::uint32_t scroll_offset;
 	std::map<std::uint32_t, std::string> line_cache;
+	std::size_t line_cache_bytes;
 	std::function<std::string(std::uint32_t, std::uint32_t)> get_formatted_line;
 };
 
@@ -1,6 +1,11 @@
 #ifndef NEWSBOAT_LOGGER_H_
 #define NEWSBOAT_LOGGER_H_
 
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "config.h"
 #include "strprintf.h"
 
@@ -19,6 +24,28 @@ void log(Level l, const std::string& format, Args... args)
 		log_internal(l, strprintf::fmt(format, args...));
 	}
 }
+
+/// A field of a structured log message: a key and a reference to its value.
+using Field = std::pair<const char*, const std::string&>;
+
+/// Writes `event` followed by `key=value` pairs. Values longer than a few
+/// hundred bytes are truncated, and their length and digest are logged
+/// instead; use this for feeds, API responses and other large payloads.
+inline void log_fields(Level l, const std::string& event,
+	std::initializer_list<Field> fields)
+{
+	if (l == Level::USERERROR || static_cast<int64_t>(l) <= get_loglevel()) {
+		std::vector<std::string> keys;
+		std::vector<std::string> values;
+		keys.reserve(fields.size());
+		values.reserve(fields.size());
+		for (const auto& field : fields) {
+			keys.emplace_back(field.first);
+			values.emplace_back(field.second);
+		}
+		log_fields_internal(l, event, keys, values);
+	}
+}
 };
 
 } // namespace newsboat
@@ -28,11 +55,18 @@ void log(Level l, const std::string& format, Args... args)
 #define LOG(x, ...) \
 	do {        \
 	} while (0)
+#define LOG_FIELDS(x, event, ...) \
+	do {                      \
+	} while (0)
 #else
 #define LOG(x, ...)                                        \
 	do {                                               \
 		newsboat::logger::log(x, __VA_ARGS__); \
 	} while (0)
+#define LOG_FIELDS(x, event, ...)                                        \
+	do {                                                             \
+		newsboat::logger::log_fields(x, event, __VA_ARGS__); \
+	} while (0)
 #endif
 
 #endif /* NEWSBOAT_LOGGER_H_ */
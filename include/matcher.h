@@ -2,6 +2,7 @@
 #define NEWSBOAT_MATCHER_H_
 
 #include "FilterParser.h"
+#include "3rd-party/optional.hpp"
 
 namespace newsboat {
 
@@ -13,6 +14,12 @@ public:
 	explicit Matcher(const std::string& expr);
 	bool parse(const std::string& expr);
 	bool matches(Matchable* item);
+
+	/// Whether some Matchable may match, judged only by the attributes
+	/// \a item knows. An attribute it doesn't know could have any value, so
+	/// this only returns false if the known ones rule a match out.
+	bool may_match(Matchable* item);
+
 	std::string get_parse_error();
 	std::string get_expression();
 
@@ -25,6 +32,7 @@ public:
 
 private:
 	bool matches_r(expression* e, Matchable* item);
+	nonstd::optional<bool> may_match_r(expression* e, Matchable* item);
 
 	bool matchop_lt(expression* e, Matchable* item);
 	bool matchop_gt(expression* e, Matchable* item);
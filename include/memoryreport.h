@@ -0,0 +1,70 @@
+#ifndef NEWSBOAT_MEMORYREPORT_H_
+#define NEWSBOAT_MEMORYREPORT_H_
+
+#include <string>
+#include <vector>
+
+#include "memoryusage.h"
+
+namespace newsboat {
+
+class FeedContainer;
+
+/// \brief Report on where Newsboat's memory goes, per feed and per subsystem.
+class MemoryReport {
+public:
+	struct FeedEntry {
+		std::string title;
+		std::size_t item_count;
+		MemoryUsage usage;
+	};
+
+	/// Collects the numbers for all feeds in \a feeds and for process-wide
+	/// caches.
+	explicit MemoryReport(FeedContainer& feeds);
+
+	/// Feeds ordered from the largest to the smallest.
+	const std::vector<FeedEntry>& feeds() const
+	{
+		return feed_entries;
+	}
+	const MemoryUsage& feed_totals() const
+	{
+		return totals;
+	}
+	std::size_t interned_strings() const
+	{
+		return interned_strings_bytes;
+	}
+	std::size_t list_line_caches() const
+	{
+		return list_line_caches_bytes;
+	}
+	std::size_t item_store() const
+	{
+		return item_store_bytes;
+	}
+	std::size_t total() const
+	{
+		return totals.total() + interned_strings_bytes + list_line_caches_bytes
+			+ item_store_bytes;
+	}
+
+	/// Human-readable report. At most \a max_feeds feeds are listed, unless
+	/// it's 0.
+	std::vector<std::string> format(std::size_t max_feeds = 0) const;
+
+	/// Formats a byte count as "123 B", "4.5 KiB" or "6.7 MiB".
+	static std::string format_bytes(std::size_t bytes);
+
+private:
+	std::vector<FeedEntry> feed_entries;
+	MemoryUsage totals;
+	std::size_t interned_strings_bytes;
+	std::size_t list_line_caches_bytes;
+	std::size_t item_store_bytes;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_MEMORYREPORT_H_ */
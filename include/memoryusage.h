@@ -0,0 +1,56 @@
+#ifndef NEWSBOAT_MEMORYUSAGE_H_
+#define NEWSBOAT_MEMORYUSAGE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace newsboat {
+
+/// Heap memory owned by \a s, not counting the std::string object itself.
+inline std::size_t heap_usage(const std::string& s)
+{
+	// With the small string optimization, short strings are stored inside
+	// the std::string object itself.
+	const char* data = s.data();
+	const char* object = reinterpret_cast<const char*>(&s);
+	if (data >= object && data < object + sizeof(s)) {
+		return 0;
+	}
+	return s.capacity() + 1;
+}
+
+/// Bytes used by `std::make_shared`'s control block, on top of the object.
+constexpr std::size_t SHARED_PTR_OVERHEAD = sizeof(void*) + 2 * sizeof(int);
+
+/// \brief Estimated memory held by feeds, broken down by what it's used for.
+///
+/// These are estimates: they count the objects and the heap buffers they own,
+/// but not allocator overhead.
+struct MemoryUsage {
+	/// Items and their fields, except descriptions.
+	std::size_t item_metadata = 0;
+	/// Descriptions loaded into items.
+	std::size_t descriptions = 0;
+	/// Maps from GUIDs to items kept by each feed.
+	std::size_t guid_maps = 0;
+	/// References to items held by query feeds.
+	std::size_t query_feed_membership = 0;
+
+	std::size_t total() const
+	{
+		return item_metadata + descriptions + guid_maps + query_feed_membership;
+	}
+
+	MemoryUsage& operator+=(const MemoryUsage& other)
+	{
+		item_metadata += other.item_metadata;
+		descriptions += other.descriptions;
+		guid_maps += other.guid_maps;
+		query_feed_membership += other.query_feed_membership;
+		return *this;
+	}
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_MEMORYUSAGE_H_ */
@@ -1,6 +1,8 @@
 #ifndef NEWSBOAT_MINIFLUXAPI_H_
 #define NEWSBOAT_MINIFLUXAPI_H_
 
+#include <functional>
+
 #include "3rd-party/json.hpp"
 #include "remoteapi.h"
 #include "rss/feed.h"
@@ -20,12 +22,17 @@ public:
 	std::vector<TaggedFeedUrl> get_subscribed_urls() override;
 	bool mark_all_read(const std::string& feedurl) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids) override;
+	bool mark_articles_unread(const std::vector<std::string>& guids) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
 	void add_custom_headers(curl_slist**) override;
 	rsspp::Feed fetch_feed(const std::string& id);
-	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& easyhandle);
+	/// Only fetches entries that changed since \a sync_cursor, unless it's
+	/// empty. Updates \a sync_cursor if the entries were fetched.
+	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& easyhandle,
+		std::string& sync_cursor);
 
 private:
 	virtual nlohmann::json run_op(const std::string& path,
@@ -35,6 +42,13 @@ private:
 		const nlohmann::json& req_data,
 		CurlHandle& cached_handle,
 		const HTTPMethod method = HTTPMethod::GET);
+	/// Like run_op(), but passes the elements of the `entries` array to
+	/// \a on_entry as they're parsed, rather than returning them.
+	nlohmann::json run_op(const std::string& path,
+		const nlohmann::json& req_data,
+		CurlHandle& cached_handle,
+		const HTTPMethod method,
+		const std::function<void(nlohmann::json&& entry)>& on_entry);
 	TaggedFeedUrl feed_from_json(const nlohmann::json& jfeed,
 		const std::vector<std::string>& tags);
 	bool flag_changed(const std::string& oldflags,
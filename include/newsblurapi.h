@@ -24,10 +24,15 @@ public:
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feedurl) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
 	rsspp::Feed fetch_feed(const std::string& id);
+	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& cached_handle);
+
+protected:
+	bool can_use_cached_subscriptions() const override;
 
 private:
 	std::string retrieve_auth();
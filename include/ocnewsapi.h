@@ -18,15 +18,24 @@ public:
 	bool mark_all_read(const std::string& feedurl) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
 	bool mark_articles_read(const std::vector<std::string>& guids) override;
+	bool mark_articles_unread(const std::vector<std::string>& guids) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
 	void add_custom_headers(curl_slist**) override;
 	rsspp::Feed fetch_feed(const std::string& feed_id);
+	/// Only fetches items added or changed since \a sync_cursor, unless
+	/// it's empty. Updates \a sync_cursor if the items were fetched.
+	rsspp::Feed fetch_feed(const std::string& feed_id, std::string& sync_cursor);
+
+protected:
+	bool can_use_cached_subscriptions() const override;
 
 private:
 	typedef std::map<std::string, std::pair<rsspp::Feed, long>> FeedMap;
 	std::string retrieve_auth();
+	bool mark_multiple(const std::vector<std::string>& guids,
+		const std::string& query);
 	bool query(const std::string& query,
 		json_object** result = nullptr,
 		const std::string& post = "");
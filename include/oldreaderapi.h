@@ -10,13 +10,17 @@ namespace newsboat {
 
 class OldReaderApi : public RemoteApi {
 public:
-	explicit OldReaderApi(ConfigContainer& c);
+	/// \a server is only ever changed by tests.
+	explicit OldReaderApi(ConfigContainer& c,
+		const std::string& server = "https://theoldreader.com");
 	~OldReaderApi() override = default;
 	bool authenticate() override;
 	std::vector<TaggedFeedUrl> get_subscribed_urls() override;
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feedurl) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids) override;
+	bool mark_articles_unread(const std::vector<std::string>& guids) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
@@ -29,9 +33,10 @@ private:
 		const std::string& postdata);
 	bool star_article(const std::string& guid, bool star);
 	bool share_article(const std::string& guid, bool share);
-	bool mark_article_read_with_token(const std::string& guid,
+	bool mark_articles_read_with_token(const std::vector<std::string>& guids,
 		bool read,
 		const std::string& token);
+	const std::string server;
 	std::string auth;
 	std::string auth_header;
 };
@@ -8,6 +8,7 @@
 #include "colormanager.h"
 #include "configcontainer.h"
 #include "download.h"
+#include "downloadengine.h"
 #include "fslock.h"
 #include "keymap.h"
 #include "queueloader.h"
@@ -37,6 +38,11 @@ public:
 	unsigned int get_maxdownloads();
 	void start_downloads();
 	void start_download(Download& item);
+	void cancel_download(Download& item);
+	void toggle_pause(Download& item);
+
+	/// Picks up progress and results of running downloads.
+	void poll_downloads();
 
 	void increase_parallel_downloads();
 	void decrease_parallel_downloads();
@@ -69,6 +75,7 @@ private:
 	unsigned int max_dls;
 
 	std::unique_ptr<QueueLoader> ql;
+	std::unique_ptr<DownloadEngine> engine;
 
 	std::string lock_file;
 	std::unique_ptr<newsboat::FsLock> fslock;
@@ -0,0 +1,82 @@
+#ifndef NEWSBOAT_QUEUEFILE_H_
+#define NEWSBOAT_QUEUEFILE_H_
+
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <vector>
+
+namespace newsboat {
+
+/// \brief Incremental access to Podboat's queue file, shared by Newsboat and
+/// Podboat.
+///
+/// Newsboat only ever appends lines to the queue file, while Podboat
+/// rewrites it when downloads change. QueueFile remembers how far it has
+/// read, so that each read only returns the lines appended since. Rewrites
+/// go to a temporary file that atomically replaces the queue. Appends and
+/// rewrites both hold an flock() on the queue file, so that an append can't
+/// get lost in a concurrent rewrite.
+class QueueFile {
+public:
+	explicit QueueFile(std::string path);
+
+	struct Update {
+		/// If `true`, the file was read from the start (because it was
+		/// replaced or truncated by someone else, or is read for the first
+		/// time), and `lines` replace whatever was read before.
+		bool from_start = false;
+		std::vector<std::string> lines;
+	};
+
+	/// Returns the lines that were added since the previous call. A missing
+	/// file reads as empty.
+	Update read_new_lines();
+
+	/// Appends `line` to the file, creating it if necessary. Returns `false`
+	/// if the file couldn't be written.
+	bool append_line(const std::string& line);
+
+	enum class ReplaceResult {
+		REPLACED,
+		/// The file has changed since it was last read. Nothing was written;
+		/// the caller should read the new lines and try again.
+		CHANGED,
+		FAILED,
+	};
+
+	/// Atomically replaces the file's contents with `lines`. If the file is
+	/// a symlink, the file it points to is replaced. The file keeps its
+	/// permissions, and its owner where we're allowed to set it.
+	ReplaceResult replace(const std::vector<std::string>& lines);
+
+	const std::string& path() const
+	{
+		return queue_path;
+	}
+
+private:
+	/// Opens the queue file and locks it. Retries if the file gets replaced
+	/// while we wait for the lock. Returns -1 on error.
+	int open_locked(int flags) const;
+
+	/// Whether `sb` describes the file as we last saw it, plus some appended
+	/// data.
+	bool only_appended(int fd, const struct stat& sb) const;
+
+	void remember(const struct stat& sb, const std::string& last_bytes);
+
+	const std::string queue_path;
+
+	bool have_read = false;
+	dev_t device = 0;
+	ino_t inode = 0;
+	off_t offset = 0;
+	/// The last few bytes before `offset`, to notice if the file was
+	/// rewritten in place rather than appended to.
+	std::string tail;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_QUEUEFILE_H_ */
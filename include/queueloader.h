@@ -8,11 +8,16 @@
 
 #include "configcontainer.h"
 #include "download.h"
+#include "queuefile.h"
 
 namespace podboat {
 
 /// Synchronizes Podboat's array of downloads with the queue file on the
 /// filesystem.
+///
+/// The loader remembers what the queue file looks like, so a reload only
+/// parses the lines Newsboat appended since the previous one, and only
+/// rewrites the file if the downloads changed.
 class QueueLoader {
 public:
 	/// Create a loader that will work with the queue file at \a filepath.
@@ -25,15 +30,18 @@ public:
 	/// status are removed. If \a also_remove_finished is `true`, `FINISHED`
 	/// downloads are removed too.
 	void reload(std::vector<Download>& downloads,
-		bool also_remove_finished = false) const;
+		bool also_remove_finished = false);
 
 private:
 	std::string get_filename(const std::string& str) const;
 
-	const std::string queuefile;
+	newsboat::QueueFile queuefile;
 	const newsboat::ConfigContainer& cfg;
 	std::function<void()> cb_require_view_update;
 
+	/// Lines of the queue file, as of the last read or write.
+	std::vector<std::string> lines_on_disk;
+
 	/// A helper type for methods that process the queue file.
 	struct CategorizedDownloads {
 		/// Downloads that should be kept in the queue file.
@@ -55,11 +63,13 @@ private:
 	static nonstd::optional<CategorizedDownloads> categorize_downloads(
 		const std::vector<Download>& downloads, bool also_remove_finished);
 
-	/// Adds downloads from the queue file to the "to keep" category.
-	void update_from_queue_file(CategorizedDownloads& downloads) const;
+	/// Adds downloads from lines that were added to the queue file since the
+	/// last reload to the "to keep" category.
+	void update_from_queue_file(CategorizedDownloads& downloads);
 
-	/// Writes "to keep" downloads to the queue file.
-	void write_queue_file(const CategorizedDownloads& downloads) const;
+	/// Returns the lines of a queue file that lists "to keep" downloads.
+	static std::vector<std::string> queue_file_lines(
+		const CategorizedDownloads& downloads);
 
 	/// If `delete-played-files` is enabled, deletes downloaded files
 	/// corresponding to downloads in the "to delete" category.
@@ -3,6 +3,9 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
+
+#include "queuefile.h"
 
 namespace newsboat {
 
@@ -24,7 +27,11 @@ struct EnqueueResult {
 
 class QueueManager {
 	ConfigContainer* cfg = nullptr;
-	std::string queue_file;
+	QueueFile queue_file;
+
+	/// URLs and filenames in the queue file, as of the last time it was read.
+	std::unordered_set<std::string> queued_urls;
+	std::unordered_set<std::string> queued_filenames;
 
 public:
 	/// Construct `QueueManager` instance out of a config container and a path
@@ -39,6 +46,10 @@ public:
 	EnqueueResult autoenqueue(std::shared_ptr<RssFeed> feed);
 
 private:
+	/// Picks up the lines that were added to the queue file since it was
+	/// last read.
+	void update_from_queue_file();
+
 	std::string generate_enqueue_filename(std::shared_ptr<RssItem> item,
 		std::shared_ptr<RssFeed> feed);
 };
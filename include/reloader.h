@@ -97,6 +97,10 @@ private:
 	}
 	bool trylock_reload_mutex();
 
+	/// Lets the remote API fetch the new articles of the feeds at
+	/// \a positions in bulk, before they are reloaded one by one.
+	void prefetch_feeds(const std::vector<unsigned int>& positions);
+
 	void partition_reload_to_threads(
 		std::function<void(unsigned int start, unsigned int end)> handle_range,
 		unsigned int num_feeds);
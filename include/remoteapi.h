@@ -1,15 +1,23 @@
 #ifndef NEWSBOAT_REMOTEAPI_H_
 #define NEWSBOAT_REMOTEAPI_H_
 
+#include <chrono>
 #include <curl/curl.h>
 #include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "curlhandle.h"
+
 namespace newsboat {
 
 class ConfigContainer;
+class SubscriptionCache;
 
 typedef std::pair<std::string, std::vector<std::string>> TaggedFeedUrl;
 
@@ -22,27 +30,97 @@ typedef struct {
 class RemoteApi {
 public:
 	explicit RemoteApi(ConfigContainer& c);
-	virtual ~RemoteApi() = default;
+	virtual ~RemoteApi();
 	virtual bool authenticate() = 0;
 	virtual std::vector<TaggedFeedUrl> get_subscribed_urls() = 0;
+
+	/// Keeps the subscription list in \a file, for the account identified
+	/// by \a key, and makes load_subscribed_urls() wait for the server for
+	/// at most \a timeout.
+	void use_subscription_cache(const std::string& file, const std::string& key,
+		std::chrono::milliseconds timeout);
+
+	/// The subscription list, as returned by get_subscribed_urls().
+	///
+	/// With a subscription cache, the list is fetched in the background,
+	/// and the cached list is returned if the server doesn't answer within
+	/// the timeout, or if fetching fails. In that case, the fresh list
+	/// is stored once it arrives, and returned by the next call.
+	std::vector<TaggedFeedUrl> load_subscribed_urls();
+
+	/// Waits until a fetch started by load_subscribed_urls() is done. This
+	/// has to be called before an object of a derived class is destroyed,
+	/// and before feeds are fetched.
+	void wait_for_subscription_refresh();
+
 	virtual void add_custom_headers(curl_slist** custom_headers) = 0;
 	virtual bool mark_all_read(const std::string& feedurl) = 0;
 	virtual bool mark_article_read(const std::string& guid, bool read) = 0;
+	/// Send one request per article unless overridden. SyncQueue sends
+	/// whole feeds that were marked read this way, so every API that can
+	/// change several articles in one request should do so.
 	virtual bool mark_articles_read(const std::vector<std::string>& guids);
+	virtual bool mark_articles_unread(const std::vector<std::string>& guids);
 	virtual bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) = 0;
+	/// Fetches the new articles of several feeds at once, before they are
+	/// fetched one by one, if the API can do that. \a sync_cursors maps the
+	/// URLs of the feeds to where their last sync left off.
+	virtual void prefetch_feeds(const std::map<std::string, std::string>&
+		sync_cursors);
 	static const std::string read_password(const std::string& file);
 	static const std::string eval_password(const std::string& cmd);
 
 protected:
+	/// Whether feeds can be fetched with a subscription list from the
+	/// cache. APIs that learn how to fetch a feed from get_subscribed_urls()
+	/// return false, and always wait for the server's list.
+	virtual bool can_use_cached_subscriptions() const;
+
 	static void update_flag(const std::string& oldflags,
 		const std::string& newflags,
 		char flag, std::function<void(bool added)>&& do_update);
 
+	/// Calls \a fetch_page for pages 0 to \a pages - 1, running up to
+	/// \a max_parallel of them at the same time. The calling thread fetches
+	/// pages through \a easyhandle; the other ones borrow handles from
+	/// a pool that all reload threads share, so that their connections are
+	/// reused by later requests. Returns once all pages are done, and
+	/// re-throws the first exception that \a fetch_page threw, if any.
+	void fetch_pages(unsigned int pages, unsigned int max_parallel,
+		CurlHandle& easyhandle,
+		const std::function<void(unsigned int page, CurlHandle& easyhandle)>&
+		fetch_page);
+
+	/// Performs the GET request to \a url that \a easyhandle is set up for,
+	/// sending \a custom_headers along, as part of get_subscribed_urls().
+	/// If the subscription cache holds an earlier reply from \a url, the
+	/// request is made conditional on its ETag and Last-Modified headers,
+	/// and the cached reply is returned if the server answers "304 Not
+	/// Modified". Headers are added to \a custom_headers, which the caller
+	/// frees.
+	std::string get_subscription_reply(CurlHandle& easyhandle,
+		const std::string& url,
+		curl_slist** custom_headers);
+
 	ConfigContainer& cfg;
 	Credentials get_credentials(const std::string& scope,
 		const std::string& name);
+
+private:
+	/// Fetches the subscription list and stores it in the cache.
+	std::vector<TaggedFeedUrl> refresh_subscribed_urls();
+
+	std::mutex idle_handles_mtx;
+	std::vector<CurlHandle> idle_handles;
+
+	std::unique_ptr<SubscriptionCache> subscription_cache;
+	std::chrono::milliseconds subscription_timeout;
+	/// Running or finished fetch of the subscription list.
+	std::future<std::vector<TaggedFeedUrl>> subscription_refresh;
+	/// Held while subscription_refresh is started, waited for, or taken.
+	std::mutex subscription_refresh_mtx;
 };
 
 } // namespace newsboat
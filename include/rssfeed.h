@@ -1,6 +1,7 @@
 #ifndef NEWSBOAT_RSSFEED_H_
 #define NEWSBOAT_RSSFEED_H_
 
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -8,6 +9,7 @@
 #include <vector>
 
 #include "matchable.h"
+#include "memoryusage.h"
 #include "rssitem.h"
 #include "utils.h"
 
@@ -62,41 +64,48 @@ public:
 
 	bool hidden() const;
 
-	std::vector<std::shared_ptr<RssItem>>& items()
+	/// Items are only changed through the methods below, which keep the
+	/// GUID index and the item handles in sync with this list.
+	const std::vector<std::shared_ptr<RssItem>>& items() const
 	{
 		return items_;
 	}
 	void add_item(std::shared_ptr<RssItem> item)
 	{
-		items_.push_back(item);
-		items_guid_map[item->guid()] = item;
+		handles_.push_back(item->handle());
+		index_item(item);
+		items_.push_back(std::move(item));
 	}
 	void add_items(const std::vector<std::shared_ptr<RssItem>>& items)
 	{
 		for (const auto& item : items) {
-			items_.push_back(item);
-			items_guid_map[item->guid()] = item;
+			add_item(item);
 		}
 	}
 	void set_items(std::vector<std::shared_ptr<RssItem>>& items)
 	{
-		erase_items(items_.begin(), items_.end());
+		erase_items(items_.cbegin(), items_.cend());
 		add_items(items);
 	}
 
-	void erase_items(std::vector<std::shared_ptr<RssItem>>::iterator begin,
-		std::vector<std::shared_ptr<RssItem>>::iterator end)
+	void erase_items(std::vector<std::shared_ptr<RssItem>>::const_iterator begin,
+		std::vector<std::shared_ptr<RssItem>>::const_iterator end)
 	{
 		for (auto it = begin; it != end; ++it) {
 			items_guid_map.erase((*it)->guid());
 		}
+		handles_.erase(handles_.cbegin() + (begin - items_.cbegin()),
+			handles_.cbegin() + (end - items_.cbegin()));
 		items_.erase(begin, end);
 	}
-	void erase_item(std::vector<std::shared_ptr<RssItem>>::iterator pos)
+	void erase_item(std::vector<std::shared_ptr<RssItem>>::const_iterator pos)
 	{
-		items_guid_map.erase((*pos)->guid());
-		items_.erase(pos);
+		erase_items(pos, pos + 1);
 	}
+	/// Erases the items for which \a pred returns true, keeping the order
+	/// of the others.
+	void erase_items_if(const std::function<bool(const std::shared_ptr<RssItem>&)>&
+		pred);
 
 	std::shared_ptr<RssItem> get_item_by_guid(const std::string& guid);
 	std::shared_ptr<RssItem> get_item_by_guid_unlocked(
@@ -111,7 +120,39 @@ public:
 	unsigned int unread_item_count() const;
 	unsigned int total_item_count() const
 	{
-		return items_.size();
+		return items_loaded_ ? items_.size() : summary_total_count_;
+	}
+	/// Publication date of the newest item, or 0 if the feed has no items.
+	time_t latest_item_timestamp() const;
+
+	/// \brief Whether items() holds the feed's items.
+	///
+	/// If false, the feed was only loaded as a summary (see
+	/// Cache::internalize_rssfeed_summaries()), and item counts come from
+	/// that summary until the items are loaded with
+	/// Cache::internalize_items().
+	bool items_loaded() const
+	{
+		return items_loaded_;
+	}
+	void set_summary(unsigned int unread_count, unsigned int total_count,
+		time_t latest_item_timestamp);
+	/// Drops all items, keeping their counts as the feed's summary. Does
+	/// nothing and returns false if any of the items is referenced from
+	/// outside of this feed, e.g. by a query feed or an open item list.
+	bool unload_items();
+	void set_items_loaded(bool loaded)
+	{
+		items_loaded_ = loaded;
+	}
+
+	void set_last_used(unsigned long tick)
+	{
+		last_used_ = tick;
+	}
+	unsigned long get_last_used() const
+	{
+		return last_used_;
 	}
 
 	void set_tags(const std::vector<std::string>& tags);
@@ -124,6 +165,12 @@ public:
 
 	void update_items(std::vector<std::shared_ptr<RssFeed>> feeds);
 
+	/// The filter expression of a query feed; empty for other feeds.
+	std::string get_query() const
+	{
+		return query;
+	}
+
 	bool is_query_feed() const
 	{
 		return rssurl_.substr(0, 6) == "query:";
@@ -187,18 +234,37 @@ public:
 
 	void mark_all_items_read();
 
+	/// Estimated memory held by the feed and its items.
+	MemoryUsage memory_usage() const;
+
 	// this is ugly, but makes it possible to lock items use e.g. from the Cache class
 	mutable std::mutex item_mutex;
 
 private:
+	// Keys are copies of the GUIDs. They can't refer to the strings held by
+	// the items, because RssItem::set_guid() can change those while the item
+	// is indexed, and the same item can be indexed by several feeds (e.g.
+	// query feeds).
+	using GuidMap = std::unordered_map<std::string, std::shared_ptr<RssItem>>;
+
+	void index_item(const std::shared_ptr<RssItem>& item)
+	{
+		items_guid_map[item->guid()] = item;
+	}
+
 	std::string title_;
 	std::string description_;
 	std::string link_;
 	time_t pubDate_;
 	const std::string rssurl_;
+	/// Stable sort by publication date, which only reads the ItemStore.
+	void sort_by_date(bool newest_first);
+
 	std::vector<std::shared_ptr<RssItem>> items_;
-	std::unordered_map<std::string, std::shared_ptr<RssItem>>
-		items_guid_map;
+	/// Handles of items_, in the same order. Scans over the items' dates
+	/// and state go through these, rather than through each RssItem.
+	std::vector<ItemHandle> handles_;
+	GuidMap items_guid_map;
 	std::vector<std::string> tags_;
 	std::string query;
 
@@ -212,6 +278,12 @@ private:
 
 	DlStatus status_;
 	std::mutex status_mutex_;
+
+	bool items_loaded_;
+	unsigned int summary_unread_count_;
+	unsigned int summary_total_count_;
+	time_t summary_latest_item_timestamp_;
+	unsigned long last_used_;
 };
 
 } // namespace newsboat
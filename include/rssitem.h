@@ -2,9 +2,10 @@
 #define NEWSBOAT_RSSITEM_H_
 
 #include <memory>
-#include <mutex>
 #include <string>
 
+#include "internedstring.h"
+#include "itemstore.h"
 #include "matchable.h"
 #include "matcher.h"
 
@@ -22,6 +23,8 @@ class RssItem : public Matchable {
 public:
 	explicit RssItem(Cache* c);
 	~RssItem() override;
+	RssItem(const RssItem&) = delete;
+	RssItem& operator=(const RssItem&) = delete;
 
 	std::string title() const
 	{
@@ -35,25 +38,22 @@ public:
 	}
 	void set_link(const std::string& l);
 
-	std::string author() const
+	const std::string& author() const
 	{
-		return author_;
+		return author_.str();
 	}
 	void set_author(const std::string& a);
 
-	Description description() const
-	{
-		std::lock_guard<std::mutex> guard(description_mutex);
-		if (description_.has_value()) {
-			return description_.value();
-		}
-		return {"", ""};
-	}
+	Description description() const;
 	void set_description(const std::string& content, const std::string& mime_type);
+	/// Called by the cache once it has stored \a stored for this item. If
+	/// the item still holds that description, it can from then on be
+	/// evicted to save memory, because it can be read back.
+	void set_description_stored(const Description& stored);
 
 	unsigned int size() const
 	{
-		return size_;
+		return ItemStore::instance().size(handle_);
 	}
 	void set_size(unsigned int size);
 
@@ -62,13 +62,14 @@ public:
 
 	time_t pubDate_timestamp() const
 	{
-		return pubDate_;
+		return ItemStore::instance().pub_date(handle_);
 	}
 	void set_pubDate(time_t t);
 
 	bool operator<(const RssItem& item) const
 	{
-		return item.pubDate_ < this->pubDate_; // new items come first
+		// new items come first
+		return item.pubDate_timestamp() < pubDate_timestamp();
 	}
 
 	const std::string& guid() const
@@ -79,7 +80,7 @@ public:
 
 	bool unread() const
 	{
-		return unread_;
+		return ItemStore::instance().unread(handle_);
 	}
 	void set_unread(bool u);
 	void set_unread_nowrite(bool u);
@@ -91,7 +92,7 @@ public:
 	}
 	void set_feedurl(const std::string& f)
 	{
-		feedurl_ = f;
+		feedurl_ = InternedString(f);
 	}
 
 	const std::string& feedurl() const;
@@ -107,11 +108,11 @@ public:
 
 	bool enqueued()
 	{
-		return enqueued_;
+		return ItemStore::instance().enqueued(handle_);
 	}
 	void set_enqueued(bool v)
 	{
-		enqueued_ = v;
+		ItemStore::instance().set_enqueued(handle_, v);
 	}
 
 	const std::string& flags() const
@@ -138,67 +139,103 @@ public:
 
 	bool deleted() const
 	{
-		return deleted_;
+		return ItemStore::instance().deleted(handle_);
 	}
 	void set_deleted(bool b)
 	{
-		deleted_ = b;
+		ItemStore::instance().set_deleted(handle_, b);
 	}
 
 	void set_index(unsigned int i)
 	{
-		idx = i;
+		ItemStore::instance().set_index(handle_, i);
 	}
 
 	void set_base(const std::string& b)
 	{
-		base = b;
+		base = InternedString(b);
 	}
 	const std::string& get_base() const
 	{
-		return base;
+		return base.str();
 	}
 
 	void set_override_unread(bool b)
 	{
-		override_unread_ = b;
+		ItemStore::instance().set_override_unread(handle_, b);
 	}
 	bool override_unread()
 	{
-		return override_unread_;
+		return ItemStore::instance().override_unread(handle_);
 	}
 
-	void unload()
+	/// The item's slot in the ItemStore, which holds its date and state.
+	ItemHandle handle() const
 	{
-		std::lock_guard<std::mutex> guard(description_mutex);
-		description_.reset();
+		return handle_;
 	}
 
+	void unload();
+
+	/// Estimated bytes used by the item, except for its description.
+	std::size_t memory_usage() const;
+	/// Estimated bytes used by the description, if it's loaded.
+	std::size_t description_memory_usage() const;
+
 private:
+	friend class DescriptionBudget;
+
+	/// Drops the description to save memory. Unlike unload(), the next call
+	/// to description() reads it back from the cache.
+	void evict_description();
+
+	/// Guards the description. It's the item's lock in the ItemStore, which
+	/// takes no memory beyond the item's slot.
+	class DescriptionLock {
+	public:
+		explicit DescriptionLock(ItemHandle h)
+			: handle(h)
+		{
+		}
+		void lock()
+		{
+			ItemStore::instance().lock(handle);
+		}
+		void unlock()
+		{
+			ItemStore::instance().unlock(handle);
+		}
+
+	private:
+		ItemHandle handle;
+	};
+
+	// Members are ordered by alignment to avoid padding.
+	Cache* ch;
+	std::weak_ptr<RssFeed> feedptr_;
 	std::string title_;
 	std::string link_;
-	std::string author_;
 	std::string guid_;
-	std::string feedurl_;
-	Cache* ch;
 	std::string enclosure_url_;
-	std::string enclosure_type_;
 	std::string enclosure_description_;
-	std::string enclosure_description_mime_type_;
 	std::string flags_;
 	std::string oldflags_;
-	std::weak_ptr<RssFeed> feedptr_;
-	std::string base;
-	unsigned int idx;
-	unsigned int size_;
-	time_t pubDate_;
-	bool unread_;
-	bool enqueued_;
-	bool deleted_;
-	bool override_unread_;
-
-	mutable std::mutex description_mutex;
-	nonstd::optional<Description> description_;
+	// Values that usually repeat across all items of a feed
+	InternedString author_;
+	InternedString feedurl_;
+	InternedString enclosure_type_;
+	InternedString enclosure_description_mime_type_;
+	InternedString base;
+	// Shared, so that the lock only has to be held while copying or
+	// swapping the pointer, never while copying the text.
+	mutable std::shared_ptr<const Description> description_;
+	const ItemHandle handle_;
+	// Set when DescriptionBudget dropped the description; guarded by
+	// DescriptionLock.
+	mutable bool description_evicted_;
+	// Set when the cache holds the same description as the item; guarded
+	// by DescriptionLock.
+	bool description_stored_;
 };
 
 } // namespace newsboat
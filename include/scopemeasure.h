@@ -2,6 +2,7 @@
 #define NEWSBOAT_SCOPEMEASURE_H_
 
 #include <string>
+#include <vector>
 
 #include "libnewsboat-ffi/src/scopemeasure.rs.h"
 
@@ -13,6 +14,19 @@ public:
 	~ScopeMeasure() = default;
 	void stopover(const std::string& son = "");
 
+	/// Starts recording all ScopeMeasure objects, from all threads, into
+	/// \a path in Chrome's trace-event format, which can be viewed in
+	/// `about:tracing` or Perfetto.
+	/// \return false if the file couldn't be created.
+	static bool start_tracing(const std::string& path);
+
+	/// Finishes the trace file started by start_tracing(), if any.
+	static void stop_tracing();
+
+	/// Count, total, minimum, percentiles and maximum of the time spent in
+	/// each scope so far, as a table with a header line.
+	static std::vector<std::string> format_stats();
+
 private:
 	rust::Box<scopemeasure::bridged::ScopeMeasure> rs_object;
 };
@@ -0,0 +1,72 @@
+#ifndef NEWSBOAT_STARTUPPROFILER_H_
+#define NEWSBOAT_STARTUPPROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace newsboat {
+
+/// \brief Measures the phases of Newsboat's startup (`--profile-startup`).
+///
+/// Phases are consecutive: starting one ends the previous one. For each
+/// phase, wall-clock time, CPU time of the whole process, growth of the heap
+/// and the number of SQL statements run by the cache are recorded. The
+/// statements are only counted while a profiler exists.
+class StartupProfiler {
+public:
+	StartupProfiler();
+	~StartupProfiler();
+	StartupProfiler(const StartupProfiler&) = delete;
+	StartupProfiler& operator=(const StartupProfiler&) = delete;
+
+	struct Phase {
+		std::string name;
+		double wall_ms;
+		double cpu_ms;
+		/// Net change in heap memory in use; 0 where the C library doesn't
+		/// tell (see heap_supported()).
+		std::int64_t heap_bytes;
+		std::uint64_t sql_statements;
+	};
+
+	/// Ends the current phase, if any, and starts a new one.
+	void begin_phase(const std::string& name);
+
+	/// Ends the current phase, if any.
+	void end_phase();
+
+	const std::vector<Phase>& phases() const
+	{
+		return completed;
+	}
+
+	/// Human-readable table of all phases, with totals in the last line.
+	std::vector<std::string> format() const;
+
+	std::string to_json() const;
+
+	/// Whether heap usage can be measured on this platform.
+	static bool heap_supported();
+
+private:
+	struct Sample {
+		std::chrono::steady_clock::time_point wall;
+		std::clock_t cpu;
+		std::int64_t heap;
+		std::uint64_t sql_statements;
+	};
+
+	static Sample take_sample();
+
+	bool in_phase = false;
+	std::string current_name;
+	Sample current_start{};
+	std::vector<Phase> completed;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_STARTUPPROFILER_H_ */
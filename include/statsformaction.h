@@ -0,0 +1,44 @@
+#ifndef NEWSBOAT_STATSFORMACTION_H_
+#define NEWSBOAT_STATSFORMACTION_H_
+
+#include "formaction.h"
+#include "listformatter.h"
+#include "textviewwidget.h"
+
+namespace newsboat {
+
+/// \brief Read-only dialog showing Newsboat's runtime statistics.
+class StatsFormAction : public FormAction {
+public:
+	StatsFormAction(View&, std::string formstr, ConfigContainer* cfg);
+	~StatsFormAction() override = default;
+	void prepare() override;
+	void init() override;
+	const std::vector<KeyMapHintEntry>& get_keymap_hint() const override;
+	std::string id() const override
+	{
+		// Uses the key bindings of the help dialog, which is the other
+		// read-only text dialog.
+		return "help";
+	}
+	std::string title() override;
+
+protected:
+	std::string main_widget() const override
+	{
+		return "statstext";
+	}
+
+private:
+	bool process_operation(Operation op,
+		const std::vector<std::string>& args,
+		BindingType bindingType = BindingType::BindKey) override;
+	void add_memory_stats(ListFormatter& listfmt);
+	void add_timing_stats(ListFormatter& listfmt);
+	bool quit;
+	TextviewWidget textview;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_STATSFORMACTION_H_ */
@@ -0,0 +1,67 @@
+#ifndef NEWSBOAT_SUBSCRIPTIONCACHE_H_
+#define NEWSBOAT_SUBSCRIPTIONCACHE_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "3rd-party/optional.hpp"
+
+#include "remoteapi.h"
+
+namespace newsboat {
+
+/// \brief The subscription list of a remote API, as it was last fetched.
+///
+/// The list is kept in a file next to the cache, so that it's at hand on the
+/// next start before the server has answered. Along with it, the file holds
+/// the replies the list was built from and their ETag and Last-Modified
+/// headers, so that the server only has to send them again if they changed.
+///
+/// The file is written as JSON. It belongs to the account it was fetched
+/// for: if it was written for a different \a key, it's ignored and
+/// eventually overwritten.
+class SubscriptionCache {
+public:
+	struct Reply {
+		std::string etag;
+		std::string last_modified;
+		std::string body;
+	};
+
+	static const unsigned int VERSION = 1;
+
+	/// Reads the cache from \a file, unless it's missing, malformed, of
+	/// a different version, or was written for a different \a key.
+	SubscriptionCache(const std::string& file, const std::string& key);
+
+	/// The list that was stored last, if any.
+	nonstd::optional<std::vector<TaggedFeedUrl>> get_urls() const;
+
+	/// Replaces the list and writes the cache to disk, replacing the file
+	/// atomically.
+	/// \return false if the file couldn't be written.
+	bool store_urls(const std::vector<TaggedFeedUrl>& urls);
+
+	/// The reply that \a url gave last, if any.
+	nonstd::optional<Reply> get_reply(const std::string& url) const;
+
+	/// Remembers \a reply until the next store_urls().
+	void set_reply(const std::string& url, const Reply& reply);
+
+private:
+	void load();
+
+	const std::string file;
+	const std::string key;
+
+	mutable std::mutex mtx;
+	bool has_urls;
+	std::vector<TaggedFeedUrl> urls;
+	std::map<std::string, Reply> replies;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_SUBSCRIPTIONCACHE_H_ */
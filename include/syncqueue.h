@@ -0,0 +1,141 @@
+#ifndef NEWSBOAT_SYNCQUEUE_H_
+#define NEWSBOAT_SYNCQUEUE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace newsboat {
+
+class RemoteApi;
+
+/// \brief Sends read state and flag changes to a remote API in the background.
+///
+/// Changes are collected for COALESCE_DELAY and then sent in batches, using
+/// the API's bulk operations where it has them. Of several changes to the
+/// same article, only the outcome is sent. Changes that couldn't be sent are
+/// retried with increasing delays, and are kept in a journal file so that
+/// they survive a restart. Feeds are never marked read as a whole: sent
+/// later, that would include articles that arrived in the meantime. A change
+/// that the server keeps refusing while it accepts others is dropped after
+/// MAX_ATTEMPTS, so that it doesn't hold up the rest forever.
+class SyncQueue {
+public:
+	/// Picks up the changes that a previous run left in \a journal_file.
+	SyncQueue(RemoteApi& api, const std::string& journal_file);
+
+	/// Stops the background thread and saves pending changes to the
+	/// journal, without trying to send them.
+	~SyncQueue();
+
+	SyncQueue(const SyncQueue&) = delete;
+	SyncQueue& operator=(const SyncQueue&) = delete;
+
+	/// Starts sending changes in a background thread.
+	void start();
+
+	/// Stops the background thread, makes a last attempt at sending pending
+	/// changes (unless the previous attempt failed), and saves whatever is
+	/// left to the journal.
+	void stop();
+
+	void mark_article_read(const std::string& guid, bool read);
+	void mark_articles_read(const std::vector<std::string>& guids);
+	void update_article_flags(const std::string& oldflags,
+		const std::string& newflags,
+		const std::string& guid);
+
+	/// Sends all pending changes from the calling thread.
+	/// \return false if some of them couldn't be sent.
+	bool flush();
+
+	/// Like flush(), but leaves the changes to the background thread while
+	/// it waits to retry a failed attempt.
+	/// \return false if changes are still pending.
+	bool try_flush();
+
+	/// Number of changes that haven't been sent yet.
+	std::size_t pending() const;
+
+	/// GUIDs of the articles whose read state hasn't been sent yet,
+	/// including those that are being sent right now.
+	std::unordered_set<std::string> pending_read_state() const;
+
+	/// How long changes are collected before they are sent.
+	static const std::chrono::milliseconds COALESCE_DELAY;
+
+	/// Maximum number of articles marked by a single request.
+	static const std::size_t BATCH_SIZE = 250;
+
+	/// Number of times the server may refuse a change before it is dropped.
+	static const unsigned int MAX_ATTEMPTS = 5;
+
+private:
+	enum class ChangeType { READ, UNREAD, FLAGS };
+	enum class Outcome { SENT, REFUSED, NOT_SENT };
+
+	struct Change {
+		ChangeType type;
+		/// GUID of the article.
+		std::string target;
+		std::string oldflags;
+		std::string newflags;
+		/// How often the server refused this change while accepting others.
+		unsigned int attempts = 0;
+	};
+
+	struct FlushResult {
+		std::size_t sent;
+		std::size_t unsent;
+	};
+
+	void add(std::vector<Change> newer);
+	/// Appends \a newer to \a changes, dropping the changes they supersede.
+	/// \return the number of changes from before that are left, at the
+	/// front.
+	static std::size_t merge(std::vector<Change>& changes,
+		std::vector<Change> newer);
+	FlushResult send_pending();
+	/// Updates retry_delay after an attempt at sending.
+	void record_result(const FlushResult& result);
+	/// Sends the changes in \a batch, unless the server turns out to be
+	/// unreachable.
+	/// \return what became of each of the changes.
+	std::vector<Outcome> send(const std::vector<Change>& batch);
+	/// Sends the changes in \a batch from \a begin to \a end, which are
+	/// all of the same type, in a single request.
+	bool send_request(const std::vector<Change>& batch,
+		std::size_t begin,
+		std::size_t end);
+	void run();
+	void join();
+
+	void load_journal();
+	void save_journal(const std::vector<Change>& remaining);
+
+	RemoteApi& api;
+	const std::string journal_file;
+	std::thread thread;
+
+	mutable std::mutex mtx;
+	std::condition_variable cv;
+	std::vector<Change> changes;
+	/// Articles whose read state is in the batch that is being sent.
+	std::unordered_set<std::string> sending_read_state;
+	bool stop_requested;
+	/// Zero unless nothing could be sent at the last attempt.
+	std::chrono::milliseconds retry_delay;
+
+	/// Held while changes are sent and the journal is saved, so that
+	/// batches go out in order.
+	std::mutex send_mtx;
+};
+
+} // namespace newsboat
+
+#endif /* NEWSBOAT_SYNCQUEUE_H_ */
@@ -1,6 +1,10 @@
 #ifndef NEWSBOAT_TTRSSAPI_H_
 #define NEWSBOAT_TTRSSAPI_H_
 
+#include <functional>
+#include <memory>
+#include <unordered_set>
+
 #include "3rd-party/json.hpp"
 #include "cache.h"
 #include "remoteapi.h"
@@ -29,16 +33,34 @@ public:
 	void add_custom_headers(curl_slist** custom_headers) override;
 	bool mark_all_read(const std::string& feed_url) override;
 	bool mark_article_read(const std::string& guid, bool read) override;
+	bool mark_articles_read(const std::vector<std::string>& guids) override;
+	bool mark_articles_unread(const std::vector<std::string>& guids) override;
 	bool update_article_flags(const std::string& oldflags,
 		const std::string& newflags,
 		const std::string& guid) override;
 	rsspp::Feed fetch_feed(const std::string& id);
 	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& cached_handle);
+	/// Only fetches articles added since \a sync_cursor, unless it's empty.
+	/// Updates \a sync_cursor if the articles were fetched.
+	rsspp::Feed fetch_feed(const std::string& id, CurlHandle& cached_handle,
+		std::string& sync_cursor);
 	bool update_article(const std::string& guid, int field, int mode);
 
 private:
+	/// Like run_op(), but passes the elements of the `content` array to
+	/// \a on_content_element as they're parsed, rather than returning them.
+	nlohmann::json run_op(const std::string& op,
+		const std::map<std::string, std::string>& args,
+		CurlHandle& cached_handle,
+		const std::function<void(nlohmann::json&& element)>& on_content_element,
+		bool try_login);
+	/// Lists the GUIDs of all unread articles in feed \a id.
+	/// \return nullptr if the list couldn't be fetched or is incomplete.
+	std::shared_ptr<const std::unordered_set<std::string>> fetch_unread_guids(
+			const std::string& id, CurlHandle& cached_handle);
 	void fetch_feeds_per_category(const nlohmann::json& cat,
-		std::vector<TaggedFeedUrl>& feeds);
+		std::vector<TaggedFeedUrl>& feeds,
+		CurlHandle& easyhandle);
 	bool star_article(const std::string& guid, bool star);
 	bool publish_article(const std::string& guid, bool publish);
 	TaggedFeedUrl feed_from_json(const nlohmann::json& jfeed,
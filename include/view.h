@@ -27,6 +27,7 @@ class KeyMap;
 struct MacroCmd;
 class RegexManager;
 class RssFeed;
+class StartupProfiler;
 
 class View : public IStatus {
 public:
@@ -76,6 +77,7 @@ public:
 		const std::string& searchphrase = "");
 	void push_empty_formaction();
 	void push_help();
+	void push_stats();
 	void push_urlview(const Links& links,
 		std::shared_ptr<RssFeed>& feed);
 	void push_searchresult(std::shared_ptr<RssFeed> feed,
@@ -121,6 +123,10 @@ public:
 
 	void set_cache(Cache* c);
 
+	/// If set, the current phase of \a profiler is ended once the first
+	/// screen is drawn.
+	void set_startup_profiler(StartupProfiler* profiler);
+
 	std::vector<std::pair<unsigned int, std::string>> get_formaction_names();
 
 	std::shared_ptr<FormAction> get_current_formaction();
@@ -176,6 +182,7 @@ protected:
 	std::string last_fragment;
 	unsigned int tab_count;
 	Cache* rsscache;
+	StartupProfiler* startup_profiler;
 	FilterContainer& filters;
 	const ColorManager& colorman;
 	std::vector<std::string> suggestions;
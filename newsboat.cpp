@@ -14,6 +14,7 @@
 #include "exception.h"
 #include "matcherexception.h"
 #include "rss/parser.h"
+#include "scopemeasure.h"
 #include "stflpp.h"
 #include "utils.h"
 #include "view.h"
@@ -118,7 +119,19 @@ void print_usage(const std::string& argv0, const ConfigPaths& configpaths)
 			_s("import list of read articles from <file>")
 		},
 		{'h', "help", "", _s("this help")},
-		{'-', "cleanup", "", _s("remove unreferenced items from cache")}
+		{'-', "cleanup", "", _s("remove unreferenced items from cache")},
+		{
+			'-',
+			"profile-startup",
+			_s("[<file>]"),
+			_s("report time spent in each startup phase, on exit or as JSON to <file>")
+		},
+		{
+			'-',
+			"trace-file",
+			_s("<tracefile>"),
+			_s("write timings to <tracefile> in Chrome's trace-event format")
+		}
 	};
 
 	std::stringstream ss;
@@ -279,6 +292,14 @@ int main(int argc, char* argv[])
 		return EXIT_SUCCESS;
 	}
 
+	if (args.trace_file().has_value()
+		&& !ScopeMeasure::start_tracing(args.trace_file().value())) {
+		std::cerr << strprintf::fmt(_("Error: couldn't create trace file %s"),
+				args.trace_file().value())
+			<< std::endl;
+		return EXIT_FAILURE;
+	}
+
 	int ret;
 	try {
 		ret = c.run(args);
@@ -306,5 +327,7 @@ int main(int argc, char* argv[])
 
 	rsspp::Parser::global_cleanup();
 
+	ScopeMeasure::stop_tracing();
+
 	return ret;
 }
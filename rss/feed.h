@@ -1,7 +1,9 @@
 #ifndef NEWSBOAT_RSSPPFEED_H_
 #define NEWSBOAT_RSSPPFEED_H_
 
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "item.h"
@@ -30,6 +32,7 @@ public:
 
 	Feed()
 		: rss_version(UNKNOWN)
+		, only_new_items(false)
 	{
 	}
 
@@ -46,6 +49,13 @@ public:
 	std::string pubDate;
 
 	std::vector<Item> items;
+
+	/// Set by remote APIs that only fetched the items added since the last
+	/// sync. The read state of the items fetched earlier is then taken from
+	/// `unread_guids`, which lists all of the feed's unread items (and
+	/// possibly those of other feeds, since it may be shared between them).
+	bool only_new_items;
+	std::shared_ptr<const std::unordered_set<std::string>> unread_guids;
 };
 
 } // namespace rsspp
@@ -232,10 +232,9 @@ Feed Parser::parse_url(const std::string& url,
 	}
 
 	const std::string buf = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"Parser::parse_url: retrieved data for %s: %s",
-		url,
-		buf);
+	LOG_FIELDS(Level::DEBUG, "Parser::parse_url: retrieved data", {
+		{"url", url},
+		{"data", buf}});
 
 	if (buf.length() > 0) {
 		LOG(Level::DEBUG,
@@ -36,6 +36,7 @@ mod bridged {
         fn using_nonstandard_configs(cliargsparser: &CliArgsParser) -> bool;
         fn should_print_usage(cliargsparser: &CliArgsParser) -> bool;
         fn refresh_on_start(cliargsparser: &CliArgsParser) -> bool;
+        fn profile_startup(cliargsparser: &CliArgsParser) -> bool;
 
         fn importfile(cliargsparser: &CliArgsParser) -> String;
         fn program_name(cliargsparser: &CliArgsParser) -> String;
@@ -53,6 +54,8 @@ mod bridged {
         fn search_history_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool;
         fn cmdline_history_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool;
         fn log_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool;
+        fn profile_startup_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool;
+        fn trace_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool;
 
         fn cmds_to_execute(cliargsparser: &CliArgsParser) -> Vec<String>;
 
@@ -110,6 +113,10 @@ fn refresh_on_start(cliargsparser: &CliArgsParser) -> bool {
     cliargsparser.0.refresh_on_start
 }
 
+fn profile_startup(cliargsparser: &CliArgsParser) -> bool {
+    cliargsparser.0.profile_startup
+}
+
 fn importfile(cliargsparser: &CliArgsParser) -> String {
     match &cliargsparser.0.importfile {
         Some(path) => path.to_string_lossy().to_string(),
@@ -235,6 +242,26 @@ fn log_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool {
     }
 }
 
+fn profile_startup_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool {
+    match &cliargsparser.0.profile_startup_file {
+        Some(p) => {
+            *path = p.to_string_lossy().to_string();
+            true
+        }
+        None => false,
+    }
+}
+
+fn trace_file(cliargsparser: &CliArgsParser, path: &mut String) -> bool {
+    match &cliargsparser.0.trace_file {
+        Some(p) => {
+            *path = p.to_string_lossy().to_string();
+            true
+        }
+        None => false,
+    }
+}
+
 fn cmds_to_execute(cliargsparser: &CliArgsParser) -> Vec<String> {
     cliargsparser.0.cmds_to_execute.to_owned()
 }
@@ -1,4 +1,4 @@
-use cxx::CxxString;
+use cxx::{CxxString, CxxVector};
 use libnewsboat::logger;
 
 #[cxx::bridge(namespace = "newsboat::logger")]
@@ -19,7 +19,16 @@ mod ffi {
         fn get_loglevel() -> i64;
         fn set_loglevel(level: Level);
         fn log_internal(level: Level, message: &CxxString);
+        fn log_fields_internal(
+            level: Level,
+            event: &str,
+            keys: &CxxVector<CxxString>,
+            values: &CxxVector<CxxString>,
+        );
         fn set_user_error_logfile(user_error_logfile: &str);
+        fn set_max_logfile_size(max_size: u64);
+        fn start_background_writer();
+        fn stop_background_writer();
     }
 }
 
@@ -57,6 +66,31 @@ fn log_internal(level: ffi::Level, message: &CxxString) {
     logger::get_instance().log_raw(level, message.as_bytes());
 }
 
+fn log_fields_internal(
+    level: ffi::Level,
+    event: &str,
+    keys: &CxxVector<CxxString>,
+    values: &CxxVector<CxxString>,
+) {
+    let level = ffi_level_to_log_level(level);
+    let keys = keys.iter().map(|key| key.to_str().unwrap_or("?"));
+    let values = values.iter().map(|value| value.as_bytes());
+    let fields = keys.zip(values).collect::<Vec<_>>();
+    logger::get_instance().log_fields(level, event, &fields);
+}
+
 fn set_user_error_logfile(user_error_logfile: &str) {
     logger::get_instance().set_user_error_logfile(user_error_logfile);
 }
+
+fn set_max_logfile_size(max_size: u64) {
+    logger::get_instance().set_max_logfile_size(max_size);
+}
+
+fn start_background_writer() {
+    logger::get_instance().start_background_writer();
+}
+
+fn stop_background_writer() {
+    logger::get_instance().stop_background_writer();
+}
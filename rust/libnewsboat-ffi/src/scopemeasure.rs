@@ -1,4 +1,5 @@
 use libnewsboat::scopemeasure;
+use std::path::Path;
 
 // cxx doesn't allow to share types from other crates, so we have to wrap it
 // cf. https://github.com/dtolnay/cxx/issues/496
@@ -11,6 +12,11 @@ mod bridged {
 
         fn create(scope_name: String) -> Box<ScopeMeasure>;
         fn stopover(obj: &ScopeMeasure, stopover_name: &str);
+
+        fn start_tracing(path: &str) -> bool;
+        fn stop_tracing();
+
+        fn format_scope_stats() -> Vec<String>;
     }
 }
 
@@ -21,3 +27,15 @@ fn create(scope_name: String) -> Box<ScopeMeasure> {
 fn stopover(obj: &ScopeMeasure, stopover_name: &str) {
     obj.0.stopover(stopover_name);
 }
+
+fn start_tracing(path: &str) -> bool {
+    scopemeasure::start_tracing(Path::new(path)).is_ok()
+}
+
+fn stop_tracing() {
+    scopemeasure::stop_tracing();
+}
+
+fn format_scope_stats() -> Vec<String> {
+    scopemeasure::format_scope_stats()
+}
@@ -81,6 +81,17 @@ pub struct CliArgsParser {
 
     /// If this contains some value, it's the log level specified by the user.
     pub log_level: Option<Level>,
+
+    /// If `true`, Newsboat should measure the phases of its startup and report them.
+    pub profile_startup: bool,
+
+    /// If this contains some value, it's the path to which the startup profile should be written
+    /// as JSON. Otherwise, it should be printed once Newsboat quits.
+    pub profile_startup_file: Option<PathBuf>,
+
+    /// If this contains some value, it's the path to which timings of `ScopeMeasure`s should be
+    /// written in Chrome's trace-event format.
+    pub trace_file: Option<PathBuf>,
 }
 
 /// Returns new path with an added extension
@@ -240,6 +251,16 @@ pub fn parse_cliargs(opts: Vec<OsString>, args: &mut CliArgsParser) -> Result<()
                     }
                 }
             }
+            Long("profile-startup") => {
+                args.profile_startup = true;
+                if let Some(profile_file) = parser.optional_value() {
+                    args.profile_startup_file = resolve_path(&profile_file);
+                }
+            }
+            Long("trace-file") => {
+                let trace_file = parser.value()?;
+                args.trace_file = resolve_path(&trace_file);
+            }
             _ => return Err(CliParseError::from(arg.unexpected())),
         }
     }
@@ -856,6 +877,58 @@ mod tests {
         check(vec!["newsboat".into(), "--log-level=90001".into()]);
     }
 
+    #[test]
+    fn t_sets_profile_startup_if_dash_dash_profile_startup_is_provided() {
+        let args = CliArgsParser::new(vec!["newsboat".into()]);
+        assert!(!args.profile_startup);
+
+        let args = CliArgsParser::new(vec!["newsboat".into(), "--profile-startup".into()]);
+        assert!(args.profile_startup);
+        assert_eq!(args.profile_startup_file, None);
+        assert_eq!(args.return_code, None);
+    }
+
+    #[test]
+    fn t_sets_profile_startup_file_if_argument_to_dash_dash_profile_startup_is_provided() {
+        let filename = "startup.json";
+
+        let args = CliArgsParser::new(vec![
+            "newsboat".into(),
+            format!("--profile-startup={filename}").into(),
+        ]);
+        assert!(args.profile_startup);
+        assert_eq!(args.profile_startup_file, Some(PathBuf::from(filename)));
+
+        // The file is optional, so it has to be attached with `=`
+        let args = CliArgsParser::new(vec![
+            "newsboat".into(),
+            "--profile-startup".into(),
+            filename.into(),
+        ]);
+        assert!(args.should_print_usage);
+        assert_eq!(args.return_code, Some(EXIT_FAILURE));
+    }
+
+    #[test]
+    fn t_sets_trace_file_if_dash_dash_trace_file_is_provided() {
+        let filename = "trace.json";
+
+        let check = |opts| {
+            let args = CliArgsParser::new(opts);
+            assert_eq!(args.trace_file, Some(PathBuf::from(filename)));
+        };
+
+        check(vec![
+            "newsboat".into(),
+            "--trace-file".into(),
+            filename.into(),
+        ]);
+        check(vec![
+            "newsboat".into(),
+            format!("--trace-file={filename}").into(),
+        ]);
+    }
+
     #[test]
     fn t_sets_program_name_to_the_first_string_of_the_options_list() {
         let check = |opts, expected: String| {
@@ -2,11 +2,13 @@
 
 use chrono::{offset::Local, Datelike, Timelike};
 use std::fmt;
-use std::fs::{File, OpenOptions};
+use std::fs::{self, File, OpenOptions};
 use std::io::Write;
+use std::path::PathBuf;
 use std::sync::atomic::{AtomicIsize, Ordering};
-use std::sync::Mutex;
 use std::sync::OnceLock;
+use std::sync::{Condvar, Mutex, MutexGuard};
+use std::thread::JoinHandle;
 
 #[derive(Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Debug)]
 /// "Importance levels" for log messages.
@@ -62,6 +64,13 @@ impl fmt::Display for Level {
     }
 }
 
+/// Which of the logs a message goes to.
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+enum Target {
+    Log,
+    UserErrorLog,
+}
+
 /// Stores the handles for logfiles.
 ///
 /// This is part of `Logger` struct. This struct is not thread-safe, but in `Logger`, it will be
@@ -70,10 +79,299 @@ struct LogFiles {
     /// The file to which all messages at and above `loglevel` will be written.
     logfile: Option<File>,
 
+    /// Path of `logfile`, needed to rotate it.
+    logfile_path: Option<PathBuf>,
+
+    /// Number of bytes in `logfile`.
+    logfile_size: u64,
+
+    /// If non-zero, `logfile` is rotated once it grows larger than this many bytes.
+    max_logfile_size: u64,
+
     /// The file to which all Level::UserError messages will be written.
     user_error_logfile: Option<File>,
 }
 
+impl LogFiles {
+    /// Writes already formatted lines to the log, rotating it if necessary.
+    ///
+    /// # Errors
+    ///
+    /// Errors are ignored since checking every log() call will be too bothersome.
+    fn write(&mut self, target: Target, data: &[u8]) {
+        if data.is_empty() {
+            return;
+        }
+
+        match target {
+            Target::Log => {
+                if let Some(ref mut logfile) = self.logfile {
+                    let _ = logfile.write_all(data);
+                    self.logfile_size += data.len() as u64;
+                }
+                if self.max_logfile_size > 0 && self.logfile_size > self.max_logfile_size {
+                    self.rotate();
+                }
+            }
+            Target::UserErrorLog => {
+                if let Some(ref mut user_error_logfile) = self.user_error_logfile {
+                    let _ = user_error_logfile.write_all(data);
+                }
+            }
+        }
+    }
+
+    /// Renames the logfile to "<name>.1", replacing the previous one, and starts a new logfile.
+    fn rotate(&mut self) {
+        let Some(path) = self.logfile_path.clone() else {
+            return;
+        };
+        let mut rotated = path.clone().into_os_string();
+        rotated.push(".1");
+
+        self.logfile = None;
+        if let Err(error) = fs::rename(&path, &rotated) {
+            eprintln!("Couldn't rotate logfile `{}': {error}", path.display());
+        }
+        self.logfile = OpenOptions::new()
+            .create(true)
+            .append(true)
+            .open(&path)
+            .ok();
+        self.logfile_size = 0;
+    }
+}
+
+/// Messages that wait for the background writer.
+struct Queue {
+    messages: Vec<(Target, Vec<u8>)>,
+
+    /// Total size of `messages`.
+    queued_bytes: usize,
+
+    /// Number of messages dropped because the queue was full, since the last batch was written.
+    dropped: u64,
+
+    /// Number of messages ever queued, and how many of them have been written out. `flush()` waits
+    /// for the latter to catch up with the former.
+    enqueued: u64,
+    written: u64,
+
+    /// Whether the background writer is accepting messages.
+    running: bool,
+}
+
+/// Writes messages to the log files from a separate thread, so that threads which log don't have
+/// to wait for disk I/O, and so that messages can be written in batches.
+struct BackgroundWriter {
+    queue: Mutex<Queue>,
+
+    /// Signalled when messages are queued, or the writer is stopped.
+    messages_queued: Condvar,
+
+    /// Signalled when a batch of messages has been written out.
+    batch_written: Condvar,
+
+    thread: Mutex<Option<JoinHandle<()>>>,
+}
+
+/// Messages beyond this many bytes in the queue are dropped, so that a thread which logs faster
+/// than the disk can keep up with doesn't eat up all the memory. Errors are queued regardless: they
+/// are few, and they're what the log is read for.
+const MAX_QUEUED_BYTES: usize = 16 * 1024 * 1024;
+
+impl BackgroundWriter {
+    fn new() -> BackgroundWriter {
+        BackgroundWriter {
+            queue: Mutex::new(Queue {
+                messages: Vec::new(),
+                queued_bytes: 0,
+                dropped: 0,
+                enqueued: 0,
+                written: 0,
+                running: false,
+            }),
+            messages_queued: Condvar::new(),
+            batch_written: Condvar::new(),
+            thread: Mutex::new(None),
+        }
+    }
+
+    fn lock_queue(&self) -> MutexGuard<Queue> {
+        self.queue
+            .lock()
+            .expect("Someone poisoned logger's queue mutex")
+    }
+
+    /// Queues a message. If the writer isn't running, the message is handed back, and the caller
+    /// has to write it itself.
+    fn push(&self, target: Target, level: Level, message: Vec<u8>) -> Result<(), Vec<u8>> {
+        let mut queue = self.lock_queue();
+        if !queue.running {
+            return Err(message);
+        }
+
+        if level > Level::Error && queue.queued_bytes + message.len() > MAX_QUEUED_BYTES {
+            queue.dropped += 1;
+        } else {
+            queue.queued_bytes += message.len();
+            queue.messages.push((target, message));
+            queue.enqueued += 1;
+        }
+        drop(queue);
+
+        self.messages_queued.notify_one();
+        Ok(())
+    }
+
+    /// Blocks until everything queued so far is written out.
+    fn flush(&self) {
+        let mut queue = self.lock_queue();
+        let target = queue.enqueued;
+        while queue.written < target && queue.running {
+            queue = self
+                .batch_written
+                .wait(queue)
+                .expect("Someone poisoned logger's queue mutex");
+        }
+    }
+
+    fn run(&self, files: &Mutex<LogFiles>) {
+        loop {
+            let (messages, dropped, enqueued, running) = {
+                let mut queue = self.lock_queue();
+                while queue.running && queue.messages.is_empty() && queue.dropped == 0 {
+                    queue = self
+                        .messages_queued
+                        .wait(queue)
+                        .expect("Someone poisoned logger's queue mutex");
+                }
+                queue.queued_bytes = 0;
+                (
+                    std::mem::take(&mut queue.messages),
+                    std::mem::replace(&mut queue.dropped, 0),
+                    queue.enqueued,
+                    queue.running,
+                )
+            };
+
+            let mut log = Vec::new();
+            let mut user_error_log = Vec::new();
+            if dropped > 0 {
+                log.extend_from_slice(&format_line(
+                    Some(Level::Warn),
+                    format!("Logger: dropped {dropped} messages because the disk couldn't keep up")
+                        .as_bytes(),
+                ));
+            }
+            for (target, message) in messages {
+                match target {
+                    Target::Log => log.extend_from_slice(&message),
+                    Target::UserErrorLog => user_error_log.extend_from_slice(&message),
+                }
+            }
+
+            {
+                let mut files = files.lock().expect("Someone poisoned logger's mutex");
+                files.write(Target::Log, &log);
+                files.write(Target::UserErrorLog, &user_error_log);
+            }
+
+            self.lock_queue().written = enqueued;
+            self.batch_written.notify_all();
+
+            if !running {
+                break;
+            }
+        }
+    }
+}
+
+/// Values of `log_fields()` longer than this many bytes are truncated.
+pub const MAX_FIELD_LENGTH: usize = 256;
+
+/// Formats an event and its fields for `Logger::log_fields()`.
+fn format_fields(event: &str, fields: &[(&str, &[u8])]) -> Vec<u8> {
+    let mut line = event.as_bytes().to_vec();
+    for (key, value) in fields {
+        line.push(b' ');
+        line.extend_from_slice(key.as_bytes());
+        line.push(b'=');
+
+        if value.len() <= MAX_FIELD_LENGTH {
+            append_field_value(&mut line, value);
+            continue;
+        }
+
+        // Don't cut a multibyte UTF-8 character in half.
+        let mut end = MAX_FIELD_LENGTH;
+        while end > 0 && (value[end] & 0b1100_0000) == 0b1000_0000 {
+            end -= 1;
+        }
+        append_field_value(&mut line, &value[..end]);
+        line.extend_from_slice(
+            format!(
+                "... {key}_length={} {key}_md5={:x}",
+                value.len(),
+                md5::compute(value)
+            )
+            .as_bytes(),
+        );
+    }
+    line
+}
+
+/// Appends a value, quoting and escaping it unless it's a single plain word.
+fn append_field_value(line: &mut Vec<u8>, value: &[u8]) {
+    let needs_quotes = value.is_empty()
+        || value
+            .iter()
+            .any(|&c| c.is_ascii_whitespace() || c.is_ascii_control() || c == b'"' || c == b'\\');
+    if !needs_quotes {
+        line.extend_from_slice(value);
+        return;
+    }
+
+    line.push(b'"');
+    for &c in value {
+        match c {
+            b'"' => line.extend_from_slice(b"\\\""),
+            b'\\' => line.extend_from_slice(b"\\\\"),
+            b'\n' => line.extend_from_slice(b"\\n"),
+            b'\r' => line.extend_from_slice(b"\\r"),
+            b'\t' => line.extend_from_slice(b"\\t"),
+            c if c.is_ascii_control() => line.extend_from_slice(format!("\\x{c:02x}").as_bytes()),
+            c => line.push(c),
+        }
+    }
+    line.push(b'"');
+}
+
+/// Formats a line of the log: a timestamp, the level (if any), the message and a newline.
+fn format_line(level: Option<Level>, data: &[u8]) -> Vec<u8> {
+    let timestamp = Local::now();
+    // DateTime::format() is extremely slow; format! is way faster. See
+    // https://github.com/chronotope/chrono/issues/94 for details.
+    let prefix = format!(
+        "[{}-{:02}-{:02} {:02}:{:02}:{:02}] ",
+        timestamp.year(),
+        timestamp.month(),
+        timestamp.day(),
+        timestamp.hour(),
+        timestamp.minute(),
+        timestamp.second()
+    );
+
+    let mut line = Vec::with_capacity(prefix.len() + 12 + data.len() + 1);
+    line.extend_from_slice(prefix.as_bytes());
+    if let Some(level) = level {
+        line.extend_from_slice(format!("{level}: ").as_bytes());
+    }
+    line.extend_from_slice(data);
+    line.push(b'\n');
+    line
+}
+
 /// Keeps a record of what the program did.
 ///
 /// Each Logger object can write up to two logs.
@@ -86,6 +384,10 @@ struct LogFiles {
 ///
 /// Each message in the log is time-stamped, and marked with its importance level.
 ///
+/// By default, messages are written before `log()` returns. After
+/// `start_background_writer()`, they are queued and written in batches by a separate thread
+/// instead; call `flush()` or `stop_background_writer()` to make sure they reach the disk.
+///
 /// This is meant to be a long-lived, shared object that exists for the duration of the program.
 /// Users would call its `log` method to add messages to the log file, like this:
 ///
@@ -112,6 +414,9 @@ pub struct Logger {
 
     /// Maximum "importance level" of the messages that will be written to the log.
     loglevel: AtomicIsize,
+
+    /// Writes messages from a separate thread, once started.
+    background: BackgroundWriter,
 }
 
 impl Logger {
@@ -122,9 +427,13 @@ impl Logger {
         Logger {
             files: Mutex::new(LogFiles {
                 logfile: None,
+                logfile_path: None,
+                logfile_size: 0,
+                max_logfile_size: 0,
                 user_error_logfile: None,
             }),
             loglevel: AtomicIsize::new(-1_isize),
+            background: BackgroundWriter::new(),
         }
     }
 
@@ -144,8 +453,11 @@ impl Logger {
 
         match file {
             Ok(file) => {
+                let size = file.metadata().map(|m| m.len()).unwrap_or(0);
                 let mut files = self.files.lock().expect("Someone poisoned logger's mutex");
                 files.logfile = Some(file);
+                files.logfile_path = Some(PathBuf::from(filename));
+                files.logfile_size = size;
             }
             Err(error) => eprintln!("Couldn't open `{filename}' as a logfile: {error}"),
         }
@@ -174,6 +486,16 @@ impl Logger {
         }
     }
 
+    /// Limits the size of the general log.
+    ///
+    /// Once the logfile grows larger than `max_size` bytes, it's renamed by appending ".1" to its
+    /// name (replacing the file that was rotated before), and a new logfile is started. 0 means
+    /// no limit, which is the default.
+    pub fn set_max_logfile_size(&self, max_size: u64) {
+        let mut files = self.files.lock().expect("Someone poisoned logger's mutex");
+        files.max_logfile_size = max_size;
+    }
+
     /// Writes a message to a log.
     ///
     /// This method is a wrapper around `log_raw()`.
@@ -202,43 +524,83 @@ impl Logger {
             return;
         }
 
-        let timestamp = Local::now();
-        // DateTime::format() is extremely slow; format! is way faster. See
-        // https://github.com/chronotope/chrono/issues/94 for details.
-        let timestamp = format!(
-            "[{}-{:02}-{:02} {:02}:{:02}:{:02}] ",
-            timestamp.year(),
-            timestamp.month(),
-            timestamp.day(),
-            timestamp.hour(),
-            timestamp.minute(),
-            timestamp.second()
-        );
-
-        let mut files = self.files.lock().expect("Someone poisoned logger's mutex");
-
         if level as isize <= self.get_loglevel() {
-            if let Some(ref mut logfile) = files.logfile {
-                let level = format!("{level}: ");
-
-                // Ignoring the error since checking every log() call will be too bothersome.
-                let _ = logfile.write_all(timestamp.as_bytes());
-                let _ = logfile.write_all(level.as_bytes());
-                let _ = logfile.write_all(data);
-                let _ = logfile.write_all(b"\n");
-            }
+            self.write(Target::Log, level, format_line(Some(level), data));
         }
 
         if level == Level::UserError {
-            if let Some(ref mut user_error_logfile) = files.user_error_logfile {
-                // Ignoring the error since checking every log() call will be too bothersome.
-                let _ = user_error_logfile.write_all(timestamp.as_bytes());
-                let _ = user_error_logfile.write_all(data);
-                let _ = user_error_logfile.write_all(b"\n");
-            }
+            self.write(Target::UserErrorLog, level, format_line(None, data));
         }
     }
 
+    /// Writes an event with key/value fields to the log, like this:
+    ///
+    /// ```text
+    /// Parser::parse_url: retrieved data url=https://example.com/feed.xml body="<?xml..."
+    /// ```
+    ///
+    /// Values longer than `MAX_FIELD_LENGTH` bytes are cut short, and their full length and MD5
+    /// digest are added as `<key>_length` and `<key>_md5` fields. This keeps the log small even
+    /// when whole feeds and API responses are logged, while still showing whether two payloads
+    /// were the same.
+    ///
+    /// Like `log_raw()`, this does nothing if `level` is below the current loglevel.
+    pub fn log_fields(&self, level: Level, event: &str, fields: &[(&str, &[u8])]) {
+        if level != Level::UserError && level as isize > self.get_loglevel() {
+            return;
+        }
+
+        self.log_raw(level, &format_fields(event, fields));
+    }
+
+    fn write(&self, target: Target, level: Level, line: Vec<u8>) {
+        let Err(line) = self.background.push(target, level, line) else {
+            return;
+        };
+        let mut files = self.files.lock().expect("Someone poisoned logger's mutex");
+        files.write(target, &line);
+    }
+
+    /// Makes messages get written by a separate thread, in batches.
+    ///
+    /// If messages are logged faster than they can be written, the excess is dropped, and the
+    /// number of dropped messages is logged instead.
+    pub fn start_background_writer(&'static self) {
+        let mut thread = self
+            .background
+            .thread
+            .lock()
+            .expect("Someone poisoned logger's thread mutex");
+        if thread.is_some() {
+            return;
+        }
+
+        self.background.lock_queue().running = true;
+        *thread = Some(std::thread::spawn(move || self.background.run(&self.files)));
+    }
+
+    /// Writes out all queued messages and goes back to writing messages immediately.
+    pub fn stop_background_writer(&self) {
+        let thread = self
+            .background
+            .thread
+            .lock()
+            .expect("Someone poisoned logger's thread mutex")
+            .take();
+        let Some(thread) = thread else {
+            return;
+        };
+
+        self.background.lock_queue().running = false;
+        self.background.messages_queued.notify_one();
+        let _ = thread.join();
+    }
+
+    /// Blocks until all messages logged so far are written out.
+    pub fn flush(&self) {
+        self.background.flush();
+    }
+
     /// Sets maximum "importance level" of the messages that will be written to the log.
     ///
     /// For example, after the call to set_loglevel(Level::Error), only UserError, Critical, and
@@ -839,4 +1201,142 @@ mod tests {
             }
         }
     }
+
+    #[test]
+    fn t_background_writer_writes_messages_after_flush() {
+        let (_tmp, logfile, error_logfile, logger) = setup_logger().unwrap();
+        let logger: &'static Logger = Box::leak(Box::new(logger));
+        logger.set_loglevel(Level::Debug);
+
+        logger.start_background_writer();
+        for i in 0..100 {
+            logger.log(Level::Debug, &format!("message #{i}"));
+        }
+        logger.log(Level::UserError, "user error");
+        logger.flush();
+
+        log_contains_n_lines(&logfile, 101).unwrap();
+        log_contains_n_lines(&error_logfile, 1).unwrap();
+
+        let contents = std::fs::read_to_string(&logfile).unwrap();
+        for (i, line) in contents.lines().take(100).enumerate() {
+            let (_, level, message) = parse_log_line(line).unwrap();
+            assert_eq!(level, "DEBUG");
+            assert_eq!(message, format!("message #{i}"));
+        }
+
+        // After the writer is stopped, messages are written immediately again.
+        logger.stop_background_writer();
+        logger.log(Level::Info, "sync");
+        log_contains_n_lines(&logfile, 102).unwrap();
+    }
+
+    #[test]
+    fn t_background_writer_keeps_errors_when_the_queue_is_full() {
+        let (_tmp, logfile, error_logfile, logger) = setup_logger().unwrap();
+        logger.set_loglevel(Level::Debug);
+
+        // Without a thread to write them out, messages pile up in the queue.
+        logger.background.lock_queue().running = true;
+        logger.log(Level::Debug, &"x".repeat(MAX_QUEUED_BYTES - 100));
+        logger.log(Level::Debug, &"dropped".repeat(100));
+        logger.log(Level::UserError, "user error");
+        logger.log(Level::Error, "error");
+
+        logger.background.lock_queue().running = false;
+        logger.background.run(&logger.files);
+
+        log_contains_n_lines(&error_logfile, 1).unwrap();
+        let contents = std::fs::read_to_string(&error_logfile).unwrap();
+        let (_, message) = parse_errorlog_line(contents.trim_end()).unwrap();
+        assert_eq!(message, "user error");
+
+        let contents = std::fs::read_to_string(&logfile).unwrap();
+        let messages: Vec<(&str, &str)> = contents
+            .lines()
+            .map(|line| {
+                let (_, level, message) = parse_log_line(line).unwrap();
+                (level, message)
+            })
+            .filter(|(_, message)| !message.starts_with('x'))
+            .collect();
+        assert_eq!(
+            messages,
+            vec![
+                (
+                    "WARNING",
+                    "Logger: dropped 1 messages because the disk couldn't keep up"
+                ),
+                ("USERERROR", "user error"),
+                ("ERROR", "error"),
+            ]
+        );
+    }
+
+    #[test]
+    fn t_logfile_is_rotated_once_it_exceeds_maximum_size() {
+        let (_tmp, logfile, _error_logfile, logger) = setup_logger().unwrap();
+        logger.set_loglevel(Level::Debug);
+        logger.set_max_logfile_size(100);
+
+        // Each line is 40 bytes long, so the third one pushes the log over the limit.
+        for i in 0..3 {
+            logger.log(Level::Debug, &format!("message #{i}"));
+        }
+
+        let mut rotated = logfile.clone().into_os_string();
+        rotated.push(".1");
+        log_contains_n_lines(path::Path::new(&rotated), 3).unwrap();
+        log_contains_n_lines(&logfile, 0).unwrap();
+
+        logger.log(Level::Debug, "message #3");
+        log_contains_n_lines(&logfile, 1).unwrap();
+    }
+
+    #[test]
+    fn t_format_fields_quotes_values_only_when_necessary() {
+        let line = format_fields(
+            "Event",
+            &[
+                ("url", b"https://example.com/feed.xml"),
+                ("title", b"Hello, \"world\"\n"),
+                ("empty", b""),
+            ],
+        );
+        assert_eq!(
+            String::from_utf8(line).unwrap(),
+            r#"Event url=https://example.com/feed.xml title="Hello, \"world\"\n" empty="""#
+        );
+    }
+
+    #[test]
+    fn t_format_fields_truncates_long_values_and_adds_their_length_and_digest() {
+        // "ä" takes two bytes, so the limit falls in the middle of a character.
+        let body = format!("a{}", "ä".repeat(MAX_FIELD_LENGTH));
+        let line = format_fields("Event", &[("body", body.as_bytes())]);
+        let line = String::from_utf8(line).expect("Truncation split a character");
+
+        let expected_prefix = format!("Event body=a{}...", "ä".repeat(MAX_FIELD_LENGTH / 2 - 1));
+        assert!(line.starts_with(&expected_prefix));
+        assert!(line.ends_with(&format!(
+            " body_length={} body_md5={:x}",
+            body.len(),
+            md5::compute(&body)
+        )));
+    }
+
+    #[test]
+    fn t_log_fields_respects_loglevel() {
+        let (_tmp, logfile, _error_logfile, logger) = setup_logger().unwrap();
+        logger.set_loglevel(Level::Info);
+
+        logger.log_fields(Level::Debug, "Hidden", &[("key", b"value")]);
+        logger.log_fields(Level::Info, "Shown", &[("key", b"value")]);
+
+        log_contains_n_lines(&logfile, 1).unwrap();
+        let contents = std::fs::read_to_string(&logfile).unwrap();
+        let (_, level, message) = parse_log_line(contents.trim_end()).unwrap();
+        assert_eq!(level, "INFO");
+        assert_eq!(message, "Shown key=value");
+    }
 }
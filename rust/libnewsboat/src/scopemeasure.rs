@@ -1,5 +1,15 @@
 //! Measures time spent in a given scope, and writes it to the log.
+//!
+//! Measurements are also aggregated per scope name (see `scope_stats()`), and can be recorded into
+//! a trace file (see `start_tracing()`), which can be opened in Chrome's `about:tracing` or in
+//! Perfetto to see how scopes nest across threads.
 
+use std::collections::HashMap;
+use std::fs::File;
+use std::io::{self, BufWriter, Write};
+use std::path::Path;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
 use std::time::Instant;
 
 use crate::{
@@ -17,6 +27,10 @@ use crate::{
 /// Calling `stopover()` will write a debug message to the log mentioning: 1) the name of the
 /// enclosing scope; 2) the name of the stopover; 3) the time that elapsed between constructing the
 /// object and calling `stopover()`.
+///
+/// The time spent in the scope is also added to the statistics of `scope_name` (see
+/// `scope_stats()`). If tracing is enabled, the scope and its stopovers are also written to the
+/// trace file.
 pub struct ScopeMeasure {
     start_time: Instant,
     scope_name: String,
@@ -42,18 +56,489 @@ impl ScopeMeasure {
                 self.start_time.elapsed().as_secs_f64()
             )
         );
+
+        if is_tracing() {
+            let name = format!("{}: {stopover_name}", self.scope_name);
+            trace_event(&name, 'i', Instant::now(), None);
+        }
     }
 }
 
 impl Drop for ScopeMeasure {
     fn drop(&mut self) {
+        let elapsed = self.start_time.elapsed();
         log!(
             Level::Debug,
             &format!(
                 "ScopeMeasure: function `{}' took {:.6} s",
                 self.scope_name,
-                self.start_time.elapsed().as_secs_f64()
+                elapsed.as_secs_f64()
             )
         );
+
+        record_duration(&self.scope_name, elapsed.as_micros() as u64);
+
+        if is_tracing() {
+            trace_event(
+                &self.scope_name,
+                'X',
+                self.start_time,
+                Some(elapsed.as_micros()),
+            );
+        }
+    }
+}
+
+/// Number of sub-buckets per power of two in `Histogram`. Values are thus rounded down by less
+/// than 1/16 (6.25%).
+const SUB_BUCKET_BITS: u32 = 4;
+const SUB_BUCKETS: u64 = 1 << SUB_BUCKET_BITS;
+/// Enough buckets to cover all of `u64`.
+const BUCKETS: usize = ((64 - SUB_BUCKET_BITS + 1) as usize) * (SUB_BUCKETS as usize);
+
+/// Scopes beyond this many distinct names are not aggregated, so that a scope whose name is
+/// built at runtime can't eat up memory.
+const MAX_SCOPES: usize = 1000;
+
+/// Log-linear histogram of durations in microseconds, in the spirit of HdrHistogram: each power
+/// of two is split into `SUB_BUCKETS` equal buckets, so the relative error is the same for short
+/// and long durations.
+struct Histogram {
+    buckets: Vec<u64>,
+    count: u64,
+    sum: u64,
+    min: u64,
+    max: u64,
+}
+
+impl Histogram {
+    fn new() -> Histogram {
+        Histogram {
+            buckets: vec![0; BUCKETS],
+            count: 0,
+            sum: 0,
+            min: u64::MAX,
+            max: 0,
+        }
+    }
+
+    fn bucket_index(value: u64) -> usize {
+        if value < SUB_BUCKETS {
+            return value as usize;
+        }
+        let exponent = 63 - value.leading_zeros();
+        let sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        ((exponent - SUB_BUCKET_BITS + 1) as usize) * (SUB_BUCKETS as usize) + sub_bucket as usize
+    }
+
+    /// Smallest value that falls into the bucket at `index`.
+    fn bucket_start(index: usize) -> u64 {
+        let sub_buckets = SUB_BUCKETS as usize;
+        if index < sub_buckets {
+            return index as u64;
+        }
+        let exponent = (index / sub_buckets) as u32 + SUB_BUCKET_BITS - 1;
+        let sub_bucket = (index % sub_buckets) as u64;
+        (SUB_BUCKETS + sub_bucket) << (exponent - SUB_BUCKET_BITS)
+    }
+
+    fn record(&mut self, value: u64) {
+        self.buckets[Histogram::bucket_index(value)] += 1;
+        self.count += 1;
+        self.sum = self.sum.saturating_add(value);
+        self.min = self.min.min(value);
+        self.max = self.max.max(value);
+    }
+
+    fn merge(&mut self, other: &Histogram) {
+        for (bucket, &other_count) in self.buckets.iter_mut().zip(other.buckets.iter()) {
+            *bucket += other_count;
+        }
+        self.count += other.count;
+        self.sum = self.sum.saturating_add(other.sum);
+        self.min = self.min.min(other.min);
+        self.max = self.max.max(other.max);
+    }
+
+    /// Value below which `quantile` (0.0 to 1.0) of recorded values lie, rounded down to its
+    /// bucket.
+    fn percentile(&self, quantile: f64) -> u64 {
+        if self.count == 0 {
+            return 0;
+        }
+        let rank = ((quantile * self.count as f64).ceil() as u64).clamp(1, self.count);
+        let mut seen = 0;
+        for (index, &bucket_count) in self.buckets.iter().enumerate() {
+            seen += bucket_count;
+            if seen >= rank {
+                return Histogram::bucket_start(index).clamp(self.min, self.max);
+            }
+        }
+        self.max
+    }
+}
+
+/// Aggregated durations of all `ScopeMeasure`s with the same name.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ScopeStats {
+    pub scope_name: String,
+    pub count: u64,
+    /// All durations are in microseconds.
+    pub total_us: u64,
+    pub min_us: u64,
+    pub max_us: u64,
+    pub p50_us: u64,
+    pub p90_us: u64,
+    pub p99_us: u64,
+}
+
+type Histograms = HashMap<String, Histogram>;
+
+/// Histograms of all threads, merged when statistics are read.
+///
+/// Each thread records into its own histograms, so measuring a scope only takes a lock that no
+/// other thread contends for (except while statistics are being read). When a thread exits, its
+/// histograms are merged into `retired`.
+struct Registry {
+    threads: Vec<Arc<Mutex<Histograms>>>,
+    retired: Histograms,
+}
+
+fn get_registry() -> &'static Mutex<Registry> {
+    static REGISTRY: OnceLock<Mutex<Registry>> = OnceLock::new();
+    REGISTRY.get_or_init(|| {
+        Mutex::new(Registry {
+            threads: Vec::new(),
+            retired: HashMap::new(),
+        })
+    })
+}
+
+fn lock_registry() -> std::sync::MutexGuard<'static, Registry> {
+    get_registry()
+        .lock()
+        .expect("Someone poisoned the scope statistics' mutex")
+}
+
+fn merge_into(target: &mut Histograms, source: &Histograms) {
+    for (scope_name, histogram) in source {
+        if let Some(existing) = target.get_mut(scope_name) {
+            existing.merge(histogram);
+        } else if target.len() < MAX_SCOPES {
+            let mut copy = Histogram::new();
+            copy.merge(histogram);
+            target.insert(scope_name.clone(), copy);
+        }
+    }
+}
+
+/// The current thread's histograms, registered with the `Registry` for as long as the thread
+/// lives.
+struct ThreadHistograms(Arc<Mutex<Histograms>>);
+
+impl ThreadHistograms {
+    fn new() -> ThreadHistograms {
+        let histograms = Arc::new(Mutex::new(HashMap::new()));
+        lock_registry().threads.push(Arc::clone(&histograms));
+        ThreadHistograms(histograms)
+    }
+}
+
+impl Drop for ThreadHistograms {
+    fn drop(&mut self) {
+        // Locks are taken in the same order as in `scope_stats()`: registry first.
+        let mut registry = lock_registry();
+        registry
+            .threads
+            .retain(|other| !Arc::ptr_eq(other, &self.0));
+        let histograms = self
+            .0
+            .lock()
+            .expect("Someone poisoned the scope statistics' mutex");
+        merge_into(&mut registry.retired, &histograms);
+    }
+}
+
+thread_local! {
+    static THREAD_HISTOGRAMS: ThreadHistograms = ThreadHistograms::new();
+}
+
+fn record_duration(scope_name: &str, duration_us: u64) {
+    // Fails if the thread is already being torn down; the measurement is dropped then.
+    let _ = THREAD_HISTOGRAMS.try_with(|thread_histograms| {
+        let mut histograms = thread_histograms
+            .0
+            .lock()
+            .expect("Someone poisoned the scope statistics' mutex");
+        if let Some(histogram) = histograms.get_mut(scope_name) {
+            histogram.record(duration_us);
+        } else if histograms.len() < MAX_SCOPES {
+            let mut histogram = Histogram::new();
+            histogram.record(duration_us);
+            histograms.insert(scope_name.to_owned(), histogram);
+        }
+    });
+}
+
+/// Statistics of all scopes measured so far, the ones that took the most time in total first.
+pub fn scope_stats() -> Vec<ScopeStats> {
+    let histograms = {
+        let registry = lock_registry();
+        let mut merged = HashMap::new();
+        merge_into(&mut merged, &registry.retired);
+        for thread in &registry.threads {
+            let histograms = thread
+                .lock()
+                .expect("Someone poisoned the scope statistics' mutex");
+            merge_into(&mut merged, &histograms);
+        }
+        merged
+    };
+    let mut result: Vec<ScopeStats> = histograms
+        .iter()
+        .map(|(scope_name, histogram)| ScopeStats {
+            scope_name: scope_name.clone(),
+            count: histogram.count,
+            total_us: histogram.sum,
+            min_us: histogram.min,
+            max_us: histogram.max,
+            p50_us: histogram.percentile(0.5),
+            p90_us: histogram.percentile(0.9),
+            p99_us: histogram.percentile(0.99),
+        })
+        .collect();
+    result.sort_by(|a, b| {
+        b.total_us
+            .cmp(&a.total_us)
+            .then_with(|| a.scope_name.cmp(&b.scope_name))
+    });
+    result
+}
+
+/// Forgets all statistics collected so far.
+pub fn reset_scope_stats() {
+    let mut registry = lock_registry();
+    registry.retired.clear();
+    for thread in &registry.threads {
+        thread
+            .lock()
+            .expect("Someone poisoned the scope statistics' mutex")
+            .clear();
+    }
+}
+
+fn format_duration(us: u64) -> String {
+    if us < 10_000 {
+        format!("{us} us")
+    } else if us < 10_000_000 {
+        format!("{:.1} ms", us as f64 / 1000.0)
+    } else {
+        format!("{:.1} s", us as f64 / 1_000_000.0)
+    }
+}
+
+/// `scope_stats()` as a table, one line per scope, with a header line.
+pub fn format_scope_stats() -> Vec<String> {
+    let mut lines = vec![format!(
+        "{:<40} {:>8} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}",
+        "Scope", "Count", "Total", "Min", "p50", "p90", "p99", "Max"
+    )];
+    for stats in scope_stats() {
+        lines.push(format!(
+            "{:<40} {:>8} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}",
+            stats.scope_name,
+            stats.count,
+            format_duration(stats.total_us),
+            format_duration(stats.min_us),
+            format_duration(stats.p50_us),
+            format_duration(stats.p90_us),
+            format_duration(stats.p99_us),
+            format_duration(stats.max_us)
+        ));
+    }
+    lines
+}
+
+/// Writes events in Chrome's trace-event format.
+///
+/// The file is a JSON array of events, which is written as events come in. The closing bracket is
+/// added by `stop_tracing()`, but viewers accept the file without it, too.
+struct TraceSink {
+    /// Timestamps of events are relative to this.
+    epoch: Instant,
+    writer: BufWriter<File>,
+    has_events: bool,
+}
+
+static TRACING: AtomicBool = AtomicBool::new(false);
+
+fn get_trace_sink() -> &'static Mutex<Option<TraceSink>> {
+    static SINK: OnceLock<Mutex<Option<TraceSink>>> = OnceLock::new();
+    SINK.get_or_init(|| Mutex::new(None))
+}
+
+fn is_tracing() -> bool {
+    TRACING.load(Ordering::Relaxed)
+}
+
+/// Small sequential number identifying the current thread in the trace.
+fn current_thread_id() -> u64 {
+    static NEXT_ID: AtomicU64 = AtomicU64::new(1);
+    thread_local! {
+        static ID: u64 = NEXT_ID.fetch_add(1, Ordering::Relaxed);
+    }
+    ID.with(|id| *id)
+}
+
+fn escape_json(input: &str) -> String {
+    let mut result = String::with_capacity(input.len());
+    for c in input.chars() {
+        match c {
+            '"' => result.push_str("\\\""),
+            '\\' => result.push_str("\\\\"),
+            c if (c as u32) < 0x20 => result.push_str(&format!("\\u{:04x}", c as u32)),
+            c => result.push(c),
+        }
+    }
+    result
+}
+
+/// Records an event of type `phase` (`X` for a complete scope, `i` for an instant) that happened
+/// at `time`.
+fn trace_event(name: &str, phase: char, time: Instant, duration_us: Option<u128>) {
+    let tid = current_thread_id();
+
+    let mut sink = get_trace_sink()
+        .lock()
+        .expect("Someone poisoned the trace sink's mutex");
+    let Some(sink) = sink.as_mut() else {
+        return;
+    };
+
+    let timestamp_us = time.saturating_duration_since(sink.epoch).as_micros();
+    let mut event = format!(
+        r#"{{"name":"{}","ph":"{phase}","ts":{timestamp_us},"pid":{},"tid":{tid}"#,
+        escape_json(name),
+        std::process::id()
+    );
+    match duration_us {
+        Some(duration_us) => event.push_str(&format!(r#","dur":{duration_us}}}"#)),
+        None => event.push_str(r#","s":"t"}"#),
+    }
+
+    let separator = if sink.has_events { ",\n" } else { "\n" };
+    sink.has_events = true;
+    // Ignoring the error for the same reason the logger does: tracing is a debugging aid, and
+    // shouldn't get in the way of the program.
+    let _ = sink.writer.write_all(separator.as_bytes());
+    let _ = sink.writer.write_all(event.as_bytes());
+}
+
+/// Starts recording all scopes and stopovers, from all threads, into the file at `path`.
+///
+/// The file is truncated. Calling this while tracing is already on switches to the new file.
+pub fn start_tracing(path: &Path) -> io::Result<()> {
+    let mut writer = BufWriter::new(File::create(path)?);
+    writer.write_all(b"[")?;
+
+    stop_tracing();
+    let mut sink = get_trace_sink()
+        .lock()
+        .expect("Someone poisoned the trace sink's mutex");
+    *sink = Some(TraceSink {
+        epoch: Instant::now(),
+        writer,
+        has_events: false,
+    });
+    TRACING.store(true, Ordering::Relaxed);
+    Ok(())
+}
+
+/// Finishes the trace file, if any. Scopes that end after this are not recorded.
+pub fn stop_tracing() {
+    TRACING.store(false, Ordering::Relaxed);
+    let mut sink = get_trace_sink()
+        .lock()
+        .expect("Someone poisoned the trace sink's mutex");
+    if let Some(mut sink) = sink.take() {
+        let _ = sink.writer.write_all(b"\n]\n");
+        let _ = sink.writer.flush();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn t_histogram_buckets_cover_values_without_gaps() {
+        for value in (0..100_000).chain([u64::MAX / 2, u64::MAX]) {
+            let index = Histogram::bucket_index(value);
+            assert!(index < BUCKETS);
+            assert!(Histogram::bucket_start(index) <= value);
+            if index + 1 < BUCKETS {
+                assert!(Histogram::bucket_start(index + 1) > value);
+            }
+        }
+    }
+
+    #[test]
+    fn t_histogram_percentiles_are_within_a_bucket_of_the_exact_value() {
+        let mut histogram = Histogram::new();
+        for value in 1..=1000 {
+            histogram.record(value);
+        }
+
+        assert_eq!(histogram.count, 1000);
+        assert_eq!(histogram.sum, 500_500);
+        assert_eq!(histogram.min, 1);
+        assert_eq!(histogram.max, 1000);
+
+        let check = |quantile: f64, exact: u64| {
+            let estimate = histogram.percentile(quantile);
+            assert!(estimate <= exact);
+            assert!(exact - estimate <= exact / SUB_BUCKETS);
+        };
+        check(0.5, 500);
+        check(0.9, 900);
+        check(0.99, 990);
+        assert_eq!(histogram.percentile(1.0), 992);
+    }
+
+    #[test]
+    fn t_merged_histogram_equals_one_that_recorded_all_values() {
+        let mut all = Histogram::new();
+        let mut odd = Histogram::new();
+        let mut even = Histogram::new();
+        for value in 1..=1000 {
+            all.record(value);
+            if value % 2 == 0 {
+                even.record(value);
+            } else {
+                odd.record(value);
+            }
+        }
+
+        let mut merged = Histogram::new();
+        merged.merge(&odd);
+        merged.merge(&even);
+
+        assert_eq!(merged.buckets, all.buckets);
+        assert_eq!(merged.count, all.count);
+        assert_eq!(merged.sum, all.sum);
+        assert_eq!(merged.min, all.min);
+        assert_eq!(merged.max, all.max);
+    }
+
+    #[test]
+    fn t_empty_histogram_has_zero_percentiles() {
+        assert_eq!(Histogram::new().percentile(0.5), 0);
+    }
+
+    #[test]
+    fn t_escape_json_escapes_quotes_backslashes_and_control_characters() {
+        assert_eq!(escape_json("plain"), "plain");
+        assert_eq!(escape_json(r#"a "b" \c"#), r#"a \"b\" \\c"#);
+        assert_eq!(escape_json("line\nbreak"), "line\\u000abreak");
     }
 }
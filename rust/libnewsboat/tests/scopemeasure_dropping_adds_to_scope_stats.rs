@@ -0,0 +1,36 @@
+use libnewsboat::scopemeasure::{self, ScopeMeasure};
+
+#[test]
+fn dropping_a_scopemeasure_adds_to_scope_stats() {
+    scopemeasure::reset_scope_stats();
+
+    for _ in 0..3 {
+        let _sm = ScopeMeasure::new(String::from("repeated"));
+    }
+    {
+        let _sm = ScopeMeasure::new(String::from("once"));
+    }
+
+    let stats = scopemeasure::scope_stats();
+    assert_eq!(stats.len(), 2);
+
+    let repeated = stats.iter().find(|s| s.scope_name == "repeated").unwrap();
+    assert_eq!(repeated.count, 3);
+    assert!(repeated.min_us <= repeated.p50_us);
+    assert!(repeated.p99_us <= repeated.max_us);
+
+    let once = stats.iter().find(|s| s.scope_name == "once").unwrap();
+    assert_eq!(once.count, 1);
+
+    let lines = scopemeasure::format_scope_stats();
+    assert_eq!(lines.len(), 3);
+    assert!(lines[0].starts_with("Scope"));
+    let columns: Vec<&str> = lines[0].split_whitespace().collect();
+    assert_eq!(
+        columns,
+        ["Scope", "Count", "Total", "Min", "p50", "p90", "p99", "Max"]
+    );
+
+    scopemeasure::reset_scope_stats();
+    assert!(scopemeasure::scope_stats().is_empty());
+}
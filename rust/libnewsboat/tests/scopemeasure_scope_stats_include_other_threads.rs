@@ -0,0 +1,45 @@
+use libnewsboat::scopemeasure::{self, ScopeMeasure};
+use std::sync::mpsc;
+use std::thread;
+
+#[test]
+fn scope_stats_include_scopes_measured_on_other_threads() {
+    scopemeasure::reset_scope_stats();
+
+    // This thread is done by the time statistics are read
+    thread::spawn(|| {
+        let _sm = ScopeMeasure::new(String::from("shared"));
+    })
+    .join()
+    .unwrap();
+
+    // This one is still running
+    let (measured_tx, measured_rx) = mpsc::channel();
+    let (done_tx, done_rx) = mpsc::channel::<()>();
+    let running = thread::spawn(move || {
+        {
+            let _sm = ScopeMeasure::new(String::from("shared"));
+        }
+        measured_tx.send(()).unwrap();
+        let _ = done_rx.recv();
+    });
+    measured_rx.recv().unwrap();
+
+    {
+        let _sm = ScopeMeasure::new(String::from("shared"));
+    }
+
+    let stats = scopemeasure::scope_stats();
+    assert_eq!(stats.len(), 1);
+    assert_eq!(stats[0].scope_name, "shared");
+    assert_eq!(stats[0].count, 3);
+
+    drop(done_tx);
+    running.join().unwrap();
+
+    // Once the second thread is gone, its measurement is still there
+    assert_eq!(scopemeasure::scope_stats()[0].count, 3);
+
+    scopemeasure::reset_scope_stats();
+    assert!(scopemeasure::scope_stats().is_empty());
+}
@@ -0,0 +1,29 @@
+use libnewsboat::scopemeasure::{self, ScopeMeasure};
+use std::fs;
+use tempfile::TempDir;
+
+#[test]
+fn tracing_writes_scopes_and_stopovers_to_the_trace_file() {
+    let tmp = TempDir::new().unwrap();
+    let tracefile = tmp.path().join("trace.json");
+
+    scopemeasure::start_tracing(&tracefile).unwrap();
+    {
+        let outer = ScopeMeasure::new(String::from("outer \"scope\""));
+        outer.stopover("halfway");
+        let _inner = ScopeMeasure::new(String::from("inner"));
+    }
+    scopemeasure::stop_tracing();
+
+    // Not recorded, since tracing is stopped
+    drop(ScopeMeasure::new(String::from("after")));
+
+    let trace = fs::read_to_string(&tracefile).unwrap();
+    assert!(trace.starts_with('['));
+    assert!(trace.trim_end().ends_with(']'));
+    assert!(trace.contains(r#""name":"outer \"scope\"","ph":"X""#));
+    assert!(trace.contains(r#""name":"outer \"scope\": halfway","ph":"i""#));
+    assert!(trace.contains(r#""name":"inner","ph":"X""#));
+    assert!(!trace.contains("after"));
+    assert_eq!(trace.matches("\"tid\":").count(), 3);
+}
@@ -0,0 +1,96 @@
+#include "bandwidthscheduler.h"
+
+#include <vector>
+
+namespace podboat {
+
+namespace {
+
+/// How long a download may receive at the full rate after having been idle.
+const double BURST_SECONDS = 0.25;
+
+} // namespace
+
+BandwidthScheduler::BandwidthScheduler(double bytes_per_second)
+	: rate(bytes_per_second)
+	, capacity(bytes_per_second * BURST_SECONDS)
+{
+}
+
+void BandwidthScheduler::add(const Download* download)
+{
+	// Start with an empty bucket, so a new download doesn't get a burst at
+	// the expense of the others.
+	buckets.emplace(download, 0.0);
+}
+
+void BandwidthScheduler::remove(const Download* download)
+{
+	buckets.erase(download);
+}
+
+void BandwidthScheduler::refill(std::chrono::steady_clock::time_point now)
+{
+	if (last_refill == std::chrono::steady_clock::time_point()) {
+		// The first call only starts the clock.
+		last_refill = now;
+		return;
+	}
+	const std::chrono::duration<double> elapsed = now - last_refill;
+	last_refill = now;
+	if (!limited() || elapsed.count() <= 0) {
+		return;
+	}
+
+	double budget = rate * elapsed.count();
+	std::vector<double*> hungry;
+	while (budget > 0) {
+		hungry.clear();
+		for (auto& bucket : buckets) {
+			if (bucket.second < capacity) {
+				hungry.push_back(&bucket.second);
+			}
+		}
+		if (hungry.empty()) {
+			// Everyone is full; the rest of the budget is lost, as it
+			// would be if the downloads were idle.
+			break;
+		}
+
+		const double share = budget / hungry.size();
+		budget = 0;
+		for (double* tokens : hungry) {
+			const double room = capacity - *tokens;
+			if (share < room) {
+				*tokens += share;
+			} else {
+				// Each round fills up at least one bucket, so this loop
+				// ends after at most as many rounds as there are buckets.
+				*tokens = capacity;
+				budget += share - room;
+			}
+		}
+	}
+}
+
+bool BandwidthScheduler::may_receive(const Download* download) const
+{
+	if (!limited()) {
+		return true;
+	}
+	const auto it = buckets.find(download);
+	return it != buckets.end() && it->second > 0;
+}
+
+void BandwidthScheduler::consume(const Download* download, std::size_t bytes)
+{
+	const auto it = buckets.find(download);
+	if (limited() && it != buckets.end()) {
+		// Data that's already been received has to be accepted, so the
+		// bucket can go into debt; it has to be paid off before the
+		// download receives anything else.
+		it->second -= bytes;
+	}
+}
+
+} // namespace podboat
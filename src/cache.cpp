@@ -1,14 +1,18 @@
 #include "cache.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cinttypes>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <iterator>
 #include <iostream>
 #include <sqlite3.h>
 #include <sstream>
 #include <time.h>
+#include <unordered_set>
 
 #include "config.h"
 #include "configcontainer.h"
@@ -23,6 +27,30 @@
 
 namespace newsboat {
 
+static std::atomic<std::uint64_t> statement_counter(0);
+
+static int count_statement(unsigned int /* type */, void* /* context */,
+	void* /* statement */, void* /* sql */)
+{
+	statement_counter.fetch_add(1, std::memory_order_relaxed);
+	return 0;
+}
+
+// Statements are only counted while someone asked for it, since the trace
+// callback costs a little on every statement.
+static std::mutex counting_mtx;
+static unsigned int counting_requests = 0;
+static std::unordered_set<sqlite3*> open_databases;
+
+static void set_statement_trace(sqlite3* db, bool enabled)
+{
+	if (enabled) {
+		sqlite3_trace_v2(db, SQLITE_TRACE_STMT, count_statement, nullptr);
+	} else {
+		sqlite3_trace_v2(db, 0, nullptr, nullptr);
+	}
+}
+
 inline void Cache::run_sql_impl(const std::string& query,
 	int (*callback)(void*, int, char**, char**),
 	void* callback_argument,
@@ -126,6 +154,25 @@ static int rssfeed_callback(void* myfeed, int argc, char** argv,
 	return 0;
 }
 
+static int feed_summary_callback(void* mysummaries, int argc, char** argv,
+	char** /* azColName */)
+{
+	auto* summaries = static_cast<FeedSummaries*>(mysummaries);
+	assert(argc == 7);
+	assert(argv[0] != nullptr);
+
+	FeedSummary summary;
+	summary.title = argv[1] ? argv[1] : "";
+	summary.link = argv[2] ? argv[2] : "";
+	summary.is_rtl = argv[3] && strcmp(argv[3], "1") == 0;
+	summary.total_count = argv[4] ? utils::to_u(argv[4]) : 0;
+	// total() always returns a floating-point value, e.g. "3.0"
+	summary.unread_count = argv[5] ? std::strtoul(argv[5], nullptr, 10) : 0;
+	summary.latest_item_timestamp = argv[6] ? std::strtoll(argv[6], nullptr, 10) : 0;
+	summaries->emplace(argv[0], summary);
+	return 0;
+}
+
 static int lastmodified_callback(void* handler,
 	int argc,
 	char** argv,
@@ -213,7 +260,11 @@ static int fill_content_callback(void* myfeed,
 	if (argv[0]) {
 		std::shared_ptr<RssItem> item =
 			feed->get_item_by_guid_unlocked(argv[0]);
-		item->set_description(argv[1] ? argv[1] : "", argv[2] ? argv[2] : "");
+		const Description description{
+			argv[1] ? argv[1] : "",
+			argv[2] ? argv[2] : ""};
+		item->set_description(description.text, description.mime);
+		item->set_description_stored(description);
 	}
 	return 0;
 }
@@ -275,10 +326,22 @@ Cache::Cache(const std::string& cachefile, ConfigContainer* c)
 		throw DbException(db);
 	}
 
-	populate_tables();
-	set_pragmas();
+	{
+		std::lock_guard<std::mutex> guard(counting_mtx);
+		open_databases.insert(db);
+		if (counting_requests > 0) {
+			set_statement_trace(db, true);
+		}
+	}
 
-	clean_old_articles();
+	try {
+		populate_tables();
+		set_pragmas();
+	} catch (...) {
+		std::lock_guard<std::mutex> guard(counting_mtx);
+		open_databases.erase(db);
+		throw;
+	}
 
 	// we need to manually lock all DB operations because SQLite has no
 	// explicit support for multithreading.
@@ -286,9 +349,35 @@ Cache::Cache(const std::string& cachefile, ConfigContainer* c)
 
 Cache::~Cache()
 {
+	{
+		std::lock_guard<std::mutex> guard(counting_mtx);
+		open_databases.erase(db);
+	}
 	sqlite3_close(db);
 }
 
+std::uint64_t Cache::executed_statements()
+{
+	return statement_counter.load(std::memory_order_relaxed);
+}
+
+void Cache::set_statement_counting(bool enabled)
+{
+	std::lock_guard<std::mutex> guard(counting_mtx);
+	const bool was_counting = counting_requests > 0;
+	if (enabled) {
+		counting_requests++;
+	} else if (counting_requests > 0) {
+		counting_requests--;
+	}
+	const bool counting = counting_requests > 0;
+	if (counting != was_counting) {
+		for (sqlite3* open_db : open_databases) {
+			set_statement_trace(open_db, counting);
+		}
+	}
+}
+
 void Cache::set_pragmas()
 {
 	std::lock_guard<std::recursive_mutex> lock(mtx);
@@ -397,6 +486,11 @@ static const schema_patches schemaPatches{
 			"ALTER TABLE rss_item ADD COLUMN enclosure_description_mime_type VARCHAR(128) NOT NULL DEFAULT \"\";",
 		}
 	},
+	{	{2, 35},
+		{
+			"ALTER TABLE rss_feed ADD COLUMN sync_cursor VARCHAR(128) NOT NULL DEFAULT \"\";",
+		}
+	},
 
 	// Note: schema changes should use the version number of the release that introduced them.
 };
@@ -493,6 +587,77 @@ void Cache::update_lastmodified(const std::string& feedurl,
 	run_sql_nothrow(query);
 }
 
+std::string Cache::fetch_sync_cursor(const std::string& feedurl)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"SELECT sync_cursor FROM rss_feed WHERE rssurl = '%q';",
+			feedurl);
+	std::string cursor;
+	run_sql(query, single_string_callback, &cursor);
+	return cursor;
+}
+
+void Cache::update_sync_cursor(const std::string& feedurl,
+	const std::string& cursor)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	const std::string query = prepare_query(
+			"UPDATE rss_feed SET sync_cursor = '%q' WHERE rssurl = '%q';",
+			cursor,
+			feedurl);
+	run_sql_nothrow(query);
+}
+
+void Cache::sync_unread_state(const std::string& feedurl,
+	const std::unordered_set<std::string>& unread_guids,
+	const std::unordered_set<std::string>& pending_guids)
+{
+	ScopeMeasure m1("Cache::sync_unread_state");
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+
+	std::unordered_set<std::string> unread_here;
+	run_sql(prepare_query(
+			"SELECT guid FROM rss_item WHERE feedurl = '%q' AND unread = 1;",
+			feedurl),
+		guid_callback,
+		&unread_here);
+	std::unordered_set<std::string> read_here;
+	run_sql(prepare_query(
+			"SELECT guid FROM rss_item WHERE feedurl = '%q' AND unread = 0;",
+			feedurl),
+		guid_callback,
+		&read_here);
+
+	// Usually only a handful of articles change, so only those are updated.
+	// The list may cover many feeds, so we only look up our own articles.
+	std::string now_read;
+	for (const auto& guid : unread_here) {
+		if (unread_guids.count(guid) == 0 && pending_guids.count(guid) == 0) {
+			now_read.append(prepare_query("'%q', ", guid));
+		}
+	}
+	std::string now_unread;
+	for (const auto& guid : read_here) {
+		if (unread_guids.count(guid) != 0 && pending_guids.count(guid) == 0) {
+			now_unread.append(prepare_query("'%q', ", guid));
+		}
+	}
+
+	if (!now_read.empty()) {
+		run_sql(prepare_query(
+				"UPDATE rss_item SET unread = 0 WHERE feedurl = '%q' AND guid IN (%s'');",
+				feedurl,
+				now_read));
+	}
+	if (!now_unread.empty()) {
+		run_sql(prepare_query(
+				"UPDATE rss_item SET unread = 1 WHERE feedurl = '%q' AND guid IN (%s'');",
+				feedurl,
+				now_unread));
+	}
+}
+
 void Cache::mark_item_deleted(const std::string& guid, bool b)
 {
 	std::lock_guard<std::recursive_mutex> lock(mtx);
@@ -550,7 +715,7 @@ void Cache::externalize_rssfeed(std::shared_ptr<RssFeed> feed,
 		run_sql(insertquery);
 	}
 
-	const unsigned int max_items = cfg->get_configvalue_as_int("max-items");
+	const unsigned int max_items = cfg->snapshot()->max_items;
 
 	LOG(Level::INFO,
 		"Cache::externalize_feed: max_items = %u "
@@ -564,7 +729,7 @@ void Cache::externalize_rssfeed(std::shared_ptr<RssFeed> feed,
 			feed->items().begin() + max_items, feed->items().end());
 	}
 
-	const unsigned int days = cfg->get_configvalue_as_int("keep-articles-days");
+	const unsigned int days = cfg->snapshot()->keep_articles_days;
 	const time_t old_time = time(nullptr) - days * 24 * 60 * 60;
 
 	// the reverse iterator is there for the sorting foo below (think about
@@ -609,15 +774,104 @@ std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 			rssurl);
 	run_sql(query, rssfeed_callback, &feed);
 
-	/* ...and then the associated items */
-	query = prepare_query(
+	internalize_items_unlocked(feed, ign);
+	return feed;
+}
+
+FeedSummaries Cache::fetch_feed_summaries()
+{
+	ScopeMeasure m1("Cache::fetch_feed_summaries");
+
+	FeedSummaries summaries;
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	run_sql(
+		"SELECT rss_feed.rssurl, rss_feed.title, rss_feed.url, "
+		"rss_feed.is_rtl, "
+		"count(rss_item.id), total(rss_item.unread), "
+		"max(rss_item.pubDate) "
+		"FROM rss_feed "
+		"LEFT JOIN rss_item "
+		"ON rss_item.feedurl = rss_feed.rssurl AND rss_item.deleted = 0"
+		+ unexpired_condition("rss_item.pubDate") +
+		"GROUP BY rss_feed.rssurl;",
+		feed_summary_callback,
+		&summaries);
+	return summaries;
+}
+
+time_t Cache::fetch_next_expiry()
+{
+	const unsigned int days = cfg->snapshot()->keep_articles_days;
+	if (days == 0) {
+		return 0;
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	std::string oldest;
+	run_sql("SELECT min(pubDate) FROM rss_item WHERE deleted = 0"
+		+ unexpired_condition("pubDate") + ";",
+		single_string_callback,
+		&oldest);
+	if (oldest.empty()) {
+		return 0;
+	}
+	return std::stoll(oldest) + static_cast<time_t>(days) * 24 * 60 * 60;
+}
+
+std::shared_ptr<RssFeed> Cache::internalize_rssfeed_summary(
+	const std::string& rssurl, const FeedSummaries& summaries)
+{
+	std::shared_ptr<RssFeed> feed(new RssFeed(this, rssurl));
+
+	const auto summary = summaries.find(rssurl);
+	if (utils::is_query_url(rssurl) || summary == summaries.end()) {
+		// Either there are no items to load, or they come from other feeds
+		return feed;
+	}
+
+	const FeedSummary& s = summary->second;
+	feed->set_title(s.title);
+	feed->set_link(s.link);
+	feed->set_rtl(s.is_rtl);
+
+	// The counts are exact unless some items are hidden by `ignore-mode
+	// display`; they are corrected once the items are loaded.
+	const unsigned int max_items = cfg->snapshot()->max_items;
+	const unsigned int total =
+		max_items > 0 ? std::min(s.total_count, max_items) : s.total_count;
+	feed->set_summary(std::min(s.unread_count, total), total,
+		s.latest_item_timestamp);
+	feed->set_items_loaded(false);
+
+	return feed;
+}
+
+void Cache::internalize_items(std::shared_ptr<RssFeed> feed, RssIgnores* ign)
+{
+	ScopeMeasure m1("Cache::internalize_items");
+
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	std::lock_guard<std::mutex> feedlock(feed->item_mutex);
+	if (feed->items_loaded()) {
+		return;
+	}
+	internalize_items_unlocked(feed, ign);
+}
+
+void Cache::internalize_items_unlocked(std::shared_ptr<RssFeed> feed,
+	RssIgnores* ign)
+{
+	const std::string& rssurl = feed->rssurl();
+
+	const std::string query = prepare_query(
 			"SELECT guid, title, author, url, pubDate, length(content), "
 			"unread, "
 			"feedurl, enclosure_url, enclosure_type, enclosure_description, enclosure_description_mime_type, "
 			"enqueued, flags, base "
 			"FROM rss_item "
 			"WHERE feedurl = '%q' "
-			"AND deleted = 0 "
+			"AND deleted = 0"
+			+ unexpired_condition("pubDate") +
 			"ORDER BY pubDate DESC, id DESC;",
 			rssurl);
 	run_sql(query, rssitem_callback, &feed);
@@ -630,12 +884,7 @@ std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 	}
 
 	if (ign != nullptr) {
-		auto& items = feed->items();
-		items.erase(
-			std::remove_if(
-				items.begin(),
-				items.end(),
-		[&](std::shared_ptr<RssItem> item) -> bool {
+		feed->erase_items_if([&](const std::shared_ptr<RssItem>& item) -> bool {
 			try
 			{
 				return ign->matches(item.get());
@@ -646,18 +895,18 @@ std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 					ex.what());
 				return false;
 			}
-		}),
-		items.end());
+		});
 	}
 
-	const unsigned int max_items = cfg->get_configvalue_as_int("max-items");
+	const unsigned int max_items = cfg->snapshot()->max_items;
 
 	if (max_items > 0 && feed->total_item_count() > max_items) {
 		std::vector<std::shared_ptr<RssItem>> flagged_items;
 		for (unsigned int j = max_items; j < feed->total_item_count();
 			++j) {
 			if (feed->items()[j]->flags().length() == 0) {
-				delete_item_unlocked(feed->items()[j]);
+				// Deleted later on by delete_overflow_items()
+				overflow_guids.insert(feed->items()[j]->guid());
 			} else {
 				flagged_items.push_back(feed->items()[j]);
 			}
@@ -669,9 +918,13 @@ std::shared_ptr<RssFeed> Cache::internalize_rssfeed(std::string rssurl,
 
 		// if some flagged articles were saved, append them
 		feed->add_items(flagged_items);
+
+		if (overflow_listener && !overflow_guids.empty()) {
+			overflow_listener();
+		}
 	}
-	feed->sort_unlocked(cfg->get_article_sort_strategy());
-	return feed;
+	feed->sort_unlocked(cfg->snapshot()->article_sort_strategy);
+	feed->set_items_loaded(true);
 }
 
 std::vector<std::shared_ptr<RssItem>> Cache::search_for_items(
@@ -693,7 +946,8 @@ std::vector<std::shared_ptr<RssItem>> Cache::search_for_items(
 				"FROM rss_item "
 				"WHERE (title LIKE '%%%q%%' OR content LIKE '%%%q%%') "
 				"AND feedurl = '%q' "
-				"AND deleted = 0 "
+				"AND deleted = 0"
+				+ unexpired_condition("pubDate") +
 				"ORDER BY pubDate DESC, id DESC;",
 				querystr,
 				querystr,
@@ -707,7 +961,8 @@ std::vector<std::shared_ptr<RssItem>> Cache::search_for_items(
 				"enqueued, flags, base "
 				"FROM rss_item "
 				"WHERE (title LIKE '%%%q%%' OR content LIKE '%%%q%%') "
-				"AND deleted = 0 "
+				"AND deleted = 0"
+				+ unexpired_condition("pubDate") +
 				"ORDER BY pubDate DESC,  id DESC;",
 				querystr,
 				querystr);
@@ -764,13 +1019,6 @@ std::unordered_set<std::string> Cache::search_in_items(
 	return items;
 }
 
-void Cache::delete_item_unlocked(const std::shared_ptr<RssItem>& item)
-{
-	const std::string query = prepare_query(
-			"DELETE FROM rss_item WHERE guid = '%q';", item->guid());
-	run_sql(query);
-}
-
 void Cache::do_vacuum()
 {
 	std::lock_guard<std::recursive_mutex> lock(mtx);
@@ -819,7 +1067,7 @@ std::vector<std::string> Cache::cleanup_cache(std::vector<std::shared_ptr<RssFee
 		cleanup_rss_items_statement.push_back(';');
 
 		std::string cleanup_read_items_statement(
-			"UPDATE rss_item SET deleted = 1 WHERE unread = 0");
+			"UPDATE rss_item SET deleted = 1 WHERE unread = 0 AND deleted = 0");
 
 		run_sql(cleanup_rss_feeds_statement);
 		run_sql(cleanup_rss_items_statement);
@@ -871,12 +1119,11 @@ void Cache::update_rssitem_unlocked(std::shared_ptr<RssItem> item,
 					item->guid());
 			run_sql(query, single_string_callback, &content);
 			if (content != description.text) {
-				LOG(Level::DEBUG,
-					"Cache::update_rssitem_unlocked: '%s' "
-					"is "
-					"different from '%s'",
-					content,
-					description.text);
+				LOG_FIELDS(Level::DEBUG,
+					"Cache::update_rssitem_unlocked: content changed", {
+					{"guid", item->guid()},
+					{"old", content},
+					{"new", description.text}});
 				query = prepare_query(
 						"UPDATE rss_item SET unread = 1 WHERE "
 						"guid = '%q';",
@@ -957,6 +1204,7 @@ void Cache::update_rssitem_unlocked(std::shared_ptr<RssItem> item,
 				item->get_base());
 		run_sql(insert);
 	}
+	item->set_description_stored(description);
 }
 
 void Cache::mark_all_read(std::shared_ptr<RssFeed> feed)
@@ -975,27 +1223,20 @@ void Cache::mark_all_read(std::shared_ptr<RssFeed> feed)
 	run_sql(query);
 }
 
-/* this function marks all RssItems (optionally of a certain feed url) as read
- */
-void Cache::mark_all_read(const std::string& feedurl)
+std::vector<std::string> Cache::mark_all_read(const std::string& feedurl)
 {
 	std::lock_guard<std::recursive_mutex> lock(mtx);
 
-	std::string query;
-	if (feedurl.length() > 0) {
-		query = prepare_query(
-				"UPDATE rss_item "
-				"SET unread = '0' "
-				"WHERE unread != '0' "
-				"AND feedurl = '%q';",
-				feedurl);
-	} else {
-		query = prepare_query(
-				"UPDATE rss_item "
-				"SET unread = '0' "
-				"WHERE unread != '0';");
-	}
-	run_sql(query);
+	const std::string condition = feedurl.length() > 0
+		? prepare_query("WHERE unread != '0' AND feedurl = '%q'", feedurl)
+		: "WHERE unread != '0'";
+
+	std::vector<std::string> guids;
+	run_sql("SELECT guid FROM rss_item " + condition + ";",
+		vectorofstring_callback,
+		&guids);
+	run_sql("UPDATE rss_item SET unread = '0' " + condition + ";");
+	return guids;
 }
 
 void Cache::update_rssitem_unread_and_enqueued(RssItem* item,
@@ -1127,30 +1368,111 @@ std::vector<std::string> Cache::get_read_item_guids()
 	return guids;
 }
 
-void Cache::clean_old_articles()
+std::string Cache::unexpired_condition(const std::string& pubdate_column)
+{
+	const unsigned int days = cfg->snapshot()->keep_articles_days;
+	if (days == 0) {
+		return " ";
+	}
+	const time_t old_date = time(nullptr) - days * 24 * 60 * 60;
+	return " AND " + pubdate_column + " >= " + std::to_string(old_date) + " ";
+}
+
+unsigned int Cache::delete_old_articles(unsigned int limit)
 {
+	const unsigned int days = cfg->snapshot()->keep_articles_days;
+	if (days == 0) {
+		return 0;
+	}
+
 	std::lock_guard<std::recursive_mutex> lock(mtx);
+	const time_t old_date = time(nullptr) - days * 24 * 60 * 60;
+	const std::string query = prepare_query(
+			"DELETE FROM rss_item WHERE id IN "
+			"(SELECT id FROM rss_item WHERE pubDate < %d LIMIT %u);",
+			old_date,
+			limit);
+	run_sql(query);
 
-	const unsigned int days = cfg->get_configvalue_as_int("keep-articles-days");
-	if (days > 0) {
-		const time_t old_date = time(nullptr) - days * 24 * 60 * 60;
+	const unsigned int deleted = sqlite3_changes(db);
+	LOG(Level::DEBUG,
+		"Cache::delete_old_articles: deleted %u articles with a pubDate "
+		"older than %" PRId64,
+		deleted,
+		// On GCC, `time_t` is `long int`, which is at least 32 bits long
+		// according to the spec. On x86_64, it's actually 64 bits. Thus,
+		// casting to int64_t is either a no-op, or an up-cast which are
+		// always safe.
+		static_cast<int64_t>(old_date));
+	return deleted;
+}
 
-		const std::string query(prepare_query(
-				"DELETE FROM rss_item WHERE pubDate < %d", old_date));
-		LOG(Level::DEBUG,
-			"Cache::clean_old_articles: about to delete articles "
-			"with a pubDate older than %" PRId64,
-			// On GCC, `time_t` is `long int`, which is at least 32 bits long
-			// according to the spec. On x86_64, it's actually 64 bits. Thus,
-			// casting to int64_t is either a no-op, or an up-cast which are
-			// always safe.
-			static_cast<int64_t>(old_date));
-		run_sql(query);
-	} else {
-		LOG(Level::DEBUG,
-			"Cache::clean_old_articles, days == 0, not cleaning up "
-			"anything");
+void Cache::set_overflow_listener(std::function<void()> listener)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	overflow_listener = std::move(listener);
+}
+
+unsigned int Cache::delete_overflow_items(unsigned int limit)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	if (overflow_guids.empty()) {
+		return 0;
+	}
+
+	const auto batch_size = std::min<std::size_t>(limit, overflow_guids.size());
+	auto batch_end = overflow_guids.begin();
+	std::advance(batch_end, batch_size);
+	std::string guidset("(");
+	for (auto it = overflow_guids.begin(); it != batch_end; ++it) {
+		guidset.append(prepare_query("'%q', ", *it));
 	}
+	guidset.append("'')");
+	overflow_guids.erase(overflow_guids.begin(), batch_end);
+
+	const std::string query = prepare_query(
+			"DELETE FROM rss_item WHERE guid IN %s;", guidset);
+	run_sql(query);
+
+	LOG(Level::DEBUG,
+		"Cache::delete_overflow_items: deleted %" PRIu64 " articles, "
+		"%" PRIu64 " left",
+		static_cast<uint64_t>(batch_size),
+		static_cast<uint64_t>(overflow_guids.size()));
+	return batch_size;
+}
+
+unsigned int Cache::delete_unreachable_feeds(
+	const std::vector<std::string>& feedurls,
+	unsigned int limit)
+{
+	if (!cfg->get_configvalue_as_bool("cleanup-on-quit")) {
+		return 0;
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(mtx);
+	std::string list = "(";
+	for (const auto& feedurl : feedurls) {
+		list.append(prepare_query("'%q', ", feedurl));
+	}
+	list.append("'')");
+
+	run_sql(prepare_query(
+			"DELETE FROM rss_item WHERE id IN "
+			"(SELECT id FROM rss_item WHERE feedurl NOT IN %s LIMIT %u);",
+			list,
+			limit));
+	unsigned int deleted = sqlite3_changes(db);
+	if (deleted == 0) {
+		run_sql(prepare_query(
+				"DELETE FROM rss_feed WHERE rssurl NOT IN %s;", list));
+		deleted = sqlite3_changes(db);
+	}
+
+	LOG(Level::DEBUG,
+		"Cache::delete_unreachable_feeds: deleted %u rows",
+		deleted);
+	return deleted;
 }
 
 void Cache::fetch_descriptions(RssFeed* feed)
@@ -1169,19 +1491,20 @@ void Cache::fetch_descriptions(RssFeed* feed)
 	run_sql(query, fill_content_callback, feed);
 }
 
-std::string Cache::fetch_description(const RssItem& item)
+Description Cache::fetch_description(const RssItem& item)
 {
 	std::lock_guard<std::recursive_mutex> lock(mtx);
 	const std::string in_clause = prepare_query("'%q'", item.guid());
 
 	const std::string query = prepare_query(
-			"SELECT content FROM rss_item WHERE guid = %s;",
+			"SELECT content, content_mime_type FROM rss_item WHERE guid = %s;",
 			in_clause);
 
-	std::string description;
+	Description description;
 	auto store_description = [](void* d, int, char** argv, char**) -> int {
-		auto& desc = *static_cast<std::string*>(d);
-		desc = argv[0] ? argv[0] : "";
+		auto& desc = *static_cast<Description*>(d);
+		desc.text = argv[0] ? argv[0] : "";
+		desc.mime = argv[1] ? argv[1] : "";
 		return 0;
 	};
 
@@ -0,0 +1,150 @@
+#include "cachemaintenance.h"
+
+#include <chrono>
+
+#include "cache.h"
+#include "dbexception.h"
+#include "logger.h"
+
+namespace newsboat {
+
+namespace {
+
+// Gives foreground operations a chance to use the cache between batches.
+const auto BATCH_PAUSE = std::chrono::milliseconds(50);
+
+} // namespace
+
+const unsigned int CacheMaintenance::BATCH_SIZE;
+
+CacheMaintenance::CacheMaintenance(Cache& cache)
+	: cache(cache)
+	, stop_requested(false)
+	, hurry(false)
+	, wake_requested(false)
+{
+	cache.set_overflow_listener([this]() {
+		wake();
+	});
+}
+
+CacheMaintenance::~CacheMaintenance()
+{
+	cache.set_overflow_listener(nullptr);
+	stop();
+}
+
+void CacheMaintenance::start(const std::vector<std::string>& urls)
+{
+	stop();
+
+	set_feedurls(urls);
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stop_requested = false;
+		hurry = false;
+		wake_requested = false;
+	}
+	thread = std::thread(&CacheMaintenance::run, this);
+}
+
+void CacheMaintenance::set_feedurls(const std::vector<std::string>& urls)
+{
+	std::lock_guard<std::mutex> guard(feedurls_mtx);
+	feedurls = urls;
+}
+
+void CacheMaintenance::finish()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		hurry = true;
+	}
+	cv.notify_all();
+	join();
+}
+
+void CacheMaintenance::stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stop_requested = true;
+	}
+	cv.notify_all();
+	join();
+}
+
+void CacheMaintenance::wake()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		wake_requested = true;
+	}
+	cv.notify_all();
+}
+
+void CacheMaintenance::join()
+{
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+bool CacheMaintenance::run_batch()
+{
+	std::lock_guard<std::mutex> guard(feedurls_mtx);
+
+	// Cheapest checks come first; each of them returns 0 once its work is
+	// done.
+	if (cache.delete_overflow_items(BATCH_SIZE) > 0) {
+		return true;
+	}
+	if (cache.delete_old_articles(BATCH_SIZE) > 0) {
+		return true;
+	}
+	if (cache.delete_unreachable_feeds(feedurls, BATCH_SIZE) > 0) {
+		return true;
+	}
+	return false;
+}
+
+void CacheMaintenance::run()
+{
+	LOG(Level::DEBUG, "CacheMaintenance: started");
+
+	unsigned int batches = 0;
+	try {
+		while (true) {
+			while (run_batch()) {
+				batches++;
+
+				std::unique_lock<std::mutex> guard(mtx);
+				cv.wait_for(guard, BATCH_PAUSE, [this]() {
+					return stop_requested || hurry;
+				});
+				if (stop_requested) {
+					LOG(Level::DEBUG,
+						"CacheMaintenance: stopped after %u batches",
+						batches);
+					return;
+				}
+			}
+
+			std::unique_lock<std::mutex> guard(mtx);
+			cv.wait(guard, [this]() {
+				return stop_requested || hurry || wake_requested;
+			});
+			if (stop_requested || !wake_requested) {
+				break;
+			}
+			wake_requested = false;
+		}
+	} catch (const DbException& e) {
+		LOG(Level::ERROR, "CacheMaintenance: aborted: %s", e.what());
+		return;
+	}
+
+	LOG(Level::DEBUG, "CacheMaintenance: done after %u batches", batches);
+}
+
+} // namespace newsboat
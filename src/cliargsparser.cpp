@@ -202,6 +202,29 @@ nonstd::optional<std::string> CliArgsParser::log_file() const
 	return nonstd::nullopt;
 }
 
+bool CliArgsParser::profile_startup() const
+{
+	return newsboat::cliargsparser::bridged::profile_startup(*rs_object);
+}
+
+nonstd::optional<std::string> CliArgsParser::profile_startup_file() const
+{
+	rust::String path;
+	if (newsboat::cliargsparser::bridged::profile_startup_file(*rs_object, path)) {
+		return std::string(path);
+	}
+	return nonstd::nullopt;
+}
+
+nonstd::optional<std::string> CliArgsParser::trace_file() const
+{
+	rust::String path;
+	if (newsboat::cliargsparser::bridged::trace_file(*rs_object, path)) {
+		return std::string(path);
+	}
+	return nonstd::nullopt;
+}
+
 nonstd::optional<Level> CliArgsParser::log_level() const
 {
 	std::int8_t level;
@@ -54,6 +54,7 @@ ConfigContainer::ConfigContainer()
 		"delete-read-articles-on-quit",
 		ConfigData("false", ConfigDataType::BOOL)},
 	{"delete-played-files", ConfigData("false", ConfigDataType::BOOL)},
+	{"description-memory-limit", ConfigData("0", ConfigDataType::INT)},
 	{
 		"display-article-progress",
 		ConfigData("yes", ConfigDataType::BOOL)},
@@ -61,11 +62,17 @@ ConfigContainer::ConfigContainer()
 		"download-filename-format",
 		ConfigData("%?u?%u&%Y-%b-%d-%H%M%S.unknown?",
 			ConfigDataType::STR)},
+	{
+		"download-fsync",
+		ConfigData("no",
+			std::unordered_set<std::string>(
+		{"no", "data", "full"}))},
 	{
 		"download-full-page",
 		ConfigData("false", ConfigDataType::BOOL)},
 	{"download-path", ConfigData("~/", ConfigDataType::PATH)},
 	{"download-retries", ConfigData("1", ConfigDataType::INT)},
+	{"download-segments", ConfigData("4", ConfigDataType::INT)},
 	{"download-timeout", ConfigData("30", ConfigDataType::INT)},
 	{"error-log", ConfigData("", ConfigDataType::PATH)},
 	{"external-url-viewer", ConfigData("", ConfigDataType::PATH)},
@@ -91,6 +98,7 @@ ConfigContainer::ConfigContainer()
 	{"feedbin-passwordfile", ConfigData("", ConfigDataType::PATH)},
 	{"feedbin-passwordeval", ConfigData("", ConfigDataType::STR)},
 	{"feedbin-flag-star", ConfigData("", ConfigDataType::STR)},
+	{"freshrss-bulk-sync", ConfigData("yes", ConfigDataType::BOOL)},
 	{"freshrss-flag-star", ConfigData("", ConfigDataType::STR)},
 	{"freshrss-login", ConfigData("", ConfigDataType::STR)},
 	{"freshrss-min-items", ConfigData("20", ConfigDataType::INT)},
@@ -140,6 +148,9 @@ ConfigContainer::ConfigContainer()
 	{"inoreader-flag-star", ConfigData("", ConfigDataType::STR)},
 	{"inoreader-min-items", ConfigData("20", ConfigDataType::INT)},
 	{"keep-articles-days", ConfigData("0", ConfigDataType::INT)},
+	{"lazy-load-feeds", ConfigData("no", ConfigDataType::BOOL)},
+	{"lazy-load-max-items", ConfigData("0", ConfigDataType::INT)},
+	{"log-file-max-size", ConfigData("0", ConfigDataType::INT)},
 	{
 		"mark-as-read-on-hover",
 		ConfigData("false", ConfigDataType::BOOL)},
@@ -239,6 +250,7 @@ ConfigContainer::ConfigContainer()
 	{"show-title-bar", ConfigData("yes", ConfigDataType::BOOL)},
 	{"show-read-articles", ConfigData("yes", ConfigDataType::BOOL)},
 	{"show-read-feeds", ConfigData("yes", ConfigDataType::BOOL)},
+	{"subscription-list-timeout", ConfigData("3000", ConfigDataType::INT)},
 	{
 		"suppress-first-reload",
 		ConfigData("no", ConfigDataType::BOOL)},
@@ -246,6 +258,7 @@ ConfigContainer::ConfigContainer()
 		"swap-title-and-hints",
 		ConfigData("no", ConfigDataType::BOOL)},
 	{"text-width", ConfigData("0", ConfigDataType::INT)},
+	{"timing-stats-file", ConfigData("", ConfigDataType::PATH)},
 	{
 		"toggleitemread-jumps-to-next-unread",
 		ConfigData("false", ConfigDataType::BOOL)},
@@ -340,6 +353,8 @@ ConfigContainer::ConfigContainer()
 		ConfigData("no", ConfigDataType::BOOL)},
 }
 {
+	std::lock_guard<std::recursive_mutex> guard(config_data_mtx);
+	publish_snapshot();
 }
 
 ConfigContainer::~ConfigContainer()
@@ -409,6 +424,8 @@ void ConfigContainer::handle_action(const std::string& action,
 		// we already handled this at the beginning of the function
 		break;
 	}
+
+	publish_snapshot();
 }
 
 std::string ConfigContainer::get_configvalue(const std::string& key) const
@@ -463,12 +480,14 @@ void ConfigContainer::set_configvalue(const std::string& key,
 		value);
 	std::lock_guard<std::recursive_mutex> guard(config_data_mtx);
 	config_data[key].set_value(value);
+	publish_snapshot();
 }
 
 void ConfigContainer::reset_to_default(const std::string& key)
 {
 	std::lock_guard<std::recursive_mutex> guard(config_data_mtx);
 	config_data[key].reset_to_default();
+	publish_snapshot();
 }
 
 void ConfigContainer::toggle(const std::string& key)
@@ -618,4 +637,29 @@ ArticleSortStrategy ConfigContainer::get_article_sort_strategy() const
 	return ss;
 }
 
+std::shared_ptr<const ConfigSnapshot> ConfigContainer::snapshot() const
+{
+	return std::atomic_load(&current_snapshot);
+}
+
+void ConfigContainer::publish_snapshot()
+{
+	auto snapshot = std::make_shared<ConfigSnapshot>();
+	snapshot->version = ++snapshot_version;
+	snapshot->articlelist_format = get_configvalue("articlelist-format");
+	snapshot->datetime_format = get_configvalue("datetime-format");
+	snapshot->feedlist_format = get_configvalue("feedlist-format");
+	snapshot->ignore_mode_download = get_configvalue("ignore-mode") == "download";
+	snapshot->keep_articles_days = get_configvalue_as_int("keep-articles-days");
+	snapshot->mark_as_read_on_hover =
+		get_configvalue_as_bool("mark-as-read-on-hover");
+	snapshot->max_items = get_configvalue_as_int("max-items");
+	snapshot->show_read_articles = get_configvalue_as_bool("show-read-articles");
+	snapshot->show_read_feeds = get_configvalue_as_bool("show-read-feeds");
+	snapshot->article_sort_strategy = get_article_sort_strategy();
+
+	std::atomic_store(&current_snapshot,
+		std::shared_ptr<const ConfigSnapshot>(std::move(snapshot)));
+}
+
 } // namespace newsboat
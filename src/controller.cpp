@@ -1,11 +1,15 @@
 #include "controller.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <curl/curl.h>
+#include <fcntl.h>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -23,6 +27,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
 
 #include "cliargsparser.h"
@@ -32,9 +37,11 @@
 #include "configexception.h"
 #include "configpaths.h"
 #include "dbexception.h"
+#include "descriptionbudget.h"
 #include "exception.h"
 #include "feedhqapi.h"
 #include "feedhqurlreader.h"
+#include "feedlistsnapshot.h"
 #include "formaction.h"
 #include "feedbinapi.h"
 #include "feedbinurlreader.h"
@@ -45,6 +52,7 @@
 #include "inoreaderurlreader.h"
 #include "itemrenderer.h"
 #include "logger.h"
+#include "memoryreport.h"
 #include "minifluxapi.h"
 #include "minifluxurlreader.h"
 #include "newsblurapi.h"
@@ -80,6 +88,16 @@ void ignore_signal(int sig)
 	LOG(Level::WARN, "caught signal %d but ignored it", sig);
 }
 
+int timing_stats_pipe[2] = {-1, -1};
+
+void timing_stats_action(int /* sig */)
+{
+	const char c = 0;
+	// Nothing sensible can be done if this fails.
+	const auto written = ::write(timing_stats_pipe[1], &c, 1);
+	(void)written;
+}
+
 Controller::Controller(ConfigPaths& configpaths)
 	: v(0)
 	, urlcfg(0)
@@ -93,8 +111,17 @@ Controller::Controller(ConfigPaths& configpaths)
 
 Controller::~Controller()
 {
+	// Writing the statistics uses the configuration
+	stop_handling_timing_stats_signal();
+	// Has to stop before the cache goes away
+	cache_maintenance.reset();
 	delete rsscache;
 	delete urlcfg;
+	// Has to stop before the API goes away
+	sync_queue.reset();
+	if (api) {
+		api->wait_for_subscription_refresh();
+	}
 	delete api;
 }
 
@@ -108,9 +135,14 @@ int Controller::run(const CliArgsParser& args)
 	::signal(SIGINT, View::ctrl_c_action);
 	::signal(SIGPIPE, ignore_signal);
 	::signal(SIGHUP, sighup_action);
+	handle_timing_stats_signal();
 
 	refresh_on_start = args.refresh_on_start();
 
+	if (args.profile_startup()) {
+		startup_profiler = std::make_unique<StartupProfiler>();
+	}
+
 	if (args.log_level().has_value()) {
 		logger::set_loglevel(args.log_level().value());
 	}
@@ -126,6 +158,11 @@ int Controller::run(const CliArgsParser& args)
 		logger::set_logfile(filename);
 	}
 
+	// Log messages are written by a separate thread from now on; make sure
+	// they reach the disk on every way out of the program.
+	logger::start_background_writer();
+	std::atexit(logger::stop_background_writer);
+
 	if (!args.display_msg().empty()) {
 		std::cerr << args.display_msg() << std::endl;
 	}
@@ -165,6 +202,8 @@ int Controller::run(const CliArgsParser& args)
 	}
 	std::cout.flush();
 
+	begin_startup_phase("configuration");
+
 	cfg.register_commands(cfgparser);
 	colorman.register_commands(cfgparser);
 
@@ -227,6 +266,7 @@ int Controller::run(const CliArgsParser& args)
 		std::cout << _("Opening cache...");
 		std::cout.flush();
 	}
+	begin_startup_phase("opening cache");
 	try {
 		rsscache = new Cache(configpaths.cache_file(), &cfg);
 	} catch (const DbException& e) {
@@ -252,6 +292,11 @@ int Controller::run(const CliArgsParser& args)
 	}
 
 	reloader = std::make_unique<Reloader>(this, rsscache, cfg);
+	cache_maintenance = std::make_unique<CacheMaintenance>(*rsscache);
+
+	DescriptionBudget::instance().set_limit(
+		static_cast<std::size_t>(cfg.get_configvalue_as_int(
+				"description-memory-limit")) * 1024 * 1024);
 
 	std::string type = cfg.get_configvalue("urls-source");
 	if (type == "local") {
@@ -380,11 +425,23 @@ int Controller::run(const CliArgsParser& args)
 				_("Loading URLs from %s..."), urlcfg->get_source());
 		std::cout.flush();
 	}
+	begin_startup_phase("loading URLs");
 	if (api) {
 		if (!api->authenticate()) {
 			std::cout << "Authentication failed." << std::endl;
 			return EXIT_FAILURE;
 		}
+		// One journal per source, so that changes are never sent to
+		// a different server than the one they were made for.
+		sync_queue = std::make_unique<SyncQueue>(*api,
+				configpaths.cache_file() + ".sync-" + type);
+		sync_queue->start();
+		api->use_subscription_cache(
+			configpaths.cache_file() + ".subscriptions-" + type,
+			cfg.get_configvalue(type + "-url") + " "
+			+ cfg.get_configvalue(type + "-login"),
+			std::chrono::milliseconds(std::max(0,
+					cfg.get_configvalue_as_int("subscription-list-timeout"))));
 	}
 	const auto error_message = urlcfg->reload();
 	if (error_message.has_value()) {
@@ -454,6 +511,8 @@ int Controller::run(const CliArgsParser& args)
 		std::cout << _("done.") << std::endl;
 		std::cout << _("Cleaning up cache thoroughly...");
 		std::cout.flush();
+		cache_maintenance->start(urlcfg->get_urls());
+		cache_maintenance->finish();
 		rsscache->do_vacuum();
 		std::cout << _("done.") << std::endl;
 		return EXIT_SUCCESS;
@@ -464,14 +523,36 @@ int Controller::run(const CliArgsParser& args)
 	}
 	std::cout.flush();
 
+	begin_startup_phase("loading feeds from cache");
+	const bool ignore_disp = (cfg.get_configvalue("ignore-mode") == "display");
+	const bool lazy_load = cfg.get_configvalue_as_bool("lazy-load-feeds");
+	FeedSummaries feed_summaries;
+	if (lazy_load) {
+		try {
+			auto snapshot = FeedListSnapshot::read(feedlist_snapshot_file(),
+					FeedListSnapshot::current_key(configpaths.cache_file(),
+						configpaths.url_file(), cfg),
+					std::time(nullptr));
+			feed_summaries = snapshot
+				? std::move(*snapshot)
+				: rsscache->fetch_feed_summaries();
+		} catch (const DbException& e) {
+			std::cout << _("Error while loading feeds from "
+					"database: ")
+				<< e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+		feedcontainer.enable_lazy_loading(rsscache,
+			ignore_disp ? &ign : nullptr,
+			cfg.get_configvalue_as_int("lazy-load-max-items"));
+	}
+
 	unsigned int i = 0;
 	for (const auto& url : urlcfg->get_urls()) {
 		try {
-			bool ignore_disp =
-				(cfg.get_configvalue("ignore-mode") ==
-					"display");
-			std::shared_ptr<RssFeed> feed =
-				rsscache->internalize_rssfeed(
+			std::shared_ptr<RssFeed> feed = lazy_load
+				? rsscache->internalize_rssfeed_summary(url, feed_summaries)
+				: rsscache->internalize_rssfeed(
 					url, ignore_disp ? &ign : nullptr);
 			feed->set_tags(urlcfg->get_tags(url));
 			feed->set_order(i);
@@ -516,6 +597,8 @@ int Controller::run(const CliArgsParser& args)
 			std::cout.flush();
 		}
 
+		begin_startup_phase("populating query feeds");
+
 		feedcontainer.populate_query_feeds();
 
 		if (!args.do_export() && !args.silent()) {
@@ -523,7 +606,11 @@ int Controller::run(const CliArgsParser& args)
 		}
 	}
 
+	begin_startup_phase("sorting feeds");
 	feedcontainer.sort_feeds(cfg.get_feed_sort_strategy());
+	if (startup_profiler) {
+		startup_profiler->end_phase();
+	}
 
 	if (args.do_export()) {
 		export_opml(args.export_as_opml2());
@@ -560,7 +647,15 @@ int Controller::run(const CliArgsParser& args)
 
 	const auto cmds_to_execute = args.cmds_to_execute();
 	if (cmds_to_execute.size() >= 1) {
+		cache_maintenance->start(urlcfg->get_urls());
 		execute_commands(cmds_to_execute);
+		// Nobody is waiting on us, so we might as well finish the job.
+		cache_maintenance->finish();
+		if (sync_queue) {
+			sync_queue->stop();
+		}
+		report_startup_profile(args);
+		write_timing_stats();
 		return EXIT_SUCCESS;
 	}
 
@@ -571,12 +666,29 @@ int Controller::run(const CliArgsParser& args)
 		refresh_on_start = true;
 	}
 
+	begin_startup_phase("loading histories");
 	FormAction::load_histories(
 		configpaths.search_history_file(), configpaths.cmdline_history_file());
 
+	begin_startup_phase("first render");
+	v->set_startup_profiler(startup_profiler.get());
+
+	cache_maintenance->start(urlcfg->get_urls());
+
 	// run the View
 	int ret = v->run();
 
+	report_startup_profile(args);
+	write_timing_stats();
+
+	// cleanup_cache() below never releases the cache, so maintenance has
+	// to be done by then. Whatever it didn't get to is left for next time.
+	cache_maintenance->stop();
+
+	if (sync_queue) {
+		sync_queue->stop();
+	}
+
 	unsigned int history_limit =
 		cfg.get_configvalue_as_int("history-limit");
 	LOG(Level::DEBUG, "Controller::run: history-limit = %u", history_limit);
@@ -613,9 +725,135 @@ int Controller::run(const CliArgsParser& args)
 		}
 	}
 
+	if (lazy_load) {
+		write_feedlist_snapshot();
+	}
+
 	return ret;
 }
 
+void Controller::write_timing_stats()
+{
+	const auto lines = ScopeMeasure::format_stats();
+	LOG(Level::INFO, "Controller::write_timing_stats: timing statistics:");
+	for (const auto& line : lines) {
+		LOG(Level::INFO, "%s", line);
+	}
+
+	const auto path = cfg.get_configvalue("timing-stats-file");
+	if (path.empty()) {
+		return;
+	}
+	std::ofstream f(path);
+	for (const auto& line : lines) {
+		f << line << '\n';
+	}
+	if (!f) {
+		LOG(Level::ERROR,
+			"Controller::write_timing_stats: couldn't write to %s",
+			path);
+	}
+}
+
+void Controller::handle_timing_stats_signal()
+{
+	// Writing the statistics takes locks, which a signal handler can't do.
+	// Instead, the handler wakes up a dedicated thread through a pipe.
+	if (::pipe(timing_stats_pipe) != 0) {
+		LOG(Level::ERROR, "Controller: couldn't create a pipe for SIGUSR1");
+		return;
+	}
+	for (const int fd : timing_stats_pipe) {
+		::fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+	::signal(SIGUSR1, timing_stats_action);
+
+	timing_stats_thread = std::thread([this]() {
+		for (;;) {
+			char c;
+			const auto result = ::read(timing_stats_pipe[0], &c, 1);
+			if (result == 1) {
+				LOG(Level::DEBUG, "caught SIGUSR1");
+				write_timing_stats();
+			} else if (result == -1 && errno == EINTR) {
+				continue;
+			} else {
+				break;
+			}
+		}
+	});
+}
+
+void Controller::stop_handling_timing_stats_signal()
+{
+	if (!timing_stats_thread.joinable()) {
+		return;
+	}
+	::signal(SIGUSR1, SIG_IGN);
+	// The thread sees the end of the pipe once its write end is closed.
+	::close(timing_stats_pipe[1]);
+	timing_stats_pipe[1] = -1;
+	timing_stats_thread.join();
+	::close(timing_stats_pipe[0]);
+	timing_stats_pipe[0] = -1;
+}
+
+void Controller::begin_startup_phase(const std::string& name)
+{
+	if (startup_profiler) {
+		startup_profiler->begin_phase(name);
+	}
+}
+
+void Controller::report_startup_profile(const CliArgsParser& args)
+{
+	if (!startup_profiler) {
+		return;
+	}
+	startup_profiler->end_phase();
+
+	const auto profile_file = args.profile_startup_file();
+	if (profile_file.has_value()) {
+		std::ofstream f(profile_file.value());
+		f << startup_profiler->to_json() << std::endl;
+		if (!f) {
+			std::cerr << strprintf::fmt(_("Error: couldn't write startup profile to %s"),
+					profile_file.value())
+				<< std::endl;
+		}
+	} else {
+		std::cout << _("Startup profile:") << std::endl;
+		for (const auto& line : startup_profiler->format()) {
+			std::cout << line << std::endl;
+		}
+	}
+	startup_profiler.reset();
+}
+
+std::string Controller::feedlist_snapshot_file() const
+{
+	return configpaths.cache_file() + ".feedlist";
+}
+
+void Controller::write_feedlist_snapshot()
+{
+	// Summaries are taken from the cache rather than from memory because
+	// cleanup_cache() might have just deleted some articles.
+	try {
+		const auto summaries = rsscache->fetch_feed_summaries();
+		FeedListSnapshot::write(feedlist_snapshot_file(),
+			FeedListSnapshot::current_key(configpaths.cache_file(),
+				configpaths.url_file(), cfg),
+			summaries,
+			rsscache->fetch_next_expiry());
+	} catch (const DbException& e) {
+		LOG(Level::ERROR,
+			"Controller::write_feedlist_snapshot: %s",
+			e.what());
+		std::remove(feedlist_snapshot_file().c_str());
+	}
+}
+
 void Controller::update_feedlist()
 {
 	v->set_feedlist(feedcontainer.get_all_feeds());
@@ -628,8 +866,9 @@ void Controller::update_visible_feeds()
 
 void Controller::mark_all_read(const std::string& feedurl)
 {
+	std::vector<std::string> item_guids;
 	try {
-		rsscache->mark_all_read(feedurl);
+		item_guids = rsscache->mark_all_read(feedurl);
 	} catch (const DbException& e) {
 		v->get_statusline().show_error(strprintf::fmt(
 				_("Error: couldn't mark all feeds read: %s"),
@@ -637,12 +876,13 @@ void Controller::mark_all_read(const std::string& feedurl)
 		return;
 	}
 
+	// The articles are named, rather than the feeds, so that articles that
+	// arrive on the server before the change is sent stay unread.
+	if (sync_queue) {
+		sync_queue->mark_articles_read(item_guids);
+	}
+
 	if (feedurl.empty()) { // Mark all feeds as read
-		if (api) {
-			for (const auto& feed : feedcontainer.get_all_feeds()) {
-				api->mark_all_read(feed->rssurl());
-			}
-		}
 		feedcontainer.mark_all_feeds_read();
 	} else { // Mark a specific feed as read
 		const auto feed = feedcontainer.get_feed_by_url(feedurl);
@@ -650,18 +890,14 @@ void Controller::mark_all_read(const std::string& feedurl)
 			return;
 		}
 
-		if (api) {
-			api->mark_all_read(feed->rssurl());
-		}
-
 		feed->mark_all_items_read();
 	}
 }
 
 void Controller::mark_article_read(const std::string& guid, bool read)
 {
-	if (api) {
-		api->mark_article_read(guid, read);
+	if (sync_queue) {
+		sync_queue->mark_article_read(guid, read);
 	}
 }
 
@@ -674,20 +910,20 @@ void Controller::mark_all_read(unsigned int pos)
 	}
 
 	if (feed->is_query_feed()) {
-		if (api) {
+		if (sync_queue) {
 			std::vector<std::string> item_guids;
 			for (const auto& item : feed->items()) {
 				if (item->unread()) {
 					item_guids.push_back(item->guid());
 				}
 			}
-			api->mark_articles_read(item_guids);
+			sync_queue->mark_articles_read(item_guids);
 		}
 		rsscache->mark_all_read(feed);
 	} else {
-		rsscache->mark_all_read(feed->rssurl());
-		if (api) {
-			api->mark_all_read(feed->rssurl());
+		const auto item_guids = rsscache->mark_all_read(feed->rssurl());
+		if (sync_queue) {
+			sync_queue->mark_articles_read(item_guids);
 		}
 	}
 	m.stopover(
@@ -697,11 +933,18 @@ void Controller::mark_all_read(unsigned int pos)
 	feedcontainer.mark_all_feed_items_read(feed);
 }
 
+void Controller::send_pending_changes()
+{
+	if (sync_queue) {
+		sync_queue->try_flush();
+	}
+}
+
 void Controller::mark_all_read(const std::vector<std::string>& item_guids)
 {
 	ScopeMeasure m("Controller::mark_all_read");
-	if (api) {
-		api->mark_articles_read(item_guids);
+	if (sync_queue) {
+		sync_queue->mark_articles_read(item_guids);
 	}
 }
 
@@ -837,6 +1080,8 @@ void Controller::reload_urls_file()
 		v->get_statusline().show_message(error_message.value().message);
 		return;
 	}
+	// Otherwise, maintenance would delete the articles of the new feeds.
+	cache_maintenance->set_feedurls(urlcfg->get_urls());
 
 	std::vector<std::shared_ptr<RssFeed>> new_feeds;
 	unsigned int i = 0;
@@ -917,6 +1162,11 @@ int Controller::execute_commands(const std::vector<std::string>& cmds)
 			std::cout << strprintf::fmt(_("%u unread articles"),
 					feedcontainer.unread_item_count())
 				<< std::endl;
+		} else if (cmd == "print-memory-report") {
+			const MemoryReport report(feedcontainer);
+			for (const auto& line : report.format()) {
+				std::cout << line << std::endl;
+			}
 		} else {
 			std::cerr
 					<< strprintf::fmt(_("%s: %s: unknown command"),
@@ -1030,6 +1280,9 @@ void Controller::update_config()
 			std::cerr << msg << std::endl;
 		}
 	}
+
+	logger::set_max_logfile_size(static_cast<std::uint64_t>(std::max(0,
+				cfg.get_configvalue_as_int("log-file-max-size"))) * 1024 * 1024);
 }
 
 void Controller::load_configfile(const std::string& filename)
@@ -1064,8 +1317,8 @@ void Controller::dump_config(const std::string& filename) const
 
 void Controller::update_flags(std::shared_ptr<RssItem> item)
 {
-	if (api) {
-		api->update_article_flags(
+	if (sync_queue) {
+		sync_queue->update_article_flags(
 			item->oldflags(), item->flags(), item->guid());
 	}
 	item->update_flags();
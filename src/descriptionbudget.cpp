@@ -0,0 +1,89 @@
+#include "descriptionbudget.h"
+
+#include <cinttypes>
+
+#include "logger.h"
+#include "rssitem.h"
+
+namespace newsboat {
+
+DescriptionBudget& DescriptionBudget::instance()
+{
+	// Deliberately leaked: items may still be destroyed while static
+	// objects are torn down.
+	static DescriptionBudget* budget = new DescriptionBudget();
+	return *budget;
+}
+
+void DescriptionBudget::set_limit(std::size_t bytes)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	limit_bytes = bytes;
+	evict_unlocked();
+}
+
+void DescriptionBudget::touch(RssItem& item, std::size_t bytes)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	const auto it = entries.find(&item);
+	if (it != entries.end()) {
+		used_bytes -= it->second->bytes;
+		it->second->bytes = bytes;
+		lru.splice(lru.begin(), lru, it->second);
+	} else {
+		lru.push_front(Entry{&item, bytes});
+		entries.emplace(&item, lru.begin());
+	}
+	used_bytes += bytes;
+	evict_unlocked();
+}
+
+void DescriptionBudget::forget(const RssItem& item)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	const auto it = entries.find(&item);
+	if (it != entries.end()) {
+		used_bytes -= it->second->bytes;
+		lru.erase(it->second);
+		entries.erase(it);
+	}
+}
+
+DescriptionBudget::Stats DescriptionBudget::stats() const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return Stats{used_bytes, limit_bytes, entries.size(), evictions};
+}
+
+void DescriptionBudget::evict_unlocked()
+{
+	if (limit_bytes == 0) {
+		return;
+	}
+
+	// The most recently used description always stays, even if it's larger
+	// than the whole budget: it's the one that is about to be displayed.
+	std::size_t evicted = 0;
+	while (used_bytes > limit_bytes && lru.size() > 1) {
+		const Entry& victim = lru.back();
+		// Items can't be destroyed while we hold `mtx`: their destructors
+		// call forget() first.
+		victim.item->evict_description();
+		used_bytes -= victim.bytes;
+		entries.erase(victim.item);
+		lru.pop_back();
+		evicted++;
+	}
+
+	if (evicted > 0) {
+		evictions += evicted;
+		LOG(Level::DEBUG,
+			"DescriptionBudget: evicted %" PRIu64 " descriptions, %" PRIu64
+			" of %" PRIu64 " bytes in use",
+			static_cast<uint64_t>(evicted),
+			static_cast<uint64_t>(used_bytes),
+			static_cast<uint64_t>(limit_bytes));
+	}
+}
+
+} // namespace newsboat
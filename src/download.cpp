@@ -81,6 +81,8 @@ const std::string Download::status_text() const
 		return _s("played");
 	case DlStatus::RENAME_FAILED:
 		return _s("rename failed");
+	case DlStatus::PAUSED:
+		return _s("paused");
 	default:
 		return _s("unknown (bug).");
 	}
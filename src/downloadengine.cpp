@@ -0,0 +1,1185 @@
+#include "downloadengine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <libgen.h>
+#include <stdexcept>
+#include <strings.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+
+#include "configcontainer.h"
+#include "curlhandle.h"
+#include "logger.h"
+#include "utils.h"
+
+// fallocate() can reserve space without changing the file's size, and
+// unlike glibc's posix_fallocate() it doesn't fall back to writing every
+// block when the filesystem can't preallocate. Elsewhere, we only size the
+// file with ftruncate().
+#ifdef __linux__
+#define NEWSBOAT_HAVE_FALLOCATE 1
+#endif
+
+using namespace newsboat;
+
+namespace podboat {
+
+const std::string DownloadEngine::RESUME_MAP_SUFFIX = ".segments";
+
+namespace {
+
+/// How long curl_multi_wait() may sleep, and how often progress is published.
+const int PROGRESS_INTERVAL_MS = 100;
+
+/// How often the resume maps of segmented downloads are written out.
+const int RESUME_MAP_INTERVAL_MS = 1000;
+
+/// Files are only split into segments that are at least this large, so small
+/// files don't pay for extra connections.
+const curl_off_t MIN_SEGMENT_SIZE = 4 * 1024 * 1024;
+
+/// How many times a single segment may fail before the whole download is
+/// considered failed. Servers often limit the number of connections per
+/// client, so a failed segment is retried once another one finishes.
+const unsigned int MAX_SEGMENT_FAILURES = 3;
+
+/// Received data is collected into buffers of this size, and written out
+/// at offsets that are multiples of it.
+const curl_off_t WRITE_BUFFER_SIZE = 1024 * 1024;
+
+/// How much data curl may hand to the write callback at once.
+const long RECEIVE_BUFFER_SIZE = 256 * 1024;
+
+enum class FsyncPolicy { NONE, DATA, FULL };
+
+FsyncPolicy parse_fsync_policy(const std::string& value)
+{
+	if (value == "data") {
+		return FsyncPolicy::DATA;
+	} else if (value == "full") {
+		return FsyncPolicy::FULL;
+	}
+	return FsyncPolicy::NONE;
+}
+
+/// Reserves space for `size` bytes. If `keep_size` is true, the file's
+/// size doesn't change, which is only possible with fallocate().
+bool preallocate(int fd, curl_off_t size, bool keep_size)
+{
+#ifdef NEWSBOAT_HAVE_FALLOCATE
+	if (::fallocate(fd, keep_size ? FALLOC_FL_KEEP_SIZE : 0, 0, size) == 0) {
+		return true;
+	}
+#endif
+	return !keep_size && ::ftruncate(fd, size) == 0;
+}
+
+bool sync_file(int fd, FsyncPolicy policy)
+{
+#ifdef __linux__
+	if (policy == FsyncPolicy::DATA) {
+		return ::fdatasync(fd) == 0;
+	}
+#endif
+	return policy == FsyncPolicy::NONE || ::fsync(fd) == 0;
+}
+
+void sync_directory(const std::string& filename)
+{
+	std::vector<char> path(filename.begin(), filename.end());
+	path.push_back('\0');
+	const int fd = ::open(dirname(&path[0]), O_RDONLY | O_CLOEXEC);
+	if (fd != -1) {
+		::fsync(fd);
+		::close(fd);
+	}
+}
+
+Download* find_download(std::vector<Download>& downloads, const Download* dl,
+	const std::string& url)
+{
+	for (auto& download : downloads) {
+		// The URL is checked as well in case the queue was reloaded, and
+		// another download ended up at the same address.
+		if (&download == dl && download.url() == url) {
+			return &download;
+		}
+	}
+	return nullptr;
+}
+
+} // namespace
+
+struct DownloadEngine::Segment {
+	Transfer* transfer;
+	CurlHandle handle;
+	curl_off_t start = 0;
+	/// One past the last byte of the segment, or -1 if the size of the file
+	/// isn't known.
+	curl_off_t end = -1;
+	/// Where the next byte received goes.
+	curl_off_t pos = 0;
+	/// Everything before this has been written to the partial file; the
+	/// rest, up to `pos`, is in `buffer`.
+	curl_off_t flushed = 0;
+	std::vector<char> buffer;
+	/// Whether the segment is requested with a Range header.
+	bool ranged = false;
+	bool range_checked = false;
+	bool running = false;
+	bool done = false;
+	unsigned int failures = 0;
+	/// Whether the segment waits for its download to get more bandwidth.
+	bool throttled = false;
+	curl_off_t dlnow = 0;
+	curl_off_t dltotal = 0;
+
+	/// What the headers of the current response said; only tracked by the
+	/// first segment, to decide if the download can be split.
+	bool accepts_ranges = false;
+	bool encoded = false;
+	curl_off_t content_length = -1;
+
+	/// Writes out `buffer`. Returns `false` (and sets the transfer's
+	/// `write_error`) if that fails.
+	bool flush();
+};
+
+struct DownloadEngine::Transfer {
+	DownloadEngine* engine;
+	const Download* download;
+	std::string url;
+	std::string filename;
+	/// Whether `url` is a file:// URL.
+	bool local = false;
+	int fd = -1;
+	/// Set if writing to the partial file failed.
+	std::string write_error;
+	std::vector<std::unique_ptr<Segment>> segments;
+	unsigned int max_segments = 1;
+	/// Whether `segments` cover the whole file, whose size is `size`.
+	bool segmented = false;
+	/// Set once the headers of a complete response have arrived, with the
+	/// size of the file in the first segment's `content_length`.
+	bool headers_received = false;
+	FsyncPolicy fsync_policy = FsyncPolicy::NONE;
+	curl_off_t size = 0;
+	/// Set once the server answered a range request with the whole file;
+	/// the download then goes on as a single stream.
+	bool ranges_refused = false;
+	/// Where the segments are fetched from, i.e. `url` after redirects.
+	std::string segment_url;
+	bool resumed = false;
+	bool paused = false;
+	curl_off_t offset = 0;
+
+	/// Speed is measured from this point, which moves when a transfer is
+	/// resumed.
+	std::chrono::steady_clock::time_point speed_start;
+	curl_off_t speed_start_bytes = 0;
+
+	~Transfer()
+	{
+		if (fd != -1) {
+			::close(fd);
+		}
+	}
+
+	std::string partial_filename() const
+	{
+		return filename + ConfigContainer::PARTIAL_FILE_SUFFIX;
+	}
+
+	std::string resume_map_filename() const
+	{
+		return partial_filename() + RESUME_MAP_SUFFIX;
+	}
+
+	/// Bytes received since the transfer was started, not counting `offset`.
+	curl_off_t received() const
+	{
+		if (!segmented) {
+			return segments.front()->dlnow;
+		}
+		curl_off_t result = 0;
+		for (const auto& segment : segments) {
+			result += segment->pos - segment->start;
+		}
+		return result - offset;
+	}
+
+	/// Size of what's being transferred (0 if unknown), not counting `offset`.
+	curl_off_t expected() const
+	{
+		return segmented ? size - offset : segments.front()->dltotal;
+	}
+
+	bool all_done() const
+	{
+		return std::all_of(segments.begin(), segments.end(),
+		[](const std::unique_ptr<Segment>& segment) {
+			return segment->done;
+		});
+	}
+
+	bool save_resume_map() const
+	{
+		const std::string map_filename = resume_map_filename();
+		const std::string tmp_filename = map_filename + ".tmp";
+		{
+			std::ofstream map(tmp_filename, std::ios::trunc);
+			map << size << '\n';
+			for (const auto& segment : segments) {
+				map << segment->start << ' ' << segment->end << ' '
+					<< segment->flushed << '\n';
+			}
+			map.flush();
+			if (!map) {
+				::unlink(tmp_filename.c_str());
+				return false;
+			}
+		}
+		return ::rename(tmp_filename.c_str(), map_filename.c_str()) == 0;
+	}
+
+	/// Returns the (start, end, pos) triples recorded by a previous run, or
+	/// nothing if there is no resume map or it doesn't make sense.
+	std::vector<std::tuple<curl_off_t, curl_off_t, curl_off_t>>
+		load_resume_map(curl_off_t& file_size) const
+	{
+		std::vector<std::tuple<curl_off_t, curl_off_t, curl_off_t>> result;
+		std::ifstream map(resume_map_filename());
+		if (!map.is_open() || !(map >> file_size) || file_size <= 0) {
+			return {};
+		}
+		curl_off_t next_start = 0;
+		curl_off_t seg_start, seg_end, seg_pos;
+		while (map >> seg_start >> seg_end >> seg_pos) {
+			if (seg_start != next_start || seg_pos < seg_start
+				|| seg_end < seg_pos || seg_end > file_size) {
+				return {};
+			}
+			result.emplace_back(seg_start, seg_end, seg_pos);
+			next_start = seg_end;
+		}
+		if (next_start != file_size) {
+			return {};
+		}
+		return result;
+	}
+};
+
+bool DownloadEngine::Segment::flush()
+{
+	size_t written = 0;
+	while (written < buffer.size()) {
+		const ssize_t rc = ::pwrite(transfer->fd, buffer.data() + written,
+				buffer.size() - written, flushed + written);
+		if (rc == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			transfer->write_error = strerror(errno);
+			return false;
+		}
+		written += rc;
+	}
+	flushed = pos;
+	buffer.clear();
+	return true;
+}
+
+DownloadEngine::DownloadEngine(ConfigContainer& cfg_)
+	: cfg(cfg_)
+	, multi(curl_multi_init())
+	, scheduler(cfg.get_configvalue_as_int("max-download-speed") * 1024.0)
+	, current_progress(std::make_shared<std::vector<TransferProgress>>())
+{
+	if (multi == nullptr) {
+		throw std::runtime_error("Can't obtain curl multi handle");
+	}
+	if (::pipe(wakeup_pipe) == -1) {
+		curl_multi_cleanup(multi);
+		throw std::runtime_error(strerror(errno));
+	}
+	for (const int fd : wakeup_pipe) {
+		::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+		::fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+
+	thread = std::thread(&DownloadEngine::run, this);
+}
+
+DownloadEngine::~DownloadEngine()
+{
+	send(Command{CommandType::QUIT, nullptr, {}, {}});
+	thread.join();
+
+	curl_multi_cleanup(multi);
+	::close(wakeup_pipe[0]);
+	::close(wakeup_pipe[1]);
+}
+
+void DownloadEngine::start(const Download& dl)
+{
+	send(Command{CommandType::START, &dl, dl.url(), dl.filename()});
+}
+
+void DownloadEngine::pause(const Download& dl)
+{
+	send(Command{CommandType::PAUSE, &dl, {}, {}});
+}
+
+void DownloadEngine::resume(const Download& dl)
+{
+	send(Command{CommandType::RESUME, &dl, {}, {}});
+}
+
+void DownloadEngine::cancel(const Download& dl)
+{
+	{
+		std::lock_guard<std::mutex> guard(queues_mtx);
+		cancelling.insert(&dl);
+		// The transfer might have finished already; the user asked for it
+		// to be cancelled, so that's what it stays.
+		results.erase(std::remove_if(results.begin(), results.end(),
+		[&dl](const Result& result) {
+			return result.download == &dl;
+		}),
+		results.end());
+	}
+	send(Command{CommandType::CANCEL, &dl, {}, {}});
+}
+
+void DownloadEngine::send(Command command)
+{
+	{
+		std::lock_guard<std::mutex> guard(queues_mtx);
+		commands.push_back(std::move(command));
+	}
+	const char byte = 0;
+	// If the pipe is full, the engine is going to wake up anyway.
+	const auto written = ::write(wakeup_pipe[1], &byte, 1);
+	static_cast<void>(written);
+}
+
+void DownloadEngine::poll(std::vector<Download>& downloads)
+{
+	std::vector<Result> finished;
+	{
+		std::lock_guard<std::mutex> guard(queues_mtx);
+		finished.swap(results);
+	}
+	for (const auto& result : finished) {
+		Download* dl = find_download(downloads, result.download, result.url);
+		if (dl != nullptr) {
+			dl->set_status(result.status, result.message);
+		}
+	}
+
+	const auto snapshot = progress();
+	for (const auto& entry : *snapshot) {
+		Download* dl = find_download(downloads, entry.download, entry.url);
+		if (dl != nullptr && (dl->status() == DlStatus::DOWNLOADING
+				|| dl->status() == DlStatus::PAUSED)) {
+			dl->set_offset(entry.offset);
+			dl->set_progress(entry.downloaded, entry.total);
+			dl->set_kbps(entry.kbps);
+		}
+	}
+}
+
+std::shared_ptr<const std::vector<TransferProgress>> DownloadEngine::progress()
+const
+{
+	return std::atomic_load(&current_progress);
+}
+
+size_t DownloadEngine::write_data(char* buffer, size_t size, size_t nmemb,
+	void* userp)
+{
+	auto segment = static_cast<Segment*>(userp);
+	Transfer& transfer = *segment->transfer;
+	BandwidthScheduler& scheduler = transfer.engine->scheduler;
+
+	// Local files take no bandwidth, and curl can't pause reading them.
+	// curl forgets a pause that was requested before the response came in,
+	// so paused transfers are held back here, too.
+	if (!transfer.local
+		&& (transfer.paused || !scheduler.may_receive(transfer.download))) {
+		// curl hands us the same data again once the segment is unpaused.
+		segment->throttled = true;
+		return CURL_WRITEFUNC_PAUSE;
+	}
+
+	if (segment->ranged && !segment->range_checked) {
+		long code = 0;
+		curl_easy_getinfo(segment->handle.ptr(), CURLINFO_RESPONSE_CODE, &code);
+		// Local files report 0. Anything else means the server sent us
+		// something other than the range we asked for.
+		if (code != 206 && code != 0) {
+			LOG(Level::ERROR,
+				"DownloadEngine::write_data: %s: expected a partial response, "
+				"got %ld",
+				transfer.url,
+				code);
+			if (code == 200) {
+				// The server sends the whole file instead, and will keep
+				// doing so.
+				transfer.ranges_refused = true;
+			}
+			return 0;
+		}
+		segment->range_checked = true;
+	}
+
+	size_t length = size * nmemb;
+	if (segment->end != -1) {
+		// Anything past the end belongs to another segment. Returning
+		// a short count stops the transfer.
+		length = std::min<curl_off_t>(length,
+				std::max<curl_off_t>(0, segment->end - segment->pos));
+	}
+
+	if (segment->buffer.capacity() == 0) {
+		segment->buffer.reserve(WRITE_BUFFER_SIZE);
+	}
+	size_t copied = 0;
+	while (copied < length) {
+		// Never let the buffer cross a multiple of its size, so that
+		// all but the first write of a segment are aligned.
+		const curl_off_t boundary =
+			(segment->pos / WRITE_BUFFER_SIZE + 1) * WRITE_BUFFER_SIZE;
+		const size_t chunk = std::min<curl_off_t>(length - copied,
+				boundary - segment->pos);
+		segment->buffer.insert(segment->buffer.end(), buffer + copied,
+			buffer + copied + chunk);
+		segment->pos += chunk;
+		copied += chunk;
+		if (segment->pos == boundary && !segment->flush()) {
+			return 0;
+		}
+	}
+	scheduler.consume(transfer.download, length);
+	return length;
+}
+
+size_t DownloadEngine::header_callback(char* buffer, size_t size,
+	size_t nitems, void* userp)
+{
+	auto segment = static_cast<Segment*>(userp);
+	const size_t length = size * nitems;
+	std::string line(buffer, length);
+	utils::trim(line);
+
+	if (line.compare(0, 5, "HTTP/") == 0) {
+		// Each redirect starts a new set of headers.
+		segment->accepts_ranges = false;
+		segment->encoded = false;
+		segment->content_length = -1;
+	} else if (line.empty()) {
+		long code = 0;
+		curl_easy_getinfo(segment->handle.ptr(), CURLINFO_RESPONSE_CODE, &code);
+		if (code == 200 && !segment->encoded && segment->content_length > 0) {
+			segment->transfer->headers_received = true;
+		}
+	} else {
+		const auto colon = line.find(':');
+		if (colon != std::string::npos) {
+			std::string name = line.substr(0, colon);
+			std::string value = line.substr(colon + 1);
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+			utils::trim(value);
+			if (name == "accept-ranges") {
+				segment->accepts_ranges = value == "bytes";
+			} else if (name == "content-encoding") {
+				segment->encoded = value != "identity";
+			} else if (name == "content-length") {
+				segment->content_length = std::strtoll(value.c_str(), nullptr, 10);
+			}
+		}
+	}
+
+	return length;
+}
+
+int DownloadEngine::progress_callback(void* clientp, curl_off_t dltotal,
+	curl_off_t dlnow, curl_off_t /* ultotal */, curl_off_t /* ulnow */)
+{
+	auto segment = static_cast<Segment*>(clientp);
+	segment->dlnow = dlnow;
+	segment->dltotal = dltotal;
+	return 0;
+}
+
+void DownloadEngine::run()
+{
+	bool quit = false;
+	while (!quit) {
+		char buf[64];
+		while (::read(wakeup_pipe[0], buf, sizeof(buf)) > 0) {
+			// Just drain the pipe; the commands are in the queue.
+		}
+		quit = handle_commands();
+		throttle();
+
+		int running = 0;
+		curl_multi_perform(multi, &running);
+
+		int remaining = 0;
+		while (CURLMsg* msg = curl_multi_info_read(multi, &remaining)) {
+			if (msg->msg == CURLMSG_DONE) {
+				finish_segment(msg->easy_handle, msg->data.result);
+			}
+		}
+
+		for (auto& entry : transfers) {
+			if (entry.second->headers_received) {
+				handle_headers(*entry.second);
+			}
+		}
+
+		publish_progress();
+		save_resume_maps();
+
+		if (!quit) {
+			curl_waitfd wakeup{};
+			wakeup.fd = wakeup_pipe[0];
+			wakeup.events = CURL_WAIT_POLLIN;
+			curl_multi_wait(multi, &wakeup, 1, PROGRESS_INTERVAL_MS, nullptr);
+		}
+	}
+
+	for (auto& transfer : transfers) {
+		remove_transfer(*transfer.second);
+	}
+	transfers.clear();
+	std::atomic_store(&current_progress,
+		std::make_shared<const std::vector<TransferProgress>>());
+}
+
+bool DownloadEngine::handle_commands()
+{
+	std::vector<Command> pending;
+	{
+		std::lock_guard<std::mutex> guard(queues_mtx);
+		pending.swap(commands);
+	}
+
+	for (const auto& command : pending) {
+		if (command.type == CommandType::QUIT) {
+			return true;
+		}
+		if (command.type == CommandType::CANCEL) {
+			std::lock_guard<std::mutex> guard(queues_mtx);
+			cancelling.erase(cancelling.find(command.download));
+		}
+		if (command.type == CommandType::START) {
+			if (transfers.count(command.download) == 0) {
+				begin_transfer(command.download, command.url, command.filename);
+			}
+			continue;
+		}
+
+		const auto it = transfers.find(command.download);
+		if (it == transfers.end()) {
+			continue;
+		}
+		Transfer& transfer = *it->second;
+
+		switch (command.type) {
+		case CommandType::PAUSE:
+			for (const auto& segment : transfer.segments) {
+				if (segment->running) {
+					curl_easy_pause(segment->handle.ptr(), CURLPAUSE_RECV);
+				}
+			}
+			transfer.paused = true;
+			// Paused downloads don't need a share of the bandwidth.
+			scheduler.remove(transfer.download);
+			break;
+		case CommandType::RESUME:
+			scheduler.add(transfer.download);
+			transfer.paused = false;
+			for (const auto& segment : transfer.segments) {
+				if (segment->running) {
+					segment->throttled = false;
+					curl_easy_pause(segment->handle.ptr(), CURLPAUSE_CONT);
+				}
+			}
+			transfer.speed_start = std::chrono::steady_clock::now();
+			transfer.speed_start_bytes = transfer.received();
+			break;
+		case CommandType::CANCEL:
+			LOG(Level::INFO, "DownloadEngine: cancelled %s", transfer.url);
+			remove_transfer(transfer);
+			transfers.erase(it);
+			break;
+		case CommandType::START:
+		case CommandType::QUIT:
+			// handled above
+			break;
+		}
+		transfers_changed = true;
+	}
+
+	return false;
+}
+
+void DownloadEngine::begin_transfer(const Download* download,
+	const std::string& url, const std::string& filename)
+{
+	auto transfer = std::make_unique<Transfer>();
+	transfer->engine = this;
+	transfer->download = download;
+	transfer->url = url;
+	transfer->filename = filename;
+	transfer->segment_url = url;
+	transfer->local = ::strncasecmp(url.c_str(), "file://", 7) == 0;
+	transfer->max_segments =
+		std::max(1, cfg.get_configvalue_as_int("download-segments"));
+	transfer->fsync_policy =
+		parse_fsync_policy(cfg.get_configvalue("download-fsync"));
+	transfer->speed_start = std::chrono::steady_clock::now();
+
+	struct stat sb;
+	const std::string partial_filename = transfer->partial_filename();
+	curl_off_t file_size = 0;
+	const auto resume_map = transfer->load_resume_map(file_size);
+	if (stat(partial_filename.c_str(), &sb) == -1) {
+		LOG(Level::INFO,
+			"DownloadEngine::begin_transfer: stat failed: starting normal "
+			"download");
+
+		// Have to copy the string into a vector in order to be able to
+		// get a char* pointer. std::string::c_str() won't do because it
+		// returns const char*, whereas ::dirname() needs non-const.
+		std::vector<char> directory(partial_filename.begin(),
+			partial_filename.end());
+		directory.push_back('\0');
+		utils::mkdir_parents(dirname(&directory[0]));
+
+		::unlink(transfer->resume_map_filename().c_str());
+		transfer->fd = ::open(partial_filename.c_str(),
+				O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+		if (transfer->fd != -1) {
+			add_segment(*transfer, 0, -1, 0, false);
+		}
+	} else if (!resume_map.empty()) {
+		LOG(Level::INFO,
+			"DownloadEngine::begin_transfer: resuming %" PRIu64
+			" segments from the resume map",
+			static_cast<uint64_t>(resume_map.size()));
+		transfer->segmented = true;
+		transfer->resumed = true;
+		transfer->size = file_size;
+		transfer->fd = ::open(partial_filename.c_str(), O_WRONLY | O_CLOEXEC);
+		if (transfer->fd != -1) {
+			for (const auto& entry : resume_map) {
+				Segment& segment = add_segment(*transfer, std::get<0>(entry),
+						std::get<1>(entry), std::get<2>(entry), true);
+				transfer->offset += segment.pos - segment.start;
+			}
+		}
+	} else {
+		LOG(Level::INFO,
+			"DownloadEngine::begin_transfer: stat ok: starting download "
+			"from %" PRIi64,
+			// That field is `long int`, which is at least 32 bits. On x86_64,
+			// it's 64 bits. Thus, this cast is either a no-op, or an up-cast
+			// which are always safe.
+			static_cast<int64_t>(sb.st_size));
+		// A map that doesn't make sense is no help in resuming.
+		::unlink(transfer->resume_map_filename().c_str());
+		transfer->offset = sb.st_size;
+		transfer->resumed = true;
+		transfer->fd = ::open(partial_filename.c_str(), O_WRONLY | O_CLOEXEC);
+		if (transfer->fd != -1) {
+			Segment& segment =
+				add_segment(*transfer, 0, -1, transfer->offset, false);
+			curl_easy_setopt(segment.handle.ptr(), CURLOPT_RESUME_FROM_LARGE,
+				transfer->offset);
+		}
+	}
+
+	if (transfer->fd == -1) {
+		post_result(*transfer, DlStatus::FAILED, strerror(errno));
+		return;
+	}
+
+	// A previous run could've been interrupted just before renaming the file.
+	if (transfer->all_done()) {
+		complete_transfer(std::move(transfer));
+		return;
+	}
+
+	scheduler.add(download);
+	for (const auto& segment : transfer->segments) {
+		if (!segment->done) {
+			start_segment(*segment);
+		}
+	}
+	transfers[download] = std::move(transfer);
+	transfers_changed = true;
+}
+
+DownloadEngine::Segment& DownloadEngine::add_segment(Transfer& transfer,
+	curl_off_t start, curl_off_t end, curl_off_t pos, bool ranged)
+{
+	auto segment = std::make_unique<Segment>();
+	segment->transfer = &transfer;
+	segment->start = start;
+	segment->end = end;
+	segment->pos = pos;
+	segment->flushed = pos;
+	segment->ranged = ranged;
+	segment->done = end != -1 && pos == end;
+
+	CURL* easy = segment->handle.ptr();
+	utils::set_common_curl_options(segment->handle, cfg);
+
+	curl_easy_setopt(easy, CURLOPT_URL,
+		ranged ? transfer.segment_url.c_str() : transfer.url.c_str());
+	curl_easy_setopt(easy, CURLOPT_TIMEOUT, 0);
+	curl_easy_setopt(easy, CURLOPT_PRIVATE, segment.get());
+
+	curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, write_data);
+	curl_easy_setopt(easy, CURLOPT_WRITEDATA, segment.get());
+	curl_easy_setopt(easy, CURLOPT_BUFFERSIZE, RECEIVE_BUFFER_SIZE);
+
+	curl_easy_setopt(easy, CURLOPT_NOPROGRESS, 0);
+	curl_easy_setopt(easy, CURLOPT_XFERINFOFUNCTION, progress_callback);
+	curl_easy_setopt(easy, CURLOPT_XFERINFODATA, segment.get());
+
+	if (!ranged && pos == 0) {
+		curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, header_callback);
+		curl_easy_setopt(easy, CURLOPT_HEADERDATA, segment.get());
+	}
+
+	transfer.segments.push_back(std::move(segment));
+	return *transfer.segments.back();
+}
+
+void DownloadEngine::start_segment(Segment& segment)
+{
+	if (segment.ranged) {
+		const std::string range = std::to_string(segment.pos) + "-"
+			+ std::to_string(segment.end - 1);
+		curl_easy_setopt(segment.handle.ptr(), CURLOPT_RANGE, range.c_str());
+		// Byte ranges refer to the unencoded file.
+		curl_easy_setopt(segment.handle.ptr(), CURLOPT_ACCEPT_ENCODING, nullptr);
+		segment.range_checked = false;
+	}
+	curl_multi_add_handle(multi, segment.handle.ptr());
+	segment.running = true;
+	if (segment.transfer->paused) {
+		curl_easy_pause(segment.handle.ptr(), CURLPAUSE_RECV);
+	}
+}
+
+void DownloadEngine::handle_headers(Transfer& transfer)
+{
+	transfer.headers_received = false;
+	Segment& first = *transfer.segments.front();
+	if (transfer.segmented || first.done) {
+		return;
+	}
+	if (first.accepts_ranges && !transfer.ranges_refused
+		&& split_transfer(transfer)) {
+		return;
+	}
+
+	// The size of the partial file tells where to resume a download that
+	// isn't segmented, so it has to stay as it is.
+	if (!preallocate(transfer.fd, first.content_length, true)) {
+		LOG(Level::DEBUG,
+			"DownloadEngine::handle_headers: couldn't preallocate %s",
+			transfer.partial_filename());
+	}
+}
+
+bool DownloadEngine::split_transfer(Transfer& transfer)
+{
+	Segment& first = *transfer.segments.front();
+	const curl_off_t size = first.content_length;
+	const curl_off_t remaining = size - first.pos;
+	const curl_off_t count = std::min<curl_off_t>(transfer.max_segments,
+			remaining / MIN_SEGMENT_SIZE);
+	if (count < 2) {
+		return false;
+	}
+
+	// Segments start at multiples of the write buffer's size, so that
+	// their writes are aligned. Rounding up keeps them clear of what the
+	// first response has written already; segments are much larger than
+	// the buffer, so they stay in order and end before the file does.
+	std::vector<curl_off_t> starts;
+	for (curl_off_t i = 1; i < count; i++) {
+		const curl_off_t start = first.pos + i * (remaining / count);
+		starts.push_back((start + WRITE_BUFFER_SIZE - 1) / WRITE_BUFFER_SIZE
+			* WRITE_BUFFER_SIZE);
+	}
+	if (starts.front() <= first.pos || starts.back() >= size) {
+		return false;
+	}
+	starts.push_back(size);
+
+	char* effective_url = nullptr;
+	curl_easy_getinfo(first.handle.ptr(), CURLINFO_EFFECTIVE_URL, &effective_url);
+	if (effective_url != nullptr) {
+		transfer.segment_url = effective_url;
+	}
+
+	LOG(Level::INFO,
+		"DownloadEngine::split_transfer: splitting %s (%" PRIi64
+		" bytes) into %" PRIi64 " segments",
+		transfer.url,
+		static_cast<int64_t>(size),
+		static_cast<int64_t>(count));
+
+	transfer.segmented = true;
+	transfer.size = size;
+	first.end = starts.front();
+	// The response that's already coming in is fine as it is, but if the
+	// first segment has to be restarted, it should only ask for its range.
+	first.ranged = true;
+	first.range_checked = true;
+	for (size_t i = 0; i + 1 < starts.size(); i++) {
+		add_segment(transfer, starts[i], starts[i + 1], starts[i], true);
+	}
+
+	// The map is written before the file grows, so that a preallocated
+	// partial file always comes with a map that describes it.
+	transfer.save_resume_map();
+	if (!preallocate(transfer.fd, size, false)) {
+		LOG(Level::WARN,
+			"DownloadEngine::split_transfer: couldn't preallocate %s: %s",
+			transfer.partial_filename(),
+			strerror(errno));
+	}
+
+	for (size_t i = 1; i < transfer.segments.size(); i++) {
+		start_segment(*transfer.segments[i]);
+	}
+	transfers_changed = true;
+	return true;
+}
+
+void DownloadEngine::finish_segment(CURL* easy, CURLcode result)
+{
+	char* priv = nullptr;
+	curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+	Segment& segment = *reinterpret_cast<Segment*>(priv);
+	const auto it = transfers.find(segment.transfer->download);
+	if (it == transfers.end()) {
+		return;
+	}
+	Transfer& transfer = *it->second;
+	if (!segment.running) {
+		// The segment was dropped when the transfer went back to a single
+		// stream.
+		return;
+	}
+
+	curl_multi_remove_handle(multi, easy);
+	segment.running = false;
+	// Whatever has arrived is good data, even if the transfer failed.
+	const bool flushed = segment.flush();
+
+	if (transfer.ranges_refused && transfer.segmented) {
+		unsplit_transfer(transfer);
+		return;
+	}
+
+	LOG(Level::INFO,
+		"DownloadEngine::finish_segment: %s [%" PRIi64 ", %" PRIi64
+		"): rc = %u (%s)",
+		transfer.url,
+		static_cast<int64_t>(segment.start),
+		static_cast<int64_t>(segment.end),
+		result,
+		curl_easy_strerror(result));
+
+	const bool reached_end = segment.end != -1 && segment.pos == segment.end;
+	if (flushed && (segment.end == -1 ? result == CURLE_OK : reached_end)) {
+		// A segment that reached its end is done, even if curl complains
+		// that we refused the rest of the response.
+		segment.done = true;
+		for (const auto& other : transfer.segments) {
+			if (!other->done && !other->running) {
+				start_segment(*other);
+				break;
+			}
+		}
+
+		if (transfer.all_done()) {
+			std::unique_ptr<Transfer> finished = std::move(it->second);
+			transfers.erase(it);
+			transfers_changed = true;
+			complete_transfer(std::move(finished));
+		}
+		return;
+	}
+
+	const std::string message = !transfer.write_error.empty()
+		? transfer.write_error
+		: (result == CURLE_OK ? "Transfer closed early" : curl_easy_strerror(result));
+
+	if (transfer.segmented && transfer.write_error.empty()
+		&& ++segment.failures <= MAX_SEGMENT_FAILURES) {
+		const bool others_running = std::any_of(transfer.segments.begin(),
+				transfer.segments.end(),
+		[](const std::unique_ptr<Segment>& s) {
+			return s->running;
+		});
+		// Otherwise it's restarted once another segment is done.
+		if (!others_running) {
+			start_segment(segment);
+		}
+		return;
+	}
+
+	std::unique_ptr<Transfer> failed = std::move(it->second);
+	transfers.erase(it);
+	transfers_changed = true;
+	fail_transfer(std::move(failed), message);
+}
+
+void DownloadEngine::unsplit_transfer(Transfer& transfer)
+{
+	LOG(Level::WARN,
+		"DownloadEngine::unsplit_transfer: %s: the server ignores byte "
+		"ranges, continuing with a single stream",
+		transfer.url);
+
+	// The segments are kept, so that curl never hands us a handle that's
+	// gone, but they're done as far as the transfer is concerned.
+	for (size_t i = 1; i < transfer.segments.size(); i++) {
+		Segment& segment = *transfer.segments[i];
+		if (segment.running) {
+			curl_multi_remove_handle(multi, segment.handle.ptr());
+			segment.running = false;
+		}
+		segment.buffer.clear();
+		segment.done = true;
+	}
+	transfer.segmented = false;
+	transfer.size = 0;
+	::unlink(transfer.resume_map_filename().c_str());
+
+	Segment& first = *transfer.segments.front();
+	long code = 0;
+	curl_easy_getinfo(first.handle.ptr(), CURLINFO_RESPONSE_CODE, &code);
+	if (first.running && code == 200 && first.pos < first.end) {
+		// The response that was split is still coming in, and it has the
+		// whole file.
+		first.end = -1;
+		first.ranged = false;
+	} else {
+		if (first.running) {
+			curl_multi_remove_handle(multi, first.handle.ptr());
+			first.running = false;
+		}
+		first.buffer.clear();
+		first.start = 0;
+		first.pos = 0;
+		first.flushed = 0;
+		first.end = -1;
+		first.done = false;
+		first.failures = 0;
+		first.ranged = false;
+		curl_easy_setopt(first.handle.ptr(), CURLOPT_RANGE, nullptr);
+		curl_easy_setopt(first.handle.ptr(), CURLOPT_RESUME_FROM_LARGE,
+			static_cast<curl_off_t>(0));
+		transfer.offset = 0;
+		transfer.speed_start = std::chrono::steady_clock::now();
+		transfer.speed_start_bytes = 0;
+		start_segment(first);
+	}
+
+	// The size of the partial file tells where to resume a download that
+	// isn't segmented, so everything past the stream's data has to go.
+	if (::ftruncate(transfer.fd, first.flushed) != 0) {
+		LOG(Level::WARN,
+			"DownloadEngine::unsplit_transfer: couldn't truncate %s: %s",
+			transfer.partial_filename(),
+			strerror(errno));
+	}
+	transfers_changed = true;
+}
+
+void DownloadEngine::complete_transfer(std::unique_ptr<Transfer> transfer)
+{
+	LOG(Level::DEBUG,
+		"DownloadEngine::complete_transfer: download complete, deleting "
+		"temporary suffix");
+	scheduler.remove(transfer->download);
+	if (!transfer->segmented) {
+		// Gives back the space that was reserved but not needed, in case
+		// the server sent less than it announced.
+		const auto ignored = ::ftruncate(transfer->fd,
+				transfer->segments.front()->pos);
+		static_cast<void>(ignored);
+	}
+	if (!sync_file(transfer->fd, transfer->fsync_policy)) {
+		const std::string message = strerror(errno);
+		LOG(Level::ERROR,
+			"DownloadEngine::complete_transfer: couldn't sync %s: %s",
+			transfer->partial_filename(),
+			message);
+		remove_transfer(*transfer);
+		post_result(*transfer, DlStatus::FAILED, message);
+		return;
+	}
+	::close(transfer->fd);
+	transfer->fd = -1;
+	::unlink(transfer->resume_map_filename().c_str());
+
+	const std::string partial_filename = transfer->partial_filename();
+	if (rename(partial_filename.c_str(), transfer->filename.c_str()) != 0) {
+		post_result(*transfer, DlStatus::RENAME_FAILED, strerror(errno));
+		return;
+	}
+	if (transfer->fsync_policy == FsyncPolicy::FULL) {
+		// The rename only survives a crash once the directory is synced.
+		sync_directory(transfer->filename);
+	}
+	post_result(*transfer, DlStatus::READY);
+}
+
+void DownloadEngine::fail_transfer(std::unique_ptr<Transfer> transfer,
+	const std::string& message)
+{
+	scheduler.remove(transfer->download);
+	for (const auto& segment : transfer->segments) {
+		if (segment->running) {
+			curl_multi_remove_handle(multi, segment->handle.ptr());
+			segment->running = false;
+		}
+	}
+	::close(transfer->fd);
+	transfer->fd = -1;
+	::unlink(transfer->partial_filename().c_str());
+	::unlink(transfer->resume_map_filename().c_str());
+
+	if (transfer->resumed) {
+		// attempt complete re-download
+		begin_transfer(transfer->download, transfer->url, transfer->filename);
+	} else {
+		post_result(*transfer, DlStatus::FAILED, message);
+	}
+}
+
+void DownloadEngine::remove_transfer(Transfer& transfer)
+{
+	scheduler.remove(transfer.download);
+	for (const auto& segment : transfer.segments) {
+		if (segment->running) {
+			curl_multi_remove_handle(multi, segment->handle.ptr());
+			segment->running = false;
+		}
+		segment->flush();
+	}
+	if (transfer.segmented) {
+		transfer.save_resume_map();
+	}
+	::close(transfer.fd);
+	transfer.fd = -1;
+}
+
+void DownloadEngine::post_result(const Transfer& transfer, DlStatus status,
+	const std::string& message)
+{
+	std::lock_guard<std::mutex> guard(queues_mtx);
+	if (cancelling.count(transfer.download) > 0) {
+		LOG(Level::DEBUG,
+			"DownloadEngine::post_result: %s was cancelled, dropping the result",
+			transfer.url);
+		return;
+	}
+	results.push_back(Result{transfer.download, transfer.url, status, message});
+}
+
+void DownloadEngine::publish_progress()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (!transfers_changed
+		&& now - last_published < std::chrono::milliseconds(PROGRESS_INTERVAL_MS)) {
+		return;
+	}
+	transfers_changed = false;
+	last_published = now;
+
+	auto snapshot = std::make_shared<std::vector<TransferProgress>>();
+	snapshot->reserve(transfers.size());
+	for (const auto& entry : transfers) {
+		const Transfer& transfer = *entry.second;
+		const curl_off_t received = transfer.received();
+
+		double kbps = 0.0;
+		const std::chrono::duration<double> elapsed = now - transfer.speed_start;
+		if (!transfer.paused && elapsed.count() > 0) {
+			kbps = (received - transfer.speed_start_bytes) / elapsed.count() / 1024;
+		}
+
+		snapshot->push_back(TransferProgress{
+			transfer.download,
+			transfer.url,
+			static_cast<double>(received),
+			static_cast<double>(transfer.expected()),
+			static_cast<unsigned long>(transfer.offset),
+			kbps});
+	}
+
+	std::atomic_store(&current_progress,
+		std::shared_ptr<const std::vector<TransferProgress>>(std::move(snapshot)));
+}
+
+void DownloadEngine::save_resume_maps()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (now - last_saved < std::chrono::milliseconds(RESUME_MAP_INTERVAL_MS)) {
+		return;
+	}
+	last_saved = now;
+
+	for (const auto& entry : transfers) {
+		if (entry.second->segmented) {
+			entry.second->save_resume_map();
+		}
+	}
+}
+
+void DownloadEngine::throttle()
+{
+	if (!scheduler.limited()) {
+		return;
+	}
+	scheduler.refill(std::chrono::steady_clock::now());
+
+	for (const auto& entry : transfers) {
+		const Transfer& transfer = *entry.second;
+		if (transfer.paused || !scheduler.may_receive(transfer.download)) {
+			continue;
+		}
+		for (const auto& segment : transfer.segments) {
+			if (segment->running && segment->throttled) {
+				// Unpausing can deliver data right away, which might
+				// throttle the segment again.
+				segment->throttled = false;
+				curl_easy_pause(segment->handle.ptr(), CURLPAUSE_CONT);
+			}
+		}
+	}
+}
+
+} // namespace podboat
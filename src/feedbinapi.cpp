@@ -1,12 +1,16 @@
 #include "feedbinapi.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
 #include <curl/curl.h>
+#include <memory>
 #include <string>
+#include <unordered_set>
 
 #include "3rd-party/json.hpp"
 #include "curlhandle.h"
+#include "jsonstream.h"
 #include "rss/feed.h"
 #include "strprintf.h"
 #include "utils.h"
@@ -16,6 +20,7 @@
 #define FEEDBIN_TAGGINGS_PATH "/v2/taggings.json"
 #define FEEDBIN_SUBSCRIPTIONS_PATH "/v2/subscriptions.json"
 #define FEEDBIN_UNREAD_ENTRIES_PATH "/v2/unread_entries.json"
+#define FEEDBIN_ENTRIES_PER_PAGE 100u
 
 using json = nlohmann::json;
 
@@ -104,15 +109,27 @@ std::vector<TaggedFeedUrl> FeedbinApi::get_subscribed_urls()
 bool FeedbinApi::mark_entries_read(const std::vector<std::string>& ids,
 	bool read)
 {
+	// Feedbin takes at most this many entries per request.
+	const std::size_t max_entries = 1000;
+
 	CurlHandle handle;
-	long response_code = 0;
 	HTTPMethod method = read ? HTTPMethod::DELETE : HTTPMethod::POST;
-	json body;
-	body["unread_entries"] = ids;
-	run_op(FEEDBIN_UNREAD_ENTRIES_PATH, body, handle, method);
-	curl_easy_getinfo(handle.ptr(), CURLINFO_RESPONSE_CODE, &response_code);
+	bool success = true;
+	for (std::size_t begin = 0; begin < ids.size(); begin += max_entries) {
+		const std::size_t end = std::min(ids.size(), begin + max_entries);
+		json body;
+		body["unread_entries"] = std::vector<std::string>(ids.begin() + begin,
+				ids.begin() + end);
+		run_op(FEEDBIN_UNREAD_ENTRIES_PATH, body, handle, method);
+
+		long response_code = 0;
+		curl_easy_getinfo(handle.ptr(), CURLINFO_RESPONSE_CODE, &response_code);
+		if (response_code != 200) {
+			success = false;
+		}
+	}
 
-	return response_code == 200;
+	return success;
 }
 
 bool FeedbinApi::mark_all_read(const std::string& combined_feed_url)
@@ -147,77 +164,129 @@ bool FeedbinApi::mark_article_read(const std::string& guid, bool read)
 	return mark_entries_read(entry_ids, read);
 }
 
+bool FeedbinApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	return mark_entries_read(guids, true);
+}
+
+bool FeedbinApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	return mark_entries_read(guids, false);
+}
+
 rsspp::Feed FeedbinApi::fetch_feed(const std::string& id)
 {
 	CurlHandle handle;
-	return fetch_feed(id, handle);
+	std::string sync_cursor;
+	return fetch_feed(id, handle, sync_cursor);
 }
 
 rsspp::Feed FeedbinApi::fetch_feed(const std::string& id,
-	CurlHandle& cached_handle)
+	CurlHandle& cached_handle,
+	std::string& sync_cursor)
 {
 	rsspp::Feed feed;
 	feed.rss_version = rsspp::Feed::FEEDBIN_JSON;
 
-	const json unread_entry_ids = run_op(FEEDBIN_UNREAD_ENTRIES_PATH, json());
-	if (!unread_entry_ids.is_array()) {
-		LOG(Level::ERROR,
-			"FeedbinApi::fetch_feed: unread_entry_ids is not an array");
+	// Replies are converted as they're parsed, so that they are never held
+	// in memory as a whole.
+	auto unread_guids = std::make_shared<std::unordered_set<std::string>>();
+	try {
+		const json unread_entry_ids = run_op(FEEDBIN_UNREAD_ENTRIES_PATH, json(),
+				cached_handle, HTTPMethod::GET,
+		[&](json&& entry_id) {
+			unread_guids->insert(std::to_string(entry_id.get<int64_t>()));
+		});
+		if (!unread_entry_ids.is_array()) {
+			LOG(Level::ERROR,
+				"FeedbinApi::fetch_feed: unread_entry_ids is not an array");
+			return feed;
+		}
+	} catch (json::exception& e) {
+		LOG(Level::ERROR, "Exception occurred while parsing feed: ", e.what());
 		return feed;
 	}
 
-	std::map<int, bool> unread_entry_id_map;
-	for (int entry_id : unread_entry_ids) {
-		unread_entry_id_map[entry_id] = true;
-	}
-
-	const std::string query = strprintf::fmt("/v2/feeds/%s/entries.json", id);
-
-	const json entries = run_op(query, json(), cached_handle, HTTPMethod::GET);
-	if (!entries.is_array()) {
-		LOG(Level::ERROR, "FeedbinApi::fetch_feed: entries is not an array");
-		return feed;
+	// The first sync gets the latest page of entries. After that, we only
+	// ask for entries created since the newest one we've seen, and take
+	// the read state of the others from the list of unread entries.
+	const bool incremental = !sync_cursor.empty();
+	std::string query = strprintf::fmt("/v2/feeds/%s/entries.json", id);
+	if (incremental) {
+		query += strprintf::fmt("?since=%s&per_page=%u",
+				sync_cursor,
+				FEEDBIN_ENTRIES_PER_PAGE);
 	}
 
-	LOG(Level::INFO, "FeedbinApi::fetch_feed: %" PRIu64 " items",
-		static_cast<uint64_t>(entries.size()));
-	try {
-		for (const auto& entry : entries) {
-			rsspp::Item item;
-
-			if (!entry["title"].is_null()) {
-				item.title = entry["title"];
-			}
-
-			if (!entry["url"].is_null()) {
-				item.link = entry["url"];
-			}
-
-			if (!entry["author"].is_null()) {
-				item.author = entry["author"];
-			}
-
-			if (!entry["content"].is_null()) {
-				item.content_encoded = entry["content"];
+	std::string newest_entry = sync_cursor;
+	for (unsigned int page = 1; ; page++) {
+		uint64_t entries = 0;
+		try {
+			const json rest = run_op(
+					incremental ? strprintf::fmt("%s&page=%u", query, page) : query,
+					json(), cached_handle, HTTPMethod::GET,
+			[&](json&& entry) {
+				rsspp::Item item;
+
+				if (!entry["title"].is_null()) {
+					item.title = entry["title"];
+				}
+
+				if (!entry["url"].is_null()) {
+					item.link = entry["url"];
+				}
+
+				if (!entry["author"].is_null()) {
+					item.author = entry["author"];
+				}
+
+				if (!entry["content"].is_null()) {
+					item.content_encoded = entry["content"];
+				}
+
+				const int64_t entry_id = entry["id"];
+				item.guid = std::to_string(entry_id);
+
+				item.pubDate = entry["published"];
+
+				if (unread_guids->count(item.guid) != 0) {
+					item.labels.push_back("feedbin:unread");
+				} else {
+					item.labels.push_back("feedbin:read");
+				}
+
+				// All timestamps are in UTC and have the same format, so
+				// they can be compared as strings.
+				if (entry.contains("created_at") && entry["created_at"].is_string()) {
+					newest_entry = std::max(newest_entry,
+							entry["created_at"].get<std::string>());
+				}
+
+				feed.items.push_back(item);
+				entries++;
+			});
+			if (!rest.is_array()) {
+				LOG(Level::ERROR, "FeedbinApi::fetch_feed: entries is not an array");
+				return feed;
 			}
+		} catch (json::exception& e) {
+			LOG(Level::ERROR, "Exception occurred while parsing feed: ", e.what());
+			return feed;
+		}
 
-			const int64_t entry_id = entry["id"];
-			item.guid = std::to_string(entry_id);
-
-			item.pubDate = entry["published"];
-
-			if (unread_entry_id_map[entry_id]) {
-				item.labels.push_back("feedbin:unread");
-			} else {
-				item.labels.push_back("feedbin:read");
-			}
+		LOG(Level::INFO, "FeedbinApi::fetch_feed: %" PRIu64 " items", entries);
 
-			feed.items.push_back(item);
+		if (!incremental || entries < FEEDBIN_ENTRIES_PER_PAGE) {
+			break;
 		}
-	} catch (json::exception& e) {
-		LOG(Level::ERROR, "Exception occurred while parsing feed: ", e.what());
 	}
 
+	if (incremental) {
+		feed.only_new_items = true;
+		feed.unread_guids = unread_guids;
+	}
+	sync_cursor = newest_entry;
+
 	std::sort(feed.items.begin(), feed.items.end(),
 	[](const rsspp::Item &a, const rsspp::Item &b) {
 		return a.pubDate_ts > b.pubDate_ts;
@@ -277,6 +346,14 @@ json FeedbinApi::run_op(const std::string& path, const json& args,
 json FeedbinApi::run_op(const std::string& path, const json& args,
 	CurlHandle& easyhandle,
 	const HTTPMethod method /* = GET */)
+{
+	return run_op(path, args, easyhandle, method, nullptr);
+}
+
+json FeedbinApi::run_op(const std::string& path, const json& args,
+	CurlHandle& easyhandle,
+	const HTTPMethod method,
+	const std::function<void(json&& element)>& on_element)
 {
 	if (method == HTTPMethod::POST || method == HTTPMethod::DELETE) {
 		curl_slist* headers = NULL;
@@ -301,15 +378,23 @@ json FeedbinApi::run_op(const std::string& path, const json& args,
 	const std::string result =
 		utils::retrieve_url(url, easyhandle, cfg, auth_info, body, method);
 
-	LOG(Level::INFO, "Feedbin::run_op(%s %s,...): body=%s reply = %s",
-		utils::http_method_str(method), path, arg_dump, result);
+	LOG_FIELDS(Level::INFO, "Feedbin::run_op", {
+		{"method", utils::http_method_str(method)},
+		{"path", path},
+		{"body", arg_dump},
+		{"reply", result}});
 
 	json content;
 	if (!result.empty()) {
 		try {
-			content = json::parse(result);
+			if (on_element) {
+				content = jsonstream::parse(result, "", on_element);
+			} else {
+				content = json::parse(result);
+			}
 		} catch (json::parse_error& e) {
-			LOG(Level::ERROR, "Feedbin::run_op: reply failed to parse: %s", result);
+			LOG_FIELDS(Level::ERROR, "Feedbin::run_op: reply failed to parse", {
+				{"reply", result}});
 			content = json(nullptr);
 		}
 	}
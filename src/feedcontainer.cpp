@@ -4,11 +4,40 @@
 #include <numeric>   // accumulate
 #include <unordered_set>
 
+#include "cache.h"
+#include "matchable.h"
+#include "matcher.h"
 #include "rssfeed.h"
 #include "utils.h"
 
 namespace newsboat {
 
+namespace {
+
+/// A feed as seen by a filter expression before its items are loaded: it
+/// knows the attributes that all of its items share, and whether none of
+/// them are unread.
+class FeedWithoutItems : public Matchable {
+public:
+	explicit FeedWithoutItems(const RssFeed& feed)
+		: feed(feed)
+	{}
+
+	nonstd::optional<std::string> attribute_value(const std::string& attr)
+	const override
+	{
+		if (attr == "unread" && feed.unread_item_count() == 0) {
+			return std::string("no");
+		}
+		return feed.attribute_value(attr);
+	}
+
+private:
+	const RssFeed& feed;
+};
+
+} // namespace
+
 void FeedContainer::sort_feeds(const FeedSortStrategy& sort_strategy)
 {
 	std::lock_guard<std::mutex> feedslock(feeds_mutex);
@@ -86,26 +115,20 @@ void FeedContainer::sort_feeds(const FeedSortStrategy& sort_strategy)
 		std::stable_sort(
 			feeds.begin(), feeds.end(),
 		[&](std::shared_ptr<RssFeed> a, std::shared_ptr<RssFeed> b) {
-			if (a->items().size() == 0 || b->items().size() == 0) {
-				bool result = a->items().size() > b->items().size();
+			if (a->total_item_count() == 0 || b->total_item_count() == 0) {
+				bool result = a->total_item_count() > b->total_item_count();
 				if (sort_strategy.sd == SortDirection::ASC) {
 					result = !result;
 				}
 				return result;
 			}
-			auto cmp = [](std::shared_ptr<RssItem> a,
-			std::shared_ptr<RssItem> b) {
-				return *a < *b;
-			};
-			auto& a_item = *std::min_element(a->items().begin(),
-					a->items().end(), cmp);
-			auto& b_item = *std::min_element(b->items().begin(),
-					b->items().end(), cmp);
+			const auto a_latest = a->latest_item_timestamp();
+			const auto b_latest = b->latest_item_timestamp();
 
 			if (sort_strategy.sd == SortDirection::DESC) {
-				return *a_item < *b_item;
+				return a_latest > b_latest;
 			} else {
-				return *b_item < *a_item;
+				return b_latest > a_latest;
 			}
 		});
 		break;
@@ -123,8 +146,13 @@ std::shared_ptr<RssFeed> FeedContainer::get_feed(const unsigned int pos)
 
 void FeedContainer::mark_all_feed_items_read(std::shared_ptr<RssFeed> feed)
 {
+	if (!feed->items_loaded()) {
+		feed->mark_all_items_read();
+		return;
+	}
+
 	std::lock_guard<std::mutex> lock(feed->item_mutex);
-	std::vector<std::shared_ptr<RssItem>>& items = feed->items();
+	const auto& items = feed->items();
 	if (items.size() > 0) {
 		bool notify = items[0]->feedurl() != feed->rssurl();
 		LOG(Level::DEBUG,
@@ -153,9 +181,48 @@ void FeedContainer::add_feed(const std::shared_ptr<RssFeed> feed)
 void FeedContainer::populate_query_feeds()
 {
 	std::lock_guard<std::mutex> feedslock(feeds_mutex);
+	std::vector<std::shared_ptr<RssFeed>> query_feeds;
 	for (const auto& feed : feeds) {
 		if (feed->is_query_feed()) {
-			feed->update_items(feeds);
+			query_feeds.push_back(feed);
+		}
+	}
+	if (query_feeds.empty()) {
+		return;
+	}
+
+	for (const auto& query_feed : query_feeds) {
+		load_query_feed_sources_unlocked(*query_feed);
+	}
+	for (const auto& query_feed : query_feeds) {
+		query_feed->update_items(feeds);
+	}
+	unload_unused_feed_items_unlocked(nullptr);
+}
+
+void FeedContainer::update_query_feed(std::shared_ptr<RssFeed> query_feed)
+{
+	std::lock_guard<std::mutex> feedslock(feeds_mutex);
+	load_query_feed_sources_unlocked(*query_feed);
+	query_feed->update_items(feeds);
+	// Only now are the items that the query feed used to hold let go of, so
+	// the feeds they came from can be unloaded.
+	unload_unused_feed_items_unlocked(query_feed);
+}
+
+void FeedContainer::load_query_feed_sources_unlocked(const RssFeed& query_feed)
+{
+	// Only load the feeds that the query could take items from.
+	Matcher m(query_feed.get_query());
+	for (const auto& feed : feeds) {
+		if (feed->is_query_feed() || feed->total_item_count() == 0) {
+			continue;
+		}
+		// Feeds that are loaded already count as used, so that they aren't
+		// the first to be unloaded again.
+		FeedWithoutItems summary(*feed);
+		if (m.may_match(&summary)) {
+			load_feed_items_unlocked(feed);
 		}
 	}
 }
@@ -268,12 +335,13 @@ unsigned int FeedContainer::unread_item_count() const
 {
 	std::lock_guard<std::mutex> feedslock(feeds_mutex);
 
+	unsigned int summary_unread_count = 0;
 	using guid_set = std::unordered_set<std::string>;
 	const auto unread_guids =
 		std::accumulate(feeds.begin(),
 			feeds.end(),
 			guid_set(),
-	[](guid_set guids, const std::shared_ptr<RssFeed> feed) {
+	[&](guid_set guids, const std::shared_ptr<RssFeed> feed) {
 		// Hidden feeds can't be viewed. The only way to read their articles is
 		// via a query feed; items that aren't in query feeds are completely
 		// inaccessible. Thus, we skip hidden feeds altogether to avoid
@@ -282,6 +350,14 @@ unsigned int FeedContainer::unread_item_count() const
 			return guids;
 		}
 
+		// Only the counts are known for feeds that aren't loaded, so their
+		// items can't be deduplicated. They're not query feeds, though, so
+		// they can't contain items of other feeds either.
+		if (!feed->items_loaded()) {
+			summary_unread_count += feed->unread_item_count();
+			return guids;
+		}
+
 		std::lock_guard<std::mutex> itemslock(feed->item_mutex);
 		for (const auto& item : feed->items()) {
 			if (item->unread()) {
@@ -292,7 +368,7 @@ unsigned int FeedContainer::unread_item_count() const
 		return guids;
 	});
 
-	return unread_guids.size();
+	return unread_guids.size() + summary_unread_count;
 }
 
 void FeedContainer::replace_feed(unsigned int pos,
@@ -303,4 +379,77 @@ void FeedContainer::replace_feed(unsigned int pos,
 	feeds[pos] = feed;
 }
 
+void FeedContainer::enable_lazy_loading(Cache* cache, RssIgnores* ignores,
+	unsigned int max_items)
+{
+	std::lock_guard<std::mutex> feedslock(feeds_mutex);
+	lazy_cache = cache;
+	lazy_ignores = ignores;
+	max_loaded_items = max_items;
+}
+
+void FeedContainer::load_feed_items(std::shared_ptr<RssFeed> feed)
+{
+	std::lock_guard<std::mutex> feedslock(feeds_mutex);
+	load_feed_items_unlocked(feed);
+	unload_unused_feed_items_unlocked(feed);
+}
+
+void FeedContainer::load_feed_items_unlocked(const std::shared_ptr<RssFeed>&
+	feed)
+{
+	if (lazy_cache == nullptr || feed->is_query_feed()) {
+		return;
+	}
+
+	feed->set_last_used(++use_counter);
+	if (!feed->items_loaded()) {
+		LOG(Level::DEBUG,
+			"FeedContainer::load_feed_items: loading items of %s",
+			feed->rssurl());
+		lazy_cache->internalize_items(feed, lazy_ignores);
+	}
+}
+
+void FeedContainer::unload_unused_feed_items_unlocked(
+	const std::shared_ptr<RssFeed>& keep)
+{
+	if (lazy_cache == nullptr || max_loaded_items == 0) {
+		return;
+	}
+
+	std::vector<std::shared_ptr<RssFeed>> loaded_feeds;
+	unsigned int loaded_items = 0;
+	for (const auto& feed : feeds) {
+		if (!feed->is_query_feed() && feed->items_loaded()) {
+			loaded_feeds.push_back(feed);
+			loaded_items += feed->total_item_count();
+		}
+	}
+
+	std::sort(loaded_feeds.begin(), loaded_feeds.end(),
+		[](const std::shared_ptr<RssFeed>& a, const std::shared_ptr<RssFeed>& b) {
+		return a->get_last_used() < b->get_last_used();
+	});
+
+	for (const auto& feed : loaded_feeds) {
+		if (loaded_items <= max_loaded_items) {
+			break;
+		}
+		if (feed == keep) {
+			continue;
+		}
+
+		const auto item_count = feed->total_item_count();
+		if (feed->unload_items()) {
+			LOG(Level::DEBUG,
+				"FeedContainer::unload_unused_feed_items: unloaded %u "
+				"items of %s",
+				item_count,
+				feed->rssurl());
+			loaded_items -= item_count;
+		}
+	}
+}
+
 } // namespace newsboat
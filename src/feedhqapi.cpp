@@ -89,22 +89,15 @@ std::vector<TaggedFeedUrl> FeedHqApi::get_subscribed_urls()
 	CurlHandle handle;
 	curl_slist* custom_headers{};
 	add_custom_headers(&custom_headers);
-	curl_easy_setopt(handle.ptr(), CURLOPT_HTTPHEADER, custom_headers);
 
 	utils::set_common_curl_options(handle, cfg);
-	curl_easy_setopt(handle.ptr(),
-		CURLOPT_URL,
-		(cfg.get_configvalue("feedhq-url") + FEEDHQ_SUBSCRIPTION_LIST)
-		.c_str());
-	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
-
-	curl_easy_perform(handle.ptr());
+	const std::string result = get_subscription_reply(handle,
+			cfg.get_configvalue("feedhq-url") + FEEDHQ_SUBSCRIPTION_LIST,
+			&custom_headers);
 	curl_slist_free_all(custom_headers);
 
-	const auto result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"FeedHqApi::get_subscribed_urls: document = %s",
-		result);
+	LOG_FIELDS(Level::DEBUG, "FeedHqApi::get_subscribed_urls", {
+		{"document", result}});
 
 	json_object* reply = json_tokener_parse(result.c_str());
 	if (reply == nullptr) {
@@ -205,27 +198,42 @@ bool FeedHqApi::mark_all_read(const std::string& feedurl)
 bool FeedHqApi::mark_article_read(const std::string& guid, bool read)
 {
 	std::string token = get_new_token();
-	return mark_article_read_with_token(guid, read, token);
+	return mark_articles_read_with_token({guid}, read, token);
+}
+
+bool FeedHqApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	std::string token = get_new_token();
+	return mark_articles_read_with_token(guids, true, token);
+}
+
+bool FeedHqApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	std::string token = get_new_token();
+	return mark_articles_read_with_token(guids, false, token);
 }
 
-bool FeedHqApi::mark_article_read_with_token(const std::string& guid,
+bool FeedHqApi::mark_articles_read_with_token(
+	const std::vector<std::string>& guids,
 	bool read,
 	const std::string& token)
 {
+	// edit-tag applies the same change to every article passed as `i`.
 	std::string postcontent;
+	for (const auto& guid : guids) {
+		postcontent += strprintf::fmt("i=%s&", guid);
+	}
 
 	if (read) {
-		postcontent = strprintf::fmt(
-				"i=%s&a=user/-/state/com.google/read&r=user/-/state/"
+		postcontent += strprintf::fmt(
+				"a=user/-/state/com.google/read&r=user/-/state/"
 				"com.google/kept-unread&ac=edit&T=%s",
-				guid,
 				token);
 	} else {
-		postcontent = strprintf::fmt(
-				"i=%s&r=user/-/state/com.google/read&a=user/-/state/"
+		postcontent += strprintf::fmt(
+				"r=user/-/state/com.google/read&a=user/-/state/"
 				"com.google/kept-unread&a=user/-/state/com.google/"
 				"tracking-kept-unread&ac=edit&T=%s",
-				guid,
 				token);
 	}
 
@@ -233,12 +241,9 @@ bool FeedHqApi::mark_article_read_with_token(const std::string& guid,
 			cfg.get_configvalue("feedhq-url") + FEEDHQ_API_EDIT_TAG_URL,
 			postcontent);
 
-	LOG(Level::DEBUG,
-		"FeedHqApi::mark_article_read_with_token: postcontent = %s "
-		"result "
-		"= %s",
-		postcontent,
-		result);
+	LOG_FIELDS(Level::DEBUG, "FeedHqApi::mark_articles_read_with_token", {
+		{"postcontent", postcontent},
+		{"result", result}});
 
 	return result == "OK";
 }
@@ -356,11 +361,10 @@ std::string FeedHqApi::post_content(const std::string& url,
 	curl_slist_free_all(custom_headers);
 
 	const auto result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"FeedHqApi::post_content: url = %s postdata = %s result = %s",
-		url,
-		postdata,
-		result);
+	LOG_FIELDS(Level::DEBUG, "FeedHqApi::post_content", {
+		{"url", url},
+		{"postdata", postdata},
+		{"result", result}});
 
 	return result;
 }
@@ -595,7 +595,7 @@ void FeedListFormAction::update_visible_feeds(
 
 	visible_feeds.clear();
 
-	bool show_read = cfg->get_configvalue_as_bool("show-read-feeds");
+	const bool show_read = cfg->snapshot()->show_read_feeds;
 
 	unsigned int i = 0;
 	for (const auto& feed : feeds) {
@@ -617,7 +617,7 @@ void FeedListFormAction::set_feedlist(
 
 	const unsigned int width = list.get_width();
 
-	std::string feedlist_format = cfg->get_configvalue("feedlist-format");
+	std::string feedlist_format = cfg->snapshot()->feedlist_format;
 
 	ListFormatter listfmt(&rxman, "feedlist");
 
@@ -0,0 +1,248 @@
+#include "feedlistsnapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "configcontainer.h"
+#include "logger.h"
+
+namespace newsboat {
+
+namespace {
+
+const char MAGIC[8] = {'N', 'B', 'F', 'L', 'S', 'N', 'A', 'P'};
+
+struct Header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t cache_generation;
+	std::int64_t urls_mtime;
+	std::uint64_t config_hash;
+	std::int64_t expires;
+	std::uint32_t feed_count;
+	std::uint32_t reserved;
+};
+
+struct Record {
+	std::int64_t latest_item_timestamp;
+	std::uint32_t total_count;
+	std::uint32_t unread_count;
+	std::uint32_t rssurl_length;
+	std::uint32_t title_length;
+	std::uint32_t link_length;
+	std::uint32_t is_rtl;
+};
+
+// SQLite keeps the "file change counter" as a big-endian integer at offset 24
+// of the database header.
+const std::streamoff SQLITE_CHANGE_COUNTER_OFFSET = 24;
+
+std::uint32_t read_cache_generation(const std::string& cache_file)
+{
+	std::ifstream f(cache_file, std::ios::binary);
+	unsigned char bytes[4] = {};
+	if (!f.seekg(SQLITE_CHANGE_COUNTER_OFFSET) ||
+		!f.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+		return 0;
+	}
+	return (std::uint32_t(bytes[0]) << 24) | (std::uint32_t(bytes[1]) << 16)
+		| (std::uint32_t(bytes[2]) << 8) | std::uint32_t(bytes[3]);
+}
+
+// Settings that change which articles are counted.
+const char* const COUNTED_SETTINGS[] = {
+	"max-items",
+	"keep-articles-days",
+	"ignore-mode",
+};
+
+/// 64-bit FNV-1a, which gives the same result in every run.
+std::uint64_t hash_settings(const ConfigContainer& cfg)
+{
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	for (const char* setting : COUNTED_SETTINGS) {
+		// The terminator separates the values.
+		const std::string value = cfg.get_configvalue(setting);
+		for (const char c : value + '\0') {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+		}
+	}
+	return hash;
+}
+
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& path)
+	{
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			return;
+		}
+		struct stat sb;
+		if (::fstat(fd, &sb) == 0 && sb.st_size > 0) {
+			void* addr = ::mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (addr != MAP_FAILED) {
+				data = static_cast<const char*>(addr);
+				size = sb.st_size;
+			}
+		}
+		::close(fd);
+	}
+
+	~MappedFile()
+	{
+		if (data != nullptr) {
+			::munmap(const_cast<char*>(data), size);
+		}
+	}
+
+	const char* data = nullptr;
+	std::size_t size = 0;
+};
+
+} // namespace
+
+const std::uint32_t FeedListSnapshot::VERSION;
+
+FeedListSnapshot::Key FeedListSnapshot::current_key(
+	const std::string& cache_file,
+	const std::string& url_file,
+	const ConfigContainer& cfg)
+{
+	Key key{read_cache_generation(cache_file), -1, hash_settings(cfg)};
+	struct stat sb;
+	if (::stat(url_file.c_str(), &sb) == 0) {
+		key.urls_mtime = sb.st_mtime;
+	}
+	return key;
+}
+
+bool FeedListSnapshot::write(const std::string& path, const Key& key,
+	const FeedSummaries& summaries, time_t expires)
+{
+	std::string records;
+	for (const auto& entry : summaries) {
+		const std::string& rssurl = entry.first;
+		const FeedSummary& summary = entry.second;
+
+		Record record{};
+		record.latest_item_timestamp = summary.latest_item_timestamp;
+		record.total_count = summary.total_count;
+		record.unread_count = summary.unread_count;
+		record.rssurl_length = rssurl.size();
+		record.title_length = summary.title.size();
+		record.link_length = summary.link.size();
+		record.is_rtl = summary.is_rtl ? 1 : 0;
+
+		records.append(reinterpret_cast<const char*>(&record), sizeof(record));
+		records.append(rssurl);
+		records.append(summary.title);
+		records.append(summary.link);
+	}
+	const std::uint32_t feed_count = summaries.size();
+
+	Header header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.cache_generation = key.cache_generation;
+	header.urls_mtime = key.urls_mtime;
+	header.config_hash = key.config_hash;
+	header.expires = expires;
+	header.feed_count = feed_count;
+
+	const std::string tmp_path = path + ".tmp";
+	{
+		std::ofstream f(tmp_path, std::ios::binary | std::ios::trunc);
+		f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		f.write(records.data(), records.size());
+		if (!f) {
+			LOG(Level::ERROR,
+				"FeedListSnapshot::write: couldn't write %s",
+				tmp_path);
+			std::remove(tmp_path.c_str());
+			return false;
+		}
+	}
+	if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+		LOG(Level::ERROR,
+			"FeedListSnapshot::write: couldn't rename %s to %s",
+			tmp_path,
+			path);
+		std::remove(tmp_path.c_str());
+		return false;
+	}
+
+	LOG(Level::DEBUG,
+		"FeedListSnapshot::write: wrote %u feeds to %s",
+		feed_count,
+		path);
+	return true;
+}
+
+nonstd::optional<FeedSummaries> FeedListSnapshot::read(const std::string& path,
+	const Key& key, time_t now)
+{
+	const MappedFile file(path);
+	if (file.size < sizeof(Header)) {
+		return nonstd::nullopt;
+	}
+
+	Header header;
+	std::memcpy(&header, file.data, sizeof(header));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+		|| header.version != VERSION) {
+		LOG(Level::DEBUG,
+			"FeedListSnapshot::read: %s has an unknown format",
+			path);
+		return nonstd::nullopt;
+	}
+	if (!(Key{header.cache_generation, header.urls_mtime, header.config_hash} == key)
+		|| (header.expires != 0 && header.expires <= now)) {
+		LOG(Level::DEBUG, "FeedListSnapshot::read: %s is outdated", path);
+		return nonstd::nullopt;
+	}
+
+	FeedSummaries summaries;
+	std::size_t offset = sizeof(Header);
+	for (std::uint32_t i = 0; i < header.feed_count; ++i) {
+		if (file.size - offset < sizeof(Record)) {
+			return nonstd::nullopt;
+		}
+		Record record;
+		std::memcpy(&record, file.data + offset, sizeof(record));
+		offset += sizeof(record);
+
+		const std::size_t strings_length = std::size_t(record.rssurl_length)
+			+ record.title_length + record.link_length;
+		if (file.size - offset < strings_length) {
+			return nonstd::nullopt;
+		}
+		const char* strings = file.data + offset;
+		offset += strings_length;
+
+		std::string rssurl(strings, record.rssurl_length);
+		strings += record.rssurl_length;
+		FeedSummary summary;
+		summary.title.assign(strings, record.title_length);
+		strings += record.title_length;
+		summary.link.assign(strings, record.link_length);
+		summary.is_rtl = record.is_rtl != 0;
+		summary.total_count = record.total_count;
+		summary.unread_count = record.unread_count;
+		summary.latest_item_timestamp = record.latest_item_timestamp;
+		summaries.emplace(std::move(rssurl), std::move(summary));
+	}
+
+	LOG(Level::DEBUG,
+		"FeedListSnapshot::read: read %u feeds from %s",
+		header.feed_count,
+		path);
+	return summaries;
+}
+
+} // namespace newsboat
@@ -1,6 +1,8 @@
 #include "feedretriever.h"
 
 #include <cinttypes>
+#include <curl/curl.h>
+#include <ctime>
 
 #include "cache.h"
 #include "config.h"
@@ -8,6 +10,7 @@
 #include "curlhandle.h"
 #include "feedbinapi.h"
 #include "freshrssapi.h"
+#include "inoreaderapi.h"
 #include "logger.h"
 #include "minifluxapi.h"
 #include "newsblurapi.h"
@@ -16,18 +19,24 @@
 #include "rss/parser.h"
 #include "rssignores.h"
 #include "strprintf.h"
+#include "syncqueue.h"
 #include "ttrssapi.h"
 #include "utils.h"
 
+// Articles may show up on the server a little after they were added, so the
+// next sync starts this many seconds before the last one did.
+#define INOREADER_SYNC_OVERLAP 300
+
 namespace newsboat {
 
 FeedRetriever::FeedRetriever(ConfigContainer& cfg, Cache& ch, RssIgnores* ign,
-	RemoteApi* api, CurlHandle* easyhandle)
+	RemoteApi* api, CurlHandle* easyhandle, SyncQueue* sync_queue)
 	: cfg(cfg)
 	, ch(ch)
 	, ign(ign)
 	, api(api)
 	, easyhandle(easyhandle)
+	, sync_queue(sync_queue)
 {
 }
 
@@ -40,11 +49,17 @@ rsspp::Feed FeedRetriever::retrieve(const std::string& uri)
 	 *parsed
 	 *	- query: URLs are ignored
 	 */
+	if (api) {
+		// The subscription list may still be fetched in the background,
+		// and the APIs aren't made to fetch feeds at the same time.
+		api->wait_for_subscription_refresh();
+	}
+
 	const std::string urls_source = cfg.get_configvalue("urls-source");
 	if (urls_source == "ttrss") {
 		const std::string::size_type pound = uri.find_first_of('#');
 		if (pound != std::string::npos) {
-			return fetch_ttrss(uri.substr(pound + 1));
+			return fetch_ttrss(uri, uri.substr(pound + 1));
 		} else {
 			return {};
 		}
@@ -58,12 +73,14 @@ rsspp::Feed FeedRetriever::retrieve(const std::string& uri)
 		const std::string::size_type pound = uri.find_first_of('#');
 		if (pound != std::string::npos) {
 			const std::string feed_id = uri.substr(pound + 1);
-			return fetch_feedbin(feed_id);
+			return fetch_feedbin(uri, feed_id);
 		} else {
 			return {};
 		}
 	} else if (urls_source == "freshrss") {
 		return fetch_freshrss(uri);
+	} else if (urls_source == "inoreader" && utils::is_http_url(uri)) {
+		return fetch_inoreader(uri);
 	} else if (utils::is_http_url(uri)) {
 		return download_http(uri);
 	} else if (utils::is_exec_url(uri)) {
@@ -80,18 +97,16 @@ rsspp::Feed FeedRetriever::retrieve(const std::string& uri)
 	}
 }
 
-rsspp::Feed FeedRetriever::fetch_ttrss(const std::string& feed_id)
+rsspp::Feed FeedRetriever::fetch_ttrss(const std::string& uri,
+	const std::string& feed_id)
 {
 	rsspp::Feed f;
 	TtRssApi* tapi = dynamic_cast<TtRssApi*>(api);
 	if (tapi) {
-		if (easyhandle) {
-			f = tapi->fetch_feed(
-					feed_id, *easyhandle);
-		} else {
-			f = tapi->fetch_feed(
-					feed_id);
-		}
+		CurlHandle handle;
+		std::string cursor = fetch_sync_cursor(uri);
+		f = tapi->fetch_feed(feed_id, easyhandle ? *easyhandle : handle, cursor);
+		save_sync_state(uri, f, cursor);
 	}
 	LOG(Level::DEBUG,
 		"FeedRetriever::fetch_ttrss: f.items.size = %" PRIu64,
@@ -105,7 +120,11 @@ rsspp::Feed FeedRetriever::fetch_newsblur(const std::string& feed_id)
 	rsspp::Feed f;
 	NewsBlurApi* napi = dynamic_cast<NewsBlurApi*>(api);
 	if (napi) {
-		f = napi->fetch_feed(feed_id);
+		if (easyhandle) {
+			f = napi->fetch_feed(feed_id, *easyhandle);
+		} else {
+			f = napi->fetch_feed(feed_id);
+		}
 	}
 	LOG(Level::INFO,
 		"FeedRetriever::fetch_newsblur: f.items.size = %" PRIu64,
@@ -119,7 +138,9 @@ rsspp::Feed FeedRetriever::fetch_ocnews(const std::string& feed_id)
 	rsspp::Feed f;
 	OcNewsApi* napi = dynamic_cast<OcNewsApi*>(api);
 	if (napi) {
-		f = napi->fetch_feed(feed_id);
+		std::string cursor = fetch_sync_cursor(feed_id);
+		f = napi->fetch_feed(feed_id, cursor);
+		save_sync_state(feed_id, f, cursor);
 	}
 	LOG(Level::INFO,
 		"FeedRetriever::fetch_ocnews: f.items.size = %" PRIu64,
@@ -133,11 +154,10 @@ rsspp::Feed FeedRetriever::fetch_miniflux(const std::string& feed_id)
 	rsspp::Feed f;
 	MinifluxApi* mapi = dynamic_cast<MinifluxApi*>(api);
 	if (mapi) {
-		if (easyhandle) {
-			f = mapi->fetch_feed(feed_id, *easyhandle);
-		} else {
-			f = mapi->fetch_feed(feed_id);
-		}
+		CurlHandle handle;
+		std::string cursor = fetch_sync_cursor(feed_id);
+		f = mapi->fetch_feed(feed_id, easyhandle ? *easyhandle : handle, cursor);
+		save_sync_state(feed_id, f, cursor);
 	}
 	LOG(Level::INFO,
 		"FeedRetriever::fetch_miniflux: f.items.size = %" PRIu64,
@@ -146,17 +166,16 @@ rsspp::Feed FeedRetriever::fetch_miniflux(const std::string& feed_id)
 	return f;
 }
 
-rsspp::Feed FeedRetriever::fetch_feedbin(const std::string& feed_id)
+rsspp::Feed FeedRetriever::fetch_feedbin(const std::string& uri,
+	const std::string& feed_id)
 {
 	rsspp::Feed f;
 	FeedbinApi* fapi = dynamic_cast<FeedbinApi*>(api);
 	if (fapi) {
-		if (easyhandle) {
-			f = fapi->fetch_feed(feed_id, *easyhandle);
-		} else {
-			f = fapi->fetch_feed(feed_id);
-		}
-
+		CurlHandle handle;
+		std::string cursor = fetch_sync_cursor(uri);
+		f = fapi->fetch_feed(feed_id, easyhandle ? *easyhandle : handle, cursor);
+		save_sync_state(uri, f, cursor);
 	}
 	LOG(Level::INFO,
 		"FeedRetriever::fetch_feedbin: f.items.size = %" PRIu64,
@@ -170,12 +189,10 @@ rsspp::Feed FeedRetriever::fetch_freshrss(const std::string& feed_id)
 	rsspp::Feed f;
 	FreshRssApi* fapi = dynamic_cast<FreshRssApi*>(api);
 	if (fapi) {
-		if (easyhandle) {
-			f = fapi->fetch_feed(feed_id, *easyhandle);
-		} else {
-			f = fapi->fetch_feed(feed_id);
-		}
-
+		CurlHandle handle;
+		std::string cursor = fetch_sync_cursor(feed_id);
+		f = fapi->fetch_feed(feed_id, easyhandle ? *easyhandle : handle, cursor);
+		save_sync_state(feed_id, f, cursor);
 	}
 	LOG(Level::INFO,
 		"FeedRetriever::fetch_freshrss: f.items.size = %" PRIu64,
@@ -184,6 +201,72 @@ rsspp::Feed FeedRetriever::fetch_freshrss(const std::string& feed_id)
 	return f;
 }
 
+rsspp::Feed FeedRetriever::fetch_inoreader(const std::string& uri)
+{
+	InoreaderApi* iapi = dynamic_cast<InoreaderApi*>(api);
+	if (!iapi) {
+		return download_http(uri);
+	}
+
+	// The first sync gets the newest articles. After that, we only ask for
+	// articles added since the last sync, oldest first, and take the read
+	// state of the others from the list of unread articles.
+	std::string cursor = fetch_sync_cursor(uri);
+	const time_t started = time(nullptr);
+	const bool incremental = !cursor.empty();
+	rsspp::Feed f = download_http(incremental
+			? uri + "&r=o&ot=" + cursor
+			: uri);
+	if (f.rss_version == rsspp::Feed::Version::UNKNOWN) {
+		return f;
+	}
+
+	if (incremental) {
+		f.unread_guids = iapi->fetch_unread_guids(uri);
+		f.only_new_items = f.unread_guids != nullptr;
+	}
+
+	// A full reply may have left out newer articles, so the next sync
+	// carries on from the newest one we got.
+	const unsigned int min_items = cfg.get_configvalue_as_int(
+			"inoreader-min-items");
+	time_t newest = 0;
+	if (incremental && min_items > 0 && f.items.size() >= min_items) {
+		newest = curl_getdate(f.items.back().pubDate.c_str(), nullptr);
+	}
+	cursor = std::to_string(newest > 0 ? newest : started - INOREADER_SYNC_OVERLAP);
+	save_sync_state(uri, f, cursor);
+
+	LOG(Level::INFO,
+		"FeedRetriever::fetch_inoreader: f.items.size = %" PRIu64,
+		static_cast<uint64_t>(f.items.size()));
+
+	return f;
+}
+
+std::string FeedRetriever::fetch_sync_cursor(const std::string& uri)
+{
+	// Feeds that ignore Last-Modified are always fetched in full.
+	if (ign && ign->matches_lastmodified(uri)) {
+		return {};
+	}
+	return ch.fetch_sync_cursor(uri);
+}
+
+void FeedRetriever::save_sync_state(const std::string& uri,
+	const rsspp::Feed& f,
+	const std::string& cursor)
+{
+	if (f.only_new_items && f.unread_guids) {
+		// Changes that are still queued would be undone by the server's
+		// older state.
+		ch.sync_unread_state(uri, *f.unread_guids,
+			sync_queue ? sync_queue->pending_read_state()
+			: std::unordered_set<std::string>());
+	}
+	ch.update_sync_cursor(uri, cursor);
+}
+
 rsspp::Feed FeedRetriever::download_http(const std::string& uri)
 {
 	rsspp::Feed f;
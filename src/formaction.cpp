@@ -52,6 +52,7 @@ FormAction::FormAction(View& vv, std::string formstr, ConfigContainer* cfg)
 	valid_cmds.push_back("source");
 	valid_cmds.push_back("dumpconfig");
 	valid_cmds.push_back("exec");
+	valid_cmds.push_back("stats");
 }
 
 void FormAction::set_keymap_hints()
@@ -333,6 +334,9 @@ void FormAction::handle_parsed_command(const Command& command)
 	case CommandType::EXEC:
 		handle_exec(command.args);
 		break;
+	case CommandType::STATS:
+		v.push_stats();
+		break;
 	case CommandType::UNKNOWN:
 		v.get_statusline().show_error(strprintf::fmt(_("Not a command: %s"), command.args[0]));
 		break;
@@ -623,6 +627,8 @@ Command FormAction::parse_command(const std::string& input,
 			return Command { .type = CommandType::DUMPCONFIG, .args = std::move(tokens) };
 		} else if (cmd_name == "exec") {
 			return Command { .type = CommandType::EXEC, .args = std::move(tokens) };
+		} else if (cmd_name == "stats") {
+			return Command { .type = CommandType::STATS, .args = std::move(tokens) };
 		} else if (cmd_name == "tag") {
 			return Command { .type = CommandType::TAG, .args = std::move(tokens) };
 		} else if (cmd_name == "goto") {
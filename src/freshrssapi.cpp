@@ -1,14 +1,18 @@
 #include "freshrssapi.h"
 
+#include <algorithm>
+#include <cinttypes>
 #include <cstring>
 #include <curl/curl.h>
 #include <json.h>
 #include <time.h>
+#include <utility>
 #include <vector>
 
 #include "config.h"
 #include "curldatareceiver.h"
 #include "curlhandle.h"
+#include "jsonstream.h"
 #include "strprintf.h"
 #include "utils.h"
 #include "rss/feed.h"
@@ -25,9 +29,107 @@
 #define FRESHRSS_API_MARK_ALL_READ_URL FRESHRSS_API_PREFIX "mark-all-as-read"
 #define FRESHRSS_API_EDIT_TAG_URL FRESHRSS_API_PREFIX "edit-tag"
 #define FRESHRSS_API_TOKEN_URL FRESHRSS_API_PREFIX "token"
+#define FRESHRSS_UNREAD_IDS_URL FRESHRSS_API_PREFIX "stream/items/ids"
+
+#define FRESHRSS_READING_LIST "user%2F-%2Fstate%2Fcom.google%2Freading-list"
+
+#define FRESHRSS_MAX_PAGES 20u
+#define FRESHRSS_MAX_UNREAD_IDS 10000u
+#define FRESHRSS_BULK_PAGE_SIZE 1000u
 
 namespace newsboat {
 
+namespace {
+
+rsspp::Item parse_item(const nlohmann::json& entry)
+{
+	rsspp::Item item;
+
+	// Title
+	if (entry.contains("title") && !entry["title"].is_null()) {
+		item.title = entry["title"];
+	}
+
+	// Link
+	if (entry.contains("canonical") && !entry["canonical"].is_null()) {
+		for (const auto& a : entry["canonical"]) {
+			if (a.contains("href") && !a["href"].is_null()) {
+				item.link = a["href"];
+				break;
+			}
+		}
+	}
+
+	// Author
+	if (entry.contains("author") && !entry["author"].is_null()) {
+		item.author = entry["author"];
+	}
+
+	// Content
+	if (entry.contains("summary") && !entry["summary"].is_null()) {
+		for (const auto& a : entry["summary"].items()) {
+			if (!a.value().is_null()) {
+				item.content_encoded = a.value();
+				break;
+			}
+		}
+	}
+
+	// Guid
+	if (entry.contains("id") && !entry["id"].is_null()) {
+		item.guid = entry["id"];
+	}
+
+	// Publish date
+	if (entry.contains("published") && !entry["published"].is_null()) {
+		int pub_time = entry["published"];
+		time_t updated = static_cast<time_t>(pub_time);
+
+		item.pubDate = utils::mt_strf_localtime(
+				"%a, %d %b %Y %H:%M:%S %z",
+				updated);
+		item.pubDate_ts = pub_time;
+	}
+
+	// Podcast enclosure
+	if (entry.contains("enclosure") && !entry["enclosure"].is_null()) {
+		for (const auto& a : entry["enclosure"]) {
+			if (a.contains("href") && a.contains("type")
+				&& !a["href"].is_null() && !a["type"].is_null()) {
+				item.enclosures.push_back(
+				rsspp::Enclosure {
+					a["href"],
+					a["type"],
+					"",
+					"",
+				}
+				);
+				break;
+			}
+		}
+	}
+
+	// Read/unread status
+	bool unread = true;
+	if (entry.contains("categories")
+		&& !entry["categories"].is_null()) {
+		for (const auto& a: entry["categories"]) {
+			if (a == "user/-/state/com.google/read") {
+				unread = false;
+			}
+		}
+	}
+	if (unread) {
+		item.labels.push_back("unread");
+	} else {
+		item.labels.push_back("read");
+	}
+
+	return item;
+}
+
+} // namespace
+
 FreshRssApi::FreshRssApi(ConfigContainer& c)
 	: RemoteApi(c)
 {
@@ -91,23 +193,15 @@ std::vector<TaggedFeedUrl> FreshRssApi::get_subscribed_urls()
 	CurlHandle handle;
 	curl_slist* custom_headers{};
 	add_custom_headers(&custom_headers);
-	curl_easy_setopt(handle.ptr(), CURLOPT_HTTPHEADER, custom_headers);
 
 	utils::set_common_curl_options(handle, cfg);
-	curl_easy_setopt(handle.ptr(),
-		CURLOPT_URL,
-		(cfg.get_configvalue("freshrss-url") + FRESHRSS_SUBSCRIPTION_LIST)
-		.c_str());
-
-	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
-
-	curl_easy_perform(handle.ptr());
+	const std::string result = get_subscription_reply(handle,
+			cfg.get_configvalue("freshrss-url") + FRESHRSS_SUBSCRIPTION_LIST,
+			&custom_headers);
 	curl_slist_free_all(custom_headers);
 
-	const std::string result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"FreshRssApi::get_subscribed_urls: document = %s",
-		result);
+	LOG_FIELDS(Level::DEBUG, "FreshRssApi::get_subscribed_urls", {
+		{"document", result}});
 
 	json_object* reply = json_tokener_parse(result.c_str());
 	if (reply == nullptr) {
@@ -224,27 +318,42 @@ bool FreshRssApi::mark_all_read(const std::string& feedurl)
 bool FreshRssApi::mark_article_read(const std::string& guid, bool read)
 {
 	refresh_token();
-	return mark_article_read_with_token(guid, read, token);
+	return mark_articles_read_with_token({guid}, read, token);
+}
+
+bool FreshRssApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	refresh_token();
+	return mark_articles_read_with_token(guids, true, token);
+}
+
+bool FreshRssApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	refresh_token();
+	return mark_articles_read_with_token(guids, false, token);
 }
 
-bool FreshRssApi::mark_article_read_with_token(const std::string& guid,
+bool FreshRssApi::mark_articles_read_with_token(
+	const std::vector<std::string>& guids,
 	bool read,
 	const std::string& token)
 {
+	// edit-tag applies the same change to every article passed as `i`.
 	std::string postcontent;
+	for (const auto& guid : guids) {
+		postcontent += strprintf::fmt("i=%s&", guid);
+	}
 
 	if (read) {
-		postcontent = strprintf::fmt(
-				"i=%s&a=user/-/state/com.google/read&r=user/-/state/"
+		postcontent += strprintf::fmt(
+				"a=user/-/state/com.google/read&r=user/-/state/"
 				"com.google/kept-unread&ac=edit&T=%s",
-				guid,
 				token);
 	} else {
-		postcontent = strprintf::fmt(
-				"i=%s&r=user/-/state/com.google/read&a=user/-/state/"
+		postcontent += strprintf::fmt(
+				"r=user/-/state/com.google/read&a=user/-/state/"
 				"com.google/kept-unread&a=user/-/state/com.google/"
 				"tracking-kept-unread&ac=edit&T=%s",
-				guid,
 				token);
 	}
 
@@ -252,12 +361,9 @@ bool FreshRssApi::mark_article_read_with_token(const std::string& guid,
 			cfg.get_configvalue("freshrss-url") + FRESHRSS_API_EDIT_TAG_URL,
 			postcontent);
 
-	LOG(Level::DEBUG,
-		"FreshRssApi::mark_article_read_with_token: postcontent = %s "
-		"result "
-		"= %s",
-		postcontent,
-		result);
+	LOG_FIELDS(Level::DEBUG, "FreshRssApi::mark_articles_read_with_token", {
+		{"postcontent", postcontent},
+		{"result", result}});
 
 	return result == "OK";
 }
@@ -388,11 +494,10 @@ std::string FreshRssApi::post_content(const std::string& url,
 	curl_slist_free_all(custom_headers);
 
 	const std::string result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"FreshRssApi::post_content: url = %s postdata = %s result = %s",
-		url,
-		postdata,
-		result);
+	LOG_FIELDS(Level::DEBUG, "FreshRssApi::post_content", {
+		{"url", url},
+		{"postdata", postdata},
+		{"result", result}});
 
 	return result;
 }
@@ -400,18 +505,14 @@ std::string FreshRssApi::post_content(const std::string& url,
 rsspp::Feed FreshRssApi::fetch_feed(const std::string& id)
 {
 	CurlHandle handle;
-	return fetch_feed(id, handle);
+	std::string sync_cursor;
+	return fetch_feed(id, handle, sync_cursor);
 }
 
-rsspp::Feed FreshRssApi::fetch_feed(const std::string& id, CurlHandle& cached_handle)
+nlohmann::json FreshRssApi::fetch_json(const std::string& url,
+	CurlHandle& cached_handle,
+	const std::function<void(nlohmann::json&& item)>& on_item)
 {
-	rsspp::Feed feed;
-	feed.rss_version = rsspp::Feed::FRESHRSS_JSON;
-
-	const std::string query = strprintf::fmt("%s?n=%u",
-			id,
-			cfg.get_configvalue_as_int("freshrss-min-items"));
-
 	curl_slist* custom_headers{};
 	add_custom_headers(&custom_headers);
 	curl_easy_setopt(cached_handle.ptr(), CURLOPT_HTTPHEADER, custom_headers);
@@ -419,7 +520,7 @@ rsspp::Feed FreshRssApi::fetch_feed(const std::string& id, CurlHandle& cached_ha
 	utils::set_common_curl_options(cached_handle, cfg);
 	curl_easy_setopt(cached_handle.ptr(),
 		CURLOPT_URL,
-		query.c_str());
+		url.c_str());
 
 	auto curlDataReceiver = CurlDataReceiver::register_data_handler(cached_handle);
 
@@ -429,120 +530,262 @@ rsspp::Feed FreshRssApi::fetch_feed(const std::string& id, CurlHandle& cached_ha
 
 	const std::string result = curlDataReceiver->get_data();
 	if (result.empty()) {
-		LOG(Level::ERROR,
-			"FreshRssApi::fetch_feed: Empty response: %s",
-			result);
-		return feed;
+		LOG_FIELDS(Level::ERROR, "FreshRssApi::fetch_json: Empty response", {
+			{"url", url}});
+		return nullptr;
 	}
-	nlohmann::json content;
 	try {
-		content = nlohmann::json::parse(result);
+		if (on_item) {
+			return jsonstream::parse(result, "items", on_item);
+		}
+		return nlohmann::json::parse(result);
 	} catch (nlohmann::json::parse_error& e) {
-		LOG(Level::ERROR,
-			"FreshRssApi::fetch_feed: reply failed to parse: %s",
-			result);
-		return feed;
+		LOG_FIELDS(Level::ERROR, "FreshRssApi::fetch_json: reply failed to parse", {
+			{"url", url},
+			{"result", result}});
+		return nullptr;
 	}
+}
 
-
-	const nlohmann::json entries = content["items"];
-	if (!entries.is_array()) {
+std::shared_ptr<const std::unordered_set<std::string>>
+	FreshRssApi::fetch_unread_guids(const std::string& stream,
+		CurlHandle& cached_handle)
+{
+	const std::string url = strprintf::fmt("%s%s?s=%s&xt=%s&n=%u",
+			cfg.get_configvalue("freshrss-url"),
+			FRESHRSS_UNREAD_IDS_URL,
+			stream,
+			"user/-/state/com.google/read",
+			FRESHRSS_MAX_UNREAD_IDS);
+
+	const nlohmann::json content = fetch_json(url, cached_handle);
+	if (!content.is_object() || !content.contains("itemRefs")
+		|| !content["itemRefs"].is_array()) {
 		LOG(Level::ERROR,
-			"FreshRssApi::fetch_feed: items is not an array");
-		return feed;
+			"FreshRssApi::fetch_unread_guids: itemRefs is not an array");
+		return nullptr;
+	}
+	const nlohmann::json& refs = content["itemRefs"];
+	if (refs.size() >= FRESHRSS_MAX_UNREAD_IDS) {
+		LOG(Level::INFO,
+			"FreshRssApi::fetch_unread_guids: too many unread items in %s",
+			stream);
+		return nullptr;
 	}
 
-	LOG(Level::DEBUG,
-		"FreshRssApi::fetch_feed: %" PRIu64 " items",
-		static_cast<uint64_t>(entries.size()));
+	auto unread_guids = std::make_shared<std::unordered_set<std::string>>();
 	try {
-		for (const auto& entry : entries) {
-			rsspp::Item item;
-
-			// Title
-			if (entry.contains("title") && !entry["title"].is_null()) {
-				item.title = entry["title"];
-			}
+		for (const auto& ref : refs) {
+			// Item IDs are listed in their short, decimal form, but the
+			// contents of a stream use the long form as the GUID.
+			const std::string short_id = ref["id"];
+			unread_guids->insert(strprintf::fmt(
+					"tag:google.com,2005:reader/item/%016" PRIx64,
+					static_cast<uint64_t>(std::stoull(short_id))));
+		}
+	} catch (const std::exception& e) {
+		LOG(Level::ERROR,
+			"FreshRssApi::fetch_unread_guids: %s",
+			e.what());
+		return nullptr;
+	}
+	return unread_guids;
+}
 
-			// Link
-			if (entry.contains("canonical") && !entry["canonical"].is_null()) {
-				for (const auto& a : entry["canonical"]) {
-					if (a.contains("href") && !a["href"].is_null()) {
-						item.link = a["href"];
-						break;
-					}
+bool FreshRssApi::fetch_stream(const std::string& query,
+	CurlHandle& cached_handle,
+	bool follow_continuation,
+	uint64_t& newest_item,
+	std::function<void(const nlohmann::json& entry, rsspp::Item item)> add_item)
+{
+	newest_item = 0;
+	std::string continuation;
+	for (unsigned int page = 0; page < FRESHRSS_MAX_PAGES; page++) {
+		uint64_t items = 0;
+		nlohmann::json content;
+		try {
+			// Items are converted as they're parsed, so that the reply is
+			// never held in memory as a whole.
+			content = fetch_json(
+					continuation.empty() ? query : query + "&c=" + continuation,
+					cached_handle,
+			[&](nlohmann::json&& entry) {
+				// Items are numbered in the order they were added, by the
+				// microsecond.
+				if (entry.contains("timestampUsec")
+					&& entry["timestampUsec"].is_string()) {
+					newest_item = std::max<uint64_t>(newest_item,
+							std::stoull(entry["timestampUsec"].get<std::string>()));
 				}
-			}
-
-			// Author
-			if (entry.contains("author") && !entry["author"].is_null()) {
-				item.author = entry["author"];
-			}
 
-			// Content
-			if (entry.contains("summary") && !entry["summary"].is_null()) {
-				for (const auto& a : entry["summary"].items()) {
-					if (!a.value().is_null()) {
-						item.content_encoded = a.value();
-						break;
-					}
-				}
-			}
+				add_item(entry, parse_item(entry));
+				items++;
+			});
+		} catch (const std::exception& e) {
+			LOG(Level::ERROR, "Exception occurred while parsing feed: ", e.what());
+			return false;
+		}
+		if (!content.is_object() || !content.contains("items")
+			|| !content["items"].is_array()) {
+			LOG(Level::ERROR,
+				"FreshRssApi::fetch_stream: items is not an array");
+			return false;
+		}
 
-			// Guid
-			if (entry.contains("id") && !entry["id"].is_null()) {
-				item.guid = entry["id"];
-			}
+		LOG(Level::DEBUG,
+			"FreshRssApi::fetch_stream: %" PRIu64 " items",
+			items);
 
-			// Publish date
-			if (entry.contains("published") && !entry["published"].is_null()) {
-				int pub_time = entry["published"];
-				time_t updated = static_cast<time_t>(pub_time);
+		if (!follow_continuation || !content.contains("continuation")
+			|| !content["continuation"].is_string()) {
+			break;
+		}
+		continuation = content["continuation"].get<std::string>();
+	}
+	return true;
+}
 
-				item.pubDate = utils::mt_strf_localtime(
-						"%a, %d %b %Y %H:%M:%S %z",
-						updated);
-				item.pubDate_ts = pub_time;
-			}
+void FreshRssApi::prefetch_feeds(
+	const std::map<std::string, std::string>& sync_cursors)
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	prefetched.clear();
+	prefetched_unread.reset();
 
-			// Podcast enclosure
-			if (entry.contains("enclosure") && !entry["enclosure"].is_null()) {
-				for (const auto& a : entry["enclosure"]) {
-					if (a.contains("href") && a.contains("type")
-						&& !a["href"].is_null() && !a["type"].is_null()) {
-						item.enclosures.push_back(
-						rsspp::Enclosure {
-							a["href"],
-							a["type"],
-							"",
-							"",
-						}
-						);
-						break;
-					}
-				}
-			}
+	if (!cfg.get_configvalue_as_bool("freshrss-bulk-sync")) {
+		return;
+	}
 
-			// Read/unread status
-			bool unread = true;
-			if (entry.contains("categories")
-				&& !entry["categories"].is_null()) {
-				for (const auto& a: entry["categories"]) {
-					if (a == "user/-/state/com.google/read") {
-						unread = false;
-					}
-				}
-			}
-			if (unread) {
-				item.labels.push_back("unread");
-			} else {
-				item.labels.push_back("read");
-			}
+	// Feeds that haven't been synced yet are fetched one by one, to get
+	// `freshrss-min-items` articles for each.
+	// Cursors are timestamps without leading zeros.
+	const auto older = [](const std::string& a, const std::string& b) {
+		return a.length() < b.length() || (a.length() == b.length() && a < b);
+	};
+	std::string oldest_cursor;
+	for (const auto& feed : sync_cursors) {
+		if (feed.second.empty()) {
+			continue;
+		}
+		if (oldest_cursor.empty() || older(feed.second, oldest_cursor)) {
+			oldest_cursor = feed.second;
+		}
+		prefetched[feed.first].sync_cursor = feed.second;
+	}
+	if (prefetched.size() < 2) {
+		prefetched.clear();
+		return;
+	}
 
-			feed.items.push_back(item);
+	CurlHandle handle;
+	const std::string prefix =
+		cfg.get_configvalue("freshrss-url") + FRESHRSS_FEED_PREFIX;
+	const std::string query = strprintf::fmt("%s%s?n=%u&r=o&ot=%s",
+			prefix,
+			FRESHRSS_READING_LIST,
+			FRESHRSS_BULK_PAGE_SIZE,
+			oldest_cursor);
+	uint64_t items = 0;
+	uint64_t newest_item = 0;
+	const bool complete = fetch_stream(query, handle, true, newest_item,
+	[&](const nlohmann::json& entry, rsspp::Item item) {
+		if (!entry.contains("origin") || !entry["origin"].contains("streamId")) {
+			return;
 		}
-	} catch (nlohmann::json::exception& e) {
-		LOG(Level::ERROR, "Exception occurred while parsing feed: ", e.what());
+		const std::string stream = entry["origin"]["streamId"];
+		char* escaped_stream = curl_easy_escape(handle.ptr(), stream.c_str(), 0);
+		const auto feed = prefetched.find(prefix + escaped_stream);
+		curl_free(escaped_stream);
+		if (feed != prefetched.end()) {
+			feed->second.items.push_back(std::move(item));
+			items++;
+		}
+	});
+	// The unread items are listed afterwards, so that the list covers every
+	// item we got.
+	if (complete) {
+		prefetched_unread = fetch_unread_guids(FRESHRSS_READING_LIST, handle);
+	}
+	if (!complete || !prefetched_unread) {
+		// The feeds are then fetched one by one.
+		prefetched.clear();
+		prefetched_unread.reset();
+		return;
+	}
+
+	// All feeds are now synced up to the same point, so the next bulk
+	// sync can carry on from there.
+	prefetched_cursor = newest_item > 0
+		? std::to_string(newest_item / 1000000)
+		: oldest_cursor;
+
+	LOG(Level::INFO,
+		"FreshRssApi::prefetch_feeds: %" PRIu64 " items for %" PRIu64 " feeds",
+		items,
+		static_cast<uint64_t>(prefetched.size()));
+}
+
+bool FreshRssApi::take_prefetched(const std::string& id,
+	rsspp::Feed& feed,
+	std::string& sync_cursor)
+{
+	std::lock_guard<std::mutex> guard(prefetch_mtx);
+	const auto found = prefetched.find(id);
+	// If the feed was synced since the prefetch, it has newer items.
+	if (found == prefetched.end() || found->second.sync_cursor != sync_cursor) {
+		return false;
+	}
+
+	feed.items = std::move(found->second.items);
+	feed.only_new_items = true;
+	feed.unread_guids = prefetched_unread;
+	sync_cursor = prefetched_cursor;
+	prefetched.erase(found);
+	return true;
+}
+
+rsspp::Feed FreshRssApi::fetch_feed(const std::string& id,
+	CurlHandle& cached_handle,
+	std::string& sync_cursor)
+{
+	rsspp::Feed feed;
+	feed.rss_version = rsspp::Feed::FRESHRSS_JSON;
+
+	if (take_prefetched(id, feed, sync_cursor)) {
+		LOG(Level::DEBUG,
+			"FreshRssApi::fetch_feed: %" PRIu64 " prefetched items",
+			static_cast<uint64_t>(feed.items.size()));
+		return feed;
+	}
+
+	// The first sync gets the newest items. After that, we only ask for
+	// items added since the newest one we've seen, oldest first, following
+	// the continuation in case there are more of them than fit in a reply.
+	const bool incremental = !sync_cursor.empty();
+	std::string query = strprintf::fmt("%s?n=%u",
+			id,
+			cfg.get_configvalue_as_int("freshrss-min-items"));
+	if (incremental) {
+		query += "&r=o&ot=" + sync_cursor;
+	}
+
+	uint64_t newest_item = 0;
+	fetch_stream(query, cached_handle, incremental, newest_item,
+	[&](const nlohmann::json& /* entry */, rsspp::Item item) {
+		feed.items.push_back(std::move(item));
+	});
+
+	const std::string prefix =
+		cfg.get_configvalue("freshrss-url") + FRESHRSS_FEED_PREFIX;
+	if (incremental && id.compare(0, prefix.length(), prefix) == 0) {
+		// The stream ID in the feed URL is already escaped.
+		const std::string stream = utils::tokenize(id.substr(prefix.length()),
+				"?")[0];
+		feed.unread_guids = fetch_unread_guids(stream, cached_handle);
+		feed.only_new_items = feed.unread_guids != nullptr;
+	}
+	if (newest_item > 0) {
+		sync_cursor = std::to_string(newest_item / 1000000);
 	}
 
 	return feed;
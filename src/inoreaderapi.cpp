@@ -1,10 +1,11 @@
 #include "inoreaderapi.h"
 
+#include <cinttypes>
+#include <cstdlib>
 #include <cstring>
 #include <curl/curl.h>
 #include <json.h>
 #include <vector>
-#include <thread>
 
 #include "config.h"
 #include "curldatareceiver.h"
@@ -12,20 +13,23 @@
 #include "strprintf.h"
 #include "utils.h"
 
-#define INOREADER_LOGIN "https://inoreader.com/accounts/ClientLogin"
-#define INOREADER_API_PREFIX "https://inoreader.com/reader/api/0/"
-#define INOREADER_FEED_PREFIX "https://inoreader.com/reader/atom/"
+#define INOREADER_LOGIN "/accounts/ClientLogin"
+#define INOREADER_API_PREFIX "/reader/api/0/"
+#define INOREADER_FEED_PREFIX "/reader/atom/"
 
 #define INOREADER_SUBSCRIPTION_LIST INOREADER_API_PREFIX "subscription/list"
 #define INOREADER_API_MARK_ALL_READ_URL INOREADER_API_PREFIX "mark-all-as-read"
 #define INOREADER_API_EDIT_TAG_URL INOREADER_API_PREFIX "edit-tag"
+#define INOREADER_UNREAD_IDS_URL INOREADER_API_PREFIX "stream/items/ids"
+#define INOREADER_MAX_UNREAD_IDS 10000u
 
 // for reference, see https://inoreader.com/developers
 
 namespace newsboat {
 
-InoreaderApi::InoreaderApi(ConfigContainer& c)
+InoreaderApi::InoreaderApi(ConfigContainer& c, const std::string& server)
 	: RemoteApi(c)
+	, server(server)
 {
 }
 
@@ -58,7 +62,9 @@ std::string InoreaderApi::retrieve_auth()
 
 	utils::set_common_curl_options(handle, cfg);
 	curl_easy_setopt(handle.ptr(), CURLOPT_POSTFIELDS, postcontent.c_str());
-	curl_easy_setopt(handle.ptr(), CURLOPT_URL, INOREADER_LOGIN);
+	curl_easy_setopt(handle.ptr(),
+		CURLOPT_URL,
+		(server + INOREADER_LOGIN).c_str());
 
 	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
 
@@ -88,20 +94,14 @@ std::vector<TaggedFeedUrl> InoreaderApi::get_subscribed_urls()
 
 	CurlHandle handle;
 	add_custom_headers(&custom_headers);
-	curl_easy_setopt(handle.ptr(), CURLOPT_HTTPHEADER, custom_headers);
 
 	utils::set_common_curl_options(handle, cfg);
-	curl_easy_setopt(handle.ptr(), CURLOPT_URL, INOREADER_SUBSCRIPTION_LIST);
-
-	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
-
-	curl_easy_perform(handle.ptr());
+	const std::string result = get_subscription_reply(handle,
+			server + INOREADER_SUBSCRIPTION_LIST, &custom_headers);
 	curl_slist_free_all(custom_headers);
 
-	const std::string result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"InoreaderApi::get_subscribed_urls: document = %s",
-		result);
+	LOG_FIELDS(Level::DEBUG, "InoreaderApi::get_subscribed_urls", {
+		{"document", result}});
 
 	json_object* reply = json_tokener_parse(result.c_str());
 	if (reply == nullptr) {
@@ -161,7 +161,8 @@ std::vector<TaggedFeedUrl> InoreaderApi::get_subscribed_urls()
 			tags.push_back(std::string(label));
 		}
 
-		auto url = strprintf::fmt("%s%s?n=%u",
+		auto url = strprintf::fmt("%s%s%s?n=%u",
+				server,
 				INOREADER_FEED_PREFIX,
 				id_uenc,
 				cfg.get_configvalue_as_int("inoreader-min-items"));
@@ -192,52 +193,56 @@ void InoreaderApi::add_custom_headers(curl_slist** custom_headers)
 bool InoreaderApi::mark_all_read(const std::string& feedurl)
 {
 	std::string real_feedurl =
-		feedurl.substr(strlen(INOREADER_FEED_PREFIX));
+		feedurl.substr((server + INOREADER_FEED_PREFIX).length());
 	std::vector<std::string> elems = utils::tokenize(real_feedurl, "?");
 	real_feedurl = utils::unescape_url(elems[0]);
 
 	std::string postcontent = strprintf::fmt("s=%s", real_feedurl);
 
 	std::string result =
-		post_content(INOREADER_API_MARK_ALL_READ_URL, postcontent);
+		post_content(server + INOREADER_API_MARK_ALL_READ_URL, postcontent);
 
 	return result == "OK";
 }
 
 bool InoreaderApi::mark_article_read(const std::string& guid, bool read)
 {
-	// Do this in a thread, as we don't care about the result enough to wait
-	// for it.  borrowed from ttrssapi.cpp
-	std::thread t{[=]()
-	{
-		LOG(Level::DEBUG,
-			"InoreaderApi::mark_article_read: inside thread, marking "
-			"thread as read...");
+	return edit_read_state({guid}, read);
+}
 
-		std::string postcontent;
+bool InoreaderApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	return edit_read_state(guids, true);
+}
 
-		if (read) {
-			postcontent = strprintf::fmt(
-					"i=%s&a=user/-/state/com.google/read",
-					guid);
-		} else {
-			postcontent = strprintf::fmt(
-					"i=%s&r=user/-/state/com.google/read",
-					guid);
-		}
+bool InoreaderApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	return edit_read_state(guids, false);
+}
+
+bool InoreaderApi::edit_read_state(const std::vector<std::string>& guids,
+	bool read)
+{
+	// edit-tag applies the same change to every article passed as `i`.
+	std::string postcontent;
+	for (const auto& guid : guids) {
+		postcontent += strprintf::fmt("i=%s&", guid);
+	}
+
+	if (read) {
+		postcontent += "a=user/-/state/com.google/read";
+	} else {
+		postcontent += "r=user/-/state/com.google/read";
+	}
 
-		std::string result =
-			post_content(INOREADER_API_EDIT_TAG_URL, postcontent);
+	std::string result =
+		post_content(server + INOREADER_API_EDIT_TAG_URL, postcontent);
 
-		LOG(Level::DEBUG,
-			"InoreaderApi::mark_article_read: postcontent = %s result = %s",
-			postcontent,
-			result);
-
-		return result == "OK";
-	}};
-	t.detach();
-	return true;
+	LOG_FIELDS(Level::DEBUG, "InoreaderApi::edit_read_state", {
+		{"postcontent", postcontent},
+		{"result", result}});
+
+	return result == "OK";
 }
 
 bool InoreaderApi::update_article_flags(const std::string& inoflags,
@@ -278,7 +283,7 @@ bool InoreaderApi::star_article(const std::string& guid, bool star)
 	}
 
 	std::string result =
-		post_content(INOREADER_API_EDIT_TAG_URL, postcontent);
+		post_content(server + INOREADER_API_EDIT_TAG_URL, postcontent);
 
 	return result == "OK";
 }
@@ -298,11 +303,91 @@ bool InoreaderApi::share_article(const std::string& guid, bool share)
 	}
 
 	std::string result =
-		post_content(INOREADER_API_EDIT_TAG_URL, postcontent);
+		post_content(server + INOREADER_API_EDIT_TAG_URL, postcontent);
 
 	return result == "OK";
 }
 
+std::shared_ptr<const std::unordered_set<std::string>>
+	InoreaderApi::fetch_unread_guids(const std::string& feedurl)
+{
+	const std::string prefix = server + INOREADER_FEED_PREFIX;
+	if (feedurl.compare(0, prefix.length(), prefix) != 0) {
+		return nullptr;
+	}
+	// The stream ID in the feed URL is already escaped.
+	const std::string stream = utils::tokenize(feedurl.substr(prefix.length()),
+			"?")[0];
+	const std::string url = strprintf::fmt("%s%s?s=%s&xt=%s&n=%u",
+			server,
+			INOREADER_UNREAD_IDS_URL,
+			stream,
+			"user/-/state/com.google/read",
+			INOREADER_MAX_UNREAD_IDS);
+
+	curl_slist* custom_headers{};
+
+	CurlHandle handle;
+	utils::set_common_curl_options(handle, cfg);
+	add_custom_headers(&custom_headers);
+	curl_easy_setopt(handle.ptr(), CURLOPT_HTTPHEADER, custom_headers);
+	curl_easy_setopt(handle.ptr(), CURLOPT_URL, url.c_str());
+
+	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
+
+	const CURLcode ret = curl_easy_perform(handle.ptr());
+	curl_slist_free_all(custom_headers);
+	if (ret != CURLE_OK) {
+		LOG(Level::ERROR,
+			"InoreaderApi::fetch_unread_guids: %s",
+			curl_easy_strerror(ret));
+		return nullptr;
+	}
+
+	const std::string result = curlDataReceiver->get_data();
+	json_object* reply = json_tokener_parse(result.c_str());
+	if (reply == nullptr) {
+		LOG(Level::ERROR,
+			"InoreaderApi::fetch_unread_guids: failed to parse "
+			"response as JSON.");
+		return nullptr;
+	}
+
+	json_object* refs{};
+	if (!json_object_object_get_ex(reply, "itemRefs", &refs)
+		|| !json_object_is_type(refs, json_type_array)
+		|| static_cast<std::size_t>(json_object_array_length(refs))
+		>= INOREADER_MAX_UNREAD_IDS) {
+		LOG(Level::INFO,
+			"InoreaderApi::fetch_unread_guids: no complete list of unread "
+			"items in %s",
+			stream);
+		json_object_put(reply);
+		return nullptr;
+	}
+
+	auto unread_guids = std::make_shared<std::unordered_set<std::string>>();
+	const auto len = json_object_array_length(refs);
+	for (decltype(json_object_array_length(refs)) i = 0; i < len; i++) {
+		json_object* ref = json_object_array_get_idx(refs, i);
+		json_object* node{};
+		json_object_object_get_ex(ref, "id", &node);
+		const char* id = json_object_get_string(node);
+		if (id == nullptr) {
+			continue;
+		}
+		// Item IDs are listed in their short, decimal form, but the feed's
+		// entries use the long form as the GUID.
+		unread_guids->insert(strprintf::fmt(
+				"tag:google.com,2005:reader/item/%016" PRIx64,
+				static_cast<uint64_t>(std::strtoull(id, nullptr, 10))));
+	}
+
+	json_object_put(reply);
+
+	return unread_guids;
+}
+
 std::string InoreaderApi::post_content(const std::string& url,
 	const std::string& postdata)
 {
@@ -321,12 +406,10 @@ std::string InoreaderApi::post_content(const std::string& url,
 	curl_slist_free_all(custom_headers);
 
 	const std::string result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"InoreaderApi::post_content: url = %s postdata = %s result = "
-		"%s",
-		url,
-		postdata,
-		result);
+	LOG_FIELDS(Level::DEBUG, "InoreaderApi::post_content", {
+		{"url", url},
+		{"postdata", postdata},
+		{"result", result}});
 
 	return result;
 }
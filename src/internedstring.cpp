@@ -0,0 +1,131 @@
+#include "internedstring.h"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+#include "memoryusage.h"
+
+namespace newsboat {
+
+namespace {
+
+class StringPool {
+public:
+	std::shared_ptr<const std::string> intern(const std::string& value)
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+
+		const auto it = strings.find(value);
+		if (it != strings.end()) {
+			return it->second;
+		}
+
+		if (strings.size() >= purge_threshold) {
+			purge_unused_unlocked();
+			// Only purge again once the pool has doubled in size, so
+			// that interning stays amortized O(1).
+			purge_threshold = std::max(MIN_PURGE_THRESHOLD, 2 * strings.size());
+		}
+
+		auto interned = std::make_shared<const std::string>(value);
+		strings.emplace(*interned, interned);
+		return interned;
+	}
+
+	std::size_t size()
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		return strings.size();
+	}
+
+	std::size_t memory_usage()
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		std::size_t bytes = strings.bucket_count() * sizeof(void*);
+		for (const auto& entry : strings) {
+			bytes += sizeof(entry) + sizeof(void*) + sizeof(std::size_t)
+				+ sizeof(std::string) + SHARED_PTR_OVERHEAD
+				+ heap_usage(*entry.second);
+		}
+		return bytes;
+	}
+
+	void purge_unused()
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		purge_unused_unlocked();
+	}
+
+private:
+	void purge_unused_unlocked()
+	{
+		// New references can only be handed out while holding `mtx`, so
+		// a string only referenced by the pool stays that way until we're
+		// done.
+		for (auto it = strings.begin(); it != strings.end();) {
+			if (it->second.use_count() == 1) {
+				it = strings.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	static const std::size_t MIN_PURGE_THRESHOLD = 1024;
+
+	// Keys refer to the pooled strings themselves, so each value is only
+	// stored once.
+	std::unordered_map<std::reference_wrapper<const std::string>,
+		std::shared_ptr<const std::string>,
+		std::hash<std::string>,
+		std::equal_to<std::string>> strings;
+	std::size_t purge_threshold = MIN_PURGE_THRESHOLD;
+	std::mutex mtx;
+};
+
+const std::size_t StringPool::MIN_PURGE_THRESHOLD;
+
+StringPool& get_pool()
+{
+	// Leaked on purpose, so that InternedStrings in other static objects
+	// can still be destroyed at exit.
+	static StringPool* pool = new StringPool();
+	return *pool;
+}
+
+const std::shared_ptr<const std::string>& empty_string()
+{
+	static const auto empty = std::make_shared<const std::string>();
+	return empty;
+}
+
+} // namespace
+
+InternedString::InternedString()
+	: value(empty_string())
+{
+}
+
+InternedString::InternedString(const std::string& value)
+	: value(value.empty() ? empty_string() : get_pool().intern(value))
+{
+}
+
+std::size_t InternedString::pool_size()
+{
+	return get_pool().size();
+}
+
+std::size_t InternedString::pool_memory_usage()
+{
+	return get_pool().memory_usage();
+}
+
+void InternedString::purge_unused()
+{
+	get_pool().purge_unused();
+}
+
+} // namespace newsboat
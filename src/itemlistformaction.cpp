@@ -1013,7 +1013,7 @@ void ItemListFormAction::do_update_visible_items()
 	}
 
 	std::lock_guard<std::mutex> lock(feed->item_mutex);
-	std::vector<std::shared_ptr<RssItem>>& items = feed->items();
+	const auto& items = feed->items();
 
 	std::vector<ItemPtrPosPair> new_visible_items;
 
@@ -1023,7 +1023,7 @@ void ItemListFormAction::do_update_visible_items()
 	 * (if applicable) whether an items matches the currently active filter.
 	 */
 
-	bool show_read = cfg->get_configvalue_as_bool("show-read-articles");
+	const bool show_read = cfg->snapshot()->show_read_articles;
 
 	unsigned int i = 0;
 	for (const auto& item : items) {
@@ -1067,9 +1067,9 @@ void ItemListFormAction::do_update_visible_items()
 
 void ItemListFormAction::draw_items()
 {
-	auto datetime_format = cfg->get_configvalue("datetime-format");
-	auto itemlist_format =
-		cfg->get_configvalue("articlelist-format");
+	const auto config = cfg->snapshot();
+	auto datetime_format = config->datetime_format;
+	auto itemlist_format = config->articlelist_format;
 
 	auto render_line = [this, itemlist_format, datetime_format](std::uint32_t line,
 	std::uint32_t width) -> std::string {
@@ -1090,7 +1090,8 @@ void ItemListFormAction::prepare()
 {
 	std::lock_guard<std::mutex> mtx(redraw_mtx);
 
-	const auto sort_strategy = cfg->get_article_sort_strategy();
+	const auto config = cfg->snapshot();
+	const auto sort_strategy = config->article_sort_strategy;
 	if (!old_sort_strategy || sort_strategy != *old_sort_strategy) {
 		feed->sort(sort_strategy);
 		old_sort_strategy = sort_strategy;
@@ -1105,7 +1106,7 @@ void ItemListFormAction::prepare()
 		return;
 	}
 
-	if (cfg->get_configvalue_as_bool("mark-as-read-on-hover")) {
+	if (config->mark_as_read_on_hover) {
 		if (!visible_items.empty()) {
 			const unsigned int itempos = list.get_position();
 			if (visible_items[itempos].first->unread()) {
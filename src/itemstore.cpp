@@ -0,0 +1,82 @@
+#include "itemstore.h"
+
+#include <stdexcept>
+#include <thread>
+
+namespace newsboat {
+
+ItemStore& ItemStore::instance()
+{
+	// Deliberately leaked: items may still be destroyed while static
+	// objects are torn down.
+	static ItemStore* store = new ItemStore();
+	return *store;
+}
+
+ItemHandle ItemStore::allocate()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+
+	std::uint32_t slot;
+	if (!free_slots.empty()) {
+		slot = free_slots.back();
+		free_slots.pop_back();
+	} else {
+		slot = next_slot;
+		if ((slot >> BLOCK_BITS) == block_count) {
+			if (block_count == MAX_BLOCKS) {
+				throw std::length_error("ItemStore: too many items");
+			}
+			blocks[block_count].store(new Block(), std::memory_order_release);
+			block_count++;
+		}
+		next_slot++;
+	}
+
+	const ItemHandle handle{slot};
+	Block& b = block(handle);
+	const auto i = offset(handle);
+	b.pub_date[i] = 0;
+	b.size[i] = 0;
+	b.index[i] = 0;
+	b.state[i].store(UNREAD, std::memory_order_relaxed);
+	return handle;
+}
+
+void ItemStore::release(ItemHandle handle)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	free_slots.push_back(handle.slot);
+}
+
+void ItemStore::lock(ItemHandle handle)
+{
+	auto& state = block(handle).state[offset(handle)];
+	unsigned int spins = 0;
+	while (state.fetch_or(LOCKED, std::memory_order_acquire) & LOCKED) {
+		if (++spins > 64) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ItemStore::unlock(ItemHandle handle)
+{
+	block(handle).state[offset(handle)].fetch_and(
+		static_cast<std::uint8_t>(~LOCKED), std::memory_order_release);
+}
+
+std::size_t ItemStore::item_count() const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return next_slot - free_slots.size();
+}
+
+std::size_t ItemStore::memory_usage() const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return sizeof(ItemStore) + block_count * sizeof(Block)
+		+ free_slots.capacity() * sizeof(free_slots[0]);
+}
+
+} // namespace newsboat
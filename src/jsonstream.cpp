@@ -0,0 +1,48 @@
+#include "jsonstream.h"
+
+namespace newsboat {
+
+namespace jsonstream {
+
+nlohmann::json parse(const std::string& input,
+	const std::string& key,
+	const std::function<void(nlohmann::json&& element)>& on_element)
+{
+	using event = nlohmann::json::parse_event_t;
+
+	// Depth of the array itself: either the input or a top-level value.
+	const int array_depth = key.empty() ? 0 : 1;
+	bool key_matches = key.empty();
+	bool in_array = false;
+
+	return nlohmann::json::parse(input,
+	[&](int depth, event e, nlohmann::json& parsed) {
+		if (depth == array_depth) {
+			switch (e) {
+			case event::key:
+				key_matches = parsed == key;
+				break;
+			case event::array_start:
+				in_array = key_matches;
+				break;
+			case event::array_end:
+				in_array = false;
+				break;
+			default:
+				break;
+			}
+		} else if (in_array && depth == array_depth + 1
+			&& (e == event::value || e == event::object_end
+				|| e == event::array_end)) {
+			on_element(std::move(parsed));
+			// The element isn't needed any more, so don't add it to the
+			// array.
+			return false;
+		}
+		return true;
+	});
+}
+
+} // namespace jsonstream
+
+} // namespace newsboat
@@ -284,6 +284,13 @@ static const std::vector<OpDesc> opdescs = {
 		translatable("Cancel download"),
 		KM_PODBOAT
 	},
+	{
+		OP_PB_TOGGLE_PAUSE,
+		"pb-toggle-pause",
+		KeyCombination("s"),
+		translatable("Pause or resume download"),
+		KM_PODBOAT
+	},
 	{
 		OP_PB_DELETE,
 		"pb-delete",
@@ -1,10 +1,26 @@
 #include "listwidgetbackend.h"
 
+#include <atomic>
+
 #include "listformatter.h"
+#include "memoryusage.h"
 #include "utils.h"
 
 namespace newsboat {
 
+namespace {
+
+std::atomic<std::size_t> all_line_caches_bytes(0);
+
+std::size_t line_cache_entry_bytes(const std::string& line)
+{
+	// std::map node: three pointers, color, key and value.
+	return 3 * sizeof(void*) + sizeof(int) + sizeof(std::uint32_t)
+		+ sizeof(std::string) + heap_usage(line);
+}
+
+} // namespace
+
 ListWidgetBackend::ListWidgetBackend(const std::string& list_name,
 	const std::string& context, Stfl::Form& form, RegexManager& rxman)
 	: list_name(list_name)
@@ -12,6 +28,7 @@ ListWidgetBackend::ListWidgetBackend(const std::string& list_name,
 	, listfmt(&rxman, context)
 	, num_lines(0)
 	, scroll_offset(0)
+	, line_cache_bytes(0)
 	, get_formatted_line({})
 {
 }
@@ -22,15 +39,33 @@ ListWidgetBackend::ListWidgetBackend(const std::string& list_name, Stfl::Form& f
 	, listfmt()
 	, num_lines(0)
 	, scroll_offset(0)
+	, line_cache_bytes(0)
 	, get_formatted_line({})
 {
 }
 
+ListWidgetBackend::~ListWidgetBackend()
+{
+	clear_line_cache();
+}
+
+std::size_t ListWidgetBackend::line_cache_memory_usage()
+{
+	return all_line_caches_bytes;
+}
+
+void ListWidgetBackend::clear_line_cache()
+{
+	line_cache.clear();
+	all_line_caches_bytes -= line_cache_bytes;
+	line_cache_bytes = 0;
+}
+
 void ListWidgetBackend::stfl_replace_list(std::string stfl)
 {
 	num_lines = 0;
 	scroll_offset = 0;
-	line_cache.clear();
+	clear_line_cache();
 	get_formatted_line = {};
 
 	form.modify(list_name, "replace", stfl);
@@ -57,7 +92,7 @@ std::uint32_t ListWidgetBackend::get_num_lines()
 void ListWidgetBackend::invalidate_list_content(std::uint32_t line_count,
 	std::function<std::string(std::uint32_t, std::uint32_t)> get_line_method)
 {
-	line_cache.clear();
+	clear_line_cache();
 	get_formatted_line = get_line_method;
 	num_lines = line_count;
 
@@ -90,7 +125,10 @@ void ListWidgetBackend::render()
 			formatted_line = line_cache[line];
 		} else if (get_formatted_line) {
 			formatted_line = get_formatted_line(line, viewport_width);
+			const auto bytes = line_cache_entry_bytes(formatted_line);
 			line_cache.insert({line, formatted_line});
+			line_cache_bytes += bytes;
+			all_line_caches_bytes += bytes;
 		}
 		listfmt.add_line(formatted_line);
 	}
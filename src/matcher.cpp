@@ -75,6 +75,19 @@ bool Matcher::matches(Matchable* item)
 	return retval;
 }
 
+bool Matcher::may_match(Matchable* item)
+{
+	if (!item) {
+		return false;
+	}
+	try {
+		return may_match_r(p.get_root(), item).value_or(true);
+	} catch (const MatcherException& e) {
+		// matches() will report the error once there is an item to match.
+		return true;
+	}
+}
+
 std::string get_attr_or_throw(Matchable* item, const std::string& attr_name)
 {
 	const auto attr = item->attribute_value(attr_name);
@@ -234,6 +247,45 @@ bool Matcher::matches_r(expression* e, Matchable* item)
 	}
 }
 
+nonstd::optional<bool> Matcher::may_match_r(expression* e, Matchable* item)
+{
+	if (!e) {
+		return true;
+	}
+
+	switch (e->op) {
+	case LOGOP_AND: {
+		const auto l = may_match_r(e->l, item);
+		const auto r = may_match_r(e->r, item);
+		if ((l.has_value() && !l.value()) || (r.has_value() && !r.value())) {
+			return false;
+		}
+		if (l.has_value() && r.has_value()) {
+			return true;
+		}
+		return nonstd::nullopt;
+	}
+
+	case LOGOP_OR: {
+		const auto l = may_match_r(e->l, item);
+		const auto r = may_match_r(e->r, item);
+		if ((l.has_value() && l.value()) || (r.has_value() && r.value())) {
+			return true;
+		}
+		if (l.has_value() && r.has_value()) {
+			return false;
+		}
+		return nonstd::nullopt;
+	}
+
+	default:
+		if (!item->attribute_value(e->name).has_value()) {
+			return nonstd::nullopt;
+		}
+		return matches_r(e, item);
+	}
+}
+
 std::string Matcher::get_parse_error()
 {
 	return errmsg;
@@ -0,0 +1,81 @@
+#include "memoryreport.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "config.h"
+#include "feedcontainer.h"
+#include "internedstring.h"
+#include "itemstore.h"
+#include "listwidgetbackend.h"
+#include "rssfeed.h"
+#include "strprintf.h"
+
+namespace newsboat {
+
+MemoryReport::MemoryReport(FeedContainer& feedcontainer)
+	: interned_strings_bytes(InternedString::pool_memory_usage())
+	, list_line_caches_bytes(ListWidgetBackend::line_cache_memory_usage())
+	, item_store_bytes(ItemStore::instance().memory_usage())
+{
+	for (const auto& feed : feedcontainer.get_all_feeds()) {
+		FeedEntry entry{feed->title(), feed->total_item_count(), feed->memory_usage()};
+		totals += entry.usage;
+		feed_entries.push_back(std::move(entry));
+	}
+
+	std::stable_sort(feed_entries.begin(), feed_entries.end(),
+	[](const FeedEntry& a, const FeedEntry& b) {
+		return a.usage.total() > b.usage.total();
+	});
+}
+
+std::vector<std::string> MemoryReport::format(std::size_t max_feeds) const
+{
+	std::vector<std::string> lines;
+
+	const auto add_row = [&](const std::string& name, std::size_t bytes) {
+		lines.push_back(strprintf::fmt("  %-30s %12s", name, format_bytes(bytes)));
+	};
+
+	lines.push_back(_("Estimated memory usage:"));
+	add_row(_("Article metadata"), totals.item_metadata);
+	add_row(_("Article contents"), totals.descriptions);
+	add_row(_("GUID indices"), totals.guid_maps);
+	add_row(_("Query feed membership"), totals.query_feed_membership);
+	add_row(_("Article dates and states"), item_store_bytes);
+	add_row(_("Interned strings"), interned_strings_bytes);
+	add_row(_("List rendering caches"), list_line_caches_bytes);
+	add_row(_("Total"), total());
+
+	lines.push_back("");
+	lines.push_back(_("Estimated memory usage per feed:"));
+	std::size_t count = 0;
+	for (const auto& entry : feed_entries) {
+		if (max_feeds != 0 && count == max_feeds) {
+			lines.push_back(strprintf::fmt(_("  ... and %" PRIu64 " more feeds"),
+					static_cast<uint64_t>(feed_entries.size() - count)));
+			break;
+		}
+		lines.push_back(strprintf::fmt("  %12s %8" PRIu64 " %s",
+				format_bytes(entry.usage.total()),
+				static_cast<uint64_t>(entry.item_count),
+				entry.title));
+		count++;
+	}
+
+	return lines;
+}
+
+std::string MemoryReport::format_bytes(std::size_t bytes)
+{
+	if (bytes < 1024) {
+		return strprintf::fmt("%" PRIu64 " B", static_cast<uint64_t>(bytes));
+	}
+	if (bytes < 1024 * 1024) {
+		return strprintf::fmt("%.1f KiB", bytes / 1024.0);
+	}
+	return strprintf::fmt("%.1f MiB", bytes / 1024.0 / 1024.0);
+}
+
+} // namespace newsboat
@@ -1,11 +1,15 @@
 #include "minifluxapi.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cinttypes>
+#include <cstdio>
 #include <curl/curl.h>
-#include <thread>
+#include <ctime>
 
 #include "3rd-party/json.hpp"
 #include "curlhandle.h"
+#include "jsonstream.h"
 #include "logger.h"
 #include "remoteapi.h"
 #include "rss/feed.h"
@@ -16,6 +20,37 @@ using json = nlohmann::json;
 using HTTPMethod = newsboat::utils::HTTPMethod;
 
 namespace newsboat {
+
+namespace {
+
+// Miniflux timestamps look like "2023-05-04T10:20:30.123456+02:00".
+std::int64_t parse_timestamp(const std::string& timestamp)
+{
+	struct tm tm {};
+	const char* rest = strptime(timestamp.c_str(), "%Y-%m-%dT%H:%M:%S", &tm);
+	if (rest == nullptr) {
+		return 0;
+	}
+	std::int64_t result = timegm(&tm);
+
+	if (*rest == '.') {
+		rest++;
+		while (std::isdigit(static_cast<unsigned char>(*rest))) {
+			rest++;
+		}
+	}
+	int hours = 0;
+	int minutes = 0;
+	if ((*rest == '+' || *rest == '-')
+		&& std::sscanf(rest + 1, "%2d:%2d", &hours, &minutes) == 2) {
+		const std::int64_t offset = (hours * 60 + minutes) * 60;
+		result += (*rest == '+') ? -offset : offset;
+	}
+	return result;
+}
+
+} // namespace
+
 MinifluxApi::MinifluxApi(ConfigContainer& c)
 	: RemoteApi(c)
 {
@@ -122,99 +157,140 @@ bool MinifluxApi::mark_all_read(const std::string& id)
 
 bool MinifluxApi::mark_article_read(const std::string& guid, bool read)
 {
-	// Do this in a thread, as we don't care about the result enough to wait
-	// for it.
-	std::thread t{[=]()
-	{
-		LOG(Level::DEBUG,
-			"MinifluxApi::mark_article_read: inside thread, marking "
-			"article as read...");
-
-		// Call the MinifluxApi's update_article function as a thread.
-		json args;
-		args["status"] = read ? "read" : "unread";
-		this->update_article(guid, args);
-	}};
-	t.detach();
-	return true;
+	json args;
+	args["status"] = read ? "read" : "unread";
+	return update_article(guid, args);
+}
+
+bool MinifluxApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	json args;
+	args["status"] = "read";
+	return update_articles(guids, args);
+}
+
+bool MinifluxApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	json args;
+	args["status"] = "unread";
+	return update_articles(guids, args);
 }
 
 bool MinifluxApi::update_article_flags(const std::string& /* oldflags */,
 	const std::string& /* newflags */,
 	const std::string& /* guid */)
 {
-	return false;
+	// Miniflux has no flags to sync, so there's nothing that could fail.
+	return true;
 }
 
 rsspp::Feed MinifluxApi::fetch_feed(const std::string& id)
 {
 	CurlHandle handle;
-	return fetch_feed(id, handle);
+	std::string sync_cursor;
+	return fetch_feed(id, handle, sync_cursor);
 }
 
-rsspp::Feed MinifluxApi::fetch_feed(const std::string& id, CurlHandle& cached_handle)
+rsspp::Feed MinifluxApi::fetch_feed(const std::string& id,
+	CurlHandle& cached_handle,
+	std::string& sync_cursor)
 {
 	rsspp::Feed feed;
 	feed.rss_version = rsspp::Feed::MINIFLUX_JSON;
 
-	const std::string query =
+	// The first sync gets the latest entries. After that, we ask for every
+	// entry that was added or changed (e.g. read elsewhere) since the
+	// newest change we've seen, page by page.
+	std::string query =
 		strprintf::fmt("/v1/feeds/%s/entries?order=published_at&direction=desc&limit=%u",
 			id,
 			cfg.get_configvalue_as_int("miniflux-min-items"));
-
-	const json content = run_op(query, json(), cached_handle, HTTPMethod::GET);
-	if (content.is_null()) {
-		return feed;
-	}
-
-	const json entries = content["entries"];
-	if (!entries.is_array()) {
-		LOG(Level::ERROR,
-			"MinifluxApi::fetch_feed: items is not an array");
-		return feed;
+	const bool incremental = !sync_cursor.empty();
+	if (incremental) {
+		query += "&changed_after=" + sync_cursor;
 	}
 
-	LOG(Level::DEBUG,
-		"MinifluxApi::fetch_feed: %" PRIu64 " items",
-		static_cast<uint64_t>(entries.size()));
-	try {
-		for (const auto& entry : entries) {
-			rsspp::Item item;
-
-			if (!entry["title"].is_null()) {
-				item.title = entry["title"];
-			}
-
-			if (!entry["url"].is_null()) {
-				item.link = entry["url"];
-			}
-
-			if (!entry["author"].is_null()) {
-				item.author = entry["author"];
-			}
-
-			if (!entry["content"].is_null()) {
-				item.content_encoded = entry["content"];
-			}
-
-			const int entry_id = entry["id"];
-			item.guid = std::to_string(entry_id);
+	std::int64_t newest_change = 0;
+	std::uint64_t offset = 0;
+	while (true) {
+		// Entries are converted as they're parsed, so that the reply is
+		// never held in memory as a whole.
+		std::uint64_t entries = 0;
+		json content;
+		try {
+			content = run_op(
+					strprintf::fmt("%s&offset=%" PRIu64, query, offset),
+					json(), cached_handle, HTTPMethod::GET,
+			[&](json&& entry) {
+				rsspp::Item item;
+
+				if (!entry["title"].is_null()) {
+					item.title = entry["title"];
+				}
+
+				if (!entry["url"].is_null()) {
+					item.link = entry["url"];
+				}
+
+				if (!entry["author"].is_null()) {
+					item.author = entry["author"];
+				}
+
+				if (!entry["content"].is_null()) {
+					item.content_encoded = entry["content"];
+				}
+
+				const int entry_id = entry["id"];
+				item.guid = std::to_string(entry_id);
+
+				item.pubDate = entry["published_at"];
+
+				const std::string status = entry["status"];
+				if (status == "unread") {
+					item.labels.push_back("miniflux:unread");
+				} else {
+					item.labels.push_back("miniflux:read");
+				}
+
+				if (entry.contains("changed_at") && entry["changed_at"].is_string()) {
+					newest_change = std::max(newest_change,
+							parse_timestamp(entry["changed_at"]));
+				}
+
+				feed.items.push_back(item);
+				entries++;
+			});
+		} catch (json::exception& e) {
+			LOG(Level::ERROR,
+				"Exception occurred while parsing feeed: ",
+				e.what());
+			return feed;
+		}
+		if (content.is_null()) {
+			return feed;
+		}
 
-			item.pubDate = entry["published_at"];
+		if (!content.is_object() || !content["entries"].is_array()) {
+			LOG(Level::ERROR,
+				"MinifluxApi::fetch_feed: items is not an array");
+			return feed;
+		}
 
-			const std::string status = entry["status"];
-			if (status == "unread") {
-				item.labels.push_back("miniflux:unread");
-			} else {
-				item.labels.push_back("miniflux:read");
-			}
+		LOG(Level::DEBUG,
+			"MinifluxApi::fetch_feed: %" PRIu64 " items",
+			entries);
 
-			feed.items.push_back(item);
+		offset += entries;
+		if (!incremental || entries == 0
+			|| offset >= content.value("total", std::uint64_t(0))) {
+			break;
 		}
-	} catch (json::exception& e) {
-		LOG(Level::ERROR,
-			"Exception occurred while parsing feeed: ",
-			e.what());
+	}
+
+	if (newest_change > 0) {
+		// `changed_after` only returns strictly newer changes, and more
+		// changes might still come in during the same second.
+		sync_cursor = std::to_string(newest_change - 1);
 	}
 
 	std::sort(feed.items.begin(),
@@ -243,6 +319,15 @@ json MinifluxApi::run_op(const std::string& path,
 	const json& args,
 	CurlHandle& easyhandle,
 	const HTTPMethod method /* = GET */)
+{
+	return run_op(path, args, easyhandle, method, nullptr);
+}
+
+json MinifluxApi::run_op(const std::string& path,
+	const json& args,
+	CurlHandle& easyhandle,
+	const HTTPMethod method,
+	const std::function<void(json&& entry)>& on_entry)
 {
 	// follow redirects and keep the same request type
 	curl_easy_setopt(easyhandle.ptr(), CURLOPT_FOLLOWLOCATION, 1);
@@ -269,21 +354,23 @@ json MinifluxApi::run_op(const std::string& path,
 			url, easyhandle, cfg, auth_info, body, method);
 
 
-	LOG(Level::DEBUG,
-		"MinifluxApi::run_op(%s %s,...): body=%s reply = %s",
-		utils::http_method_str(method),
-		path,
-		arg_dump,
-		result);
+	LOG_FIELDS(Level::DEBUG, "MinifluxApi::run_op", {
+		{"method", utils::http_method_str(method)},
+		{"path", path},
+		{"body", arg_dump},
+		{"reply", result}});
 
 	json content;
 	if (!result.empty()) {
 		try {
-			content = json::parse(result);
+			if (on_entry) {
+				content = jsonstream::parse(result, "entries", on_entry);
+			} else {
+				content = json::parse(result);
+			}
 		} catch (json::parse_error& e) {
-			LOG(Level::ERROR,
-				"MinifluxApi::run_op: reply failed to parse: %s",
-				result);
+			LOG_FIELDS(Level::ERROR, "MinifluxApi::run_op: reply failed to parse", {
+				{"reply", result}});
 			content = json(nullptr);
 		}
 	}
@@ -1,10 +1,17 @@
 #include "newsblurapi.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <iterator>
 #include <string.h>
 #include <time.h>
 
+#include "3rd-party/json.hpp"
+#include "curlhandle.h"
 #include "json.h"
+#include "jsonstream.h"
 #include "remoteapi.h"
 #include "strprintf.h"
 #include "utils.h"
@@ -23,6 +30,7 @@
 #endif
 
 #define NEWSBLUR_ITEMS_PER_PAGE 6
+#define NEWSBLUR_MAX_PARALLEL_PAGES 4u
 
 using HTTPMethod = newsboat::utils::HTTPMethod;
 
@@ -80,6 +88,13 @@ std::string NewsBlurApi::retrieve_auth()
 	return strprintf::fmt("username=%s&password=%s", cred.user, cred.pass);
 }
 
+bool NewsBlurApi::can_use_cached_subscriptions() const
+{
+	// Feeds are fetched with the title and link that get_subscribed_urls()
+	// found for them.
+	return false;
+}
+
 std::vector<TaggedFeedUrl> NewsBlurApi::get_subscribed_urls()
 {
 	std::vector<TaggedFeedUrl> result;
@@ -229,11 +244,45 @@ bool NewsBlurApi::mark_article_read(const std::string& guid, bool read)
 	return request_successfull(query_result);
 }
 
+bool NewsBlurApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	// mark_story_as_read takes any number of stories, as long as they are
+	// all from the same feed.
+	std::map<std::string, std::string> post_data_per_feed;
+	for (const auto& guid : guids) {
+		// handle dummy articles
+		if (guid.empty()) {
+			continue;
+		}
+		const auto separator = guid.find(ID_SEPARATOR);
+		const std::string feed_id = guid.substr(0, separator);
+		const std::string article_id =
+			guid.substr(separator + sizeof(ID_SEPARATOR) - 1);
+
+		std::string& post_data = post_data_per_feed[feed_id];
+		if (post_data.empty()) {
+			post_data = "feed_id=" + feed_id;
+		}
+		post_data += "&story_id=" + article_id;
+	}
+
+	bool success = true;
+	for (const auto& entry : post_data_per_feed) {
+		json_object* query_result = query_api("/reader/mark_story_as_read",
+				&entry.second, HTTPMethod::POST);
+		if (!request_successfull(query_result)) {
+			success = false;
+		}
+	}
+	return success;
+}
+
 bool NewsBlurApi::update_article_flags(const std::string& /* oldflags */,
 	const std::string& /* newflags */,
 	const std::string& /* guid */)
 {
-	return false;
+	// NewsBlur has no flags to sync, so there's nothing that could fail.
+	return true;
 }
 
 time_t parse_date(const char* raw)
@@ -246,6 +295,13 @@ time_t parse_date(const char* raw)
 }
 
 rsspp::Feed NewsBlurApi::fetch_feed(const std::string& id)
+{
+	CurlHandle handle;
+	return fetch_feed(id, handle);
+}
+
+rsspp::Feed NewsBlurApi::fetch_feed(const std::string& id,
+	CurlHandle& cached_handle)
 {
 	rsspp::Feed f = known_feeds[id];
 
@@ -254,102 +310,125 @@ rsspp::Feed NewsBlurApi::fetch_feed(const std::string& id)
 		min_pages,
 		id);
 
-	for (unsigned int i = 1; i <= min_pages; i++) {
-		std::string page = std::to_string(i);
-
-		json_object* query_result = query_api(
-				"/reader/feed/" + id + "?page=" + page, nullptr);
-
-		if (!query_result) {
-			return f;
+	// json-c can only parse whole replies, which would leave the text and
+	// the parsed form of all stories in memory at once. Converting each
+	// story as soon as it's parsed avoids that.
+	const auto as_string = [](const nlohmann::json& value) -> std::string {
+		if (value.is_string()) {
+			return value.get<std::string>();
+		} else if (value.is_null()) {
+			return {};
 		}
-
-		json_object* stories{};
-		if (json_object_object_get_ex(
-				query_result, "stories", &stories) == FALSE) {
-			LOG(Level::ERROR,
-				"NewsBlurApi::fetch_feed: request returned no "
-				"stories");
-			return f;
+		return value.dump();
+	};
+
+	// Pages are fetched at the same time, but only those before the first
+	// one that failed are used, like when fetching them one by one.
+	std::vector<std::vector<rsspp::Item>> pages(min_pages);
+	std::atomic<unsigned int> first_failed_page(min_pages);
+	const auto fail = [&](unsigned int page) {
+		unsigned int failed = first_failed_page;
+		while (page < failed
+			&& !first_failed_page.compare_exchange_weak(failed, page)) {
 		}
+	};
 
-		if (json_object_get_type(stories) != json_type_array) {
-			LOG(Level::ERROR,
-				"NewsBlurApi::fetch_feed: content is not an "
-				"array");
-			return f;
-		}
-
-		struct array_list* items = json_object_get_array(stories);
-		int items_size = array_list_length(items);
-		LOG(Level::DEBUG,
-			"NewsBlurApi::fetch_feed: %d items",
-			items_size);
-
-		for (int i = 0; i < items_size; i++) {
-			json_object* item_obj = (json_object*)array_list_get_idx(items, i);
+	fetch_pages(min_pages, NEWSBLUR_MAX_PARALLEL_PAGES, cached_handle,
+	[&](unsigned int i, CurlHandle& handle) {
+		const std::string page = std::to_string(i + 1);
 
-			rsspp::Item item;
+		const std::string url = api_location + "/reader/feed/" + id + "?page=" + page;
+		const std::string data = utils::retrieve_url(url, handle, cfg, "", nullptr,
+				HTTPMethod::GET);
 
-			json_object* node{};
+		std::vector<rsspp::Item>& items = pages[i];
+		nlohmann::json rest;
+		try {
+			rest = jsonstream::parse(data, "stories",
+			[&](nlohmann::json&& item_obj) {
+				rsspp::Item item;
 
-			if (json_object_object_get_ex(item_obj, "story_title", &node) == TRUE) {
-				const auto title = json_object_get_string(node);
-				if (title != nullptr) {
-					item.title = title;
+				if (item_obj.contains("story_title")) {
+					item.title = as_string(item_obj["story_title"]);
 				}
-			}
 
-			if (json_object_object_get_ex(item_obj, "story_authors", &node) == TRUE) {
-				const auto author = json_object_get_string(node);
-				if (author != nullptr) {
-					item.author = author;
+				if (item_obj.contains("story_authors")) {
+					item.author = as_string(item_obj["story_authors"]);
 				}
-			}
 
-			if (json_object_object_get_ex(item_obj, "story_permalink", &node) == TRUE) {
-				const auto link = json_object_get_string(node);
-				if (link != nullptr) {
-					item.link = link;
+				if (item_obj.contains("story_permalink")) {
+					item.link = as_string(item_obj["story_permalink"]);
 				}
-			}
 
-			if (json_object_object_get_ex(item_obj, "story_content", &node) == TRUE) {
-				const auto content_encoded = json_object_get_string(node);
-				if (content_encoded != nullptr) {
-					item.content_encoded = content_encoded;
+				if (item_obj.contains("story_content")) {
+					item.content_encoded = as_string(item_obj["story_content"]);
 				}
-			}
-
-			const char* article_id{};
-			if (json_object_object_get_ex(item_obj, "id", &node) == TRUE) {
-				article_id = json_object_get_string(node);
-			}
-			item.guid = id + ID_SEPARATOR + (article_id ? article_id : "");
 
-			if (json_object_object_get_ex(item_obj, "read_status", &node) == TRUE) {
-				if (!static_cast<bool>(json_object_get_int(node))) {
-					item.labels.push_back("newsblur:unread");
-				} else {
-					item.labels.push_back("newsblur:read");
+				std::string article_id;
+				if (item_obj.contains("id")) {
+					article_id = as_string(item_obj["id"]);
+				}
+				item.guid = id + ID_SEPARATOR + article_id;
+
+				if (item_obj.contains("read_status")) {
+					const nlohmann::json& read_status = item_obj["read_status"];
+					const bool read = read_status.is_number()
+						? read_status.get<int>() != 0
+						: read_status.is_boolean() && read_status.get<bool>();
+					if (!read) {
+						item.labels.push_back("newsblur:unread");
+					} else {
+						item.labels.push_back("newsblur:read");
+					}
 				}
-			}
 
-			if (json_object_object_get_ex(item_obj, "story_date", &node) == TRUE) {
-				const char* pub_date = json_object_get_string(node);
-				if (pub_date != nullptr) {
-					item.pubDate_ts = parse_date(pub_date);
-				} else {
-					item.pubDate_ts = ::time(nullptr);
+				if (item_obj.contains("story_date")) {
+					const nlohmann::json& pub_date = item_obj["story_date"];
+					if (pub_date.is_string()) {
+						item.pubDate_ts = parse_date(pub_date.get<std::string>().c_str());
+					} else {
+						item.pubDate_ts = ::time(nullptr);
+					}
+
+					item.pubDate = utils::mt_strf_localtime(
+							"%a, %d %b %Y %H:%M:%S %z",
+							item.pubDate_ts);
 				}
 
-				item.pubDate = utils::mt_strf_localtime(
-						"%a, %d %b %Y %H:%M:%S %z",
-						item.pubDate_ts);
-			}
+				items.push_back(item);
+			});
+		} catch (const nlohmann::json::exception& e) {
+			LOG(Level::WARN,
+				"NewsBlurApi::fetch_feed: request to %s failed: %s",
+				url,
+				e.what());
+			fail(i);
+			return;
+		}
 
-			f.items.push_back(item);
+		if (!rest.is_object() || !rest.contains("stories")) {
+			LOG(Level::ERROR,
+				"NewsBlurApi::fetch_feed: request returned no "
+				"stories");
+			fail(i);
+			return;
 		}
+
+		if (!rest["stories"].is_array()) {
+			LOG(Level::ERROR,
+				"NewsBlurApi::fetch_feed: content is not an "
+				"array");
+			fail(i);
+			return;
+		}
+
+		LOG(Level::DEBUG,
+			"NewsBlurApi::fetch_feed: %" PRIu64 " items",
+			static_cast<uint64_t>(items.size()));
+	});
+
+	for (unsigned int i = 0; i < first_failed_page; i++) {
+		std::move(pages[i].begin(), pages[i].end(), std::back_inserter(f.items));
 	}
 
 	std::sort(f.items.begin(),
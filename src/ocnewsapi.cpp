@@ -1,6 +1,7 @@
 #include "ocnewsapi.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <curl/curl.h>
@@ -49,6 +50,13 @@ std::string OcNewsApi::retrieve_auth()
 	return cred.user + ":" + cred.pass;
 }
 
+bool OcNewsApi::can_use_cached_subscriptions() const
+{
+	// Feeds are fetched by the IDs that get_subscribed_urls() found for
+	// them.
+	return false;
+}
+
 std::vector<TaggedFeedUrl> OcNewsApi::get_subscribed_urls()
 {
 	std::vector<TaggedFeedUrl> result;
@@ -179,13 +187,23 @@ bool OcNewsApi::mark_article_read(const std::string& guid, bool read)
 }
 
 bool OcNewsApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	return mark_multiple(guids, "items/read/multiple");
+}
+
+bool OcNewsApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	return mark_multiple(guids, "items/unread/multiple");
+}
+
+bool OcNewsApi::mark_multiple(const std::vector<std::string>& guids,
+	const std::string& query)
 {
 	std::vector<std::string> ids;
 	for (const auto& guid : guids) {
 		ids.push_back(guid.substr(0, guid.find_first_of(":")));
 	}
 
-	const std::string query = "items/read/multiple";
 	const std::string id_array = strprintf::fmt("[%s]", utils::join(ids, ","));
 	const std::string parameters = strprintf::fmt(R"({"items": %s})", id_array);
 	return this->query(query, nullptr, parameters);
@@ -215,10 +233,22 @@ bool OcNewsApi::update_article_flags(const std::string& oldflags,
 }
 
 rsspp::Feed OcNewsApi::fetch_feed(const std::string& feed_id)
+{
+	std::string sync_cursor;
+	return fetch_feed(feed_id, sync_cursor);
+}
+
+rsspp::Feed OcNewsApi::fetch_feed(const std::string& feed_id,
+	std::string& sync_cursor)
 {
 	rsspp::Feed feed = known_feeds[feed_id].first;
 
+	// After the first sync, we only ask for the items that were added or
+	// changed since then, which includes changes to their read state.
 	std::string query = "items?";
+	if (!sync_cursor.empty()) {
+		query = "items/updated?lastModified=" + sync_cursor + "&";
+	}
 	query += "type=" +
 		std::to_string(known_feeds[feed_id].second != 0 ? 0 : 2);
 	query += "&id=" + std::to_string(known_feeds[feed_id].second);
@@ -242,6 +272,7 @@ rsspp::Feed OcNewsApi::fetch_feed(const std::string& feed_id)
 
 	feed.items.clear();
 
+	int64_t last_modified = 0;
 	for (int i = 0; i < array_length; i++) {
 		json_object* item_j = static_cast<json_object*>(list->array[i]);
 		json_object* node;
@@ -320,9 +351,16 @@ rsspp::Feed OcNewsApi::fetch_feed(const std::string& feed_id)
 				"%a, %d %b %Y %H:%M:%S %z",
 				updated);
 
+		json_object_object_get_ex(item_j, "lastModified", &node);
+		last_modified = std::max(last_modified, json_object_get_int64(node));
+
 		feed.items.push_back(item);
 	}
 
+	if (last_modified > 0) {
+		sync_cursor = std::to_string(last_modified);
+	}
+
 	return feed;
 }
 
@@ -11,9 +11,9 @@
 #include "strprintf.h"
 #include "utils.h"
 
-#define OLDREADER_LOGIN "https://theoldreader.com/accounts/ClientLogin"
-#define OLDREADER_API_PREFIX "https://theoldreader.com/reader/api/0/"
-#define OLDREADER_FEED_PREFIX "https://theoldreader.com/reader/atom/"
+#define OLDREADER_LOGIN "/accounts/ClientLogin"
+#define OLDREADER_API_PREFIX "/reader/api/0/"
+#define OLDREADER_FEED_PREFIX "/reader/atom/"
 
 #define OLDREADER_OUTPUT_SUFFIX "?output=json"
 
@@ -27,8 +27,9 @@
 
 namespace newsboat {
 
-OldReaderApi::OldReaderApi(ConfigContainer& c)
+OldReaderApi::OldReaderApi(ConfigContainer& c, const std::string& server)
 	: RemoteApi(c)
+	, server(server)
 {
 }
 
@@ -63,7 +64,9 @@ std::string OldReaderApi::retrieve_auth()
 
 	utils::set_common_curl_options(handle, cfg);
 	curl_easy_setopt(handle.ptr(), CURLOPT_POSTFIELDS, postcontent.c_str());
-	curl_easy_setopt(handle.ptr(), CURLOPT_URL, OLDREADER_LOGIN);
+	curl_easy_setopt(handle.ptr(),
+		CURLOPT_URL,
+		(server + OLDREADER_LOGIN).c_str());
 
 	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
 
@@ -91,20 +94,14 @@ std::vector<TaggedFeedUrl> OldReaderApi::get_subscribed_urls()
 
 	CurlHandle handle;
 	add_custom_headers(&custom_headers);
-	curl_easy_setopt(handle.ptr(), CURLOPT_HTTPHEADER, custom_headers);
 
 	utils::set_common_curl_options(handle, cfg);
-	curl_easy_setopt(handle.ptr(), CURLOPT_URL, OLDREADER_SUBSCRIPTION_LIST);
-
-	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
-
-	curl_easy_perform(handle.ptr());
+	const std::string result = get_subscription_reply(handle,
+			server + OLDREADER_SUBSCRIPTION_LIST, &custom_headers);
 	curl_slist_free_all(custom_headers);
 
-	const std::string result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"OldReaderApi::get_subscribed_urls: document = %s",
-		result);
+	LOG_FIELDS(Level::DEBUG, "OldReaderApi::get_subscribed_urls", {
+		{"document", result}});
 
 	json_object* reply = json_tokener_parse(result.c_str());
 	if (reply == nullptr) {
@@ -174,7 +171,8 @@ std::vector<TaggedFeedUrl> OldReaderApi::get_subscribed_urls()
 				tags.push_back(std::string(label));
 			}
 
-			auto url = strprintf::fmt("%s%s?n=%u",
+			auto url = strprintf::fmt("%s%s%s?n=%u",
+					server,
 					OLDREADER_FEED_PREFIX,
 					id,
 					cfg.get_configvalue_as_int("oldreader-min-items"));
@@ -202,8 +200,9 @@ void OldReaderApi::add_custom_headers(curl_slist** custom_headers)
 
 bool OldReaderApi::mark_all_read(const std::string& feedurl)
 {
-	std::string real_feedurl = feedurl.substr(strlen(OLDREADER_FEED_PREFIX),
-			feedurl.length() - strlen(OLDREADER_FEED_PREFIX));
+	const std::string prefix = server + OLDREADER_FEED_PREFIX;
+	std::string real_feedurl = feedurl.substr(prefix.length(),
+			feedurl.length() - prefix.length());
 	std::vector<std::string> elems = utils::tokenize(real_feedurl, "?");
 	try {
 		real_feedurl = utils::unescape_url(elems[0]);
@@ -222,7 +221,7 @@ bool OldReaderApi::mark_all_read(const std::string& feedurl)
 		strprintf::fmt("s=%s&T=%s", real_feedurl, token);
 
 	std::string result =
-		post_content(OLDREADER_API_MARK_ALL_READ_URL, postcontent);
+		post_content(server + OLDREADER_API_MARK_ALL_READ_URL, postcontent);
 
 	return result == "OK";
 }
@@ -230,38 +229,51 @@ bool OldReaderApi::mark_all_read(const std::string& feedurl)
 bool OldReaderApi::mark_article_read(const std::string& guid, bool read)
 {
 	std::string token = get_new_token();
-	return mark_article_read_with_token(guid, read, token);
+	return mark_articles_read_with_token({guid}, read, token);
+}
+
+bool OldReaderApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	std::string token = get_new_token();
+	return mark_articles_read_with_token(guids, true, token);
 }
 
-bool OldReaderApi::mark_article_read_with_token(const std::string& guid,
+bool OldReaderApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	std::string token = get_new_token();
+	return mark_articles_read_with_token(guids, false, token);
+}
+
+bool OldReaderApi::mark_articles_read_with_token(
+	const std::vector<std::string>& guids,
 	bool read,
 	const std::string& token)
 {
+	// edit-tag applies the same change to every article passed as `i`.
 	std::string postcontent;
+	for (const auto& guid : guids) {
+		postcontent += strprintf::fmt("i=%s&", guid);
+	}
 
 	if (read) {
-		postcontent = strprintf::fmt(
-				"i=%s&a=user/-/state/com.google/read&r=user/-/state/"
+		postcontent += strprintf::fmt(
+				"a=user/-/state/com.google/read&r=user/-/state/"
 				"com.google/kept-unread&ac=edit&T=%s",
-				guid,
 				token);
 	} else {
-		postcontent = strprintf::fmt(
-				"i=%s&r=user/-/state/com.google/read&a=user/-/state/"
+		postcontent += strprintf::fmt(
+				"r=user/-/state/com.google/read&a=user/-/state/"
 				"com.google/kept-unread&a=user/-/state/com.google/"
 				"tracking-kept-unread&ac=edit&T=%s",
-				guid,
 				token);
 	}
 
 	std::string result =
-		post_content(OLDREADER_API_EDIT_TAG_URL, postcontent);
+		post_content(server + OLDREADER_API_EDIT_TAG_URL, postcontent);
 
-	LOG(Level::DEBUG,
-		"OldReaderApi::mark_article_read_with_token: postcontent = %s "
-		"result = %s",
-		postcontent,
-		result);
+	LOG_FIELDS(Level::DEBUG, "OldReaderApi::mark_articles_read_with_token", {
+		{"postcontent", postcontent},
+		{"result", result}});
 
 	return result == "OK";
 }
@@ -274,7 +286,9 @@ std::string OldReaderApi::get_new_token()
 	utils::set_common_curl_options(handle, cfg);
 	add_custom_headers(&custom_headers);
 	curl_easy_setopt(handle.ptr(), CURLOPT_HTTPHEADER, custom_headers);
-	curl_easy_setopt(handle.ptr(), CURLOPT_URL, OLDREADER_API_TOKEN_URL);
+	curl_easy_setopt(handle.ptr(),
+		CURLOPT_URL,
+		(server + OLDREADER_API_TOKEN_URL).c_str());
 
 	auto curlDataReceiver = CurlDataReceiver::register_data_handler(handle);
 
@@ -328,7 +342,7 @@ bool OldReaderApi::star_article(const std::string& guid, bool star)
 	}
 
 	std::string result =
-		post_content(OLDREADER_API_EDIT_TAG_URL, postcontent);
+		post_content(server + OLDREADER_API_EDIT_TAG_URL, postcontent);
 
 	return result == "OK";
 }
@@ -351,7 +365,7 @@ bool OldReaderApi::share_article(const std::string& guid, bool share)
 	}
 
 	std::string result =
-		post_content(OLDREADER_API_EDIT_TAG_URL, postcontent);
+		post_content(server + OLDREADER_API_EDIT_TAG_URL, postcontent);
 
 	return result == "OK";
 }
@@ -374,12 +388,10 @@ std::string OldReaderApi::post_content(const std::string& url,
 	curl_slist_free_all(custom_headers);
 
 	const std::string result = curlDataReceiver->get_data();
-	LOG(Level::DEBUG,
-		"OldReaderApi::post_content: url = %s postdata = %s result = "
-		"%s",
-		url,
-		postdata,
-		result);
+	LOG_FIELDS(Level::DEBUG, "OldReaderApi::post_content", {
+		{"url", url},
+		{"postdata", postdata},
+		{"result", result}});
 
 	return result;
 }
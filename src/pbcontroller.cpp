@@ -24,7 +24,6 @@
 #include "matcherexception.h"
 #include "nullconfigactionhandler.h"
 #include "pbview.h"
-#include "poddlthread.h"
 #include "queueloader.h"
 #include "strprintf.h"
 #include "utils.h"
@@ -250,6 +249,9 @@ void PbController::initialize(int argc, char* argv[])
 		logger::set_logfile(filename);
 	}
 
+	logger::start_background_writer();
+	std::atexit(logger::stop_background_writer);
+
 	std::cout << strprintf::fmt(
 			_("Starting %s %s..."), "Podboat", utils::program_version())
 		<< std::endl;
@@ -314,7 +316,9 @@ int PbController::run(PbView& v)
 	});
 	ql->reload(downloads_);
 
+	engine = std::make_unique<DownloadEngine>(cfg);
 	v.run(automatic_dl, cfg.get_configvalue_as_bool("wrap-scroll"));
+	engine.reset();
 
 	Stfl::reset();
 
@@ -415,7 +419,8 @@ unsigned int PbController::downloads_in_progress()
 {
 	unsigned int count = 0;
 	for (const auto& dl : downloads_) {
-		if (dl.status() == DlStatus::DOWNLOADING) {
+		if (dl.status() == DlStatus::DOWNLOADING
+			|| dl.status() == DlStatus::PAUSED) {
 			++count;
 		}
 	}
@@ -462,8 +467,30 @@ void PbController::start_downloads()
 
 void PbController::start_download(Download& item)
 {
-	std::thread t{PodDlThread(&item, cfg)};
-	t.detach();
+	item.set_status(DlStatus::DOWNLOADING);
+	engine->start(item);
+}
+
+void PbController::cancel_download(Download& item)
+{
+	item.set_status(DlStatus::CANCELLED);
+	engine->cancel(item);
+}
+
+void PbController::toggle_pause(Download& item)
+{
+	if (item.status() == DlStatus::DOWNLOADING) {
+		item.set_status(DlStatus::PAUSED);
+		engine->pause(item);
+	} else if (item.status() == DlStatus::PAUSED) {
+		item.set_status(DlStatus::DOWNLOADING);
+		engine->resume(item);
+	}
+}
+
+void PbController::poll_downloads()
+{
+	engine->poll(downloads_);
 }
 
 void PbController::increase_parallel_downloads()
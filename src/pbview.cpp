@@ -60,6 +60,8 @@ void PbView::run(bool auto_download, bool wrap_scroll)
 	set_dllist_keymap_hint();
 
 	do {
+		ctrl.poll_downloads();
+
 		if (update_view) {
 			const double total_kbps = ctrl.get_total_kbps();
 			const auto speed = get_speed_human_readable(total_kbps);
@@ -185,7 +187,8 @@ void PbView::run(bool auto_download, bool wrap_scroll)
 			if (ctrl.downloads().size() >= 1) {
 				const auto idx = downloads_list.get_position();
 				auto& item = ctrl.downloads()[idx];
-				if (item.status() != DlStatus::DOWNLOADING) {
+				if (item.status() != DlStatus::DOWNLOADING
+					&& item.status() != DlStatus::PAUSED) {
 					ctrl.start_download(item);
 				}
 			}
@@ -228,20 +231,27 @@ void PbView::run(bool auto_download, bool wrap_scroll)
 		case OP_PB_CANCEL: {
 			if (ctrl.downloads().size() >= 1) {
 				const auto idx = downloads_list.get_position();
-				if (ctrl.downloads()[idx].status() ==
-					DlStatus::DOWNLOADING) {
-					ctrl.downloads()[idx].set_status(
-						DlStatus::CANCELLED);
+				auto& item = ctrl.downloads()[idx];
+				if (item.status() == DlStatus::DOWNLOADING
+					|| item.status() == DlStatus::PAUSED) {
+					ctrl.cancel_download(item);
 				}
 			}
 		}
 		break;
+		case OP_PB_TOGGLE_PAUSE: {
+			if (ctrl.downloads().size() >= 1) {
+				const auto idx = downloads_list.get_position();
+				ctrl.toggle_pause(ctrl.downloads()[idx]);
+			}
+		}
+		break;
 		case OP_PB_DELETE: {
 			auto& downloads = ctrl.downloads();
 			if (downloads.size() >= 1) {
 				const auto idx = downloads_list.get_position();
-				if (downloads[idx].status() !=
-					DlStatus::DOWNLOADING) {
+				if (downloads[idx].status() != DlStatus::DOWNLOADING
+					&& downloads[idx].status() != DlStatus::PAUSED) {
 					downloads[idx].set_status(DlStatus::DELETED);
 					if (idx + 1 < downloads.size()) {
 						downloads_list.set_position(idx + 1);
@@ -383,6 +393,7 @@ void PbView::set_dllist_keymap_hint()
 	static const std::vector<KeyMapHintEntry> hints = {{OP_QUIT, _("Quit")},
 		{OP_PB_DOWNLOAD, _("Download")},
 		{OP_PB_CANCEL, _("Cancel")},
+		{OP_PB_TOGGLE_PAUSE, _("Pause/Resume")},
 		{OP_PB_DELETE, _("Delete")},
 		{OP_PB_PURGE, _("Purge Finished")},
 		{OP_PB_TOGGLE_DLALL, _("Toggle Automatic Download")},
@@ -0,0 +1,273 @@
+#include "queuefile.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+namespace newsboat {
+
+namespace {
+
+/// How many bytes before the read offset are compared to notice in-place
+/// rewrites.
+const size_t TAIL_SIZE = 64;
+
+bool read_from(int fd, off_t offset, std::string& data)
+{
+	char buf[64 * 1024];
+	for (;;) {
+		const ssize_t rc = ::pread(fd, buf, sizeof(buf), offset);
+		if (rc == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		if (rc == 0) {
+			return true;
+		}
+		data.append(buf, rc);
+		offset += rc;
+	}
+}
+
+bool write_all(int fd, const std::string& data)
+{
+	size_t written = 0;
+	while (written < data.size()) {
+		const ssize_t rc = ::write(fd, data.data() + written,
+				data.size() - written);
+		if (rc == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		written += rc;
+	}
+	return true;
+}
+
+std::string last_bytes(const std::string& data)
+{
+	return data.size() > TAIL_SIZE ? data.substr(data.size() - TAIL_SIZE) : data;
+}
+
+/// The file that `path` refers to, with symlinks resolved, so that replacing
+/// it keeps the links pointing at it. Returns `path` if it can't be resolved.
+std::string resolve_symlinks(const std::string& path)
+{
+	char resolved[PATH_MAX];
+	if (::realpath(path.c_str(), resolved) == nullptr) {
+		return path;
+	}
+	return resolved;
+}
+
+} // namespace
+
+QueueFile::QueueFile(std::string path)
+	: queue_path(std::move(path))
+{
+}
+
+int QueueFile::open_locked(int flags) const
+{
+	for (;;) {
+		const int fd = ::open(queue_path.c_str(), flags | O_CLOEXEC, 0666);
+		if (fd == -1) {
+			return -1;
+		}
+		while (::flock(fd, LOCK_EX) == -1) {
+			if (errno != EINTR) {
+				::close(fd);
+				return -1;
+			}
+		}
+
+		// If Podboat replaced the file while we waited for the lock, we
+		// hold a lock on the old one, and have to start over.
+		struct stat locked;
+		struct stat current;
+		if (::fstat(fd, &locked) == 0 && ::stat(queue_path.c_str(), &current) == 0
+			&& locked.st_dev == current.st_dev && locked.st_ino == current.st_ino) {
+			return fd;
+		}
+		::close(fd);
+	}
+}
+
+bool QueueFile::only_appended(int fd, const struct stat& sb) const
+{
+	if (!have_read || sb.st_dev != device || sb.st_ino != inode
+		|| sb.st_size < offset) {
+		return false;
+	}
+
+	std::string current_tail(tail.size(), '\0');
+	const ssize_t rc = ::pread(fd, &current_tail[0], tail.size(),
+			offset - tail.size());
+	return rc == static_cast<ssize_t>(tail.size()) && current_tail == tail;
+}
+
+void QueueFile::remember(const struct stat& sb, const std::string& last)
+{
+	have_read = true;
+	device = sb.st_dev;
+	inode = sb.st_ino;
+	offset = sb.st_size;
+	tail = last;
+}
+
+QueueFile::Update QueueFile::read_new_lines()
+{
+	Update update;
+
+	const int fd = open_locked(O_RDONLY);
+	if (fd == -1) {
+		if (errno != ENOENT) {
+			LOG(Level::ERROR,
+				"QueueFile::read_new_lines: can't open %s: %s",
+				queue_path,
+				strerror(errno));
+		}
+		update.from_start = true;
+		have_read = false;
+		return update;
+	}
+
+	struct stat sb;
+	std::string data;
+	if (::fstat(fd, &sb) == -1) {
+		::close(fd);
+		return update;
+	}
+	update.from_start = !only_appended(fd, sb);
+	const off_t start = update.from_start ? 0 : offset;
+	const bool ok = read_from(fd, start, data);
+	::close(fd);
+	if (!ok) {
+		LOG(Level::ERROR,
+			"QueueFile::read_new_lines: can't read %s: %s",
+			queue_path,
+			strerror(errno));
+		return update;
+	}
+
+	// Whatever was appended after fstat() is read as well.
+	sb.st_size = start + data.size();
+	remember(sb, last_bytes(update.from_start ? data : tail + data));
+
+	size_t line_start = 0;
+	while (line_start < data.size()) {
+		size_t line_end = data.find('\n', line_start);
+		if (line_end == std::string::npos) {
+			line_end = data.size();
+		}
+		update.lines.push_back(data.substr(line_start, line_end - line_start));
+		line_start = line_end + 1;
+	}
+
+	LOG(Level::DEBUG,
+		"QueueFile::read_new_lines: read %" PRIu64 " lines from %s (from the "
+		"start: %s)",
+		static_cast<uint64_t>(update.lines.size()),
+		queue_path,
+		update.from_start ? "yes" : "no");
+	return update;
+}
+
+bool QueueFile::append_line(const std::string& line)
+{
+	const int fd = open_locked(O_WRONLY | O_APPEND | O_CREAT);
+	if (fd == -1) {
+		return false;
+	}
+	const bool ok = write_all(fd, line + "\n");
+	::close(fd);
+	return ok;
+}
+
+QueueFile::ReplaceResult QueueFile::replace(const std::vector<std::string>&
+	lines)
+{
+	const int fd = open_locked(O_RDONLY | O_CREAT);
+	if (fd == -1) {
+		LOG(Level::ERROR,
+			"QueueFile::replace: can't open %s: %s",
+			queue_path,
+			strerror(errno));
+		return ReplaceResult::FAILED;
+	}
+
+	struct stat sb;
+	if (::fstat(fd, &sb) == -1) {
+		::close(fd);
+		return ReplaceResult::FAILED;
+	}
+	// A file that doesn't exist reads as empty, so it's fine to create it.
+	const bool unchanged = have_read
+		? only_appended(fd, sb) && sb.st_size == offset
+		: sb.st_size == 0;
+	if (!unchanged) {
+		::close(fd);
+		return ReplaceResult::CHANGED;
+	}
+
+	std::string contents;
+	for (const auto& line : lines) {
+		contents.append(line);
+		contents.push_back('\n');
+	}
+
+	// If the queue is a symlink, replace the file it points to; the
+	// temporary file has to be next to that file for rename() to work.
+	const std::string target_path = resolve_symlinks(queue_path);
+	const std::string tmp_path = target_path + ".tmp";
+	const int tmp_fd = ::open(tmp_path.c_str(),
+			O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	bool ok = tmp_fd != -1;
+	if (ok) {
+		// Keep the owner where we're allowed to. Changing it to ourselves
+		// is a no-op, and only root can give the file to someone else.
+		if (::fchown(tmp_fd, sb.st_uid, sb.st_gid) == -1) {
+			LOG(Level::DEBUG,
+				"QueueFile::replace: can't keep the owner of %s: %s",
+				target_path,
+				strerror(errno));
+		}
+		// After fchown(), which may clear the set-user-ID bits.
+		ok = ::fchmod(tmp_fd, sb.st_mode & 07777) == 0
+			&& write_all(tmp_fd, contents)
+			&& ::fsync(tmp_fd) == 0;
+		struct stat tmp_sb;
+		ok = ::fstat(tmp_fd, &tmp_sb) == 0 && ok;
+		ok = ::close(tmp_fd) == 0 && ok;
+		// The old file stays locked until the new one is in place, so
+		// that Newsboat waits and then appends to the new one.
+		ok = ok && ::rename(tmp_path.c_str(), target_path.c_str()) == 0;
+		if (ok) {
+			remember(tmp_sb, last_bytes(contents));
+		}
+	}
+	if (!ok) {
+		LOG(Level::ERROR,
+			"QueueFile::replace: can't write %s: %s",
+			tmp_path,
+			strerror(errno));
+		::unlink(tmp_path.c_str());
+	}
+	::close(fd);
+
+	return ok ? ReplaceResult::REPLACED : ReplaceResult::FAILED;
+}
+
+} // namespace newsboat
@@ -4,7 +4,6 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
-#include <fstream>
 #include <iostream>
 #include <libgen.h>
 #include <unistd.h>
@@ -20,6 +19,14 @@ using namespace newsboat;
 
 namespace podboat {
 
+namespace {
+
+/// How many times reload() tries to rewrite a queue file that keeps
+/// changing underneath it.
+const int MAX_REPLACE_ATTEMPTS = 3;
+
+} // namespace
+
 QueueLoader::QueueLoader(const std::string& filepath,
 	const ConfigContainer& cfg_,
 	std::function<void()> cb_require_view_update_)
@@ -30,7 +37,7 @@ QueueLoader::QueueLoader(const std::string& filepath,
 }
 
 void QueueLoader::reload(std::vector<Download>& downloads,
-	bool also_remove_finished) const
+	bool also_remove_finished)
 {
 	CategorizedDownloads categorized_downloads;
 	const auto res = categorize_downloads(downloads, also_remove_finished);
@@ -39,8 +46,31 @@ void QueueLoader::reload(std::vector<Download>& downloads,
 	}
 	categorized_downloads = res.value();
 
-	update_from_queue_file(categorized_downloads);
-	write_queue_file(categorized_downloads);
+	for (int attempt = 1; ; attempt++) {
+		update_from_queue_file(categorized_downloads);
+
+		const auto lines = queue_file_lines(categorized_downloads);
+		if (lines == lines_on_disk) {
+			break;
+		}
+		const auto result = queuefile.replace(lines);
+		if (result == QueueFile::ReplaceResult::REPLACED) {
+			lines_on_disk = lines;
+		}
+		if (result != QueueFile::ReplaceResult::CHANGED) {
+			break;
+		}
+		if (attempt == MAX_REPLACE_ATTEMPTS) {
+			LOG(Level::ERROR,
+				"QueueLoader::reload: %s keeps changing, giving up on "
+				"updating it",
+				queuefile.path());
+			break;
+		}
+		// Newsboat appended to the queue file in the meantime; pick up
+		// the new lines and try again.
+	}
+
 	if (cfg.get_configvalue_as_bool("delete-played-files")) {
 		delete_played_files(categorized_downloads);
 	}
@@ -55,10 +85,11 @@ nonstd::optional<QueueLoader::CategorizedDownloads> QueueLoader::categorize_down
 
 	for (const auto& dl : downloads) {
 		// we are not allowed to reload if a download is in progress!
-		if (dl.status() == DlStatus::DOWNLOADING) {
+		if (dl.status() == DlStatus::DOWNLOADING
+			|| dl.status() == DlStatus::PAUSED) {
 			LOG(Level::INFO,
 				"QueueLoader::reload: aborting reload due to "
-				"DlStatus::DOWNLOADING status");
+				"DlStatus::DOWNLOADING or DlStatus::PAUSED status");
 			return nonstd::nullopt;
 		}
 		bool keep_entry = false;
@@ -88,6 +119,7 @@ nonstd::optional<QueueLoader::CategorizedDownloads> QueueLoader::categorize_down
 			break;
 
 		case DlStatus::DOWNLOADING:
+		case DlStatus::PAUSED:
 			assert(!"Can't be reached because of the `if` above");
 			break;
 		}
@@ -102,15 +134,17 @@ nonstd::optional<QueueLoader::CategorizedDownloads> QueueLoader::categorize_down
 	return result;
 }
 
-void QueueLoader::update_from_queue_file(CategorizedDownloads& downloads) const
+void QueueLoader::update_from_queue_file(CategorizedDownloads& downloads)
 {
-	std::fstream f(queuefile, std::fstream::in);
-	if (!f.is_open()) {
-		return;
+	const auto update = queuefile.read_new_lines();
+	if (update.from_start) {
+		lines_on_disk.clear();
 	}
+	lines_on_disk.insert(lines_on_disk.end(), update.lines.begin(),
+		update.lines.end());
 
 	bool comments_ignored = false;
-	for (std::string line; std::getline(f, line); ) {
+	for (const auto& line : update.lines) {
 		if (line.empty()) {
 			continue;
 		}
@@ -129,7 +163,7 @@ void QueueLoader::update_from_queue_file(CategorizedDownloads& downloads) const
 							"when Podboat exits and comments will "
 							"be deleted. Press Enter to continue or "
 							"Ctrl+C to abort"),
-						queuefile)
+						queuefile.path())
 					<< std::endl;
 				std::cin.ignore();
 				comments_ignored = true;
@@ -203,26 +237,25 @@ void QueueLoader::update_from_queue_file(CategorizedDownloads& downloads) const
 	}
 }
 
-void QueueLoader::write_queue_file(const CategorizedDownloads& downloads) const
+std::vector<std::string> QueueLoader::queue_file_lines(
+	const CategorizedDownloads& downloads)
 {
-	std::fstream f(queuefile, std::fstream::out);
-	if (!f.is_open()) {
-		return;
-	}
+	std::vector<std::string> lines;
+	lines.reserve(downloads.to_keep.size());
 
 	for (const auto& dl : downloads.to_keep) {
-		f << dl.url() << " " << utils::quote(dl.filename());
+		std::string line = dl.url() + " " + utils::quote(dl.filename());
 		switch (dl.status()) {
 		case DlStatus::READY:
-			f << " downloaded";
+			line.append(" downloaded");
 			break;
 
 		case DlStatus::PLAYED:
-			f << " played";
+			line.append(" played");
 			break;
 
 		case DlStatus::FINISHED:
-			f << " finished";
+			line.append(" finished");
 			break;
 
 		// The following statuses have no marks in the queue file.
@@ -233,10 +266,13 @@ void QueueLoader::write_queue_file(const CategorizedDownloads& downloads) const
 		case DlStatus::FAILED:
 		case DlStatus::ALREADY_DOWNLOADED:
 		case DlStatus::RENAME_FAILED:
+		case DlStatus::PAUSED:
 			break;
 		}
-		f << std::endl;
+		lines.push_back(std::move(line));
 	}
+
+	return lines;
 }
 
 void QueueLoader::delete_played_files(const CategorizedDownloads& downloads)
@@ -1,6 +1,5 @@
 #include "queuemanager.h"
 
-#include <fstream>
 #include <libxml/uri.h>
 
 #include "fmtstrformatter.h"
@@ -20,37 +19,43 @@ EnqueueResult QueueManager::enqueue_url(std::shared_ptr<RssItem> item,
 	const std::string& url = item->enclosure_url();
 	const std::string filename = generate_enqueue_filename(item, feed);
 
-	std::fstream f;
-	f.open(queue_file, std::fstream::in);
-	if (f.is_open()) {
-		do {
-			std::string line;
-			getline(f, line);
-			if (!f.eof() && !line.empty()) {
-				const auto fields = utils::tokenize_quoted(line);
-				if (fields.size() >= 1 && fields[0] == url) {
-					return {EnqueueStatus::URL_QUEUED_ALREADY, url};
-				}
-				if (fields.size() >= 2 && fields[1] == filename) {
-					return {EnqueueStatus::OUTPUT_FILENAME_USED_ALREADY, filename};
-				}
-			}
-		} while (!f.eof());
-		f.close();
+	update_from_queue_file();
+	if (queued_urls.count(url) != 0) {
+		return {EnqueueStatus::URL_QUEUED_ALREADY, url};
+	}
+	if (queued_filenames.count(filename) != 0) {
+		return {EnqueueStatus::OUTPUT_FILENAME_USED_ALREADY, filename};
 	}
 
-	f.open(queue_file, std::fstream::app | std::fstream::out);
-	if (!f.is_open()) {
-		return {EnqueueStatus::QUEUE_FILE_OPEN_ERROR, queue_file};
+	if (!queue_file.append_line(url + " " + utils::quote(filename))) {
+		return {EnqueueStatus::QUEUE_FILE_OPEN_ERROR, queue_file.path()};
 	}
-	f << url << " " << utils::quote(filename) << std::endl;
-	f.close();
+	queued_urls.insert(url);
+	queued_filenames.insert(filename);
 
 	item->set_enqueued(true);
 
 	return {EnqueueStatus::QUEUED_SUCCESSFULLY, ""};
 }
 
+void QueueManager::update_from_queue_file()
+{
+	const auto update = queue_file.read_new_lines();
+	if (update.from_start) {
+		queued_urls.clear();
+		queued_filenames.clear();
+	}
+	for (const auto& line : update.lines) {
+		const auto fields = utils::tokenize_quoted(line);
+		if (fields.size() >= 1) {
+			queued_urls.insert(fields[0]);
+		}
+		if (fields.size() >= 2) {
+			queued_filenames.insert(fields[1]);
+		}
+	}
+}
+
 std::string get_hostname_from_url(const std::string& url)
 {
 	xmlURIPtr uri = xmlParseURI(url.c_str());
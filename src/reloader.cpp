@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <cinttypes>
 #include <iostream>
+#include <map>
+#include <numeric>
 #include <ncurses.h>
 #include <thread>
 
@@ -12,6 +14,7 @@
 #include "feedretriever.h"
 #include "fmtstrformatter.h"
 #include "matcherexception.h"
+#include "remoteapi.h"
 #include "reloadthread.h"
 #include "rss/exception.h"
 #include "rssfeed.h"
@@ -102,8 +105,7 @@ void Reloader::reload(unsigned int pos,
 						utils::censor_url(oldfeed->rssurl())));
 		}
 
-		const bool ignore_dl =
-			(cfg.get_configvalue("ignore-mode") == "download");
+		const bool ignore_dl = cfg.snapshot()->ignore_mode_download;
 
 		try {
 			const auto inner_message_lifetime = message_lifetime;
@@ -112,9 +114,14 @@ void Reloader::reload(unsigned int pos,
 
 			RssIgnores* ign = ignore_dl ? ctrl->get_ignores() : nullptr;
 
+			// The server's read state overrides ours, so it has to be
+			// up to date before we fetch it.
+			ctrl->send_pending_changes();
+
 			LOG(Level::INFO, "Reloader::reload: retrieving feed");
 			sm.stopover("start retrieving");
-			FeedRetriever feed_retriever(cfg, *rsscache, ign, ctrl->get_api(), &easyhandle);
+			FeedRetriever feed_retriever(cfg, *rsscache, ign, ctrl->get_api(),
+				&easyhandle, ctrl->get_sync_queue());
 			const rsspp::Feed feed = feed_retriever.retrieve(oldfeed->rssurl());
 
 			LOG(Level::INFO, "Reloader::reload: parsing feed");
@@ -158,6 +165,39 @@ void Reloader::reload(unsigned int pos,
 	}
 }
 
+void Reloader::prefetch_feeds(const std::vector<unsigned int>& positions)
+{
+	RemoteApi* api = ctrl->get_api();
+	if (api == nullptr) {
+		return;
+	}
+	ScopeMeasure sm("Reloader::prefetch_feeds");
+
+	// The server's read state overrides ours, so it has to be up to date
+	// before we fetch it.
+	ctrl->send_pending_changes();
+
+	RssIgnores* ign = cfg.snapshot()->ignore_mode_download ?
+		ctrl->get_ignores() : nullptr;
+	FeedRetriever feed_retriever(cfg, *rsscache, ign, api);
+	std::map<std::string, std::string> sync_cursors;
+	for (const auto pos : positions) {
+		const auto feed = ctrl->get_feedcontainer()->get_feed(pos);
+		if (feed && !feed->is_query_feed()) {
+			sync_cursors[feed->rssurl()] =
+				feed_retriever.fetch_sync_cursor(feed->rssurl());
+		}
+	}
+
+	try {
+		api->wait_for_subscription_refresh();
+		api->prefetch_feeds(sync_cursors);
+	} catch (const std::exception& e) {
+		// The feeds are then fetched one by one.
+		LOG(Level::ERROR, "Reloader::prefetch_feeds: %s", e.what());
+	}
+}
+
 void Reloader::partition_reload_to_threads(
 	std::function<void(unsigned int start, unsigned int end)> handle_range,
 	unsigned int num_feeds)
@@ -209,6 +249,10 @@ void Reloader::reload_all(bool unattended)
 	ctrl->get_feedcontainer()->reset_feeds_status();
 	const auto num_feeds = ctrl->get_feedcontainer()->feeds_size();
 
+	std::vector<unsigned int> positions(num_feeds);
+	std::iota(positions.begin(), positions.end(), 0);
+	prefetch_feeds(positions);
+
 	partition_reload_to_threads([=](unsigned int start, unsigned int end) {
 		reload_range(start, end, unattended);
 	}, num_feeds);
@@ -241,6 +285,8 @@ void Reloader::reload_indexes(const std::vector<int>& indexes, bool unattended)
 	const auto unread_articles =
 		ctrl->get_feedcontainer()->unread_item_count();
 
+	prefetch_feeds(std::vector<unsigned int>(indexes.cbegin(), indexes.cend()));
+
 	partition_reload_to_threads([&](unsigned int start, unsigned int end) {
 		for (auto i = start; i <= end; ++i) {
 			reload(indexes[i], true, unattended);
@@ -1,18 +1,198 @@
 #include "remoteapi.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <exception>
 #include <fstream>
 #include <glob.h>
 #include <iostream>
+#include <strings.h>
+#include <system_error>
+#include <thread>
 #include <unistd.h>
 
 #include "configcontainer.h"
+#include "curldatareceiver.h"
+#include "logger.h"
+#include "subscriptioncache.h"
 #include "utils.h"
 
 namespace newsboat {
 
+namespace {
+
+// Enough for every reload thread to fetch several pages at once.
+const std::size_t MAX_IDLE_HANDLES = 16;
+
+struct Validators {
+	std::string etag;
+	std::string last_modified;
+};
+
+size_t handle_validators(char* buffer, size_t size, size_t nitems, void* data)
+{
+	Validators* validators = static_cast<Validators*>(data);
+	const std::string header(buffer, size * nitems);
+
+	if (header.compare(0, 5, "HTTP/") == 0) {
+		// Each response of a redirect starts with a status line; only the
+		// headers of the last one describe the body we get.
+		*validators = Validators();
+	} else if (!strncasecmp("ETag:", header.c_str(), 5)) {
+		validators->etag = header.substr(5);
+		utils::trim(validators->etag);
+	} else if (!strncasecmp("Last-Modified:", header.c_str(), 14)) {
+		validators->last_modified = header.substr(14);
+		utils::trim(validators->last_modified);
+	}
+
+	return size * nitems;
+}
+
+} // namespace
+
 RemoteApi::RemoteApi(ConfigContainer& c)
 	: cfg(c)
+	, subscription_timeout(0)
+{
+}
+
+RemoteApi::~RemoteApi() = default;
+
+void RemoteApi::use_subscription_cache(const std::string& file,
+	const std::string& key,
+	std::chrono::milliseconds timeout)
+{
+	wait_for_subscription_refresh();
+	subscription_cache.reset(new SubscriptionCache(file, key));
+	subscription_timeout = timeout;
+}
+
+std::vector<TaggedFeedUrl> RemoteApi::load_subscribed_urls()
+{
+	if (!subscription_cache || !can_use_cached_subscriptions()) {
+		return get_subscribed_urls();
+	}
+
+	std::lock_guard<std::mutex> guard(subscription_refresh_mtx);
+
+	// A fetch that's still running from the previous call is the freshest
+	// one there is, so it's waited for rather than started again.
+	if (!subscription_refresh.valid()) {
+		try {
+			subscription_refresh = std::async(std::launch::async,
+					&RemoteApi::refresh_subscribed_urls, this);
+		} catch (const std::system_error& e) {
+			LOG(Level::WARN, "RemoteApi::load_subscribed_urls: %s", e.what());
+			return refresh_subscribed_urls();
+		}
+	}
+
+	const auto cached = subscription_cache->get_urls();
+	if (cached.has_value()
+		&& subscription_refresh.wait_for(subscription_timeout)
+		!= std::future_status::ready) {
+		LOG(Level::INFO,
+			"RemoteApi::load_subscribed_urls: no answer within %" PRIi64
+			" ms, using the %u cached subscriptions",
+			static_cast<std::int64_t>(subscription_timeout.count()),
+			static_cast<unsigned int>(cached.value().size()));
+		return cached.value();
+	}
+
+	try {
+		std::vector<TaggedFeedUrl> urls = subscription_refresh.get();
+		if (urls.empty() && cached.has_value()) {
+			LOG(Level::ERROR,
+				"RemoteApi::load_subscribed_urls: got no subscriptions, "
+				"using the %u cached ones",
+				static_cast<unsigned int>(cached.value().size()));
+			return cached.value();
+		}
+		return urls;
+	} catch (const std::exception& e) {
+		if (!cached.has_value()) {
+			throw;
+		}
+		LOG(Level::ERROR,
+			"RemoteApi::load_subscribed_urls: %s; using the %u cached "
+			"subscriptions",
+			e.what(),
+			static_cast<unsigned int>(cached.value().size()));
+		return cached.value();
+	}
+}
+
+std::vector<TaggedFeedUrl> RemoteApi::refresh_subscribed_urls()
+{
+	std::vector<TaggedFeedUrl> urls = get_subscribed_urls();
+	// An empty list is far more likely to be a failed request than an
+	// account without subscriptions.
+	if (!urls.empty()) {
+		subscription_cache->store_urls(urls);
+	}
+	return urls;
+}
+
+void RemoteApi::wait_for_subscription_refresh()
+{
+	std::lock_guard<std::mutex> guard(subscription_refresh_mtx);
+	if (subscription_refresh.valid()) {
+		subscription_refresh.wait();
+	}
+}
+
+std::string RemoteApi::get_subscription_reply(CurlHandle& easyhandle,
+	const std::string& url,
+	curl_slist** custom_headers)
 {
+	nonstd::optional<SubscriptionCache::Reply> cached;
+	if (subscription_cache) {
+		cached = subscription_cache->get_reply(url);
+	}
+	if (cached.has_value()) {
+		if (!cached.value().etag.empty()) {
+			const std::string header = "If-None-Match: " + cached.value().etag;
+			*custom_headers = curl_slist_append(*custom_headers, header.c_str());
+		}
+		if (!cached.value().last_modified.empty()) {
+			const std::string header =
+				"If-Modified-Since: " + cached.value().last_modified;
+			*custom_headers = curl_slist_append(*custom_headers, header.c_str());
+		}
+	}
+
+	curl_easy_setopt(easyhandle.ptr(), CURLOPT_HTTPHEADER, *custom_headers);
+	curl_easy_setopt(easyhandle.ptr(), CURLOPT_URL, url.c_str());
+
+	Validators validators;
+	curl_easy_setopt(easyhandle.ptr(), CURLOPT_HEADERDATA, &validators);
+	curl_easy_setopt(easyhandle.ptr(), CURLOPT_HEADERFUNCTION, handle_validators);
+	auto curlDataReceiver = CurlDataReceiver::register_data_handler(easyhandle);
+
+	curl_easy_perform(easyhandle.ptr());
+
+	curl_easy_setopt(easyhandle.ptr(), CURLOPT_HEADERFUNCTION, nullptr);
+	curl_easy_setopt(easyhandle.ptr(), CURLOPT_HEADERDATA, nullptr);
+
+	long status = 0;
+	curl_easy_getinfo(easyhandle.ptr(), CURLINFO_RESPONSE_CODE, &status);
+	if (status == 304 && cached.has_value()) {
+		LOG(Level::DEBUG,
+			"RemoteApi::get_subscription_reply: %s didn't change",
+			url);
+		return cached.value().body;
+	}
+
+	const std::string result = curlDataReceiver->get_data();
+	if (status == 200 && subscription_cache
+		&& (!validators.etag.empty() || !validators.last_modified.empty())) {
+		subscription_cache->set_reply(url,
+		{validators.etag, validators.last_modified, result});
+	}
+	return result;
 }
 
 bool RemoteApi::mark_articles_read(const std::vector<std::string>& guids)
@@ -26,6 +206,97 @@ bool RemoteApi::mark_articles_read(const std::vector<std::string>& guids)
 	return success;
 }
 
+bool RemoteApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	bool success = true;
+	for (const auto& guid : guids) {
+		if (!this->mark_article_read(guid, false)) {
+			success = false;
+		}
+	}
+	return success;
+}
+
+void RemoteApi::fetch_pages(unsigned int pages, unsigned int max_parallel,
+	CurlHandle& easyhandle,
+	const std::function<void(unsigned int page, CurlHandle& easyhandle)>&
+	fetch_page)
+{
+	if (pages == 0) {
+		return;
+	}
+
+	std::atomic<unsigned int> next_page(0);
+	std::mutex error_mtx;
+	std::exception_ptr error;
+	const auto fetch = [&](CurlHandle& handle) {
+		try {
+			for (unsigned int page = next_page++; page < pages; page = next_page++) {
+				fetch_page(page, handle);
+			}
+		} catch (...) {
+			std::lock_guard<std::mutex> guard(error_mtx);
+			if (!error) {
+				error = std::current_exception();
+			}
+			next_page = pages;
+		}
+	};
+
+	std::vector<CurlHandle> handles;
+	{
+		const unsigned int helpers = std::max(1u, std::min(pages, max_parallel)) - 1;
+		std::lock_guard<std::mutex> guard(idle_handles_mtx);
+		while (handles.size() < helpers && !idle_handles.empty()) {
+			handles.push_back(std::move(idle_handles.back()));
+			idle_handles.pop_back();
+		}
+		while (handles.size() < helpers) {
+			handles.emplace_back();
+		}
+	}
+
+	std::vector<std::thread> threads;
+	for (auto& handle : handles) {
+		try {
+			threads.emplace_back(fetch, std::ref(handle));
+		} catch (const std::system_error& e) {
+			// The remaining pages are fetched by the threads we have.
+			LOG(Level::WARN, "RemoteApi::fetch_pages: %s", e.what());
+			break;
+		}
+	}
+	fetch(easyhandle);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(idle_handles_mtx);
+		for (auto& handle : handles) {
+			if (idle_handles.size() >= MAX_IDLE_HANDLES) {
+				break;
+			}
+			idle_handles.push_back(std::move(handle));
+		}
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+bool RemoteApi::can_use_cached_subscriptions() const
+{
+	return true;
+}
+
+void RemoteApi::prefetch_feeds(const std::map<std::string, std::string>&
+	/* sync_cursors */)
+{
+	// Feeds are only fetched one by one.
+}
+
 const std::string RemoteApi::read_password(const std::string& file)
 {
 	glob_t exp;
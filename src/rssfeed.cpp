@@ -37,6 +37,11 @@ RssFeed::RssFeed(Cache* c, const std::string& rssurl)
 	, idx(0)
 	, order(0)
 	, status_(DlStatus::SUCCESS)
+	, items_loaded_(true)
+	, summary_unread_count_(0)
+	, summary_total_count_(0)
+	, summary_latest_item_timestamp_(0)
+	, last_used_(0)
 {
 	if (utils::is_query_url(rssurl_)) {
 		/* Query string looks like this:
@@ -83,11 +88,71 @@ RssFeed::~RssFeed()
 unsigned int RssFeed::unread_item_count() const
 {
 	std::lock_guard<std::mutex> lock(item_mutex);
-	return std::count_if(items_.begin(),
-			items_.end(),
+	if (!items_loaded_) {
+		return summary_unread_count_;
+	}
+	const auto& store = ItemStore::instance();
+	return std::count_if(handles_.begin(), handles_.end(),
+	[&](ItemHandle handle) {
+		return store.unread(handle);
+	});
+}
+
+time_t RssFeed::latest_item_timestamp() const
+{
+	if (!items_loaded_) {
+		return summary_latest_item_timestamp_;
+	}
+
+	const auto& store = ItemStore::instance();
+	time_t latest = 0;
+	for (const auto handle : handles_) {
+		latest = std::max(latest, store.pub_date(handle));
+	}
+	return latest;
+}
+
+void RssFeed::set_summary(unsigned int unread_count, unsigned int total_count,
+	time_t latest_item_timestamp)
+{
+	std::lock_guard<std::mutex> lock(item_mutex);
+	summary_unread_count_ = unread_count;
+	summary_total_count_ = total_count;
+	summary_latest_item_timestamp_ = latest_item_timestamp;
+}
+
+bool RssFeed::unload_items()
+{
+	std::lock_guard<std::mutex> lock(item_mutex);
+	if (!items_loaded_) {
+		return true;
+	}
+
+	// Each item is referenced from `items_` and `items_guid_map`; anything
+	// beyond that means someone else is still using it.
+	const bool in_use = std::any_of(items_.begin(), items_.end(),
 	[](const std::shared_ptr<RssItem>& item) {
-		return item->unread();
+		return item.use_count() > 2;
+	});
+	if (in_use) {
+		return false;
+	}
+
+	const auto& store = ItemStore::instance();
+	summary_unread_count_ = std::count_if(handles_.begin(), handles_.end(),
+	[&](ItemHandle handle) {
+		return store.unread(handle);
 	});
+	summary_total_count_ = items_.size();
+	summary_latest_item_timestamp_ = latest_item_timestamp();
+
+	items_guid_map.clear();
+	items_.clear();
+	items_.shrink_to_fit();
+	handles_.clear();
+	handles_.shrink_to_fit();
+	items_loaded_ = false;
+	return true;
 }
 
 bool RssFeed::matches_tag(const std::string& tag)
@@ -188,7 +253,7 @@ nonstd::optional<std::string> RssFeed::attribute_value(const std::string&
 	} else if (attribname == "unread_count") {
 		return std::to_string(unread_item_count());
 	} else if (attribname == "total_count") {
-		return std::to_string(items_.size());
+		return std::to_string(total_item_count());
 	} else if (attribname == "tags") {
 		std::string tags;
 		for (const std::string& t : get_tags()) {
@@ -199,14 +264,8 @@ nonstd::optional<std::string> RssFeed::attribute_value(const std::string&
 	} else if (attribname == "feedindex") {
 		return std::to_string(idx);
 	} else if (attribname == "latest_article_age") {
-		using ItemType = std::shared_ptr<RssItem>;
-		const auto latest_article_iterator = std::max_element(items_.begin(),
-		items_.end(), [](const ItemType& a, const ItemType& b) {
-			return a->pubDate_timestamp() < b->pubDate_timestamp();
-		});
-		if (latest_article_iterator != items_.end()) {
-			const auto latest_article = *latest_article_iterator;
-			const auto timestamp = latest_article->pubDate_timestamp();
+		if (total_item_count() > 0) {
+			const auto timestamp = latest_item_timestamp();
 			return std::to_string((time(nullptr) - timestamp) / 86400);
 		}
 		return "0";
@@ -228,6 +287,7 @@ void RssFeed::update_items(std::vector<std::shared_ptr<RssFeed>> feeds)
 	Matcher m(query);
 
 	items_.clear();
+	handles_.clear();
 	items_guid_map.clear();
 
 	for (const auto& feed : feeds) {
@@ -239,15 +299,14 @@ void RssFeed::update_items(std::vector<std::shared_ptr<RssFeed>> feeds)
 			if (!item->deleted() && m.matches(item.get())) {
 				LOG(Level::DEBUG, "RssFeed::update_items: Matcher matches!");
 				item->set_feedptr(feed);
-				items_.push_back(item);
-				items_guid_map[item->guid()] = item;
+				add_item(item);
 			}
 		}
 	}
 
 	sm.stopover("matching");
 
-	std::sort(items_.begin(), items_.end());
+	sort_by_date(true);
 
 	sm.stopover("sorting");
 }
@@ -290,6 +349,11 @@ void RssFeed::sort_unlocked(const ArticleSortStrategy& sort_strategy)
 			items_.end(),
 			[&](const std::shared_ptr<RssItem>& a,
 		const std::shared_ptr<RssItem>& b) {
+			// Authors are interned, so equal authors share storage and
+			// don't need to be converted and compared
+			if (&a->author() == &b->author()) {
+				return false;
+			}
 			const auto author_a = utils::utf8_to_locale(a->author());
 			const auto author_b = utils::utf8_to_locale(b->author());
 			const auto cmp = strcmp(author_a.c_str(), author_b.c_str());
@@ -323,24 +387,47 @@ void RssFeed::sort_unlocked(const ArticleSortStrategy& sort_strategy)
 		});
 		break;
 	case ArtSortMethod::DATE:
-		std::stable_sort(items_.begin(),
-			items_.end(),
-			[&](const std::shared_ptr<RssItem>& a,
-		const std::shared_ptr<RssItem>& b) {
-			// date is descending by default
-			return sort_strategy.sd == SortDirection::ASC
-				? (a->pubDate_timestamp() >
-					b->pubDate_timestamp())
-				: (a->pubDate_timestamp() <
-					b->pubDate_timestamp());
-		});
-		break;
+		// date is descending by default
+		sort_by_date(sort_strategy.sd == SortDirection::ASC);
+		return;
 	case ArtSortMethod::RANDOM:
 		std::random_device rd;
 		std::default_random_engine rng(rd());
 		std::shuffle(items_.begin(), items_.end(), rng);
 		break;
 	}
+
+	for (std::size_t i = 0; i < items_.size(); ++i) {
+		handles_[i] = items_[i]->handle();
+	}
+}
+
+void RssFeed::sort_by_date(bool newest_first)
+{
+	// Sort positions by the dates in the store, then move the items into
+	// place, so that the comparisons don't touch the items themselves.
+	const auto& store = ItemStore::instance();
+	std::vector<std::pair<time_t, std::size_t>> order;
+	order.reserve(handles_.size());
+	for (std::size_t i = 0; i < handles_.size(); ++i) {
+		order.emplace_back(store.pub_date(handles_[i]), i);
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[&](const std::pair<time_t, std::size_t>& a,
+	const std::pair<time_t, std::size_t>& b) {
+		return newest_first ? (a.first > b.first) : (a.first < b.first);
+	});
+
+	std::vector<std::shared_ptr<RssItem>> sorted_items;
+	std::vector<ItemHandle> sorted_handles;
+	sorted_items.reserve(items_.size());
+	sorted_handles.reserve(handles_.size());
+	for (const auto& entry : order) {
+		sorted_items.push_back(std::move(items_[entry.second]));
+		sorted_handles.push_back(handles_[entry.second]);
+	}
+	items_ = std::move(sorted_items);
+	handles_ = std::move(sorted_handles);
 }
 
 void RssFeed::purge_deleted_items()
@@ -348,22 +435,29 @@ void RssFeed::purge_deleted_items()
 	std::lock_guard<std::mutex> lock(item_mutex);
 	ScopeMeasure m1("RssFeed::purge_deleted_items");
 
-	// Purge in items_guid_map
-	{
-		std::lock_guard<std::mutex> lock2(items_guid_map_mutex);
-		for (const auto& item : items_) {
-			if (item->deleted()) {
-				items_guid_map.erase(item->guid());
-			}
+	std::lock_guard<std::mutex> lock2(items_guid_map_mutex);
+	erase_items_if([](const std::shared_ptr<RssItem>& item) {
+		return item->deleted();
+	});
+}
+
+void RssFeed::erase_items_if(const
+	std::function<bool(const std::shared_ptr<RssItem>&)>& pred)
+{
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < items_.size(); ++i) {
+		if (pred(items_[i])) {
+			items_guid_map.erase(items_[i]->guid());
+			continue;
 		}
+		if (kept != i) {
+			items_[kept] = std::move(items_[i]);
+			handles_[kept] = handles_[i];
+		}
+		kept++;
 	}
-
-	items_.erase(std::remove_if(items_.begin(),
-			items_.end(),
-	[](const std::shared_ptr<RssItem> item) {
-		return item->deleted();
-	}),
-	items_.end());
+	items_.resize(kept);
+	handles_.resize(kept);
 }
 
 void RssFeed::set_feedptrs(std::shared_ptr<RssFeed> self)
@@ -391,6 +485,41 @@ std::string RssFeed::get_status()
 	return "?";
 }
 
+MemoryUsage RssFeed::memory_usage() const
+{
+	std::lock_guard<std::mutex> lock(item_mutex);
+
+	MemoryUsage usage;
+	usage.item_metadata = sizeof(RssFeed) + SHARED_PTR_OVERHEAD
+		+ heap_usage(title_) + heap_usage(description_) + heap_usage(link_)
+		+ heap_usage(rssurl_) + heap_usage(query);
+
+	// Each node holds the key/value pair, a pointer to the next node and
+	// the cached hash; long GUIDs add a heap block for the key.
+	std::size_t guid_map_bytes = items_guid_map.bucket_count() * sizeof(void*)
+		+ items_guid_map.size() * (sizeof(GuidMap::value_type) + sizeof(void*) +
+			sizeof(std::size_t));
+	for (const auto& entry : items_guid_map) {
+		guid_map_bytes += heap_usage(entry.first);
+	}
+	const std::size_t item_list_bytes = items_.capacity() * sizeof(items_[0])
+		+ handles_.capacity() * sizeof(handles_[0]);
+
+	if (is_query_feed()) {
+		// Items belong to other feeds, and are accounted for there.
+		usage.query_feed_membership = item_list_bytes + guid_map_bytes;
+		return usage;
+	}
+
+	usage.item_metadata += item_list_bytes;
+	usage.guid_maps = guid_map_bytes;
+	for (const auto& item : items_) {
+		usage.item_metadata += item->memory_usage();
+		usage.descriptions += item->description_memory_usage();
+	}
+	return usage;
+}
+
 void RssFeed::unload()
 {
 	std::lock_guard<std::mutex> lock(item_mutex);
@@ -408,8 +537,10 @@ void RssFeed::load()
 void RssFeed::mark_all_items_read()
 {
 	std::lock_guard<std::mutex> lock(item_mutex);
-	for (const auto& item : items_) {
-		item->set_unread_nowrite(false);
+	summary_unread_count_ = 0;
+	auto& store = ItemStore::instance();
+	for (const auto handle : handles_) {
+		store.set_unread(handle, false);
 	}
 }
 
@@ -6,6 +6,8 @@
 
 #include "cache.h"
 #include "dbexception.h"
+#include "descriptionbudget.h"
+#include "memoryusage.h"
 #include "rssfeed.h"
 #include "scopemeasure.h"
 #include "strprintf.h"
@@ -15,17 +17,107 @@ namespace newsboat {
 
 RssItem::RssItem(Cache* c)
 	: ch(c)
-	, idx(0)
-	, size_(0)
-	, pubDate_(0)
-	, unread_(true)
-	, enqueued_(false)
-	, deleted_(0)
-	, override_unread_(false)
+	, handle_(ItemStore::instance().allocate())
+	, description_evicted_(false)
+	, description_stored_(false)
 {
 }
 
-RssItem::~RssItem() {}
+RssItem::~RssItem()
+{
+	DescriptionBudget::instance().forget(*this);
+	ItemStore::instance().release(handle_);
+}
+
+Description RssItem::description() const
+{
+	std::shared_ptr<const Description> result;
+	bool stored = false;
+	bool evicted = false;
+	{
+		DescriptionLock lock(handle_);
+		std::lock_guard<DescriptionLock> guard(lock);
+		stored = description_stored_;
+		result = description_;
+		evicted = description_evicted_;
+	}
+
+	if (!result) {
+		if (!evicted || ch == nullptr) {
+			return {"", ""};
+		}
+		result = std::make_shared<const Description>(ch->fetch_description(*this));
+
+		DescriptionLock lock(handle_);
+		std::lock_guard<DescriptionLock> guard(lock);
+		if (description_evicted_) {
+			description_ = result;
+			description_evicted_ = false;
+		}
+	}
+
+	// Budget's lock has to be taken after the description lock is released,
+	// because eviction takes them in the opposite order.
+	if (stored) {
+		DescriptionBudget::instance().touch(const_cast<RssItem&>(*this),
+			result->text.size() + result->mime.size());
+	}
+	return *result;
+}
+
+void RssItem::unload()
+{
+	// Freed once the lock is released
+	std::shared_ptr<const Description> old;
+	{
+		DescriptionLock lock(handle_);
+		std::lock_guard<DescriptionLock> guard(lock);
+		old.swap(description_);
+		description_evicted_ = false;
+	}
+	DescriptionBudget::instance().forget(*this);
+}
+
+void RssItem::evict_description()
+{
+	// Freed once the lock is released
+	std::shared_ptr<const Description> old;
+	DescriptionLock lock(handle_);
+	std::lock_guard<DescriptionLock> guard(lock);
+	if (description_) {
+		old.swap(description_);
+		description_evicted_ = true;
+	}
+}
+
+std::size_t RssItem::memory_usage() const
+{
+	// Interned strings are shared, and accounted for by the pool; fields
+	// kept in the ItemStore are accounted for by the store.
+	return sizeof(RssItem) + SHARED_PTR_OVERHEAD
+		+ heap_usage(title_)
+		+ heap_usage(link_)
+		+ heap_usage(guid_)
+		+ heap_usage(enclosure_url_)
+		+ heap_usage(enclosure_description_)
+		+ heap_usage(flags_)
+		+ heap_usage(oldflags_);
+}
+
+std::size_t RssItem::description_memory_usage() const
+{
+	std::shared_ptr<const Description> description;
+	{
+		DescriptionLock lock(handle_);
+		std::lock_guard<DescriptionLock> guard(lock);
+		description = description_;
+	}
+	if (!description) {
+		return 0;
+	}
+	return sizeof(Description) + SHARED_PTR_OVERHEAD
+		+ heap_usage(description->text) + heap_usage(description->mime);
+}
 
 // RssItem setters
 
@@ -43,24 +135,60 @@ void RssItem::set_link(const std::string& l)
 
 void RssItem::set_author(const std::string& a)
 {
-	author_ = a;
+	author_ = InternedString(a);
 }
 
 void RssItem::set_description(const std::string& content,
 	const std::string& mime_type)
 {
-	std::lock_guard<std::mutex> guard(description_mutex);
-	description_ = {content, mime_type};
+	std::shared_ptr<const Description> description =
+		std::make_shared<const Description>(Description{content, mime_type});
+	{
+		DescriptionLock lock(handle_);
+		std::lock_guard<DescriptionLock> guard(lock);
+		description.swap(description_);
+		description_evicted_ = false;
+		description_stored_ = false;
+	}
+	// The old description is freed here, after the lock is released.
+	// Until the cache has the new description, evicting it would lose it.
+	DescriptionBudget::instance().forget(*this);
+}
+
+void RssItem::set_description_stored(const Description& stored)
+{
+	std::shared_ptr<const Description> current;
+	{
+		DescriptionLock lock(handle_);
+		std::lock_guard<DescriptionLock> guard(lock);
+		current = description_;
+	}
+	// The description might have been replaced while it was written.
+	if (!current || current->text != stored.text
+		|| current->mime != stored.mime) {
+		return;
+	}
+	{
+		DescriptionLock lock(handle_);
+		std::lock_guard<DescriptionLock> guard(lock);
+		// ...or while it was compared.
+		if (description_ != current) {
+			return;
+		}
+		description_stored_ = true;
+	}
+	DescriptionBudget::instance().touch(*this,
+		stored.text.size() + stored.mime.size());
 }
 
 void RssItem::set_size(unsigned int size)
 {
-	size_ = size;
+	ItemStore::instance().set_size(handle_, size);
 }
 
 std::string RssItem::length() const
 {
-	std::string::size_type l(size_);
+	std::string::size_type l(size());
 	if (!l) {
 		return "";
 	}
@@ -76,7 +204,7 @@ std::string RssItem::length() const
 
 void RssItem::set_pubDate(time_t t)
 {
-	pubDate_ = t;
+	ItemStore::instance().set_pub_date(handle_, t);
 }
 
 void RssItem::set_guid(const std::string& g)
@@ -86,37 +214,37 @@ void RssItem::set_guid(const std::string& g)
 
 void RssItem::set_unread_nowrite(bool u)
 {
-	unread_ = u;
+	ItemStore::instance().set_unread(handle_, u);
 }
 
 void RssItem::set_unread_nowrite_notify(bool u, bool notify)
 {
-	unread_ = u;
+	set_unread_nowrite(u);
 	std::shared_ptr<RssFeed> feedptr = feedptr_.lock();
 	if (feedptr && notify) {
 		feedptr->get_item_by_guid(guid_)->set_unread_nowrite(
-			unread_); // notify parent feed
+			u); // notify parent feed
 	}
 }
 
 void RssItem::set_unread(bool u)
 {
-	if (unread_ != u) {
-		bool old_u = unread_;
-		unread_ = u;
+	if (unread() != u) {
+		bool old_u = unread();
+		set_unread_nowrite(u);
 		std::shared_ptr<RssFeed> feedptr = feedptr_.lock();
 		if (feedptr)
 			feedptr->get_item_by_guid(guid_)->set_unread_nowrite(
-				unread_); // notify parent feed
+				u); // notify parent feed
 		try {
 			if (ch) {
 				ch->update_rssitem_unread_and_enqueued(
-					this, feedurl_);
+					this, feedurl_.str());
 			}
 		} catch (const DbException& e) {
 			// if the update failed, restore the old unread flag and
 			// rethrow the exception
-			unread_ = old_u;
+			set_unread_nowrite(old_u);
 			throw;
 		}
 	}
@@ -124,12 +252,13 @@ void RssItem::set_unread(bool u)
 
 std::string RssItem::pubDate() const
 {
-	return utils::mt_strf_localtime(_("%a, %d %b %Y %T %z"), pubDate_);
+	return utils::mt_strf_localtime(_("%a, %d %b %Y %T %z"),
+			pubDate_timestamp());
 }
 
 const std::string& RssItem::feedurl() const
 {
-	return feedurl_;
+	return feedurl_.str();
 }
 
 const std::string& RssItem::enclosure_url() const
@@ -139,7 +268,7 @@ const std::string& RssItem::enclosure_url() const
 
 const std::string& RssItem::enclosure_type() const
 {
-	return enclosure_type_;
+	return enclosure_type_.str();
 }
 
 const std::string& RssItem::enclosure_description() const
@@ -149,7 +278,7 @@ const std::string& RssItem::enclosure_description() const
 
 const std::string& RssItem::enclosure_description_mime_type() const
 {
-	return enclosure_description_mime_type_;
+	return enclosure_description_mime_type_.str();
 }
 
 void RssItem::set_enclosure_url(const std::string& url)
@@ -159,7 +288,7 @@ void RssItem::set_enclosure_url(const std::string& url)
 
 void RssItem::set_enclosure_type(const std::string& type)
 {
-	enclosure_type_ = type;
+	enclosure_type_ = InternedString(type);
 }
 
 void RssItem::set_enclosure_description(const std::string& description)
@@ -169,7 +298,7 @@ void RssItem::set_enclosure_description(const std::string& description)
 
 void RssItem::set_enclosure_description_mime_type(const std::string& type)
 {
-	enclosure_description_mime_type_ = type;
+	enclosure_description_mime_type_ = InternedString(type);
 }
 
 nonstd::optional<std::string> RssItem::attribute_value(const std::string&
@@ -183,12 +312,19 @@ nonstd::optional<std::string> RssItem::attribute_value(const std::string&
 		return utils::utf8_to_locale(author());
 	} else if (attribname == "content") {
 		ScopeMeasure sm("RssItem::attribute_value(\"content\")");
-		std::lock_guard<std::mutex> guard(description_mutex);
-		if (description_.has_value()) {
-			const std::string content = description_.value().text;
-			return utils::utf8_to_locale(content);
-		} else if (ch) {
-			std::string description = ch->fetch_description(*this);
+		std::shared_ptr<const Description> description;
+		{
+			DescriptionLock lock(handle_);
+			std::lock_guard<DescriptionLock> guard(lock);
+			description = description_;
+		}
+		if (description) {
+			return utils::utf8_to_locale(description->text);
+		}
+		// Don't hold the lock while waiting on the cache, which might be
+		// filling in this very item.
+		if (ch) {
+			const std::string description = ch->fetch_description(*this).text;
 			return utils::utf8_to_locale(description);
 		}
 		return "";
@@ -197,7 +333,7 @@ nonstd::optional<std::string> RssItem::attribute_value(const std::string&
 	} else if (attribname == "guid") {
 		return guid();
 	} else if (attribname == "unread") {
-		return unread_ ? "yes" : "no";
+		return unread() ? "yes" : "no";
 	} else if (attribname == "enclosure_url") {
 		return enclosure_url();
 	} else if (attribname == "enclosure_type") {
@@ -208,7 +344,7 @@ nonstd::optional<std::string> RssItem::attribute_value(const std::string&
 		return std::to_string(
 				(time(nullptr) - pubDate_timestamp()) / 86400);
 	else if (attribname == "articleindex") {
-		return std::to_string(idx);
+		return std::to_string(ItemStore::instance().index(handle_));
 	}
 
 	// if we have a feed, then forward the request
@@ -12,4 +12,23 @@ void ScopeMeasure::stopover(const std::string& son)
 	scopemeasure::bridged::stopover(*rs_object, son);
 }
 
+bool ScopeMeasure::start_tracing(const std::string& path)
+{
+	return scopemeasure::bridged::start_tracing(path);
+}
+
+void ScopeMeasure::stop_tracing()
+{
+	scopemeasure::bridged::stop_tracing();
+}
+
+std::vector<std::string> ScopeMeasure::format_stats()
+{
+	std::vector<std::string> lines;
+	for (const auto& line : scopemeasure::bridged::format_scope_stats()) {
+		lines.push_back(std::string(line));
+	}
+	return lines;
+}
+
 } // namespace newsboat
@@ -0,0 +1,150 @@
+#include "startupprofiler.h"
+
+#include <cinttypes>
+#include <cstdlib>
+
+// mallinfo2() appeared in glibc 2.33; the older mallinfo() overflows at 2 GiB.
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define NEWSBOAT_HAVE_MALLINFO2 1
+#include <malloc.h>
+#endif
+
+#include "3rd-party/json.hpp"
+
+#include "cache.h"
+#include "memoryreport.h"
+#include "strprintf.h"
+
+using json = nlohmann::json;
+
+namespace newsboat {
+
+namespace {
+
+double milliseconds(std::clock_t ticks)
+{
+	return 1000.0 * ticks / CLOCKS_PER_SEC;
+}
+
+std::string format_heap(std::int64_t bytes)
+{
+	if (!StartupProfiler::heap_supported()) {
+		return "n/a";
+	}
+	const std::string sign = bytes < 0 ? "-" : "+";
+	return sign + MemoryReport::format_bytes(std::llabs(bytes));
+}
+
+} // namespace
+
+StartupProfiler::StartupProfiler()
+{
+	Cache::set_statement_counting(true);
+}
+
+StartupProfiler::~StartupProfiler()
+{
+	Cache::set_statement_counting(false);
+}
+
+bool StartupProfiler::heap_supported()
+{
+#ifdef NEWSBOAT_HAVE_MALLINFO2
+	return true;
+#else
+	return false;
+#endif
+}
+
+StartupProfiler::Sample StartupProfiler::take_sample()
+{
+	Sample sample;
+	sample.wall = std::chrono::steady_clock::now();
+	sample.cpu = std::clock();
+#ifdef NEWSBOAT_HAVE_MALLINFO2
+	const auto info = mallinfo2();
+	sample.heap = static_cast<std::int64_t>(info.uordblks + info.hblkhd);
+#else
+	sample.heap = 0;
+#endif
+	sample.sql_statements = Cache::executed_statements();
+	return sample;
+}
+
+void StartupProfiler::begin_phase(const std::string& name)
+{
+	end_phase();
+
+	current_name = name;
+	in_phase = true;
+	current_start = take_sample();
+}
+
+void StartupProfiler::end_phase()
+{
+	if (!in_phase) {
+		return;
+	}
+	in_phase = false;
+
+	const Sample end = take_sample();
+	Phase phase;
+	phase.name = current_name;
+	phase.wall_ms = std::chrono::duration<double, std::milli>(
+			end.wall - current_start.wall).count();
+	phase.cpu_ms = milliseconds(end.cpu - current_start.cpu);
+	phase.heap_bytes = end.heap - current_start.heap;
+	phase.sql_statements = end.sql_statements - current_start.sql_statements;
+	completed.push_back(phase);
+}
+
+std::vector<std::string> StartupProfiler::format() const
+{
+	const auto line = [](const std::string& name, double wall_ms,
+	double cpu_ms, const std::string& heap, std::uint64_t sql) {
+		return strprintf::fmt("%-28s %10.1f %10.1f %12s %8" PRIu64,
+				name, wall_ms, cpu_ms, heap, sql);
+	};
+
+	std::vector<std::string> lines;
+	lines.push_back(strprintf::fmt("%-28s %10s %10s %12s %8s",
+			"Phase", "Wall (ms)", "CPU (ms)", "Heap", "SQL"));
+
+	Phase total{"Total", 0, 0, 0, 0};
+	for (const auto& phase : completed) {
+		lines.push_back(line(phase.name, phase.wall_ms, phase.cpu_ms,
+				format_heap(phase.heap_bytes), phase.sql_statements));
+		total.wall_ms += phase.wall_ms;
+		total.cpu_ms += phase.cpu_ms;
+		total.heap_bytes += phase.heap_bytes;
+		total.sql_statements += phase.sql_statements;
+	}
+	lines.push_back(line(total.name, total.wall_ms, total.cpu_ms,
+			format_heap(total.heap_bytes), total.sql_statements));
+
+	return lines;
+}
+
+std::string StartupProfiler::to_json() const
+{
+	json phases = json::array();
+	for (const auto& phase : completed) {
+		json entry;
+		entry["name"] = phase.name;
+		entry["wall_ms"] = phase.wall_ms;
+		entry["cpu_ms"] = phase.cpu_ms;
+		if (heap_supported()) {
+			entry["heap_bytes"] = phase.heap_bytes;
+		} else {
+			entry["heap_bytes"] = nullptr;
+		}
+		entry["sql_statements"] = phase.sql_statements;
+		phases.push_back(entry);
+	}
+
+	json result;
+	result["phases"] = phases;
+	return result.dump(2);
+}
+
+} // namespace newsboat
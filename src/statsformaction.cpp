@@ -0,0 +1,121 @@
+#include "statsformaction.h"
+
+#include <cinttypes>
+
+#include "config.h"
+#include "controller.h"
+#include "descriptionbudget.h"
+#include "memoryreport.h"
+#include "scopemeasure.h"
+#include "strprintf.h"
+#include "utils.h"
+#include "view.h"
+
+namespace newsboat {
+
+StatsFormAction::StatsFormAction(View& vv,
+	std::string formstr,
+	ConfigContainer* cfg)
+	: FormAction(vv, formstr, cfg)
+	, quit(false)
+	, textview("statstext", FormAction::f)
+{
+}
+
+bool StatsFormAction::process_operation(Operation op,
+	const std::vector<std::string>& /* args */,
+	BindingType /*bindingType*/)
+{
+	bool hardquit = false;
+	switch (op) {
+	case OP_QUIT:
+		quit = true;
+		break;
+	case OP_HARDQUIT:
+		hardquit = true;
+		break;
+	default:
+		handle_textview_operations(textview, op);
+		break;
+	}
+	if (hardquit) {
+		while (v.formaction_stack_size() > 0) {
+			v.pop_current_formaction();
+		}
+	} else if (quit) {
+		v.pop_current_formaction();
+	}
+	return true;
+}
+
+void StatsFormAction::prepare()
+{
+	if (do_redraw) {
+		recalculate_widget_dimensions();
+
+		set_title(strprintf::fmt("%s %s - %s",
+				PROGRAM_NAME,
+				utils::program_version(),
+				title()));
+
+		ListFormatter listfmt;
+		add_memory_stats(listfmt);
+		listfmt.add_line("");
+		add_timing_stats(listfmt);
+
+		textview.stfl_replace_lines(listfmt.get_lines_count(), listfmt.format_list());
+
+		do_redraw = false;
+	}
+	quit = false;
+}
+
+void StatsFormAction::add_memory_stats(ListFormatter& listfmt)
+{
+	const MemoryReport report(*v.get_ctrl()->get_feedcontainer());
+	for (const auto& line : report.format()) {
+		listfmt.add_line(utils::quote_for_stfl(line));
+	}
+	listfmt.add_line("");
+
+	const auto budget = DescriptionBudget::instance().stats();
+	listfmt.add_line(_("Article contents budget:"));
+	listfmt.add_line(strprintf::fmt("  %-30s %" PRIu64,
+			_("Article contents in memory"),
+			static_cast<uint64_t>(budget.descriptions)));
+	listfmt.add_line(strprintf::fmt("  %-30s %s",
+			_("Size of article contents"),
+			MemoryReport::format_bytes(budget.used_bytes)));
+	listfmt.add_line(strprintf::fmt("  %-30s %s",
+			_("Limit"),
+			budget.limit_bytes == 0 ? _("none") : MemoryReport::format_bytes(budget.limit_bytes)));
+	listfmt.add_line(strprintf::fmt("  %-30s %" PRIu64,
+			_("Article contents dropped"),
+			static_cast<uint64_t>(budget.evictions)));
+}
+
+void StatsFormAction::add_timing_stats(ListFormatter& listfmt)
+{
+	listfmt.add_line(_("Timings:"));
+	for (const auto& line : ScopeMeasure::format_stats()) {
+		listfmt.add_line(utils::quote_for_stfl("  " + line));
+	}
+}
+
+void StatsFormAction::init()
+{
+	set_keymap_hints();
+}
+
+const std::vector<KeyMapHintEntry>& StatsFormAction::get_keymap_hint() const
+{
+	static const std::vector<KeyMapHintEntry> hints = {{OP_QUIT, _("Quit")}};
+	return hints;
+}
+
+std::string StatsFormAction::title()
+{
+	return _("Statistics");
+}
+
+} // namespace newsboat
@@ -0,0 +1,163 @@
+#include "subscriptioncache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "3rd-party/json.hpp"
+#include "logger.h"
+
+using json = nlohmann::json;
+
+namespace newsboat {
+
+const unsigned int SubscriptionCache::VERSION;
+
+SubscriptionCache::SubscriptionCache(const std::string& file,
+	const std::string& key)
+	: file(file)
+	, key(key)
+	, has_urls(false)
+{
+	load();
+}
+
+nonstd::optional<std::vector<TaggedFeedUrl>> SubscriptionCache::get_urls()
+const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	if (!has_urls) {
+		return nonstd::nullopt;
+	}
+	return urls;
+}
+
+bool SubscriptionCache::store_urls(const std::vector<TaggedFeedUrl>& new_urls)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	urls = new_urls;
+	has_urls = true;
+
+	json content;
+	content["version"] = VERSION;
+	content["key"] = key;
+	content["urls"] = urls;
+	content["replies"] = json::object();
+	for (const auto& entry : replies) {
+		content["replies"][entry.first] = {
+			{"etag", entry.second.etag},
+			{"last_modified", entry.second.last_modified},
+			{"body", entry.second.body},
+		};
+	}
+
+	std::string serialized;
+	try {
+		serialized = content.dump();
+	} catch (const json::type_error& e) {
+		// A reply that isn't valid UTF-8 can't be stored as it is, and
+		// a mangled copy must never stand in for it. The next start then
+		// fetches the replies again.
+		LOG(Level::DEBUG,
+			"SubscriptionCache::store_urls: not storing replies: %s",
+			e.what());
+		content["replies"] = json::object();
+		serialized = content.dump(-1, ' ', false, json::error_handler_t::replace);
+	}
+
+	const std::string tmp_file = file + ".tmp";
+	{
+		std::ofstream f(tmp_file, std::ios::binary | std::ios::trunc);
+		f << serialized;
+		if (!f) {
+			LOG(Level::ERROR,
+				"SubscriptionCache::store_urls: couldn't write %s",
+				tmp_file);
+			std::remove(tmp_file.c_str());
+			return false;
+		}
+	}
+	if (std::rename(tmp_file.c_str(), file.c_str()) != 0) {
+		LOG(Level::ERROR,
+			"SubscriptionCache::store_urls: couldn't rename %s to %s",
+			tmp_file,
+			file);
+		std::remove(tmp_file.c_str());
+		return false;
+	}
+
+	LOG(Level::DEBUG,
+		"SubscriptionCache::store_urls: wrote %u subscriptions to %s",
+		static_cast<unsigned int>(urls.size()),
+		file);
+	return true;
+}
+
+nonstd::optional<SubscriptionCache::Reply> SubscriptionCache::get_reply(
+	const std::string& url) const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	const auto it = replies.find(url);
+	if (it == replies.cend()) {
+		return nonstd::nullopt;
+	}
+	return it->second;
+}
+
+void SubscriptionCache::set_reply(const std::string& url, const Reply& reply)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	replies[url] = reply;
+}
+
+void SubscriptionCache::load()
+{
+	std::ifstream f(file, std::ios::binary);
+	if (!f) {
+		return;
+	}
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+
+	try {
+		const json content = json::parse(buffer.str());
+		if (content.at("version") != VERSION) {
+			LOG(Level::DEBUG,
+				"SubscriptionCache::load: %s has an unknown format",
+				file);
+			return;
+		}
+		if (content.at("key") != key) {
+			LOG(Level::DEBUG,
+				"SubscriptionCache::load: %s belongs to a different account",
+				file);
+			return;
+		}
+
+		std::map<std::string, Reply> loaded_replies;
+		for (const auto& entry : content.at("replies").items()) {
+			Reply reply;
+			reply.etag = entry.value().at("etag");
+			reply.last_modified = entry.value().at("last_modified");
+			reply.body = entry.value().at("body");
+			loaded_replies[entry.key()] = reply;
+		}
+
+		urls = content.at("urls").get<std::vector<TaggedFeedUrl>>();
+		replies = std::move(loaded_replies);
+		has_urls = true;
+	} catch (const json::exception& e) {
+		LOG(Level::DEBUG,
+			"SubscriptionCache::load: ignoring %s: %s",
+			file,
+			e.what());
+		return;
+	}
+
+	LOG(Level::DEBUG,
+		"SubscriptionCache::load: read %u subscriptions from %s",
+		static_cast<unsigned int>(urls.size()),
+		file);
+}
+
+} // namespace newsboat
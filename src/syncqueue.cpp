@@ -0,0 +1,544 @@
+#include "syncqueue.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "logger.h"
+#include "remoteapi.h"
+#include "utils.h"
+
+namespace newsboat {
+
+namespace {
+
+const auto MIN_RETRY_DELAY = std::chrono::milliseconds(5000);
+const auto MAX_RETRY_DELAY = std::chrono::milliseconds(5 * 60 * 1000);
+
+// Journal lines are the name of the change followed by tab-separated fields,
+// the first of which is the number of attempts at sending it. The GUID comes
+// last, so it may contain tabs itself.
+const std::string JOURNAL_READ = "read";
+const std::string JOURNAL_UNREAD = "unread";
+const std::string JOURNAL_FLAGS = "flags";
+
+std::vector<std::string> split_fields(const std::string& line,
+	std::size_t count)
+{
+	std::vector<std::string> fields;
+	std::string::size_type start = 0;
+	while (fields.size() + 1 < count) {
+		const auto tab = line.find('\t', start);
+		if (tab == std::string::npos) {
+			break;
+		}
+		fields.push_back(line.substr(start, tab - start));
+		start = tab + 1;
+	}
+	fields.push_back(line.substr(start));
+	return fields;
+}
+
+} // namespace
+
+const std::chrono::milliseconds SyncQueue::COALESCE_DELAY(1000);
+const std::size_t SyncQueue::BATCH_SIZE;
+
+SyncQueue::SyncQueue(RemoteApi& api, const std::string& journal_file)
+	: api(api)
+	, journal_file(journal_file)
+	, stop_requested(false)
+	, retry_delay(0)
+{
+	load_journal();
+}
+
+SyncQueue::~SyncQueue()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stop_requested = true;
+	}
+	cv.notify_all();
+	join();
+
+	std::lock_guard<std::mutex> sending(send_mtx);
+	std::lock_guard<std::mutex> guard(mtx);
+	save_journal(changes);
+}
+
+void SyncQueue::start()
+{
+	join();
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stop_requested = false;
+	}
+	thread = std::thread(&SyncQueue::run, this);
+}
+
+void SyncQueue::stop()
+{
+	bool offline;
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stop_requested = true;
+		offline = retry_delay.count() > 0;
+	}
+	cv.notify_all();
+	join();
+
+	if (!offline) {
+		flush();
+	}
+}
+
+void SyncQueue::join()
+{
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void SyncQueue::mark_article_read(const std::string& guid, bool read)
+{
+	add({Change{read ? ChangeType::READ : ChangeType::UNREAD, guid, {}, {}}});
+}
+
+void SyncQueue::mark_articles_read(const std::vector<std::string>& guids)
+{
+	std::vector<Change> newer;
+	newer.reserve(guids.size());
+	for (const auto& guid : guids) {
+		newer.push_back(Change{ChangeType::READ, guid, {}, {}});
+	}
+	add(std::move(newer));
+}
+
+void SyncQueue::update_article_flags(const std::string& oldflags,
+	const std::string& newflags,
+	const std::string& guid)
+{
+	add({Change{ChangeType::FLAGS, guid, oldflags, newflags}});
+}
+
+std::size_t SyncQueue::pending() const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return changes.size();
+}
+
+std::unordered_set<std::string> SyncQueue::pending_read_state() const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	std::unordered_set<std::string> guids = sending_read_state;
+	for (const auto& change : changes) {
+		if (change.type != ChangeType::FLAGS) {
+			guids.insert(change.target);
+		}
+	}
+	return guids;
+}
+
+void SyncQueue::add(std::vector<Change> newer)
+{
+	// Servers can't do anything with articles that have no GUID, and would
+	// keep refusing them.
+	newer.erase(std::remove_if(newer.begin(), newer.end(),
+	[](const Change& change) {
+		return change.target.empty();
+	}), newer.end());
+
+	bool backing_off;
+	std::vector<Change> remaining;
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		merge(changes, std::move(newer));
+		backing_off = retry_delay.count() > 0;
+		if (backing_off) {
+			remaining = changes;
+		}
+	}
+	cv.notify_all();
+
+	// The next attempt may be minutes away, so the changes are saved
+	// right away. If changes are being sent, that saves them afterwards.
+	if (backing_off) {
+		std::unique_lock<std::mutex> sending(send_mtx, std::try_to_lock);
+		if (sending.owns_lock()) {
+			save_journal(remaining);
+		}
+	}
+}
+
+std::size_t SyncQueue::merge(std::vector<Change>& changes,
+	std::vector<Change> newer)
+{
+	// Read and unread cancel each other out, so they share a key.
+	const auto key = [](const Change& change) {
+		return (change.type == ChangeType::FLAGS ? "f" : "r") + change.target;
+	};
+	const std::size_t older = changes.size();
+
+	std::unordered_map<std::string, std::size_t> latest;
+	for (std::size_t i = 0; i < changes.size(); i++) {
+		latest[key(changes[i])] = i;
+	}
+	std::vector<bool> superseded(changes.size(), false);
+
+	for (auto& change : newer) {
+		const auto change_key = key(change);
+		const auto found = latest.find(change_key);
+		if (found != latest.end()) {
+			if (change.type == ChangeType::FLAGS) {
+				change.oldflags = changes[found->second].oldflags;
+			}
+			superseded[found->second] = true;
+			latest.erase(found);
+		}
+		if (change.type == ChangeType::FLAGS && change.oldflags == change.newflags) {
+			continue;
+		}
+		latest[change_key] = changes.size();
+		changes.push_back(std::move(change));
+		superseded.push_back(false);
+	}
+
+	std::size_t kept = 0;
+	std::size_t kept_older = 0;
+	for (std::size_t i = 0; i < changes.size(); i++) {
+		if (!superseded[i]) {
+			if (kept != i) {
+				changes[kept] = std::move(changes[i]);
+			}
+			kept++;
+			if (i < older) {
+				kept_older++;
+			}
+		}
+	}
+	changes.resize(kept);
+	return kept_older;
+}
+
+bool SyncQueue::flush()
+{
+	return send_pending().unsent == 0;
+}
+
+bool SyncQueue::try_flush()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		if (retry_delay.count() > 0) {
+			return changes.empty();
+		}
+	}
+
+	const auto result = send_pending();
+	record_result(result);
+	return result.unsent == 0;
+}
+
+SyncQueue::FlushResult SyncQueue::send_pending()
+{
+	std::lock_guard<std::mutex> sending(send_mtx);
+
+	std::vector<Change> batch;
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		batch.swap(changes);
+		for (const auto& change : batch) {
+			if (change.type != ChangeType::FLAGS) {
+				sending_read_state.insert(change.target);
+			}
+		}
+	}
+	if (batch.empty()) {
+		return FlushResult{0, 0};
+	}
+
+	const auto outcomes = send(batch);
+	const std::size_t sent = std::count(outcomes.begin(), outcomes.end(),
+			Outcome::SENT);
+	LOG(Level::DEBUG,
+		"SyncQueue::flush: sent %" PRIu64 " of %" PRIu64 " changes",
+		static_cast<std::uint64_t>(sent),
+		static_cast<std::uint64_t>(batch.size()));
+
+	std::vector<Change> unsent;
+	std::vector<Change> refused;
+	for (std::size_t i = 0; i < batch.size(); i++) {
+		if (outcomes[i] == Outcome::NOT_SENT) {
+			unsent.push_back(std::move(batch[i]));
+		} else if (outcomes[i] == Outcome::REFUSED) {
+			// A server that took nothing is probably unreachable, so that
+			// doesn't count against the change.
+			if (sent > 0 && ++batch[i].attempts >= MAX_ATTEMPTS) {
+				LOG(Level::ERROR,
+					"SyncQueue::flush: giving up on change to %s, the server "
+					"refused it %u times",
+					batch[i].target,
+					batch[i].attempts);
+				continue;
+			}
+			refused.push_back(std::move(batch[i]));
+		}
+	}
+
+	std::vector<Change> remaining;
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		// Changes made while we were sending take precedence over the ones
+		// that weren't sent. The refused ones go last, so that they don't
+		// hold up the others next time.
+		std::vector<Change> newer;
+		newer.swap(changes);
+		merge(unsent, std::move(newer));
+		const auto kept_refused = merge(refused, std::move(unsent));
+		std::rotate(refused.begin(), refused.begin() + kept_refused,
+			refused.end());
+		changes = std::move(refused);
+		remaining = changes;
+		sending_read_state.clear();
+	}
+	save_journal(remaining);
+	return FlushResult{sent, batch.size() - sent};
+}
+
+void SyncQueue::record_result(const FlushResult& result)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	if (result.unsent == 0 || result.sent > 0) {
+		retry_delay = std::chrono::milliseconds(0);
+	} else {
+		retry_delay = std::min(MAX_RETRY_DELAY,
+				std::max(MIN_RETRY_DELAY, retry_delay * 2));
+		LOG(Level::INFO,
+			"SyncQueue: %" PRIu64 " changes pending, retrying in %" PRIi64 " ms",
+			static_cast<std::uint64_t>(changes.size()),
+			static_cast<std::int64_t>(retry_delay.count()));
+	}
+}
+
+std::vector<SyncQueue::Outcome> SyncQueue::send(
+	const std::vector<Change>& batch)
+{
+	std::vector<Outcome> outcomes(batch.size(), Outcome::NOT_SENT);
+	bool any_sent = false;
+	// Until the server has taken something, a refusal may mean that it's
+	// unreachable. The second one is taken as proof, as every other request
+	// would just fail the same way.
+	unsigned int refusals = 0;
+	const auto reachable = [&]() {
+		return any_sent || refusals < 2;
+	};
+	std::size_t i = 0;
+	try {
+		while (i < batch.size()) {
+			std::size_t next = i + 1;
+			if (batch[i].type == ChangeType::READ
+				|| batch[i].type == ChangeType::UNREAD) {
+				while (next < batch.size() && batch[next].type == batch[i].type
+					&& next - i < BATCH_SIZE) {
+					next++;
+				}
+			}
+
+			if (send_request(batch, i, next)) {
+				std::fill(outcomes.begin() + i, outcomes.begin() + next,
+					Outcome::SENT);
+				any_sent = true;
+			} else {
+				refusals++;
+				std::fill(outcomes.begin() + i, outcomes.begin() + next,
+					Outcome::REFUSED);
+				if (next - i > 1) {
+					// Find out which of the articles the server refuses, so
+					// that the others don't share their fate. Articles it
+					// refused before come last, so the first ones are the
+					// best test of whether it's reachable at all.
+					for (std::size_t j = i; j < next && reachable(); j++) {
+						if (send_request(batch, j, j + 1)) {
+							outcomes[j] = Outcome::SENT;
+							any_sent = true;
+						} else {
+							refusals++;
+						}
+					}
+				}
+			}
+			i = next;
+
+			if (!reachable()) {
+				break;
+			}
+		}
+	} catch (const std::exception& e) {
+		LOG(Level::ERROR, "SyncQueue::send: %s", e.what());
+		if (i < batch.size() && outcomes[i] == Outcome::NOT_SENT) {
+			outcomes[i] = Outcome::REFUSED;
+		}
+	}
+	return outcomes;
+}
+
+bool SyncQueue::send_request(const std::vector<Change>& batch,
+	std::size_t begin,
+	std::size_t end)
+{
+	const Change& change = batch[begin];
+	bool success = false;
+
+	switch (change.type) {
+	case ChangeType::READ:
+	case ChangeType::UNREAD: {
+		const bool read = change.type == ChangeType::READ;
+		if (end - begin == 1) {
+			success = api.mark_article_read(change.target, read);
+			break;
+		}
+		std::vector<std::string> guids;
+		for (std::size_t i = begin; i < end; i++) {
+			guids.push_back(batch[i].target);
+		}
+		success = read ? api.mark_articles_read(guids)
+			: api.mark_articles_unread(guids);
+		break;
+	}
+	case ChangeType::FLAGS:
+		success = api.update_article_flags(
+				change.oldflags, change.newflags, change.target);
+		break;
+	}
+
+	if (!success) {
+		LOG(Level::INFO,
+			"SyncQueue::send: server refused change to %s",
+			change.target);
+	}
+	return success;
+}
+
+void SyncQueue::run()
+{
+	LOG(Level::DEBUG, "SyncQueue: started");
+
+	std::unique_lock<std::mutex> guard(mtx);
+	while (true) {
+		cv.wait(guard, [this]() {
+			return stop_requested || !changes.empty();
+		});
+		// Give the user time to make more changes, and the server time to
+		// recover if the last attempt failed.
+		cv.wait_for(guard, COALESCE_DELAY + retry_delay, [this]() {
+			return stop_requested;
+		});
+		if (stop_requested) {
+			break;
+		}
+
+		guard.unlock();
+		record_result(send_pending());
+		guard.lock();
+	}
+
+	LOG(Level::DEBUG, "SyncQueue: stopped");
+}
+
+void SyncQueue::load_journal()
+{
+	std::ifstream f(journal_file);
+	if (!f.is_open()) {
+		return;
+	}
+
+	std::vector<Change> loaded;
+	std::string line;
+	while (std::getline(f, line)) {
+		const auto tab = line.find('\t');
+		if (tab == std::string::npos) {
+			continue;
+		}
+		const std::string name = line.substr(0, tab);
+		const bool is_flags = name == JOURNAL_FLAGS;
+		const auto fields = split_fields(line.substr(tab + 1), is_flags ? 4 : 2);
+		if (fields.size() != (is_flags ? 4u : 2u)) {
+			continue;
+		}
+
+		Change change;
+		change.target = fields.back();
+		change.attempts = utils::to_u(fields[0]);
+		if (name == JOURNAL_READ) {
+			change.type = ChangeType::READ;
+		} else if (name == JOURNAL_UNREAD) {
+			change.type = ChangeType::UNREAD;
+		} else if (is_flags) {
+			change.type = ChangeType::FLAGS;
+			change.oldflags = fields[1];
+			change.newflags = fields[2];
+		} else {
+			LOG(Level::WARN,
+				"SyncQueue::load_journal: ignoring unknown change `%s'",
+				name);
+			continue;
+		}
+		loaded.push_back(std::move(change));
+	}
+
+	LOG(Level::INFO,
+		"SyncQueue::load_journal: %" PRIu64 " changes left from the last run",
+		static_cast<std::uint64_t>(loaded.size()));
+	merge(changes, std::move(loaded));
+}
+
+void SyncQueue::save_journal(const std::vector<Change>& remaining)
+{
+	if (remaining.empty()) {
+		std::remove(journal_file.c_str());
+		return;
+	}
+
+	const std::string tmp_path = journal_file + ".tmp";
+	{
+		std::ofstream f(tmp_path, std::ios::trunc);
+		for (const auto& change : remaining) {
+			if (change.target.find('\n') != std::string::npos) {
+				continue;
+			}
+			switch (change.type) {
+			case ChangeType::READ:
+				f << JOURNAL_READ << '\t' << change.attempts;
+				break;
+			case ChangeType::UNREAD:
+				f << JOURNAL_UNREAD << '\t' << change.attempts;
+				break;
+			case ChangeType::FLAGS:
+				f << JOURNAL_FLAGS << '\t' << change.attempts << '\t'
+					<< change.oldflags << '\t' << change.newflags;
+				break;
+			}
+			f << '\t' << change.target << '\n';
+		}
+		if (!f) {
+			LOG(Level::ERROR,
+				"SyncQueue::save_journal: couldn't write %s",
+				tmp_path);
+			std::remove(tmp_path.c_str());
+			return;
+		}
+	}
+	if (std::rename(tmp_path.c_str(), journal_file.c_str()) != 0) {
+		LOG(Level::ERROR,
+			"SyncQueue::save_journal: couldn't rename %s to %s",
+			tmp_path,
+			journal_file);
+		std::remove(tmp_path.c_str());
+	}
+}
+
+} // namespace newsboat
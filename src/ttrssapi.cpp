@@ -3,11 +3,14 @@
 #include <algorithm>
 #include <cinttypes>
 #include <cstring>
-#include <thread>
+#include <iterator>
+#include <memory>
 #include <time.h>
+#include <unordered_set>
 
 #include "3rd-party/json.hpp"
 #include "curlhandle.h"
+#include "jsonstream.h"
 #include "logger.h"
 #include "remoteapi.h"
 #include "rss/feed.h"
@@ -16,6 +19,11 @@
 
 using json = nlohmann::json;
 
+#define TTRSS_MAX_PARALLEL_REQUESTS 4u
+// getHeadlines never returns more than this many articles per request.
+#define TTRSS_HEADLINES_PER_PAGE 200u
+#define TTRSS_MAX_UNREAD_IDS 10000u
+
 namespace newsboat {
 
 TtRssApi::TtRssApi(ConfigContainer& c)
@@ -133,6 +141,15 @@ json TtRssApi::run_op(const std::string& op,
 	const std::map<std::string, std::string>& args,
 	CurlHandle& cached_handle,
 	bool try_login /* = true */)
+{
+	return run_op(op, args, cached_handle, nullptr, try_login);
+}
+
+json TtRssApi::run_op(const std::string& op,
+	const std::map<std::string, std::string>& args,
+	CurlHandle& cached_handle,
+	const std::function<void(json&& element)>& on_content_element,
+	bool try_login)
 {
 	std::string url =
 		strprintf::fmt("%s/api/", cfg.get_configvalue("ttrss-url"));
@@ -161,19 +178,21 @@ json TtRssApi::run_op(const std::string& op,
 	std::string result = utils::retrieve_url(
 			url, cached_handle, cfg, auth_info, &req_data, utils::HTTPMethod::POST);
 
-	LOG(Level::DEBUG,
-		"TtRssApi::run_op(%s,...): post=%s reply = %s",
-		op,
-		req_data,
-		result);
+	LOG_FIELDS(Level::DEBUG, "TtRssApi::run_op", {
+		{"op", op},
+		{"post", req_data},
+		{"reply", result}});
 
 	json reply;
 	try {
-		reply = json::parse(result);
+		if (on_content_element) {
+			reply = jsonstream::parse(result, "content", on_content_element);
+		} else {
+			reply = json::parse(result);
+		}
 	} catch (json::parse_error& e) {
-		LOG(Level::ERROR,
-			"TtRssApi::run_op: reply failed to parse: %s",
-			result);
+		LOG_FIELDS(Level::ERROR, "TtRssApi::run_op: reply failed to parse", {
+			{"reply", result}});
 		return json(nullptr);
 	}
 
@@ -189,7 +208,7 @@ json TtRssApi::run_op(const std::string& op,
 
 	json content;
 	try {
-		content = reply.at("content");
+		content = std::move(reply.at("content"));
 	} catch (json::exception& e) {
 		LOG(Level::ERROR,
 			"TtRssApi::run_op: no content part in answer from "
@@ -200,7 +219,7 @@ json TtRssApi::run_op(const std::string& op,
 	if (status != 0) {
 		if (content["error"] == "NOT_LOGGED_IN" && try_login) {
 			if (authenticate()) {
-				return run_op(op, args, cached_handle, false);
+				return run_op(op, args, cached_handle, on_content_element, false);
 			} else {
 				return json(nullptr);
 			}
@@ -289,12 +308,21 @@ std::vector<TaggedFeedUrl> TtRssApi::get_subscribed_urls()
 
 	} else {
 		try {
-			// first fetch feeds within no category
-			fetch_feeds_per_category(json(nullptr), feeds);
-
-			// then fetch the feeds of all categories
-			for (const auto& i : categories) {
-				fetch_feeds_per_category(i, feeds);
+			// Fetch the feeds of several categories at once, but list them
+			// in the order of the categories. The first page holds the feeds
+			// within no category.
+			std::vector<std::vector<TaggedFeedUrl>> per_category(
+				categories.size() + 1);
+			CurlHandle handle;
+			fetch_pages(per_category.size(), TTRSS_MAX_PARALLEL_REQUESTS, handle,
+			[&](unsigned int i, CurlHandle& easyhandle) {
+				fetch_feeds_per_category(i == 0 ? json(nullptr) : categories[i - 1],
+					per_category[i],
+					easyhandle);
+			});
+			for (auto& category_feeds : per_category) {
+				std::move(category_feeds.begin(), category_feeds.end(),
+					std::back_inserter(feeds));
 			}
 		} catch (json::exception& e) {
 			LOG(Level::ERROR,
@@ -324,19 +352,18 @@ bool TtRssApi::mark_all_read(const std::string& feed_url)
 
 bool TtRssApi::mark_article_read(const std::string& guid, bool read)
 {
-	// Do this in a thread, as we don't care about the result enough to wait
-	// for it.
-	std::thread t{[=]()
-	{
-		LOG(Level::DEBUG,
-			"TtRssApi::mark_article_read: inside thread, marking "
-			"thread as read...");
-
-		// Call the TtRssApi's update_article function as a thread.
-		this->update_article(guid, 2, read ? 0 : 1);
-	}};
-	t.detach();
-	return true;
+	return update_article(guid, 2, read ? 0 : 1);
+}
+
+bool TtRssApi::mark_articles_read(const std::vector<std::string>& guids)
+{
+	// updateArticle takes a comma-separated list of article IDs.
+	return update_article(utils::join(guids, ","), 2, 0);
+}
+
+bool TtRssApi::mark_articles_unread(const std::vector<std::string>& guids)
+{
+	return update_article(utils::join(guids, ","), 2, 1);
 }
 
 bool TtRssApi::update_article_flags(const std::string& oldflags,
@@ -369,91 +396,144 @@ rsspp::Feed TtRssApi::fetch_feed(const std::string& id)
 }
 
 rsspp::Feed TtRssApi::fetch_feed(const std::string& id, CurlHandle& cached_handle)
+{
+	std::string sync_cursor;
+	return fetch_feed(id, cached_handle, sync_cursor);
+}
+
+rsspp::Feed TtRssApi::fetch_feed(const std::string& id,
+	CurlHandle& cached_handle,
+	std::string& sync_cursor)
 {
 	rsspp::Feed f;
 
 	f.rss_version = rsspp::Feed::TTRSS_JSON;
 
+	// The first sync gets the latest headlines. After that, we only ask for
+	// articles with a higher ID than the newest one we've seen (IDs only
+	// grow), and take the read state of the others from the list of unread
+	// articles.
+	const bool incremental = !sync_cursor.empty();
+	std::shared_ptr<const std::unordered_set<std::string>> unread_guids;
+	if (incremental) {
+		unread_guids = fetch_unread_guids(id, cached_handle);
+	}
+
 	std::map<std::string, std::string> args;
 	args["feed_id"] = id;
 	args["show_content"] = "1";
 	args["include_attachments"] = "1";
-	json content = run_op("getHeadlines", args, cached_handle, true);
-
-	if (content.is_null()) {
-		return f;
+	if (incremental) {
+		args["since_id"] = sync_cursor;
+		args["limit"] = std::to_string(TTRSS_HEADLINES_PER_PAGE);
 	}
 
-	if (!content.is_array()) {
-		LOG(Level::ERROR,
-			"TtRssApi::fetch_feed: content is not an array");
-		return f;
+	int64_t newest_id = 0;
+	if (incremental) {
+		newest_id = utils::to_u(sync_cursor);
 	}
+	uint64_t page_items = 0;
 
-	LOG(Level::DEBUG,
-		"TtRssApi::fetch_feed: %" PRIu64 " items",
-		static_cast<uint64_t>(content.size()));
+	// Articles are converted as they're parsed, so that the reply is never
+	// held in memory as a whole.
+	const auto add_item = [&](json&& item_obj) {
+		rsspp::Item item;
 
-	try {
-		for (const auto& item_obj : content) {
-			rsspp::Item item;
-
-			if (!item_obj["title"].is_null()) {
-				item.title = item_obj["title"];
-			}
+		if (!item_obj["title"].is_null()) {
+			item.title = item_obj["title"];
+		}
 
-			if (!item_obj["link"].is_null()) {
-				item.link = item_obj["link"];
-			}
+		if (!item_obj["link"].is_null()) {
+			item.link = item_obj["link"];
+		}
 
-			if (!item_obj["author"].is_null()) {
-				item.author = item_obj["author"];
-			}
+		if (!item_obj["author"].is_null()) {
+			item.author = item_obj["author"];
+		}
 
-			if (!item_obj["content"].is_null()) {
-				item.content_encoded = item_obj["content"];
-			}
+		if (!item_obj["content"].is_null()) {
+			item.content_encoded = item_obj["content"];
+		}
 
-			if (!item_obj["attachments"].is_null()) {
-				for (const json& a : item_obj["attachments"]) {
-					if (!a["content_url"].is_null() && !a["content_type"].is_null()) {
-						item.enclosures.push_back(
-						rsspp::Enclosure {
-							a["content_url"],
-							a["content_type"],
-							"",
-							"",
-						}
-						);
-						break;
+		if (!item_obj["attachments"].is_null()) {
+			for (const json& a : item_obj["attachments"]) {
+				if (!a["content_url"].is_null() && !a["content_type"].is_null()) {
+					item.enclosures.push_back(
+					rsspp::Enclosure {
+						a["content_url"],
+						a["content_type"],
+						"",
+						"",
 					}
+					);
+					break;
 				}
 			}
+		}
 
-			int id = item_obj["id"];
-			item.guid = strprintf::fmt("%d", id);
+		int id = item_obj["id"];
+		item.guid = strprintf::fmt("%d", id);
+		newest_id = std::max<int64_t>(newest_id, id);
 
-			bool unread = item_obj["unread"];
-			if (unread) {
-				item.labels.push_back("ttrss:unread");
-			} else {
-				item.labels.push_back("ttrss:read");
-			}
+		bool unread = item_obj["unread"];
+		if (unread) {
+			item.labels.push_back("ttrss:unread");
+		} else {
+			item.labels.push_back("ttrss:read");
+		}
+
+		int updated_time = item_obj["updated"];
+		time_t updated = static_cast<time_t>(updated_time);
 
-			int updated_time = item_obj["updated"];
-			time_t updated = static_cast<time_t>(updated_time);
+		item.pubDate = utils::mt_strf_localtime(
+				"%a, %d %b %Y %H:%M:%S %z",
+				updated);
+		item.pubDate_ts = updated;
 
-			item.pubDate = utils::mt_strf_localtime(
-					"%a, %d %b %Y %H:%M:%S %z",
-					updated);
-			item.pubDate_ts = updated;
+		f.items.push_back(item);
+		page_items++;
+	};
 
-			f.items.push_back(item);
+	for (unsigned int skip = 0; ; skip += TTRSS_HEADLINES_PER_PAGE) {
+		if (incremental) {
+			args["skip"] = std::to_string(skip);
+		}
+		page_items = 0;
+
+		json content;
+		try {
+			content = run_op("getHeadlines", args, cached_handle, add_item, true);
+		} catch (json::exception& e) {
+			LOG(Level::ERROR,
+				"Exception occurred while parsing feeed: ",
+				e.what());
+		}
+
+		if (content.is_null()) {
+			return f;
+		}
+
+		if (!content.is_array()) {
+			LOG(Level::ERROR,
+				"TtRssApi::fetch_feed: content is not an array");
+			return f;
+		}
+
+		if (!incremental || page_items < TTRSS_HEADLINES_PER_PAGE) {
+			break;
 		}
-	} catch (json::exception& e) {
-		LOG(Level::ERROR,
-			"Exception occurred while parsing feeed: ",
-			e.what());
+	}
+
+	LOG(Level::DEBUG,
+		"TtRssApi::fetch_feed: %" PRIu64 " items",
+		static_cast<uint64_t>(f.items.size()));
+
+	if (incremental && unread_guids) {
+		f.only_new_items = true;
+		f.unread_guids = unread_guids;
+	}
+	if (newest_id > 0) {
+		sync_cursor = std::to_string(newest_id);
 	}
 
 	std::sort(f.items.begin(),
@@ -465,8 +545,57 @@ rsspp::Feed TtRssApi::fetch_feed(const std::string& id, CurlHandle& cached_handl
 	return f;
 }
 
+std::shared_ptr<const std::unordered_set<std::string>> TtRssApi::fetch_unread_guids(
+		const std::string& id,
+		CurlHandle& cached_handle)
+{
+	std::map<std::string, std::string> args;
+	args["feed_id"] = id;
+	args["view_mode"] = "unread";
+	args["limit"] = std::to_string(TTRSS_HEADLINES_PER_PAGE);
+
+	auto unread_guids = std::make_shared<std::unordered_set<std::string>>();
+	for (unsigned int skip = 0; ; skip += TTRSS_HEADLINES_PER_PAGE) {
+		if (skip >= TTRSS_MAX_UNREAD_IDS) {
+			LOG(Level::INFO,
+				"TtRssApi::fetch_unread_guids: too many unread articles in %s",
+				id);
+			return nullptr;
+		}
+		args["skip"] = std::to_string(skip);
+
+		uint64_t page_items = 0;
+		json content;
+		try {
+			content = run_op("getHeadlines", args, cached_handle,
+			[&](json&& item_obj) {
+				const int article_id = item_obj["id"];
+				unread_guids->insert(strprintf::fmt("%d", article_id));
+				page_items++;
+			}, true);
+		} catch (json::exception& e) {
+			LOG(Level::ERROR,
+				"TtRssApi::fetch_unread_guids: %s",
+				e.what());
+			return nullptr;
+		}
+
+		if (!content.is_array()) {
+			LOG(Level::ERROR,
+				"TtRssApi::fetch_unread_guids: content is not an array");
+			return nullptr;
+		}
+
+		if (page_items < TTRSS_HEADLINES_PER_PAGE) {
+			break;
+		}
+	}
+	return unread_guids;
+}
+
 void TtRssApi::fetch_feeds_per_category(const json& cat,
-	std::vector<TaggedFeedUrl>& feeds)
+	std::vector<TaggedFeedUrl>& feeds,
+	CurlHandle& easyhandle)
 {
 	json cat_name;
 
@@ -503,7 +632,7 @@ void TtRssApi::fetch_feeds_per_category(const json& cat,
 	std::map<std::string, std::string> args;
 	args["cat_id"] = cat_id;
 
-	json feed_list_obj = run_op("getFeeds", args);
+	json feed_list_obj = run_op("getFeeds", args, easyhandle);
 
 	if (feed_list_obj.is_null()) {
 		return;
@@ -40,7 +40,7 @@ nonstd::optional<utils::ReadTextFileError> TtRssUrlReader::reload()
 		}
 	}
 
-	auto feedurls = api->get_subscribed_urls();
+	auto feedurls = api->load_subscribed_urls();
 
 	for (const auto& url : feedurls) {
 		LOG(Level::DEBUG, "added %s to URL list", url.first);
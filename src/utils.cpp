@@ -315,7 +315,11 @@ std::string utils::retrieve_url(const std::string& url,
 		LOG(Level::ERROR, "%s: LibCURL error (%d): %s", logprefix.str(), res, errmsg);
 		buf = "";
 	} else {
-		LOG(Level::DEBUG, "%s: %s", logprefix.str(), buf);
+		LOG_FIELDS(Level::DEBUG, "utils::retrieve_url", {
+			{"method", http_method_str(method)},
+			{"url", url},
+			{"body", body != nullptr ? *body : std::string("-")},
+			{"response", buf}});
 	}
 
 	// Reset ERRORBUFFER: has to be valid for the whole lifetime of the handle
@@ -58,6 +58,9 @@ extern "C" {
 #include "rssfeed.h"
 #include "selectformaction.h"
 #include "selecttag.h"
+#include "stats.h"
+#include "startupprofiler.h"
+#include "statsformaction.h"
 #include "strprintf.h"
 #include "urlview.h"
 #include "urlviewformaction.h"
@@ -81,6 +84,7 @@ View::View(Controller* c)
 	, is_inside_cmdline(false)
 	, tab_count(0)
 	, rsscache(nullptr)
+	, startup_profiler(nullptr)
 	, filters(ctrl->get_filtercontainer())
 	, colorman(ctrl->get_colormanager())
 {
@@ -186,6 +190,12 @@ int View::run()
 		// we signal "oh, you will receive an operation soon"
 		fa->prepare();
 
+		if (startup_profiler != nullptr) {
+			fa->draw_form();
+			startup_profiler->end_phase();
+			startup_profiler = nullptr;
+		}
+
 		// we then receive the event and ignore timeouts.
 		const std::string event = fa->draw_form_wait_for_event(INT_MAX);
 
@@ -607,6 +617,16 @@ void View::push_help()
 	current_formaction = formaction_stack_size() - 1;
 }
 
+void View::push_stats()
+{
+	auto statsview = std::make_shared<StatsFormAction>(*this, stats_str, cfg);
+	apply_colors(statsview);
+	statsview->set_parent_formaction(get_current_formaction());
+	statsview->init();
+	formaction_stack.push_back(statsview);
+	current_formaction = formaction_stack_size() - 1;
+}
+
 void View::push_urlview(const Links& links,
 	std::shared_ptr<RssFeed>& feed)
 {
@@ -980,14 +1000,16 @@ bool View::get_prev_feed(ItemListFormAction& itemlist)
 
 void View::prepare_query_feed(std::shared_ptr<RssFeed> feed)
 {
-	if (feed->is_query_feed()) {
+	if (!feed->is_query_feed()) {
+		ctrl->get_feedcontainer()->load_feed_items(feed);
+	} else {
 		LOG(Level::DEBUG,
 			"View::prepare_query_feed: %s",
 			feed->rssurl());
 
 		const std::shared_ptr<AutoDiscardMessage> message =
 			status_line.show_message_until_finished(_("Updating query feed..."));
-		feed->update_items(ctrl->get_feedcontainer()->get_all_feeds());
+		ctrl->get_feedcontainer()->update_query_feed(feed);
 		feed->sort(cfg->get_article_sort_strategy());
 		notify_itemlist_change(feed);
 	}
@@ -1121,6 +1143,11 @@ void View::set_cache(Cache* c)
 	rsscache = c;
 }
 
+void View::set_startup_profiler(StartupProfiler* profiler)
+{
+	startup_profiler = profiler;
+}
+
 std::vector<std::pair<unsigned int, std::string>> View::get_formaction_names()
 {
 	std::vector<std::pair<unsigned int, std::string>> formaction_names;
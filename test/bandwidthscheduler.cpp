@@ -0,0 +1,92 @@
+#include "bandwidthscheduler.h"
+
+#include "3rd-party/catch.hpp"
+#include "download.h"
+
+using namespace podboat;
+using namespace std::chrono;
+
+TEST_CASE("BandwidthScheduler doesn't limit anything if the rate is 0",
+	"[BandwidthScheduler]")
+{
+	Download dl([]() {});
+	BandwidthScheduler scheduler(0);
+
+	REQUIRE_FALSE(scheduler.limited());
+	REQUIRE(scheduler.may_receive(&dl));
+
+	scheduler.consume(&dl, 1000000);
+	REQUIRE(scheduler.may_receive(&dl));
+}
+
+TEST_CASE("BandwidthScheduler splits the budget evenly between downloads",
+	"[BandwidthScheduler]")
+{
+	Download first([]() {});
+	Download second([]() {});
+	BandwidthScheduler scheduler(10240);
+	scheduler.add(&first);
+	scheduler.add(&second);
+
+	const auto start = steady_clock::now();
+	scheduler.refill(start);
+	REQUIRE_FALSE(scheduler.may_receive(&first));
+	REQUIRE_FALSE(scheduler.may_receive(&second));
+
+	// An eighth of a second is 1280 bytes, i.e. 640 for each
+	scheduler.refill(start + milliseconds(125));
+	REQUIRE(scheduler.may_receive(&first));
+	REQUIRE(scheduler.may_receive(&second));
+
+	scheduler.consume(&first, 639);
+	REQUIRE(scheduler.may_receive(&first));
+	scheduler.consume(&first, 1);
+	REQUIRE_FALSE(scheduler.may_receive(&first));
+	REQUIRE(scheduler.may_receive(&second));
+
+	SECTION("Going into debt delays the next chunk") {
+		scheduler.consume(&second, 1920);
+		scheduler.refill(start + milliseconds(250));
+		REQUIRE(scheduler.may_receive(&first));
+		REQUIRE_FALSE(scheduler.may_receive(&second));
+	}
+
+	SECTION("Removed downloads don't get a share, nor can receive anything") {
+		scheduler.remove(&second);
+		REQUIRE_FALSE(scheduler.may_receive(&second));
+
+		// The whole budget goes to the remaining download
+		scheduler.refill(start + milliseconds(250));
+		scheduler.consume(&first, 1279);
+		REQUIRE(scheduler.may_receive(&first));
+		scheduler.consume(&first, 1);
+		REQUIRE_FALSE(scheduler.may_receive(&first));
+	}
+}
+
+TEST_CASE("BandwidthScheduler gives the share a download can't hold to the "
+	"others",
+	"[BandwidthScheduler]")
+{
+	Download idle([]() {});
+	Download busy([]() {});
+	BandwidthScheduler scheduler(10240);
+	scheduler.add(&idle);
+	scheduler.add(&busy);
+
+	const auto start = steady_clock::now();
+	scheduler.refill(start);
+
+	// Half a second fills both buckets, which hold a quarter of a second
+	// worth of budget each
+	scheduler.refill(start + milliseconds(500));
+	scheduler.consume(&busy, 2560);
+	REQUIRE_FALSE(scheduler.may_receive(&busy));
+
+	// The idle download is full, so the busy one gets all 1280 bytes
+	scheduler.refill(start + milliseconds(625));
+	scheduler.consume(&busy, 1279);
+	REQUIRE(scheduler.may_receive(&busy));
+	scheduler.consume(&busy, 1);
+	REQUIRE_FALSE(scheduler.may_receive(&busy));
+}
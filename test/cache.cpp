@@ -1,5 +1,6 @@
 #include "cache.h"
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 
@@ -66,20 +67,85 @@ TEST_CASE("Cleaning old articles works", "[Cache]")
 
 	/* Simulating a restart of Newsboat. */
 
-	/* Setting "keep-articles-days" to non-zero value to trigger
-	 * Cache::clean_old_articles().
+	/* Setting "keep-articles-days" to non-zero value to make old articles
+	 * expire.
 	 *
 	 * The value of 42 days is sufficient because the items in the test feed
 	 * are dating back to 2006. */
 	cfg = std::make_unique<ConfigContainer>();
 	cfg->set_configvalue("keep-articles-days", "42");
 	rsscache = std::make_unique<Cache>(dbfile.get_path(), cfg.get());
+
+	/* Opening the cache doesn't delete anything; CacheMaintenance does that
+	 * later on. Until then, expired articles are never loaded. */
 	feed = rsscache->internalize_rssfeed("file://data/rss.xml", nullptr);
+	REQUIRE(feed->items().size() == 1);
+	const auto summaries = rsscache->fetch_feed_summaries();
+	REQUIRE(rsscache->internalize_rssfeed_summary(uri, summaries)
+		->total_item_count() == 1);
+
+	unsigned int deleted = 0;
+	while (const auto batch = rsscache->delete_old_articles(3)) {
+		deleted += batch;
+	}
+	REQUIRE(deleted == 8);
 
 	/* The important part: old articles should be gone, new one remains. */
+	feed = rsscache->internalize_rssfeed("file://data/rss.xml", nullptr);
 	REQUIRE(feed->items().size() == 1);
 }
 
+TEST_CASE("fetch_next_expiry() returns when the oldest counted article "
+	"expires", "[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string uri = "file://data/rss.xml";
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(uri, rsscache, cfg, nullptr);
+	const auto feed = parser.parse(feed_retriever.retrieve(uri));
+	rsscache.externalize_rssfeed(feed, false);
+
+	REQUIRE(rsscache.fetch_next_expiry() == 0);
+
+	// The items in the test feed date back to 2006.
+	cfg.set_configvalue("keep-articles-days", "10000");
+	time_t oldest = feed->items()[0]->pubDate_timestamp();
+	for (const auto& item : feed->items()) {
+		oldest = std::min(oldest, item->pubDate_timestamp());
+	}
+	REQUIRE(rsscache.fetch_next_expiry() == oldest + 10000 * 24 * 60 * 60);
+
+	cfg.set_configvalue("keep-articles-days", "42");
+	REQUIRE(rsscache.fetch_next_expiry() == 0);
+}
+
+TEST_CASE("delete_old_articles() deletes articles that expired after the "
+	"cache was opened in batches",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string uri = "file://data/rss.xml";
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(uri, rsscache, cfg, nullptr);
+	rsscache.externalize_rssfeed(parser.parse(feed_retriever.retrieve(uri)),
+		false);
+
+	REQUIRE(rsscache.delete_old_articles(3) == 0);
+
+	// The items in the test feed date back to 2006.
+	cfg.set_configvalue("keep-articles-days", "42");
+
+	unsigned int deleted = 0;
+	while (const auto batch = rsscache.delete_old_articles(3)) {
+		REQUIRE(batch <= 3);
+		deleted += batch;
+	}
+	REQUIRE(deleted == 8);
+	REQUIRE(rsscache.internalize_rssfeed(uri, nullptr)->items().empty());
+}
+
 TEST_CASE("Last-Modified and ETag values are persisted to DB", "[Cache]")
 {
 	auto cfg = std::make_unique<ConfigContainer>();
@@ -130,6 +196,87 @@ TEST_CASE("Last-Modified and ETag values are persisted to DB", "[Cache]")
 	}
 }
 
+TEST_CASE("Sync cursor is persisted to DB", "[Cache]")
+{
+	auto cfg = std::make_unique<ConfigContainer>();
+	test_helpers::TempFile dbfile;
+	auto rsscache = std::make_unique<Cache>(dbfile.get_path(), cfg.get());
+	const auto feedurl = "file://data/rss.xml";
+	FeedRetriever feed_retriever(*cfg, *rsscache);
+	RssParser parser(feedurl, *rsscache, *cfg, nullptr);
+	auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+	rsscache->externalize_rssfeed(feed, false);
+
+	REQUIRE(rsscache->fetch_sync_cursor(feedurl) == "");
+
+	rsscache->update_sync_cursor(feedurl, "1476382350");
+
+	cfg = std::make_unique<ConfigContainer>();
+	rsscache = std::make_unique<Cache>(dbfile.get_path(), cfg.get());
+	REQUIRE(rsscache->fetch_sync_cursor(feedurl) == "1476382350");
+}
+
+TEST_CASE("sync_unread_state marks only the listed items unread", "[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const auto feedurl = "file://data/rss.xml";
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(feedurl, rsscache, cfg, nullptr);
+	auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+	REQUIRE(feed->total_item_count() == 8);
+	rsscache.externalize_rssfeed(feed, false);
+	rsscache.mark_all_read(feedurl);
+
+	const std::string unread_guid = feed->items()[0]->guid();
+	const std::string other_guid = feed->items()[1]->guid();
+	rsscache.sync_unread_state(feedurl, {unread_guid, "not-in-the-feed"});
+
+	feed = rsscache.internalize_rssfeed(feedurl, nullptr);
+	REQUIRE(feed->unread_item_count() == 1);
+	for (const auto& item : feed->items()) {
+		INFO("guid: " << item->guid());
+		REQUIRE(item->unread() == (item->guid() == unread_guid));
+	}
+
+	rsscache.sync_unread_state(feedurl, {other_guid});
+
+	feed = rsscache.internalize_rssfeed(feedurl, nullptr);
+	REQUIRE(feed->unread_item_count() == 1);
+	for (const auto& item : feed->items()) {
+		INFO("guid: " << item->guid());
+		REQUIRE(item->unread() == (item->guid() == other_guid));
+	}
+}
+
+TEST_CASE("sync_unread_state leaves items with pending changes alone",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const auto feedurl = "file://data/rss.xml";
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(feedurl, rsscache, cfg, nullptr);
+	auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+	rsscache.externalize_rssfeed(feed, false);
+	rsscache.mark_all_read(feedurl);
+
+	// The first item was marked unread, and the second read, but the
+	// server doesn't know yet.
+	const std::string marked_unread = feed->items()[0]->guid();
+	const std::string marked_read = feed->items()[1]->guid();
+	rsscache.sync_unread_state(feedurl, {marked_unread});
+	rsscache.sync_unread_state(feedurl, {marked_read},
+		{marked_unread, marked_read});
+
+	feed = rsscache.internalize_rssfeed(feedurl, nullptr);
+	REQUIRE(feed->unread_item_count() == 1);
+	for (const auto& item : feed->items()) {
+		INFO("guid: " << item->guid());
+		REQUIRE(item->unread() == (item->guid() == marked_unread));
+	}
+}
+
 TEST_CASE("mark_all_read marks all items in the feed read", "[Cache]")
 {
 	std::shared_ptr<RssFeed> feed, test_feed;
@@ -855,6 +1002,43 @@ TEST_CASE("internalize_rssfeed doesn't return items that are ignored",
 	REQUIRE(feed->total_item_count() == 2);
 }
 
+TEST_CASE("internalize_rssfeed_summary returns feed whose items can be "
+	"loaded later",
+	"[Cache]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	const std::string feedurl("file://data/rss.xml");
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(feedurl, rsscache, cfg, nullptr);
+	auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+	REQUIRE(feed->total_item_count() == 8);
+	feed->items()[0]->set_unread_nowrite(false);
+	rsscache.externalize_rssfeed(feed, false);
+
+	const auto summaries = rsscache.fetch_feed_summaries();
+	REQUIRE(summaries.size() == 1);
+
+	feed = rsscache.internalize_rssfeed_summary(feedurl, summaries);
+	REQUIRE_FALSE(feed->items_loaded());
+	REQUIRE(feed->items().empty());
+	REQUIRE(feed->total_item_count() == 8);
+	REQUIRE(feed->unread_item_count() == 7);
+	REQUIRE(feed->title() == "AK's moblog");
+
+	rsscache.internalize_items(feed, nullptr);
+	REQUIRE(feed->items_loaded());
+	REQUIRE(feed->items().size() == 8);
+	REQUIRE(feed->unread_item_count() == 7);
+
+	REQUIRE(feed->unload_items());
+	REQUIRE_FALSE(feed->items_loaded());
+	REQUIRE(feed->items().empty());
+	REQUIRE(feed->total_item_count() == 8);
+	REQUIRE(feed->unread_item_count() == 7);
+}
+
 TEST_CASE(
 	"externalize_rssfeed resets \"unread\" field if item's content "
 	"changed and reset_unread = \"yes\"",
@@ -0,0 +1,178 @@
+#include "cachemaintenance.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "3rd-party/catch.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "feedretriever.h"
+#include "rssfeed.h"
+#include "rssparser.h"
+#include "test_helpers/tempfile.h"
+
+using namespace newsboat;
+
+namespace {
+
+void store_feed(Cache& rsscache, ConfigContainer& cfg, const std::string& url)
+{
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(url, rsscache, cfg, nullptr);
+	auto feed = parser.parse(feed_retriever.retrieve(url));
+	rsscache.externalize_rssfeed(feed, false);
+}
+
+} // anonymous namespace
+
+TEST_CASE("internalize_rssfeed leaves deleting articles over `max-items` "
+	"to CacheMaintenance",
+	"[CacheMaintenance]")
+{
+	test_helpers::TempFile dbfile;
+	const std::string feedurl("file://data/rss.xml");
+
+	auto cfg = std::make_unique<ConfigContainer>();
+	// Otherwise maintenance would delete everything, since it isn't told
+	// about any feeds
+	cfg->set_configvalue("cleanup-on-quit", "no");
+	auto rsscache = std::make_unique<Cache>(dbfile.get_path(), cfg.get());
+	store_feed(*rsscache, *cfg, feedurl);
+
+	cfg->set_configvalue("max-items", "3");
+	auto feed = rsscache->internalize_rssfeed(feedurl, nullptr);
+	REQUIRE(feed->total_item_count() == 3);
+
+	INFO("Articles are still in the cache");
+	cfg->set_configvalue("max-items", "0");
+	REQUIRE(rsscache->internalize_rssfeed(feedurl, nullptr)->total_item_count() == 8);
+
+	CacheMaintenance maintenance(*rsscache);
+	REQUIRE(maintenance.run_batch());
+	REQUIRE_FALSE(maintenance.run_batch());
+
+	REQUIRE(rsscache->internalize_rssfeed(feedurl, nullptr)->total_item_count() == 3);
+}
+
+TEST_CASE("Articles dropped by repeated internalizing are deleted once",
+	"[CacheMaintenance]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string feedurl("file://data/rss.xml");
+	store_feed(rsscache, cfg, feedurl);
+
+	cfg.set_configvalue("max-items", "3");
+	for (int i = 0; i < 3; ++i) {
+		REQUIRE(rsscache.internalize_rssfeed(feedurl, nullptr)->total_item_count() == 3);
+	}
+
+	REQUIRE(rsscache.delete_overflow_items(CacheMaintenance::BATCH_SIZE) == 5);
+	REQUIRE(rsscache.delete_overflow_items(CacheMaintenance::BATCH_SIZE) == 0);
+}
+
+TEST_CASE("Idle CacheMaintenance deletes articles over `max-items` as soon "
+	"as a feed is internalized",
+	"[CacheMaintenance]")
+{
+	ConfigContainer cfg;
+	cfg.set_configvalue("cleanup-on-quit", "no");
+	Cache rsscache(":memory:", &cfg);
+	const std::string feedurl("file://data/rss.xml");
+	store_feed(rsscache, cfg, feedurl);
+
+	CacheMaintenance maintenance(rsscache);
+	maintenance.start({feedurl});
+
+	cfg.set_configvalue("max-items", "3");
+	REQUIRE(rsscache.internalize_rssfeed(feedurl, nullptr)->total_item_count() == 3);
+	cfg.set_configvalue("max-items", "0");
+
+	unsigned int left = 8;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (left != 3 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		left = rsscache.internalize_rssfeed(feedurl, nullptr)->total_item_count();
+	}
+	REQUIRE(left == 3);
+
+	maintenance.stop();
+}
+
+TEST_CASE("CacheMaintenance removes feeds that are no longer subscribed to "
+	"only if `cleanup-on-quit` is enabled",
+	"[CacheMaintenance]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::vector<std::string> feedurls = {
+		"file://data/rss.xml",
+		"file://data/atom10_1.xml",
+	};
+	for (const auto& url : feedurls) {
+		store_feed(rsscache, cfg, url);
+	}
+
+	SECTION("cleanup-on-quit set to \"no\"") {
+		cfg.set_configvalue("cleanup-on-quit", "no");
+		CacheMaintenance maintenance(rsscache);
+		maintenance.start({feedurls[1]});
+		maintenance.finish();
+
+		REQUIRE(rsscache.internalize_rssfeed(feedurls[0], nullptr)->total_item_count() == 8);
+	}
+
+	SECTION("cleanup-on-quit set to \"yes\"") {
+		cfg.set_configvalue("cleanup-on-quit", "yes");
+		CacheMaintenance maintenance(rsscache);
+		maintenance.start({feedurls[1]});
+		maintenance.finish();
+
+		REQUIRE(rsscache.internalize_rssfeed(feedurls[0], nullptr)->total_item_count() == 0);
+		REQUIRE(rsscache.fetch_feed_summaries().count(feedurls[0]) == 0);
+		REQUIRE(rsscache.internalize_rssfeed(feedurls[1], nullptr)->total_item_count() == 3);
+	}
+}
+
+TEST_CASE("CacheMaintenance keeps the articles of feeds subscribed to after "
+	"it started",
+	"[CacheMaintenance]")
+{
+	ConfigContainer cfg;
+	cfg.set_configvalue("cleanup-on-quit", "yes");
+	Cache rsscache(":memory:", &cfg);
+	const std::vector<std::string> feedurls = {
+		"file://data/rss.xml",
+		"file://data/atom10_1.xml",
+	};
+	store_feed(rsscache, cfg, feedurls[0]);
+
+	CacheMaintenance maintenance(rsscache);
+	maintenance.start({feedurls[0]});
+	maintenance.set_feedurls(feedurls);
+	store_feed(rsscache, cfg, feedurls[1]);
+
+	// Articles over `max-items` wake up the worker.
+	cfg.set_configvalue("max-items", "3");
+	REQUIRE(rsscache.internalize_rssfeed(feedurls[0], nullptr)->total_item_count() == 3);
+	maintenance.finish();
+
+	cfg.set_configvalue("max-items", "0");
+	REQUIRE(rsscache.internalize_rssfeed(feedurls[0], nullptr)->total_item_count() == 3);
+	REQUIRE(rsscache.internalize_rssfeed(feedurls[1], nullptr)->total_item_count() == 3);
+}
+
+TEST_CASE("CacheMaintenance::stop() can be called at any time",
+	"[CacheMaintenance]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	CacheMaintenance maintenance(rsscache);
+	maintenance.stop();
+
+	maintenance.start({});
+	maintenance.stop();
+	maintenance.stop();
+}
@@ -857,6 +857,52 @@ TEST_CASE(
 	}
 }
 
+TEST_CASE("Sets `profile_startup` if --profile-startup is provided",
+	"[CliArgsParser]")
+{
+	SECTION("without a file") {
+		test_helpers::Opts opts{"newsboat", "--profile-startup"};
+		CliArgsParser args(opts.argc(), opts.argv());
+
+		REQUIRE(args.profile_startup());
+		REQUIRE_FALSE(args.profile_startup_file().has_value());
+	}
+
+	SECTION("with a file") {
+		test_helpers::Opts opts{"newsboat", "--profile-startup=startup.json"};
+		CliArgsParser args(opts.argc(), opts.argv());
+
+		REQUIRE(args.profile_startup());
+		REQUIRE(args.profile_startup_file() == "startup.json");
+	}
+
+	SECTION("not provided") {
+		test_helpers::Opts opts{"newsboat"};
+		CliArgsParser args(opts.argc(), opts.argv());
+
+		REQUIRE_FALSE(args.profile_startup());
+	}
+}
+
+TEST_CASE("Sets `trace_file` if --trace-file is provided", "[CliArgsParser]")
+{
+	const std::string filename("trace.json");
+
+	auto check = [&filename](test_helpers::Opts opts) {
+		CliArgsParser args(opts.argc(), opts.argv());
+
+		REQUIRE(args.trace_file() == filename);
+	};
+
+	SECTION("--trace-file <file>") {
+		check({"newsboat", "--trace-file", filename});
+	}
+
+	SECTION("--trace-file=<file>") {
+		check({"newsboat", "--trace-file=" + filename});
+	}
+}
+
 TEST_CASE("Sets `program_name` to the first string of the options list",
 	"[CliArgsParser]")
 {
@@ -300,6 +300,7 @@ TEST_CASE(
 		"datetime-format",
 		"delete-played-files",
 		"delete-read-articles-on-quit",
+		"description-memory-limit",
 		"dialogs-title-format",
 		"display-article-progress",
 		"dirbrowser-title-format",
@@ -710,3 +711,44 @@ TEST_CASE("get_article_sort_strategy() returns ascending direction "
 		REQUIRE(cfg.get_article_sort_strategy().sd == SortDirection::ASC);
 	}
 }
+
+TEST_CASE("snapshot() contains typed values of the settings",
+	"[ConfigContainer]")
+{
+	ConfigContainer cfg;
+
+	const auto defaults = cfg.snapshot();
+	REQUIRE(defaults->show_read_articles);
+	REQUIRE(defaults->max_items == 0);
+	REQUIRE_FALSE(defaults->ignore_mode_download);
+	REQUIRE(defaults->articlelist_format == cfg.get_configvalue("articlelist-format"));
+
+	SECTION("a new snapshot is published when a setting changes") {
+		cfg.set_configvalue("max-items", "42");
+		cfg.set_configvalue("ignore-mode", "download");
+		cfg.set_configvalue("article-sort-order", "title-desc");
+
+		const auto changed = cfg.snapshot();
+		REQUIRE(changed->version > defaults->version);
+		REQUIRE(changed->max_items == 42);
+		REQUIRE(changed->ignore_mode_download);
+		REQUIRE(changed->article_sort_strategy.sm == ArtSortMethod::TITLE);
+		REQUIRE(changed->article_sort_strategy.sd == SortDirection::DESC);
+
+		// Snapshots taken earlier keep the old values
+		REQUIRE(defaults->max_items == 0);
+	}
+
+	SECTION("toggle() and reset_to_default() publish a new snapshot") {
+		cfg.toggle("show-read-articles");
+		REQUIRE_FALSE(cfg.snapshot()->show_read_articles);
+
+		cfg.reset_to_default("show-read-articles");
+		REQUIRE(cfg.snapshot()->show_read_articles);
+	}
+
+	SECTION("settings from the config file are in the snapshot") {
+		cfg.handle_action("show-read-feeds", {"no"});
+		REQUIRE_FALSE(cfg.snapshot()->show_read_feeds);
+	}
+}
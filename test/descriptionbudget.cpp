@@ -0,0 +1,169 @@
+#include "descriptionbudget.h"
+
+#include "3rd-party/catch.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "feedretriever.h"
+#include "rssfeed.h"
+#include "rssitem.h"
+#include "rssparser.h"
+
+using namespace newsboat;
+
+TEST_CASE("DescriptionBudget evicts least recently used descriptions once "
+	"the limit is exceeded",
+	"[DescriptionBudget]")
+{
+	DescriptionBudget budget;
+
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string feedurl("file://data/rss.xml");
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(feedurl, rsscache, cfg, nullptr);
+	auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+	rsscache.externalize_rssfeed(feed, false);
+
+	auto& items = feed->items();
+	REQUIRE(items.size() >= 3);
+	const auto first_description = items[0]->description();
+	REQUIRE_FALSE(first_description.text.empty());
+
+	budget.touch(*items[0], 100);
+	budget.touch(*items[1], 100);
+	budget.touch(*items[0], 100);
+
+	auto stats = budget.stats();
+	REQUIRE(stats.descriptions == 2);
+	REQUIRE(stats.used_bytes == 200);
+	REQUIRE(stats.evictions == 0);
+
+	SECTION("no limit keeps everything") {
+		budget.touch(*items[2], 1000000);
+		stats = budget.stats();
+		REQUIRE(stats.descriptions == 3);
+		REQUIRE(stats.evictions == 0);
+	}
+
+	SECTION("limit drops the least recently used descriptions") {
+		budget.set_limit(250);
+		budget.touch(*items[2], 100);
+
+		stats = budget.stats();
+		REQUIRE(stats.descriptions == 2);
+		REQUIRE(stats.used_bytes == 200);
+		REQUIRE(stats.evictions == 1);
+
+		INFO("Evicted description is read back from the cache");
+		const auto description = items[1]->description();
+		REQUIRE(description.text == rsscache.fetch_description(*items[1]).text);
+		REQUIRE_FALSE(description.text.empty());
+
+		INFO("Descriptions that weren't evicted are still in memory");
+		REQUIRE(items[0]->description().text == first_description.text);
+	}
+
+	SECTION("most recently used description is kept even if it's over the limit") {
+		budget.set_limit(50);
+
+		stats = budget.stats();
+		REQUIRE(stats.descriptions == 1);
+		REQUIRE(stats.used_bytes == 100);
+		REQUIRE(stats.evictions == 1);
+		REQUIRE(items[0]->description().text == first_description.text);
+	}
+
+	SECTION("forgotten items are not evicted") {
+		budget.forget(*items[1]);
+		budget.set_limit(100);
+
+		stats = budget.stats();
+		REQUIRE(stats.descriptions == 1);
+		REQUIRE(stats.evictions == 0);
+	}
+}
+
+TEST_CASE("RssItem reports its description to the process-wide "
+	"DescriptionBudget once the cache has stored it",
+	"[DescriptionBudget]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	auto& budget = DescriptionBudget::instance();
+	const auto before = budget.stats();
+
+	auto item = std::make_shared<RssItem>(&rsscache);
+	item->set_description("Some content", "text/plain");
+
+	INFO("A description that isn't in the cache yet can't be evicted");
+	auto stats = budget.stats();
+	REQUIRE(stats.descriptions == before.descriptions);
+	item->description();
+	stats = budget.stats();
+	REQUIRE(stats.descriptions == before.descriptions);
+
+	item->set_description_stored({"Some content", "text/plain"});
+
+	stats = budget.stats();
+	REQUIRE(stats.descriptions == before.descriptions + 1);
+	REQUIRE(stats.used_bytes == before.used_bytes
+		+ std::string("Some content").size()
+		+ std::string("text/plain").size());
+
+	SECTION("unload() releases the description") {
+		item->unload();
+	}
+
+	SECTION("destruction releases the description") {
+		item.reset();
+	}
+
+	SECTION("a new description is released until it's stored") {
+		item->set_description("Other content", "text/plain");
+	}
+
+	stats = budget.stats();
+	REQUIRE(stats.descriptions == before.descriptions);
+	REQUIRE(stats.used_bytes == before.used_bytes);
+}
+
+TEST_CASE("Descriptions survive a reload that exceeds the DescriptionBudget",
+	"[DescriptionBudget]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string feedurl("file://data/rss.xml");
+	FeedRetriever feed_retriever(cfg, rsscache);
+	RssParser parser(feedurl, rsscache, cfg, nullptr);
+	rsscache.externalize_rssfeed(
+		parser.parse(feed_retriever.retrieve(feedurl)), false);
+
+	auto& budget = DescriptionBudget::instance();
+	const auto before = budget.stats();
+	struct LimitGuard {
+		~LimitGuard()
+		{
+			DescriptionBudget::instance().set_limit(0);
+		}
+	} limit_guard;
+	budget.set_limit(1);
+
+	// Reload: parse the feed again and write it over the stored one.
+	auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+	std::vector<std::string> expected;
+	for (const auto& item : feed->items()) {
+		expected.push_back(item->description().text);
+	}
+	REQUIRE(budget.stats().descriptions == before.descriptions);
+
+	rsscache.externalize_rssfeed(feed, true);
+
+	const auto& items = feed->items();
+	REQUIRE(items.size() == expected.size());
+	REQUIRE(budget.stats().evictions > before.evictions);
+	for (std::size_t i = 0; i < items.size(); ++i) {
+		INFO("Item " << i);
+		REQUIRE(rsscache.fetch_description(*items[i]).text == expected[i]);
+		REQUIRE(items[i]->description().text == expected[i]);
+	}
+}
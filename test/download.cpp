@@ -163,7 +163,8 @@ TEST_CASE("status_text() does not contain obvious copy-paste errors",
 		DlStatus::FAILED,
 		DlStatus::ALREADY_DOWNLOADED,
 		DlStatus::READY,
-		DlStatus::PLAYED
+		DlStatus::PLAYED,
+		DlStatus::PAUSED
 	};
 
 	SECTION("status_text returns a non-empty string for each possible status") {
@@ -0,0 +1,550 @@
+#include "downloadengine.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+#include "configcontainer.h"
+#include "test_helpers/httpserver.h"
+#include "test_helpers/tempdir.h"
+#include "test_helpers/tempfile.h"
+
+using namespace podboat;
+
+namespace {
+
+void wait_while_downloading(DownloadEngine& engine,
+	std::vector<Download>& downloads)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (downloads[0].status() == DlStatus::DOWNLOADING
+		&& std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		engine.poll(downloads);
+	}
+}
+
+std::string read_file(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(in),
+			std::istreambuf_iterator<char>());
+}
+
+/// Holds back the responses of a server until it's opened, so that tests
+/// can act on a transfer that is still running.
+class Gate {
+public:
+	void wait()
+	{
+		std::unique_lock<std::mutex> guard(mtx);
+		// Don't hold up the server's shutdown if a test fails early.
+		cv.wait_for(guard, std::chrono::seconds(10), [this]() {
+			return opened;
+		});
+	}
+
+	void open()
+	{
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			opened = true;
+		}
+		cv.notify_all();
+	}
+
+private:
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool opened = false;
+};
+
+/// Answers like a server that supports byte ranges, and counts the
+/// requests for a range.
+class RangeServer {
+public:
+	explicit RangeServer(const std::string& contents)
+		: contents(contents)
+		, server([this](const test_helpers::HttpServer::Request& request) {
+		return respond(request);
+	})
+	{
+	}
+
+	std::string get_url() const
+	{
+		return server.get_url() + "/episode.mp3";
+	}
+
+	/// Makes the first \a count requests for a range fail.
+	void fail_ranges(unsigned int count)
+	{
+		ranges_to_fail = count;
+	}
+
+	/// Answers requests for a range with the whole file, as some servers
+	/// do even though they claim to accept ranges.
+	void ignore_ranges()
+	{
+		ranges_ignored = true;
+	}
+
+	unsigned int range_requests() const
+	{
+		return ranges_requested;
+	}
+
+private:
+	test_helpers::HttpServer::Response respond(
+		const test_helpers::HttpServer::Request& request)
+	{
+		test_helpers::HttpServer::Response response;
+		response.content_type = "audio/mpeg";
+		response.headers["Accept-Ranges"] = "bytes";
+
+		const auto range = request.headers.find("range");
+		if (range == request.headers.end()) {
+			response.body = contents;
+			return response;
+		}
+
+		ranges_requested++;
+		if (ranges_ignored) {
+			response.body = contents;
+			return response;
+		}
+		if (ranges_to_fail > 0) {
+			ranges_to_fail--;
+			response.status = 500;
+			response.content_type = "text/plain";
+			response.body = "Try again later";
+			return response;
+		}
+
+		// "bytes=<first>-<last>"
+		const std::string spec = range->second.substr(6);
+		const auto dash = spec.find('-');
+		const std::size_t first = std::stoul(spec.substr(0, dash));
+		const std::size_t last = std::stoul(spec.substr(dash + 1));
+		response.status = 206;
+		response.headers["Content-Range"] = "bytes " + std::to_string(first)
+			+ "-" + std::to_string(last) + "/" + std::to_string(contents.size());
+		response.body = contents.substr(first, last - first + 1);
+		return response;
+	}
+
+	const std::string contents;
+	std::atomic<unsigned int> ranges_to_fail{0};
+	std::atomic<unsigned int> ranges_requested{0};
+	std::atomic<bool> ranges_ignored{false};
+	test_helpers::HttpServer server;
+};
+
+std::string make_episode(std::size_t size)
+{
+	std::string contents;
+	contents.reserve(size);
+	for (std::size_t i = 0; i < size; i++) {
+		contents.push_back('a' + i % 26);
+	}
+	return contents;
+}
+
+/// Gives the engine's thread time to act on a command.
+void let_engine_run(DownloadEngine& engine, std::vector<Download>& downloads)
+{
+	for (int i = 0; i < 20; i++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		engine.poll(downloads);
+	}
+}
+
+} // namespace
+
+TEST_CASE("DownloadEngine downloads the file and marks the download as ready",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	test_helpers::TempFile source;
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string contents(100000, 'x');
+	std::ofstream(source.get_path(), std::ios::binary) << contents;
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url("file://" + source.get_path());
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	wait_while_downloading(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::READY);
+	REQUIRE(read_file(target) == contents);
+	REQUIRE(::access((target + newsboat::ConfigContainer::PARTIAL_FILE_SUFFIX).c_str(),
+			F_OK) != 0);
+	REQUIRE(engine.progress()->empty());
+}
+
+TEST_CASE("DownloadEngine finishes downloads with every `download-fsync` policy",
+	"[DownloadEngine]")
+{
+	const std::string contents(3 * 1024 * 1024 + 1, 'y');
+	test_helpers::TempFile source;
+	std::ofstream(source.get_path(), std::ios::binary) << contents;
+
+	const std::vector<std::string> policies = {"no", "data", "full"};
+	for (const auto& policy : policies) {
+		INFO("download-fsync " << policy);
+
+		newsboat::ConfigContainer cfg;
+		cfg.set_configvalue("download-fsync", policy);
+		test_helpers::TempDir target_dir;
+		const std::string target = target_dir.get_path() + "episode.mp3";
+
+		std::vector<Download> downloads;
+		downloads.emplace_back([]() {});
+		downloads[0].set_url("file://" + source.get_path());
+		downloads[0].set_filename(target);
+
+		DownloadEngine engine(cfg);
+		downloads[0].set_status(DlStatus::DOWNLOADING);
+		engine.start(downloads[0]);
+		wait_while_downloading(engine, downloads);
+
+		REQUIRE(downloads[0].status() == DlStatus::READY);
+		REQUIRE(read_file(target) == contents);
+	}
+}
+
+TEST_CASE("DownloadEngine marks the download as failed if the URL can't be "
+	"retrieved",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	test_helpers::TempFile missing;
+	test_helpers::TempDir target_dir;
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url("file://" + missing.get_path());
+	downloads[0].set_filename(target_dir.get_path() + "episode.mp3");
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	wait_while_downloading(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::FAILED);
+	REQUIRE_FALSE(downloads[0].status_msg().empty());
+}
+
+TEST_CASE("DownloadEngine resumes segmented downloads from the resume map",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	test_helpers::TempFile source;
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string partial = target + newsboat::ConfigContainer::PARTIAL_FILE_SUFFIX;
+	const std::string resume_map = partial + DownloadEngine::RESUME_MAP_SUFFIX;
+
+	std::string contents;
+	for (int i = 0; i < 300000; i++) {
+		contents.push_back('a' + i % 26);
+	}
+	std::ofstream(source.get_path(), std::ios::binary) << contents;
+
+	// The first segment is partially downloaded, the second one hasn't been
+	// started, and the third one is complete. Whatever is still missing is
+	// filled with garbage, which the engine has to overwrite.
+	std::string partial_contents = contents.substr(0, 50000)
+		+ std::string(150000, '?')
+		+ contents.substr(200000);
+	std::ofstream(partial, std::ios::binary) << partial_contents;
+	std::ofstream(resume_map)
+			<< "300000\n"
+			<< "0 100000 50000\n"
+			<< "100000 200000 100000\n"
+			<< "200000 300000 300000\n";
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url("file://" + source.get_path());
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	wait_while_downloading(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::READY);
+	REQUIRE(read_file(target) == contents);
+	REQUIRE(::access(resume_map.c_str(), F_OK) != 0);
+}
+
+TEST_CASE("DownloadEngine splits large downloads into segments if the server "
+	"accepts byte ranges",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	cfg.set_configvalue("download-segments", "4");
+	// Over loopback, the whole response could otherwise arrive before the
+	// engine looks at the headers.
+	cfg.set_configvalue("max-download-speed", "50000");
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string partial = target + newsboat::ConfigContainer::PARTIAL_FILE_SUFFIX;
+	// Segments are at least 4 MiB, so this makes for two of them.
+	const std::string contents = make_episode(9 * 1024 * 1024 + 123);
+	RangeServer server(contents);
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url(server.get_url());
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	wait_while_downloading(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::READY);
+	REQUIRE(server.range_requests() == 1);
+	REQUIRE(read_file(target) == contents);
+	REQUIRE(::access((partial + DownloadEngine::RESUME_MAP_SUFFIX).c_str(),
+			F_OK) != 0);
+}
+
+TEST_CASE("DownloadEngine gets the file right however much of it arrived "
+	"before the split",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	cfg.set_configvalue("download-segments", "4");
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string contents = make_episode(17 * 1024 * 1024 + 321);
+	RangeServer server(contents);
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url(server.get_url());
+	downloads[0].set_filename(target);
+
+	// Without a speed limit, loopback is fast enough for the first response
+	// to be anywhere by the time the engine looks at its headers.
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	wait_while_downloading(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::READY);
+	REQUIRE(read_file(target) == contents);
+}
+
+TEST_CASE("DownloadEngine goes back to a single stream if the server answers "
+	"range requests with the whole file",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	cfg.set_configvalue("download-segments", "4");
+	cfg.set_configvalue("max-download-speed", "50000");
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string partial = target + newsboat::ConfigContainer::PARTIAL_FILE_SUFFIX;
+	const std::string contents = make_episode(9 * 1024 * 1024 + 123);
+	RangeServer server(contents);
+	server.ignore_ranges();
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url(server.get_url());
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	wait_while_downloading(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::READY);
+	REQUIRE(server.range_requests() >= 1);
+	REQUIRE(read_file(target) == contents);
+	REQUIRE(::access((partial + DownloadEngine::RESUME_MAP_SUFFIX).c_str(),
+			F_OK) != 0);
+}
+
+TEST_CASE("DownloadEngine retries a failed segment a few times before giving up",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	cfg.set_configvalue("download-segments", "2");
+	cfg.set_configvalue("max-download-speed", "50000");
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string contents = make_episode(9 * 1024 * 1024);
+	RangeServer server(contents);
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url(server.get_url());
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+
+	SECTION("a segment that fails now and then is restarted") {
+		server.fail_ranges(2);
+
+		downloads[0].set_status(DlStatus::DOWNLOADING);
+		engine.start(downloads[0]);
+		wait_while_downloading(engine, downloads);
+
+		REQUIRE(downloads[0].status() == DlStatus::READY);
+		REQUIRE(server.range_requests() == 3);
+		REQUIRE(read_file(target) == contents);
+	}
+
+	SECTION("the download fails once a segment failed too often") {
+		server.fail_ranges(100);
+
+		downloads[0].set_status(DlStatus::DOWNLOADING);
+		engine.start(downloads[0]);
+		wait_while_downloading(engine, downloads);
+
+		REQUIRE(downloads[0].status() == DlStatus::FAILED);
+		INFO("The first attempt, and three retries");
+		REQUIRE(server.range_requests() == 4);
+		REQUIRE(::access(target.c_str(), F_OK) != 0);
+	}
+}
+
+TEST_CASE("DownloadEngine doesn't receive anything while a download is paused",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string contents(100000, 'p');
+
+	Gate gate;
+	test_helpers::HttpServer server([&](const test_helpers::HttpServer::Request&) {
+		gate.wait();
+		test_helpers::HttpServer::Response response;
+		response.content_type = "audio/mpeg";
+		response.body = contents;
+		return response;
+	});
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url(server.get_url() + "/episode.mp3");
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	downloads[0].set_status(DlStatus::PAUSED);
+	engine.pause(downloads[0]);
+	let_engine_run(engine, downloads);
+
+	gate.open();
+	let_engine_run(engine, downloads);
+	REQUIRE(downloads[0].status() == DlStatus::PAUSED);
+	REQUIRE(::access(target.c_str(), F_OK) != 0);
+
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.resume(downloads[0]);
+	wait_while_downloading(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::READY);
+	REQUIRE(read_file(target) == contents);
+}
+
+TEST_CASE("DownloadEngine stops a cancelled download and keeps its partial file",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	const std::string partial = target + newsboat::ConfigContainer::PARTIAL_FILE_SUFFIX;
+
+	Gate gate;
+	test_helpers::HttpServer server([&](const test_helpers::HttpServer::Request&) {
+		gate.wait();
+		test_helpers::HttpServer::Response response;
+		response.content_type = "audio/mpeg";
+		response.body = std::string(100000, 'c');
+		return response;
+	});
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url(server.get_url() + "/episode.mp3");
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+	let_engine_run(engine, downloads);
+
+	downloads[0].set_status(DlStatus::CANCELLED);
+	engine.cancel(downloads[0]);
+	gate.open();
+	let_engine_run(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::CANCELLED);
+	REQUIRE(::access(target.c_str(), F_OK) != 0);
+	REQUIRE(::access(partial.c_str(), F_OK) == 0);
+	REQUIRE(engine.progress()->empty());
+}
+
+TEST_CASE("A download cancelled just as it finishes stays cancelled",
+	"[DownloadEngine]")
+{
+	newsboat::ConfigContainer cfg;
+	test_helpers::TempFile source;
+	test_helpers::TempDir target_dir;
+	const std::string target = target_dir.get_path() + "episode.mp3";
+	std::ofstream(source.get_path(), std::ios::binary) << std::string(1000, 'r');
+
+	std::vector<Download> downloads;
+	downloads.emplace_back([]() {});
+	downloads[0].set_url("file://" + source.get_path());
+	downloads[0].set_filename(target);
+
+	DownloadEngine engine(cfg);
+	downloads[0].set_status(DlStatus::DOWNLOADING);
+	engine.start(downloads[0]);
+
+	// Let the engine finish, but don't poll() for the outcome yet.
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while ((::access(target.c_str(), F_OK) != 0 || !engine.progress()->empty())
+		&& std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	downloads[0].set_status(DlStatus::CANCELLED);
+	engine.cancel(downloads[0]);
+	let_engine_run(engine, downloads);
+
+	REQUIRE(downloads[0].status() == DlStatus::CANCELLED);
+
+	SECTION("the download can be started again afterwards") {
+		::unlink(target.c_str());
+		downloads[0].set_status(DlStatus::DOWNLOADING);
+		engine.start(downloads[0]);
+		wait_while_downloading(engine, downloads);
+
+		REQUIRE(downloads[0].status() == DlStatus::READY);
+	}
+}
@@ -6,7 +6,9 @@
 #include "cache.h"
 #include "configcontainer.h"
 #include "feedcontainer.h"
+#include "feedretriever.h"
 #include "rssfeed.h"
+#include "rssparser.h"
 
 #include "3rd-party/catch.hpp"
 
@@ -101,6 +103,127 @@ TEST_CASE("populate_query_feeds() populates query feeds", "[FeedContainer]")
 	REQUIRE(feeds[5]->total_item_count() == 5);
 }
 
+TEST_CASE("populate_query_feeds() only loads the feeds that a query could "
+	"take items from",
+	"[FeedContainer]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	const std::vector<std::string> feedurls = {
+		"file://data/rss.xml",
+		"file://data/atom10_1.xml",
+	};
+	for (const auto& feedurl : feedurls) {
+		FeedRetriever feed_retriever(cfg, rsscache);
+		RssParser parser(feedurl, rsscache, cfg, nullptr);
+		const auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+		rsscache.externalize_rssfeed(feed, false);
+	}
+
+	const auto summaries = rsscache.fetch_feed_summaries();
+	std::vector<std::shared_ptr<RssFeed>> feeds;
+	for (const auto& feedurl : feedurls) {
+		feeds.push_back(rsscache.internalize_rssfeed_summary(feedurl,
+				summaries));
+	}
+
+	SECTION("Nothing is loaded if there are no query feeds") {
+		FeedContainer feedcontainer;
+		feedcontainer.set_feeds(feeds);
+		feedcontainer.enable_lazy_loading(&rsscache, nullptr, 0);
+
+		feedcontainer.populate_query_feeds();
+
+		REQUIRE_FALSE(feeds[0]->items_loaded());
+		REQUIRE_FALSE(feeds[1]->items_loaded());
+	}
+
+	SECTION("Feeds that the query rules out are not loaded") {
+		const auto query = std::make_shared<RssFeed>(&rsscache,
+				"query:From Atom:rssurl = \"file://data/atom10_1.xml\" "
+				"and unread = \"yes\"");
+		feeds.push_back(query);
+
+		FeedContainer feedcontainer;
+		feedcontainer.set_feeds(feeds);
+		feedcontainer.enable_lazy_loading(&rsscache, nullptr, 0);
+
+		feedcontainer.populate_query_feeds();
+
+		REQUIRE_FALSE(feeds[0]->items_loaded());
+		REQUIRE(feeds[1]->items_loaded());
+		REQUIRE(query->total_item_count() == 3);
+	}
+
+	SECTION("Feeds without unread items are not loaded for a query that "
+		"needs them") {
+		rsscache.mark_all_read(feedurls[1]);
+		const auto read_summaries = rsscache.fetch_feed_summaries();
+		feeds[1] = rsscache.internalize_rssfeed_summary(feedurls[1],
+				read_summaries);
+		REQUIRE(feeds[1]->unread_item_count() == 0);
+
+		const auto query = std::make_shared<RssFeed>(&rsscache,
+				"query:Unread:unread = \"yes\"");
+		feeds.push_back(query);
+
+		FeedContainer feedcontainer;
+		feedcontainer.set_feeds(feeds);
+		feedcontainer.enable_lazy_loading(&rsscache, nullptr, 0);
+
+		feedcontainer.populate_query_feeds();
+
+		REQUIRE(feeds[0]->items_loaded());
+		REQUIRE_FALSE(feeds[1]->items_loaded());
+		REQUIRE(query->total_item_count() == 8);
+	}
+}
+
+TEST_CASE("update_query_feed() only loads the feeds that the query could "
+	"take items from, and stays within the limit",
+	"[FeedContainer]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	const std::vector<std::string> feedurls = {
+		"file://data/rss.xml",
+		"file://data/atom10_1.xml",
+	};
+	for (const auto& feedurl : feedurls) {
+		FeedRetriever feed_retriever(cfg, rsscache);
+		RssParser parser(feedurl, rsscache, cfg, nullptr);
+		const auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+		rsscache.externalize_rssfeed(feed, false);
+	}
+
+	const auto summaries = rsscache.fetch_feed_summaries();
+	std::vector<std::shared_ptr<RssFeed>> feeds;
+	for (const auto& feedurl : feedurls) {
+		feeds.push_back(rsscache.internalize_rssfeed_summary(feedurl,
+				summaries));
+	}
+	const auto query = std::make_shared<RssFeed>(&rsscache,
+			"query:From Atom:rssurl = \"file://data/atom10_1.xml\"");
+	feeds.push_back(query);
+
+	FeedContainer feedcontainer;
+	feedcontainer.set_feeds(feeds);
+	feedcontainer.enable_lazy_loading(&rsscache, nullptr, 3);
+
+	feedcontainer.load_feed_items(feeds[0]);
+	REQUIRE(feeds[0]->items_loaded());
+
+	feedcontainer.update_query_feed(query);
+
+	REQUIRE(query->total_item_count() == 3);
+	REQUIRE(feeds[1]->items_loaded());
+	INFO("The query can't take items from the first feed, so it got unloaded");
+	REQUIRE_FALSE(feeds[0]->items_loaded());
+	REQUIRE(feeds[0]->total_item_count() == 8);
+}
+
 TEST_CASE("set_feeds() sets FeedContainer's feed vector to the given one",
 	"[FeedContainer]")
 {
@@ -1409,3 +1532,47 @@ TEST_CASE("replace_feed() puts given feed into the specified position",
 	REQUIRE(feed_before_replacement != feed_after_replacement);
 	REQUIRE(feed_after_replacement == first_feed);
 }
+
+TEST_CASE("load_feed_items() loads items of the feed and unloads least "
+	"recently used feeds to stay within the limit",
+	"[FeedContainer]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	const std::vector<std::string> feedurls = {
+		"file://data/rss.xml",
+		"file://data/atom10_1.xml",
+	};
+	for (const auto& feedurl : feedurls) {
+		FeedRetriever feed_retriever(cfg, rsscache);
+		RssParser parser(feedurl, rsscache, cfg, nullptr);
+		const auto feed = parser.parse(feed_retriever.retrieve(feedurl));
+		rsscache.externalize_rssfeed(feed, false);
+	}
+
+	const auto summaries = rsscache.fetch_feed_summaries();
+	std::vector<std::shared_ptr<RssFeed>> feeds;
+	for (const auto& feedurl : feedurls) {
+		feeds.push_back(rsscache.internalize_rssfeed_summary(feedurl,
+				summaries));
+	}
+
+	FeedContainer feedcontainer;
+	feedcontainer.set_feeds(feeds);
+	feedcontainer.enable_lazy_loading(&rsscache, nullptr, 10);
+	REQUIRE(feedcontainer.unread_item_count() == 11);
+
+	feedcontainer.load_feed_items(feeds[0]);
+	REQUIRE(feeds[0]->items_loaded());
+	REQUIRE(feeds[0]->items().size() == 8);
+	REQUIRE_FALSE(feeds[1]->items_loaded());
+
+	feedcontainer.load_feed_items(feeds[1]);
+	REQUIRE(feeds[1]->items_loaded());
+	REQUIRE(feeds[1]->items().size() == 3);
+	INFO("The first feed was used least recently, so it got unloaded");
+	REQUIRE_FALSE(feeds[0]->items_loaded());
+	REQUIRE(feeds[0]->total_item_count() == 8);
+	REQUIRE(feedcontainer.unread_item_count() == 11);
+}
@@ -0,0 +1,174 @@
+#include "feedlistsnapshot.h"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+#include "3rd-party/catch.hpp"
+#include "configcontainer.h"
+#include "rssfeed.h"
+#include "test_helpers/tempfile.h"
+
+using namespace newsboat;
+
+namespace {
+
+FeedSummaries sample_summaries()
+{
+	FeedSummaries summaries;
+	summaries["https://example.com/feed.xml"] =
+		FeedSummary{"Example feed", "https://example.com/", false, 42, 7, 1600000000};
+	summaries["https://example.com/rtl.xml"] =
+		FeedSummary{"", "", true, 0, 0, 0};
+	return summaries;
+}
+
+} // namespace
+
+TEST_CASE("FeedListSnapshot::read() returns what write() wrote",
+	"[FeedListSnapshot]")
+{
+	test_helpers::TempFile snapshot;
+	const FeedListSnapshot::Key key{12, 1600000000, 99};
+	const auto summaries = sample_summaries();
+
+	REQUIRE(FeedListSnapshot::write(snapshot.get_path(), key, summaries, 0));
+
+	const auto result = FeedListSnapshot::read(snapshot.get_path(), key,
+			1700000000);
+	REQUIRE(result);
+	REQUIRE(result->size() == 2);
+
+	const auto& feed = result->at("https://example.com/feed.xml");
+	REQUIRE(feed.title == "Example feed");
+	REQUIRE(feed.link == "https://example.com/");
+	REQUIRE_FALSE(feed.is_rtl);
+	REQUIRE(feed.total_count == 42);
+	REQUIRE(feed.unread_count == 7);
+	REQUIRE(feed.latest_item_timestamp == 1600000000);
+
+	const auto& rtl_feed = result->at("https://example.com/rtl.xml");
+	REQUIRE(rtl_feed.title.empty());
+	REQUIRE(rtl_feed.is_rtl);
+}
+
+TEST_CASE("FeedListSnapshot::read() ignores snapshots written for another key",
+	"[FeedListSnapshot]")
+{
+	test_helpers::TempFile snapshot;
+	const FeedListSnapshot::Key key{12, 1600000000, 99};
+	REQUIRE(FeedListSnapshot::write(snapshot.get_path(), key,
+			sample_summaries(), 0));
+
+	SECTION("cache changed") {
+		const FeedListSnapshot::Key other{13, 1600000000, 99};
+		REQUIRE_FALSE(FeedListSnapshot::read(snapshot.get_path(), other, 0));
+	}
+
+	SECTION("urls file changed") {
+		const FeedListSnapshot::Key other{12, 1600000001, 99};
+		REQUIRE_FALSE(FeedListSnapshot::read(snapshot.get_path(), other, 0));
+	}
+
+	SECTION("settings changed") {
+		const FeedListSnapshot::Key other{12, 1600000000, 100};
+		REQUIRE_FALSE(FeedListSnapshot::read(snapshot.get_path(), other, 0));
+	}
+}
+
+TEST_CASE("FeedListSnapshot::read() ignores snapshots once an article they "
+	"count has expired", "[FeedListSnapshot]")
+{
+	test_helpers::TempFile snapshot;
+	const FeedListSnapshot::Key key{12, 1600000000, 99};
+	REQUIRE(FeedListSnapshot::write(snapshot.get_path(), key,
+			sample_summaries(), 1700000000));
+
+	REQUIRE(FeedListSnapshot::read(snapshot.get_path(), key, 1699999999));
+	REQUIRE_FALSE(FeedListSnapshot::read(snapshot.get_path(), key, 1700000000));
+}
+
+TEST_CASE("FeedListSnapshot::read() rejects missing and malformed files",
+	"[FeedListSnapshot]")
+{
+	test_helpers::TempFile snapshot;
+	const FeedListSnapshot::Key key{12, 1600000000, 99};
+
+	SECTION("missing file") {
+		REQUIRE_FALSE(FeedListSnapshot::read(snapshot.get_path(), key, 0));
+	}
+
+	SECTION("not a snapshot") {
+		std::ofstream(snapshot.get_path()) << "this is not a snapshot";
+		REQUIRE_FALSE(FeedListSnapshot::read(snapshot.get_path(), key, 0));
+	}
+
+	SECTION("truncated snapshot") {
+		REQUIRE(FeedListSnapshot::write(snapshot.get_path(), key,
+				sample_summaries(), 0));
+
+		std::string contents;
+		{
+			std::ifstream in(snapshot.get_path(), std::ios::binary);
+			contents.assign(std::istreambuf_iterator<char>(in),
+				std::istreambuf_iterator<char>());
+		}
+		contents.resize(contents.size() - 5);
+		std::ofstream(snapshot.get_path(), std::ios::binary) << contents;
+
+		REQUIRE_FALSE(FeedListSnapshot::read(snapshot.get_path(), key, 0));
+	}
+}
+
+TEST_CASE("FeedListSnapshot::current_key() changes when the cache is modified",
+	"[FeedListSnapshot]")
+{
+	test_helpers::TempFile cachefile;
+	test_helpers::TempFile urlfile;
+	std::ofstream(urlfile.get_path()) << "https://example.com/feed.xml\n";
+
+	ConfigContainer cfg;
+	std::unique_ptr<Cache> rsscache(new Cache(cachefile.get_path(), &cfg));
+
+	const auto before = FeedListSnapshot::current_key(cachefile.get_path(),
+			urlfile.get_path(), cfg);
+	REQUIRE(before == FeedListSnapshot::current_key(cachefile.get_path(),
+			urlfile.get_path(), cfg));
+
+	rsscache->externalize_rssfeed(
+		std::make_shared<RssFeed>(rsscache.get(), "https://example.com/feed.xml"),
+		false);
+
+	const auto after = FeedListSnapshot::current_key(cachefile.get_path(),
+			urlfile.get_path(), cfg);
+	REQUIRE_FALSE(before == after);
+}
+
+TEST_CASE("FeedListSnapshot::current_key() changes with the settings that "
+	"affect the counts", "[FeedListSnapshot]")
+{
+	test_helpers::TempFile cachefile;
+	test_helpers::TempFile urlfile;
+	ConfigContainer cfg;
+	const auto before = FeedListSnapshot::current_key(cachefile.get_path(),
+			urlfile.get_path(), cfg);
+
+	for (const std::string setting : {
+			"max-items", "keep-articles-days"
+		}) {
+		INFO("setting: " << setting);
+		cfg.set_configvalue(setting, "30");
+		REQUIRE_FALSE(before == FeedListSnapshot::current_key(cachefile.get_path(),
+				urlfile.get_path(), cfg));
+		cfg.reset_to_default(setting);
+	}
+
+	cfg.set_configvalue("ignore-mode", "display");
+	REQUIRE_FALSE(before == FeedListSnapshot::current_key(cachefile.get_path(),
+			urlfile.get_path(), cfg));
+	cfg.reset_to_default("ignore-mode");
+
+	cfg.set_configvalue("show-read-feeds", "no");
+	REQUIRE(before == FeedListSnapshot::current_key(cachefile.get_path(),
+			urlfile.get_path(), cfg));
+}
@@ -0,0 +1,50 @@
+#include "internedstring.h"
+
+#include "3rd-party/catch.hpp"
+
+using namespace newsboat;
+
+TEST_CASE("InternedString holds the value it was constructed from",
+	"[InternedString]")
+{
+	REQUIRE(InternedString().str() == "");
+	REQUIRE(InternedString().empty());
+
+	const InternedString s("audio/mpeg");
+	REQUIRE(s.str() == "audio/mpeg");
+	REQUIRE_FALSE(s.empty());
+}
+
+TEST_CASE("InternedStrings with the same value share storage",
+	"[InternedString]")
+{
+	const InternedString a("https://example.com/feed.xml");
+	const InternedString b(std::string("https://example.com/") + "feed.xml");
+	const InternedString c("https://example.com/other.xml");
+
+	REQUIRE(&a.str() == &b.str());
+	REQUIRE(a == b);
+
+	REQUIRE(&a.str() != &c.str());
+	REQUIRE(a != c);
+
+	REQUIRE(InternedString("") == InternedString());
+}
+
+TEST_CASE("InternedString::purge_unused() drops values nobody refers to",
+	"[InternedString]")
+{
+	InternedString::purge_unused();
+	const auto initial_size = InternedString::pool_size();
+
+	{
+		const InternedString temporary("a value only used in this test");
+		REQUIRE(InternedString::pool_size() == initial_size + 1);
+
+		InternedString::purge_unused();
+		REQUIRE(InternedString::pool_size() == initial_size + 1);
+	}
+
+	InternedString::purge_unused();
+	REQUIRE(InternedString::pool_size() == initial_size);
+}
@@ -0,0 +1,123 @@
+#include "itemstore.h"
+
+#include <thread>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+
+using namespace newsboat;
+
+TEST_CASE("ItemStore::allocate() returns an unread item with zeroed fields",
+	"[ItemStore]")
+{
+	ItemStore store;
+	const auto handle = store.allocate();
+
+	REQUIRE(store.pub_date(handle) == 0);
+	REQUIRE(store.size(handle) == 0);
+	REQUIRE(store.index(handle) == 0);
+	REQUIRE(store.unread(handle));
+	REQUIRE_FALSE(store.enqueued(handle));
+	REQUIRE_FALSE(store.deleted(handle));
+	REQUIRE_FALSE(store.override_unread(handle));
+	REQUIRE(store.item_count() == 1);
+}
+
+TEST_CASE("ItemStore keeps the fields of each item separate", "[ItemStore]")
+{
+	ItemStore store;
+	const auto a = store.allocate();
+	const auto b = store.allocate();
+
+	store.set_pub_date(a, 1000);
+	store.set_size(a, 42);
+	store.set_index(a, 7);
+	store.set_unread(a, false);
+	store.set_enqueued(a, true);
+	store.set_deleted(a, true);
+	store.set_override_unread(a, true);
+
+	REQUIRE(store.pub_date(a) == 1000);
+	REQUIRE(store.size(a) == 42);
+	REQUIRE(store.index(a) == 7);
+	REQUIRE_FALSE(store.unread(a));
+	REQUIRE(store.enqueued(a));
+	REQUIRE(store.deleted(a));
+	REQUIRE(store.override_unread(a));
+
+	REQUIRE(store.pub_date(b) == 0);
+	REQUIRE(store.size(b) == 0);
+	REQUIRE(store.index(b) == 0);
+	REQUIRE(store.unread(b));
+	REQUIRE_FALSE(store.enqueued(b));
+	REQUIRE_FALSE(store.deleted(b));
+	REQUIRE_FALSE(store.override_unread(b));
+
+	SECTION("Flags don't affect each other") {
+		store.set_deleted(a, false);
+		REQUIRE(store.enqueued(a));
+		REQUIRE_FALSE(store.deleted(a));
+		REQUIRE(store.override_unread(a));
+	}
+}
+
+TEST_CASE("ItemStore reuses released slots, and resets their fields",
+	"[ItemStore]")
+{
+	ItemStore store;
+	const auto a = store.allocate();
+	store.set_pub_date(a, 1000);
+	store.set_unread(a, false);
+	store.release(a);
+	REQUIRE(store.item_count() == 0);
+
+	const auto b = store.allocate();
+	REQUIRE(b.slot == a.slot);
+	REQUIRE(store.pub_date(b) == 0);
+	REQUIRE(store.unread(b));
+	REQUIRE(store.item_count() == 1);
+}
+
+TEST_CASE("ItemStore grows past a single block", "[ItemStore]")
+{
+	ItemStore store;
+	const auto initial_usage = store.memory_usage();
+
+	std::vector<ItemHandle> handles;
+	for (unsigned int i = 0; i < 40000; ++i) {
+		handles.push_back(store.allocate());
+		store.set_index(handles.back(), i);
+	}
+
+	REQUIRE(store.memory_usage() > initial_usage);
+	for (unsigned int i = 0; i < handles.size(); ++i) {
+		REQUIRE(store.index(handles[i]) == i);
+	}
+}
+
+TEST_CASE("ItemStore::lock() excludes other threads without touching the "
+	"item's state", "[ItemStore]")
+{
+	ItemStore store;
+	const auto handle = store.allocate();
+	store.set_enqueued(handle, true);
+
+	unsigned int counter = 0;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&]() {
+			for (int i = 0; i < 10000; ++i) {
+				store.lock(handle);
+				counter++;
+				store.unlock(handle);
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	REQUIRE(counter == 40000);
+	REQUIRE(store.unread(handle));
+	REQUIRE(store.enqueued(handle));
+}
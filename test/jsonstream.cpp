@@ -0,0 +1,84 @@
+#include "jsonstream.h"
+
+#include <string>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+
+using namespace newsboat;
+using nlohmann::json;
+
+TEST_CASE("jsonstream::parse() passes the elements of the array under the "
+	"given key on one by one, and leaves them out of the result",
+	"[jsonstream]")
+{
+	const std::string input = R"({
+		"status": 0,
+		"items": [
+			{"id": 1, "items": [10, 11]},
+			"two",
+			[3],
+			{"id": 4, "tags": {"items": [40]}}
+		],
+		"continuation": "abc"
+	})";
+
+	std::vector<json> elements;
+	const json rest = jsonstream::parse(input, "items", [&](json&& element) {
+		elements.push_back(std::move(element));
+	});
+
+	REQUIRE(elements.size() == 4);
+	REQUIRE(elements[0] == json::parse(R"({"id": 1, "items": [10, 11]})"));
+	REQUIRE(elements[1] == "two");
+	REQUIRE(elements[2] == json::parse("[3]"));
+	REQUIRE(elements[3] == json::parse(R"({"id": 4, "tags": {"items": [40]}})"));
+
+	REQUIRE(rest == json::parse(R"({
+		"status": 0,
+		"items": [],
+		"continuation": "abc"
+	})"));
+}
+
+TEST_CASE("jsonstream::parse() treats the whole input as the array if the key "
+	"is empty",
+	"[jsonstream]")
+{
+	std::vector<json> elements;
+	const json rest = jsonstream::parse(R"([{"id": 1}, {"id": 2}])", "",
+	[&](json&& element) {
+		elements.push_back(std::move(element));
+	});
+
+	REQUIRE(elements.size() == 2);
+	REQUIRE(elements[1]["id"] == 2);
+	REQUIRE(rest == json::array());
+}
+
+TEST_CASE("jsonstream::parse() leaves other values alone", "[jsonstream]")
+{
+	const std::vector<std::string> inputs = {
+		R"({"error": "NOT_LOGGED_IN"})",
+		R"({"items": {"id": 1}})",
+		R"({"other": [1, 2]})",
+		R"([1, 2])",
+	};
+	for (const auto& input : inputs) {
+		INFO("input: " << input);
+
+		bool called = false;
+		const json rest = jsonstream::parse(input, "items", [&](json&&) {
+			called = true;
+		});
+
+		REQUIRE_FALSE(called);
+		REQUIRE(rest == json::parse(input));
+	}
+}
+
+TEST_CASE("jsonstream::parse() throws on invalid JSON", "[jsonstream]")
+{
+	REQUIRE_THROWS_AS(jsonstream::parse(R"({"items": [{"id": 1},)", "items",
+	[](json&&) {}), json::parse_error);
+}
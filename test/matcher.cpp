@@ -851,6 +851,37 @@ TEST_CASE("Whitespace before and/or is not required", "[Matcher]")
 	REQUIRE(m.matches(&mock));
 }
 
+TEST_CASE("may_match() only rules out a match if the known attributes do",
+	"[Matcher]")
+{
+	MatcherMockMatchable mock({{"x", "42"}});
+	Matcher m;
+
+	SECTION("Unknown attributes could have any value") {
+		REQUIRE(m.parse("y = 0"));
+		REQUIRE(m.may_match(&mock));
+
+		REQUIRE(m.parse("y = 0 and x = 42"));
+		REQUIRE(m.may_match(&mock));
+	}
+
+	SECTION("A known attribute that doesn't match rules out a conjunction") {
+		REQUIRE(m.parse("y = 0 and x = 43"));
+		REQUIRE_FALSE(m.may_match(&mock));
+
+		REQUIRE(m.parse("(y = 0 or y = 1) and x != 42"));
+		REQUIRE_FALSE(m.may_match(&mock));
+	}
+
+	SECTION("A disjunction can match as long as one of its sides can") {
+		REQUIRE(m.parse("y = 0 or x = 43"));
+		REQUIRE(m.may_match(&mock));
+
+		REQUIRE(m.parse("x = 41 or x = 43"));
+		REQUIRE_FALSE(m.may_match(&mock));
+	}
+}
+
 TEST_CASE("string_to_num() converts numeric prefix of the string to int",
 	"[Matcher]")
 {
@@ -0,0 +1,84 @@
+#include "memoryreport.h"
+
+#include <memory>
+#include <string>
+
+#include "3rd-party/catch.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "feedcontainer.h"
+#include "rssfeed.h"
+#include "rssitem.h"
+
+using namespace newsboat;
+
+TEST_CASE("heap_usage() counts only memory allocated outside the string",
+	"[MemoryReport]")
+{
+	REQUIRE(heap_usage(std::string()) == 0);
+	REQUIRE(heap_usage(std::string("short")) == 0);
+
+	const std::string long_string(1000, 'x');
+	REQUIRE(heap_usage(long_string) > 1000);
+}
+
+TEST_CASE("MemoryReport accounts feeds by subsystem and orders them by size",
+	"[MemoryReport]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+
+	auto small_feed = std::make_shared<RssFeed>(&rsscache, "https://example.com/small.xml");
+	small_feed->set_title("Small feed");
+	auto big_feed = std::make_shared<RssFeed>(&rsscache, "https://example.com/big.xml");
+	big_feed->set_title("Big feed");
+	for (int i = 0; i < 10; ++i) {
+		auto item = std::make_shared<RssItem>(&rsscache);
+		item->set_guid("https://example.com/big/" + std::to_string(i));
+		item->set_description(std::string(1000, 'x'), "text/html");
+		big_feed->add_item(item);
+	}
+
+	auto query_feed = std::make_shared<RssFeed>(&rsscache, "query:Everything:unread = \"yes\"");
+	query_feed->add_items(big_feed->items());
+
+	FeedContainer feedcontainer;
+	feedcontainer.set_feeds({small_feed, big_feed, query_feed});
+
+	const MemoryReport report(feedcontainer);
+
+	const auto big_usage = big_feed->memory_usage();
+	REQUIRE(big_usage.descriptions >= 10 * 1000);
+	REQUIRE(big_usage.guid_maps > 0);
+	REQUIRE(big_usage.query_feed_membership == 0);
+
+	const auto query_usage = query_feed->memory_usage();
+	INFO("Query feeds don't own their items");
+	REQUIRE(query_usage.descriptions == 0);
+	REQUIRE(query_usage.guid_maps == 0);
+	REQUIRE(query_usage.query_feed_membership > 0);
+
+	const auto& totals = report.feed_totals();
+	REQUIRE(totals.descriptions == big_usage.descriptions);
+	REQUIRE(totals.query_feed_membership == query_usage.query_feed_membership);
+	REQUIRE(report.total() >= totals.total());
+
+	REQUIRE(report.feeds().size() == 3);
+	REQUIRE(report.feeds()[0].title == "Big feed");
+	REQUIRE(report.feeds()[0].item_count == 10);
+
+	SECTION("format() can limit the number of feeds listed") {
+		const auto all_lines = report.format();
+		const auto limited_lines = report.format(1);
+		REQUIRE(limited_lines.size() == all_lines.size() - 1);
+	}
+}
+
+TEST_CASE("MemoryReport::format_bytes() picks a suitable unit",
+	"[MemoryReport]")
+{
+	REQUIRE(MemoryReport::format_bytes(0) == "0 B");
+	REQUIRE(MemoryReport::format_bytes(1023) == "1023 B");
+	REQUIRE(MemoryReport::format_bytes(1536) == "1.5 KiB");
+	REQUIRE(MemoryReport::format_bytes(3 * 1024 * 1024) == "3.0 MiB");
+}
@@ -0,0 +1,133 @@
+#include "queuefile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "3rd-party/catch.hpp"
+#include "test_helpers/misc.h"
+#include "test_helpers/tempfile.h"
+
+using namespace newsboat;
+
+TEST_CASE("read_new_lines() returns only the lines added since the previous "
+	"call",
+	"[QueueFile]")
+{
+	test_helpers::TempFile queue_path;
+	QueueFile queue_file(queue_path.get_path());
+
+	SECTION("A missing file reads as empty") {
+		const auto update = queue_file.read_new_lines();
+		REQUIRE(update.from_start);
+		REQUIRE(update.lines.empty());
+		REQUIRE_FALSE(test_helpers::file_exists(queue_path.get_path()));
+	}
+
+	std::ofstream(queue_path.get_path()) << "first\nsecond\n";
+
+	auto update = queue_file.read_new_lines();
+	REQUIRE(update.from_start);
+	REQUIRE(update.lines == std::vector<std::string>({"first", "second"}));
+
+	update = queue_file.read_new_lines();
+	REQUIRE_FALSE(update.from_start);
+	REQUIRE(update.lines.empty());
+
+	SECTION("Appended lines are returned on their own") {
+		REQUIRE(queue_file.append_line("third"));
+		std::ofstream(queue_path.get_path(), std::ios::app) << "fourth\n";
+
+		update = queue_file.read_new_lines();
+		REQUIRE_FALSE(update.from_start);
+		REQUIRE(update.lines == std::vector<std::string>({"third", "fourth"}));
+	}
+
+	SECTION("The file is read from the start if it was replaced") {
+		const std::string other_path = queue_path.get_path() + ".other";
+		std::ofstream(other_path) << "first\nsecond\nthird\n";
+		REQUIRE(std::rename(other_path.c_str(), queue_path.get_path().c_str()) == 0);
+
+		update = queue_file.read_new_lines();
+		REQUIRE(update.from_start);
+		REQUIRE(update.lines.size() == 3);
+	}
+
+	SECTION("The file is read from the start if it was rewritten in place") {
+		std::ofstream(queue_path.get_path()) << "FIRST\nSECOND\nthird\n";
+
+		update = queue_file.read_new_lines();
+		REQUIRE(update.from_start);
+		REQUIRE(update.lines == std::vector<std::string>({"FIRST", "SECOND", "third"}));
+	}
+}
+
+TEST_CASE("replace() only succeeds if the file didn't change since it was "
+	"last read",
+	"[QueueFile]")
+{
+	test_helpers::TempFile queue_path;
+	QueueFile queue_file(queue_path.get_path());
+	std::ofstream(queue_path.get_path()) << "first\nsecond\n";
+
+	SECTION("The file hasn't been read yet") {
+		REQUIRE(queue_file.replace({"new"}) == QueueFile::ReplaceResult::CHANGED);
+	}
+
+	queue_file.read_new_lines();
+
+	SECTION("Unchanged file is replaced") {
+		REQUIRE(queue_file.replace({"new", "lines"})
+			== QueueFile::ReplaceResult::REPLACED);
+		REQUIRE(test_helpers::file_contents(queue_path.get_path())
+			== std::vector<std::string>({"new", "lines", ""}));
+
+		// Our own write isn't returned as new lines
+		const auto update = queue_file.read_new_lines();
+		REQUIRE_FALSE(update.from_start);
+		REQUIRE(update.lines.empty());
+	}
+
+	SECTION("File with appended lines isn't replaced") {
+		REQUIRE(queue_file.append_line("third"));
+		REQUIRE(queue_file.replace({"new"}) == QueueFile::ReplaceResult::CHANGED);
+		REQUIRE(test_helpers::file_contents(queue_path.get_path()).size() == 4);
+
+		const auto update = queue_file.read_new_lines();
+		REQUIRE(update.lines == std::vector<std::string>({"third"}));
+		REQUIRE(queue_file.replace({"new"}) == QueueFile::ReplaceResult::REPLACED);
+	}
+}
+
+TEST_CASE("replace() keeps a symlinked queue file a symlink, and keeps the "
+	"file's permissions",
+	"[QueueFile]")
+{
+	test_helpers::TempFile target_path;
+	const std::string link_path = target_path.get_path() + ".link";
+	std::ofstream(target_path.get_path()) << "first\n";
+	REQUIRE(::chmod(target_path.get_path().c_str(), 0640) == 0);
+	REQUIRE(::symlink(target_path.get_path().c_str(), link_path.c_str()) == 0);
+
+	QueueFile queue_file(link_path);
+	queue_file.read_new_lines();
+	REQUIRE(queue_file.replace({"new"}) == QueueFile::ReplaceResult::REPLACED);
+
+	struct stat sb;
+	REQUIRE(::lstat(link_path.c_str(), &sb) == 0);
+	REQUIRE(S_ISLNK(sb.st_mode));
+
+	REQUIRE(::stat(target_path.get_path().c_str(), &sb) == 0);
+	REQUIRE((sb.st_mode & 07777) == 0640);
+	REQUIRE(test_helpers::file_contents(target_path.get_path())
+		== std::vector<std::string>({"new", ""}));
+
+	// The next replace() goes through the link as well
+	queue_file.read_new_lines();
+	REQUIRE(queue_file.replace({"newer"}) == QueueFile::ReplaceResult::REPLACED);
+	REQUIRE(test_helpers::file_contents(link_path)
+		== std::vector<std::string>({"newer", ""}));
+
+	::unlink(link_path.c_str());
+}
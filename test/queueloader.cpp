@@ -1,6 +1,7 @@
 #include "queueloader.h"
 
 #include <fstream>
+#include <sys/stat.h>
 
 #include "3rd-party/catch.hpp"
 #include "test_helpers/chmod.h"
@@ -601,3 +602,54 @@ TEST_CASE("No exceptions are thrown if reload() can't write the queue file",
 
 	REQUIRE_NOTHROW(queue_loader.reload(downloads));
 }
+
+TEST_CASE("reload() picks up appended lines, and only rewrites the queue file "
+	"if downloads changed",
+	"[QueueLoader]")
+{
+	test_helpers::TempFile queueFile;
+	test_helpers::copy_file("data/queue-file-for-merging", queueFile.get_path());
+
+	ConfigContainer cfg;
+	auto empty_callback = []() {};
+
+	QueueLoader queue_loader(queueFile.get_path(), cfg, empty_callback);
+	std::vector<Download> downloads;
+	queue_loader.reload(downloads);
+	const auto downloads_count = downloads.size();
+
+	const auto inode = [&queueFile]() {
+		struct stat sb;
+		REQUIRE(::stat(queueFile.get_path().c_str(), &sb) == 0);
+		return sb.st_ino;
+	};
+	const auto inode_after_first_reload = inode();
+
+	SECTION("Nothing changed") {
+		queue_loader.reload(downloads);
+
+		REQUIRE(downloads.size() == downloads_count);
+		REQUIRE(inode() == inode_after_first_reload);
+	}
+
+	SECTION("Newsboat appended a download") {
+		std::ofstream(queueFile.get_path(), std::ios::app)
+				<< R"(https://example.com/appended.mp3 "appended.mp3")" << '\n';
+
+		queue_loader.reload(downloads);
+
+		REQUIRE(downloads.size() == downloads_count + 1);
+		REQUIRE(downloads.back().url() == "https://example.com/appended.mp3");
+		REQUIRE(inode() == inode_after_first_reload);
+	}
+
+	SECTION("A download was deleted") {
+		downloads.front().set_status(DlStatus::DELETED);
+
+		queue_loader.reload(downloads);
+
+		REQUIRE(downloads.size() == downloads_count - 1);
+		REQUIRE(test_helpers::file_contents(queueFile.get_path()).size()
+			== downloads_count);
+	}
+}
@@ -1,6 +1,14 @@
 #include "remoteapi.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "3rd-party/catch.hpp"
 
@@ -27,6 +35,7 @@ public:
 	{
 		return get_credentials(scope, name).pass;
 	}
+	using RemoteApi::fetch_pages;
 	bool authenticate() override
 	{
 		throw 0;
@@ -125,3 +134,48 @@ TEST_CASE("eval_password() returns the first line of command's output",
 	// following test will wait for user input and block tests
 	// REQUIRE(RemoteApi->eval_password("read password") == "");
 }
+
+TEST_CASE("fetch_pages() fetches every page once, a few at a time",
+	"[RemoteApi]")
+{
+	ConfigContainer cfg;
+	test_api api(cfg);
+	CurlHandle handle;
+
+	std::mutex mtx;
+	std::vector<unsigned int> fetched;
+	std::vector<CURL*> handles;
+	std::atomic<unsigned int> running(0);
+	std::atomic<unsigned int> max_running(0);
+
+	api.fetch_pages(20, 4, handle, [&](unsigned int page, CurlHandle& h) {
+		const unsigned int now_running = ++running;
+		unsigned int seen = max_running;
+		while (now_running > seen
+			&& !max_running.compare_exchange_weak(seen, now_running)) {
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			fetched.push_back(page);
+			handles.push_back(h.ptr());
+		}
+		--running;
+	});
+
+	std::sort(fetched.begin(), fetched.end());
+	std::vector<unsigned int> expected(20);
+	std::iota(expected.begin(), expected.end(), 0);
+	REQUIRE(fetched == expected);
+	REQUIRE(max_running <= 4);
+	REQUIRE(std::find(handles.begin(), handles.end(), handle.ptr()) != handles.end());
+
+	SECTION("and re-throws the first exception") {
+		REQUIRE_THROWS_AS(api.fetch_pages(5, 2, handle, [](unsigned int page,
+		CurlHandle&) {
+			if (page == 3) {
+				throw std::runtime_error("page 3");
+			}
+		}), std::runtime_error);
+	}
+}
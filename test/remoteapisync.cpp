@@ -0,0 +1,395 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "3rd-party/catch.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+#include "curlhandle.h"
+#include "feedretriever.h"
+#include "freshrssapi.h"
+#include "memoryreport.h"
+#include "remoteapi.h"
+#include "rss/feed.h"
+#include "rssparser.h"
+#include "startupprofiler.h"
+#include "strprintf.h"
+#include "test_helpers/misc.h"
+#include "test_helpers/mockapiserver.h"
+#include "test_helpers/tempfile.h"
+
+using namespace newsboat;
+using test_helpers::MockAccount;
+using test_helpers::MockApiServer;
+using test_helpers::MockBackend;
+
+namespace {
+
+struct SyncResult {
+	std::vector<TaggedFeedUrl> urls;
+	std::vector<rsspp::Feed> feeds;
+	std::uint64_t articles = 0;
+	std::uint64_t unread = 0;
+};
+
+/// Does what the first start with a remote API does: logs in, lists the
+/// subscriptions and fetches every feed.
+SyncResult sync_account(RemoteApi& api, ConfigContainer& cfg, Cache& cache)
+{
+	SyncResult result;
+	REQUIRE(api.authenticate());
+	result.urls = api.get_subscribed_urls();
+
+	FeedRetriever retriever(cfg, cache, nullptr, &api);
+	for (const auto& url : result.urls) {
+		result.feeds.push_back(retriever.retrieve(url.first));
+		for (const auto& item : result.feeds.back().items) {
+			result.articles++;
+			for (const auto& label : item.labels) {
+				if (label == "unread" || test_helpers::ends_with(":unread", label)) {
+					result.unread++;
+				}
+			}
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+TEST_CASE("Every remote API backend syncs a whole account from a mock server",
+	"[RemoteApi]")
+{
+	MockAccount account;
+	account.feeds = 5;
+	account.categories = 2;
+	account.articles_per_feed = 10;
+	account.unread_every = 3;
+
+	for (const auto backend : MockApiServer::all_backends()) {
+		INFO("urls-source " << MockApiServer::name(backend));
+
+		MockApiServer server(backend, account);
+		ConfigContainer cfg;
+		server.configure(cfg);
+		Cache cache(":memory:", &cfg);
+		const auto api = server.create_api(cfg);
+
+		const SyncResult result = sync_account(*api, cfg, cache);
+
+		// Nextcloud News lists starred articles as a feed of their own.
+		const std::size_t extra_feeds = backend == MockBackend::OCNEWS ? 1 : 0;
+		REQUIRE(result.urls.size() == account.feeds + extra_feeds);
+		REQUIRE(result.articles == account.feeds * account.articles_per_feed);
+
+		// FeedHQ doesn't turn categories into tags.
+		if (backend != MockBackend::FEEDHQ) {
+			std::size_t tagged = 0;
+			for (const auto& url : result.urls) {
+				for (const auto& tag : url.second) {
+					if (tag == "Category 1") {
+						tagged++;
+					}
+				}
+			}
+			REQUIRE(tagged == 3);
+		}
+
+		// The Atom feeds of the Google Reader-like services don't say which
+		// articles are read.
+		if (backend != MockBackend::INOREADER
+			&& backend != MockBackend::OLDREADER
+			&& backend != MockBackend::FEEDHQ) {
+			REQUIRE(result.unread == account.feeds * 4);
+		}
+
+		REQUIRE(server.http().request_count() > 0);
+	}
+}
+
+TEST_CASE("TT-RSS and Inoreader only fetch the articles added since the "
+	"last sync", "[RemoteApi]")
+{
+	MockAccount account;
+	account.feeds = 2;
+	account.categories = 0;
+	account.articles_per_feed = 10;
+	account.unread_every = 3;
+
+	for (const auto backend : {
+			MockBackend::TTRSS, MockBackend::INOREADER
+		}) {
+		INFO("urls-source " << MockApiServer::name(backend));
+
+		MockApiServer server(backend, account);
+		ConfigContainer cfg;
+		server.configure(cfg);
+		Cache cache(":memory:", &cfg);
+		const auto api = server.create_api(cfg);
+
+		// Cursors are kept with the feeds, so they have to be in the cache.
+		const SyncResult first = sync_account(*api, cfg, cache);
+		REQUIRE(first.articles == account.feeds * account.articles_per_feed);
+		for (std::size_t i = 0; i < first.urls.size(); i++) {
+			RssParser parser(first.urls[i].first, cache, cfg, nullptr);
+			cache.externalize_rssfeed(parser.parse(first.feeds[i]), false);
+		}
+
+		const SyncResult second = sync_account(*api, cfg, cache);
+		REQUIRE(second.articles == first.articles);
+		for (const auto& url : second.urls) {
+			REQUIRE_FALSE(cache.fetch_sync_cursor(url.first).empty());
+		}
+
+		const SyncResult third = sync_account(*api, cfg, cache);
+		REQUIRE(third.articles == 0);
+		for (const auto& feed : third.feeds) {
+			REQUIRE(feed.only_new_items);
+			REQUIRE(feed.unread_guids != nullptr);
+			REQUIRE(feed.unread_guids->size() == 4);
+		}
+	}
+}
+
+TEST_CASE("Remote APIs list subscriptions from the subscription cache "
+	"when they can", "[RemoteApi]")
+{
+	MockAccount account;
+	MockApiServer server(MockBackend::FRESHRSS, account);
+	ConfigContainer cfg;
+	server.configure(cfg);
+	test_helpers::TempFile subscriptions;
+	const auto patient = std::chrono::seconds(10);
+
+	std::vector<TaggedFeedUrl> fetched;
+	{
+		const auto api = server.create_api(cfg);
+		REQUIRE(api->authenticate());
+		api->use_subscription_cache(subscriptions.get_path(), "account", patient);
+		fetched = api->load_subscribed_urls();
+		api->wait_for_subscription_refresh();
+	}
+	REQUIRE(fetched.size() == account.feeds);
+
+	const auto api = server.create_api(cfg);
+	REQUIRE(api->authenticate());
+
+	SECTION("An unchanged list isn't sent again") {
+		api->use_subscription_cache(subscriptions.get_path(), "account", patient);
+		const auto bytes_sent = server.http().bytes_sent();
+
+		REQUIRE(api->load_subscribed_urls() == fetched);
+		REQUIRE(server.http().bytes_sent() == bytes_sent);
+	}
+
+	SECTION("A slow server doesn't hold up the list") {
+		const auto latency = std::chrono::milliseconds(500);
+		server.http().set_latency(latency);
+		api->use_subscription_cache(subscriptions.get_path(), "account",
+			std::chrono::milliseconds(20));
+
+		const auto start = std::chrono::steady_clock::now();
+		REQUIRE(api->load_subscribed_urls() == fetched);
+		REQUIRE(std::chrono::steady_clock::now() - start < latency);
+	}
+
+	SECTION("The cached list stands in for an unreachable server") {
+		cfg.set_configvalue("freshrss-url", "http://127.0.0.1:1");
+		api->use_subscription_cache(subscriptions.get_path(), "account", patient);
+
+		REQUIRE(api->load_subscribed_urls() == fetched);
+	}
+
+	SECTION("The cached list belongs to one account") {
+		api->use_subscription_cache(subscriptions.get_path(), "another account",
+			std::chrono::milliseconds(0));
+		const auto requests = server.http().request_count();
+
+		REQUIRE(api->load_subscribed_urls() == fetched);
+		REQUIRE(server.http().request_count() > requests);
+	}
+
+	api->wait_for_subscription_refresh();
+}
+
+TEST_CASE("Remote APIs that fetch feeds by what the subscription list told "
+	"them don't use the cached list", "[RemoteApi]")
+{
+	MockAccount account;
+
+	for (const auto backend : {
+			MockBackend::NEWSBLUR, MockBackend::OCNEWS
+		}) {
+		INFO("urls-source " << MockApiServer::name(backend));
+
+		MockApiServer server(backend, account);
+		ConfigContainer cfg;
+		server.configure(cfg);
+		test_helpers::TempFile subscriptions;
+
+		SyncResult expected;
+		{
+			Cache cache(":memory:", &cfg);
+			const auto api = server.create_api(cfg);
+			REQUIRE(api->authenticate());
+			api->use_subscription_cache(subscriptions.get_path(), "account",
+				std::chrono::seconds(10));
+			api->load_subscribed_urls();
+			api->wait_for_subscription_refresh();
+			expected = sync_account(*api, cfg, cache);
+		}
+
+		// Without the server's list, the feeds would be fetched without
+		// their IDs, titles and links.
+		server.http().set_latency(std::chrono::milliseconds(50));
+		Cache cache(":memory:", &cfg);
+		const auto api = server.create_api(cfg);
+		REQUIRE(api->authenticate());
+		api->use_subscription_cache(subscriptions.get_path(), "account",
+			std::chrono::milliseconds(0));
+		REQUIRE(api->load_subscribed_urls() == expected.urls);
+
+		FeedRetriever retriever(cfg, cache, nullptr, api.get());
+		for (std::size_t i = 0; i < expected.urls.size(); i++) {
+			const auto feed = retriever.retrieve(expected.urls[i].first);
+			REQUIRE(feed.title == expected.feeds[i].title);
+			REQUIRE(feed.link == expected.feeds[i].link);
+			REQUIRE(feed.items.size() == expected.feeds[i].items.size());
+		}
+	}
+}
+
+TEST_CASE("FreshRssApi hands out the articles of a bulk sync to the feeds "
+	"they belong to", "[RemoteApi][FreshRssApi]")
+{
+	MockAccount account;
+	account.feeds = 3;
+	account.categories = 0;
+	MockApiServer server(MockBackend::FRESHRSS, account);
+	ConfigContainer cfg;
+	server.configure(cfg);
+	const auto api = server.create_api(cfg);
+	auto& freshrss = dynamic_cast<FreshRssApi&>(*api);
+	REQUIRE(api->authenticate());
+	const auto urls = api->get_subscribed_urls();
+	REQUIRE(urls.size() == account.feeds);
+
+	const auto hours_ago = [&](std::time_t hours) {
+		return std::to_string(account.newest_article - hours * 3600);
+	};
+	const auto guids = [](const rsspp::Feed& feed) {
+		std::vector<std::string> result;
+		for (const auto& item : feed.items) {
+			result.push_back(item.guid);
+		}
+		return result;
+	};
+
+	// The bulk sync starts at the oldest cursor.
+	std::map<std::string, std::string> sync_cursors;
+	for (const auto& url : urls) {
+		sync_cursors[url.first] = hours_ago(url == urls[0] ? 5 : 3);
+	}
+
+	cfg.set_configvalue("freshrss-bulk-sync", "no");
+	std::map<std::string, std::vector<std::string>> expected;
+	for (const auto& url : urls) {
+		newsboat::CurlHandle handle;
+		std::string sync_cursor = hours_ago(5);
+		expected[url.first] = guids(freshrss.fetch_feed(url.first, handle,
+					sync_cursor));
+		REQUIRE(expected[url.first].size() == 5);
+	}
+	cfg.set_configvalue("freshrss-bulk-sync", "yes");
+
+	SECTION("Each feed gets its own articles, and they all share the newest "
+		"cursor") {
+		const auto requests = server.http().request_count();
+		freshrss.prefetch_feeds(sync_cursors);
+
+		// The unread articles are listed last, so that the list covers all
+		// of the articles that were fetched.
+		const auto log = server.http().requests();
+		REQUIRE(log.size() == requests + 2);
+		REQUIRE(log[requests].find("/stream/contents/") != std::string::npos);
+		REQUIRE(log[requests + 1].find("/stream/items/ids") != std::string::npos);
+
+		for (const auto& url : urls) {
+			newsboat::CurlHandle handle;
+			std::string sync_cursor = sync_cursors[url.first];
+			const auto feed = freshrss.fetch_feed(url.first, handle, sync_cursor);
+			REQUIRE(guids(feed) == expected[url.first]);
+			REQUIRE(feed.only_new_items);
+			REQUIRE(feed.unread_guids != nullptr);
+			REQUIRE(sync_cursor == std::to_string(account.newest_article));
+		}
+		REQUIRE(server.http().request_count() == requests + 2);
+	}
+
+	SECTION("Feeds are fetched one by one if the bulk sync fails") {
+		server.fail_requests(
+			"/reader/api/0/stream/contents/user/-/state/com.google/reading-list");
+		freshrss.prefetch_feeds(sync_cursors);
+		server.fail_requests("");
+
+		for (const auto& url : urls) {
+			const auto requests = server.http().request_count();
+			newsboat::CurlHandle handle;
+			std::string sync_cursor = hours_ago(5);
+			const auto feed = freshrss.fetch_feed(url.first, handle, sync_cursor);
+			REQUIRE(guids(feed) == expected[url.first]);
+			REQUIRE(server.http().request_count() > requests);
+		}
+	}
+}
+
+TEST_CASE("Benchmark: full sync of a large account from every backend",
+	"[.][benchmark][RemoteApi]")
+{
+	MockAccount account;
+	account.feeds = 200;
+	account.categories = 10;
+	account.articles_per_feed = 50;
+	account.content_size = 2000;
+	const auto latency = std::chrono::milliseconds(5);
+
+	StartupProfiler profiler;
+	std::vector<std::string> lines;
+	lines.push_back(strprintf::fmt("%-12s %10s %12s %10s",
+			"Backend", "Requests", "Received", "Articles"));
+
+	for (const auto backend : MockApiServer::all_backends()) {
+		const std::string name = MockApiServer::name(backend);
+		MockApiServer server(backend, account);
+		server.http().set_latency(latency);
+		ConfigContainer cfg;
+		server.configure(cfg);
+		Cache cache(":memory:", &cfg);
+		const auto api = server.create_api(cfg);
+
+		profiler.begin_phase(name);
+		const SyncResult result = sync_account(*api, cfg, cache);
+		// Heap growth is measured while the articles are still held.
+		profiler.end_phase();
+
+		lines.push_back(strprintf::fmt("%-12s %10" PRIu64 " %12s %10" PRIu64,
+				name,
+				server.http().request_count(),
+				MemoryReport::format_bytes(server.http().bytes_sent()),
+				result.articles));
+	}
+
+	std::cout << account.feeds << " feeds with " << account.articles_per_feed
+		<< " articles each, " << latency.count() << " ms latency" << std::endl;
+	for (const auto& line : profiler.format()) {
+		std::cout << line << std::endl;
+	}
+	for (const auto& line : lines) {
+		std::cout << line << std::endl;
+	}
+}
@@ -240,6 +240,97 @@ TEST_CASE("RssFeed::unread_item_count() returns number of unread articles",
 	REQUIRE(f.unread_item_count() == 0);
 }
 
+TEST_CASE("RssFeed's counts and date sort follow the items it holds after "
+	"items are erased", "[RssFeed]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	RssFeed f(&rsscache, "");
+	for (int i = 0; i < 6; ++i) {
+		const auto item = std::make_shared<RssItem>(&rsscache);
+		item->set_guid(std::to_string(i));
+		item->set_pubDate(100 + i);
+		item->set_unread_nowrite(i % 2 == 0);
+		f.add_item(item);
+	}
+
+	f.erase_items_if([](const std::shared_ptr<RssItem>& item) {
+		return item->guid() == "1" || item->guid() == "4";
+	});
+	REQUIRE(f.items().size() == 4);
+	// Erased items are gone from the GUID index, too
+	REQUIRE(f.get_item_by_guid("4")->guid().empty());
+	REQUIRE(f.unread_item_count() == 2);
+	REQUIRE(f.latest_item_timestamp() == 105);
+
+	f.erase_item(f.items().end() - 1);
+	REQUIRE(f.unread_item_count() == 2);
+	REQUIRE(f.latest_item_timestamp() == 103);
+
+	ArticleSortStrategy ss;
+	ss.sm = ArtSortMethod::DATE;
+	ss.sd = SortDirection::DESC;
+	f.sort(ss);
+	REQUIRE(f.items()[0]->guid() == "0");
+	REQUIRE(f.items()[2]->guid() == "3");
+
+	f.mark_all_items_read();
+	REQUIRE(f.unread_item_count() == 0);
+	for (const auto& item : f.items()) {
+		REQUIRE_FALSE(item->unread());
+	}
+}
+
+TEST_CASE("RssFeed::get_item_by_guid() returns the last item added with "
+	"that GUID", "[RssFeed]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	RssFeed f(&rsscache, "");
+
+	auto first = std::make_shared<RssItem>(&rsscache);
+	first->set_guid("duplicate");
+	first->set_title("First");
+	f.add_item(first);
+
+	auto second = std::make_shared<RssItem>(&rsscache);
+	second->set_guid("duplicate");
+	second->set_title("Second");
+	f.add_item(second);
+
+	REQUIRE(f.get_item_by_guid("duplicate")->title() == "Second");
+
+	SECTION("lookup keeps working once the first item is gone") {
+		f.erase_item(f.items().begin());
+		first.reset();
+
+		REQUIRE(f.items().size() == 1);
+
+		f.add_item(second);
+		REQUIRE(f.get_item_by_guid("duplicate")->title() == "Second");
+	}
+}
+
+TEST_CASE("RssFeed::get_item_by_guid() still finds an item after its GUID "
+	"changed", "[RssFeed]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	RssFeed f(&rsscache, "");
+
+	auto item = std::make_shared<RssItem>(&rsscache);
+	item->set_guid("old");
+	f.add_item(item);
+
+	item->set_guid("a GUID long enough to be stored on the heap");
+	REQUIRE(f.get_item_by_guid("old") == item);
+
+	f.add_item(item);
+	REQUIRE(f.get_item_by_guid("a GUID long enough to be stored on the heap")
+		== item);
+	REQUIRE(f.get_item_by_guid("old") == item);
+}
+
 TEST_CASE("RssFeed::matches_tag() returns true if article has a specified tag",
 	"[RssFeed]")
 {
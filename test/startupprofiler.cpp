@@ -0,0 +1,79 @@
+#include "startupprofiler.h"
+
+#include "3rd-party/catch.hpp"
+#include "cache.h"
+#include "configcontainer.h"
+
+using namespace newsboat;
+
+TEST_CASE("StartupProfiler records consecutive phases", "[StartupProfiler]")
+{
+	StartupProfiler profiler;
+	REQUIRE(profiler.phases().empty());
+
+	profiler.begin_phase("first");
+	profiler.begin_phase("second");
+	profiler.end_phase();
+	profiler.end_phase();
+
+	const auto& phases = profiler.phases();
+	REQUIRE(phases.size() == 2);
+	REQUIRE(phases[0].name == "first");
+	REQUIRE(phases[1].name == "second");
+	REQUIRE(phases[0].wall_ms >= 0);
+	REQUIRE(phases[1].cpu_ms >= 0);
+
+	SECTION("format() adds a header and a line with totals") {
+		const auto lines = profiler.format();
+		REQUIRE(lines.size() == 4);
+		REQUIRE(lines[1].find("first") == 0);
+		REQUIRE(lines[3].find("Total") == 0);
+	}
+
+	SECTION("to_json() lists all phases") {
+		const auto json = profiler.to_json();
+		REQUIRE(json.find("\"first\"") != std::string::npos);
+		REQUIRE(json.find("\"second\"") != std::string::npos);
+		REQUIRE(json.find("\"sql_statements\"") != std::string::npos);
+	}
+}
+
+TEST_CASE("StartupProfiler counts SQL statements run by the cache",
+	"[StartupProfiler]")
+{
+	ConfigContainer cfg;
+	StartupProfiler profiler;
+
+	profiler.begin_phase("opening cache");
+	Cache rsscache(":memory:", &cfg);
+	profiler.end_phase();
+
+	profiler.begin_phase("idle");
+	profiler.end_phase();
+
+	REQUIRE(profiler.phases()[0].sql_statements > 0);
+	REQUIRE(profiler.phases()[1].sql_statements == 0);
+}
+
+TEST_CASE("The cache only counts SQL statements while a StartupProfiler "
+	"exists", "[StartupProfiler]")
+{
+	ConfigContainer cfg;
+	Cache rsscache(":memory:", &cfg);
+	const std::string feedurl = "https://example.com/feed.xml";
+
+	auto before = Cache::executed_statements();
+	rsscache.fetch_sync_cursor(feedurl);
+	REQUIRE(Cache::executed_statements() == before);
+
+	{
+		StartupProfiler profiler;
+		before = Cache::executed_statements();
+		rsscache.fetch_sync_cursor(feedurl);
+		REQUIRE(Cache::executed_statements() > before);
+	}
+
+	before = Cache::executed_statements();
+	rsscache.fetch_sync_cursor(feedurl);
+	REQUIRE(Cache::executed_statements() == before);
+}
@@ -0,0 +1,114 @@
+#include "subscriptioncache.h"
+
+#include <fstream>
+
+#include "3rd-party/catch.hpp"
+#include "test_helpers/tempfile.h"
+
+using namespace newsboat;
+
+namespace {
+
+std::vector<TaggedFeedUrl> sample_urls()
+{
+	return {
+		{"https://example.com/feed.xml", {"News", "~Example"}},
+		{"https://example.com/untagged.xml", {}},
+	};
+}
+
+} // namespace
+
+TEST_CASE("SubscriptionCache has no list until one is stored",
+	"[SubscriptionCache]")
+{
+	test_helpers::TempFile file;
+	SubscriptionCache cache(file.get_path(), "account");
+
+	REQUIRE_FALSE(cache.get_urls().has_value());
+	REQUIRE_FALSE(cache.get_reply("https://example.com/list").has_value());
+}
+
+TEST_CASE("SubscriptionCache reads back the list and replies it stored",
+	"[SubscriptionCache]")
+{
+	test_helpers::TempFile file;
+	{
+		SubscriptionCache cache(file.get_path(), "account");
+		cache.set_reply("https://example.com/list",
+		{"\"abc\"", "Tue, 14 Nov 2023 22:13:20 GMT", "{\"subscriptions\":[]}"});
+		REQUIRE(cache.store_urls(sample_urls()));
+		REQUIRE(cache.get_urls() == sample_urls());
+	}
+
+	SubscriptionCache cache(file.get_path(), "account");
+	REQUIRE(cache.get_urls() == sample_urls());
+
+	const auto reply = cache.get_reply("https://example.com/list");
+	REQUIRE(reply.has_value());
+	REQUIRE(reply.value().etag == "\"abc\"");
+	REQUIRE(reply.value().last_modified == "Tue, 14 Nov 2023 22:13:20 GMT");
+	REQUIRE(reply.value().body == "{\"subscriptions\":[]}");
+}
+
+TEST_CASE("SubscriptionCache only writes replies along with a list",
+	"[SubscriptionCache]")
+{
+	test_helpers::TempFile file;
+	{
+		SubscriptionCache cache(file.get_path(), "account");
+		REQUIRE(cache.store_urls(sample_urls()));
+		cache.set_reply("https://example.com/list", {"\"abc\"", "", "{}"});
+	}
+
+	SubscriptionCache cache(file.get_path(), "account");
+	REQUIRE(cache.get_urls().has_value());
+	REQUIRE_FALSE(cache.get_reply("https://example.com/list").has_value());
+}
+
+TEST_CASE("SubscriptionCache drops replies that aren't valid UTF-8",
+	"[SubscriptionCache]")
+{
+	test_helpers::TempFile file;
+	{
+		SubscriptionCache cache(file.get_path(), "account");
+		cache.set_reply("https://example.com/list", {"\"abc\"", "", "\xff\xfe"});
+		REQUIRE(cache.store_urls(sample_urls()));
+	}
+
+	SubscriptionCache cache(file.get_path(), "account");
+	REQUIRE(cache.get_urls() == sample_urls());
+	REQUIRE_FALSE(cache.get_reply("https://example.com/list").has_value());
+}
+
+TEST_CASE("SubscriptionCache ignores files of another account",
+	"[SubscriptionCache]")
+{
+	test_helpers::TempFile file;
+	{
+		SubscriptionCache cache(file.get_path(), "account");
+		cache.set_reply("https://example.com/list", {"\"abc\"", "", "{}"});
+		REQUIRE(cache.store_urls(sample_urls()));
+	}
+
+	SubscriptionCache cache(file.get_path(), "another account");
+	REQUIRE_FALSE(cache.get_urls().has_value());
+	REQUIRE_FALSE(cache.get_reply("https://example.com/list").has_value());
+}
+
+TEST_CASE("SubscriptionCache ignores malformed files", "[SubscriptionCache]")
+{
+	test_helpers::TempFile file;
+	{
+		std::ofstream f(file.get_path());
+		f << "{\"version\": 1, \"key\": \"account\", \"urls\": [";
+	}
+
+	SubscriptionCache cache(file.get_path(), "account");
+	REQUIRE_FALSE(cache.get_urls().has_value());
+
+	// ...and replace them with a valid one.
+	REQUIRE(cache.store_urls(sample_urls()));
+	REQUIRE(SubscriptionCache(file.get_path(), "account").get_urls() ==
+		sample_urls());
+}
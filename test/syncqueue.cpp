@@ -0,0 +1,311 @@
+#include "syncqueue.h"
+
+#include <set>
+#include <unistd.h>
+
+#include "3rd-party/catch.hpp"
+#include "configcontainer.h"
+#include "remoteapi.h"
+#include "test_helpers/tempfile.h"
+#include "utils.h"
+
+using namespace newsboat;
+
+namespace {
+
+/*
+ * Records the requests that SyncQueue makes, or refuses all of them while
+ * `online` is false. Requests touching a GUID in `refused` are refused too.
+ */
+class RecordingApi : public RemoteApi {
+public:
+	explicit RecordingApi(ConfigContainer& c)
+		: RemoteApi(c)
+	{
+	}
+	bool authenticate() override
+	{
+		return true;
+	}
+	std::vector<TaggedFeedUrl> get_subscribed_urls() override
+	{
+		return {};
+	}
+	void add_custom_headers(curl_slist**) override
+	{
+	}
+	bool mark_all_read(const std::string&) override
+	{
+		return false;
+	}
+	bool mark_article_read(const std::string& guid, bool read) override
+	{
+		return record((read ? "read " : "unread ") + guid, {guid});
+	}
+	bool mark_articles_read(const std::vector<std::string>& guids) override
+	{
+		return record("read " + utils::join(guids, ","), guids);
+	}
+	bool mark_articles_unread(const std::vector<std::string>& guids) override
+	{
+		return record("unread " + utils::join(guids, ","), guids);
+	}
+	bool update_article_flags(const std::string& oldflags,
+		const std::string& newflags,
+		const std::string& guid) override
+	{
+		return record("flags " + oldflags + " " + newflags + " " + guid, {guid});
+	}
+
+	std::vector<std::string> calls;
+	std::set<std::string> refused;
+	unsigned int requests = 0;
+	bool online = true;
+
+private:
+	bool record(const std::string& call,
+		const std::vector<std::string>& targets)
+	{
+		requests++;
+		if (!online) {
+			return false;
+		}
+		for (const auto& target : targets) {
+			if (refused.count(target) != 0) {
+				return false;
+			}
+		}
+		calls.push_back(call);
+		return true;
+	}
+};
+
+} // anonymous namespace
+
+TEST_CASE("SyncQueue only sends the outcome of changes to the same article, "
+	"batching consecutive ones",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	test_helpers::TempFile journal;
+	SyncQueue queue(api, journal.get_path());
+
+	queue.mark_articles_read({"a", "b", "c"});
+	queue.mark_article_read("b", false);
+	queue.update_article_flags("", "s", "a");
+	queue.mark_article_read("d", true);
+	REQUIRE(queue.pending() == 5);
+
+	REQUIRE(queue.flush());
+	REQUIRE(queue.pending() == 0);
+	REQUIRE(api.calls == std::vector<std::string>({
+		"read a,c",
+		"unread b",
+		"flags  s a",
+		"read d",
+	}));
+}
+
+TEST_CASE("SyncQueue::pending_read_state() lists the articles whose read "
+	"state hasn't been sent", "[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	api.online = false;
+	test_helpers::TempFile journal;
+	SyncQueue queue(api, journal.get_path());
+
+	queue.mark_article_read("a", true);
+	queue.update_article_flags("", "s", "b");
+	queue.mark_articles_read({"c"});
+	queue.mark_article_read("d", false);
+	REQUIRE(queue.pending_read_state() == std::unordered_set<std::string>({
+		"a", "c", "d"
+	}));
+
+	REQUIRE_FALSE(queue.flush());
+	REQUIRE(queue.pending_read_state().size() == 3);
+
+	api.online = true;
+	REQUIRE(queue.flush());
+	REQUIRE(queue.pending_read_state().empty());
+}
+
+TEST_CASE("SyncQueue merges flag changes, and drops the ones that cancel out",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	test_helpers::TempFile journal;
+	SyncQueue queue(api, journal.get_path());
+
+	queue.update_article_flags("", "s", "a");
+	queue.update_article_flags("s", "", "a");
+	queue.update_article_flags("", "s", "b");
+	queue.update_article_flags("s", "ps", "b");
+	REQUIRE(queue.pending() == 1);
+
+	REQUIRE(queue.flush());
+	REQUIRE(api.calls == std::vector<std::string>({"flags  ps b"}));
+}
+
+TEST_CASE("SyncQueue keeps changes that couldn't be sent, even across restarts",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	api.online = false;
+	test_helpers::TempFile journal;
+
+	{
+		SyncQueue queue(api, journal.get_path());
+		queue.mark_articles_read({"a", "b"});
+		queue.update_article_flags("", "s", "guid\twith a tab");
+
+		REQUIRE_FALSE(queue.flush());
+		REQUIRE(queue.pending() == 3);
+
+		queue.mark_article_read("a", false);
+		REQUIRE(queue.pending() == 3);
+	}
+	REQUIRE(::access(journal.get_path().c_str(), F_OK) == 0);
+
+	api.online = true;
+	SyncQueue queue(api, journal.get_path());
+	REQUIRE(queue.pending() == 3);
+	REQUIRE(queue.flush());
+	// The changes that the server refused come last.
+	REQUIRE(api.calls == std::vector<std::string>({
+		"flags  s guid\twith a tab",
+		"read b",
+		"unread a",
+	}));
+	REQUIRE(::access(journal.get_path().c_str(), F_OK) != 0);
+}
+
+TEST_CASE("SyncQueue sends the rest of a batch when the server refuses a change, "
+	"and gives up on it eventually",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	api.refused = {"bad"};
+	test_helpers::TempFile journal;
+
+	{
+		SyncQueue queue(api, journal.get_path());
+		queue.mark_articles_read({"bad", "a", "b"});
+		queue.update_article_flags("", "s", "c");
+
+		// With nothing taken before, refusing both the batch and "bad"
+		// looks like an unreachable server.
+		REQUIRE_FALSE(queue.flush());
+		REQUIRE(queue.pending() == 4);
+		REQUIRE(api.calls.empty());
+
+		// The refused articles were moved to the back.
+		REQUIRE_FALSE(queue.flush());
+		REQUIRE(queue.pending() == 1);
+		REQUIRE(api.calls == std::vector<std::string>({
+			"flags  s c",
+			"read a",
+			"read b",
+		}));
+	}
+
+	// The attempts are kept in the journal.
+	SyncQueue queue(api, journal.get_path());
+	REQUIRE(queue.pending() == 1);
+	for (unsigned int i = 1; i < SyncQueue::MAX_ATTEMPTS; i++) {
+		REQUIRE(queue.pending() == 1);
+		queue.mark_article_read("d" + std::to_string(i), false);
+		REQUIRE_FALSE(queue.flush());
+	}
+	REQUIRE(queue.pending() == 0);
+	REQUIRE(api.calls.back() == "unread d4");
+	REQUIRE(::access(journal.get_path().c_str(), F_OK) != 0);
+}
+
+TEST_CASE("SyncQueue doesn't give up on changes while the server is unreachable",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	api.online = false;
+	test_helpers::TempFile journal;
+	SyncQueue queue(api, journal.get_path());
+
+	queue.mark_articles_read({"a", "b", "c"});
+	for (unsigned int i = 0; i < SyncQueue::MAX_ATTEMPTS + 1; i++) {
+		REQUIRE_FALSE(queue.flush());
+	}
+	REQUIRE(queue.pending() == 3);
+	// The batch, and a single article to find out whether the server
+	// refuses just some of them.
+	REQUIRE(api.requests == 2 * (SyncQueue::MAX_ATTEMPTS + 1));
+
+	api.online = true;
+	REQUIRE(queue.flush());
+	REQUIRE(api.calls == std::vector<std::string>({"read a,b,c"}));
+}
+
+TEST_CASE("SyncQueue::try_flush() leaves changes alone while waiting for a retry",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	api.online = false;
+	test_helpers::TempFile journal;
+	SyncQueue queue(api, journal.get_path());
+
+	queue.mark_article_read("a", true);
+	REQUIRE_FALSE(queue.try_flush());
+	REQUIRE(api.requests == 1);
+
+	api.online = true;
+	REQUIRE_FALSE(queue.try_flush());
+	REQUIRE(api.requests == 1);
+	REQUIRE(queue.pending() == 1);
+
+	// flush() doesn't wait.
+	REQUIRE(queue.flush());
+	REQUIRE(api.calls == std::vector<std::string>({"read a"}));
+}
+
+TEST_CASE("SyncQueue stops sending once the server looks unreachable",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	api.online = false;
+	test_helpers::TempFile journal;
+	SyncQueue queue(api, journal.get_path());
+
+	queue.mark_article_read("a", true);
+	queue.update_article_flags("", "s", "b");
+	queue.mark_article_read("c", false);
+	queue.update_article_flags("", "s", "d");
+
+	REQUIRE_FALSE(queue.flush());
+	REQUIRE(api.requests == 2);
+	REQUIRE(queue.pending() == 4);
+}
+
+TEST_CASE("SyncQueue saves changes made while it waits for a retry",
+	"[SyncQueue]")
+{
+	ConfigContainer cfg;
+	RecordingApi api(cfg);
+	api.online = false;
+	test_helpers::TempFile journal;
+	SyncQueue queue(api, journal.get_path());
+
+	queue.mark_article_read("a", true);
+	REQUIRE_FALSE(queue.try_flush());
+	queue.mark_article_read("b", true);
+
+	// As if Newsboat had crashed.
+	SyncQueue restarted(api, journal.get_path());
+	REQUIRE(restarted.pending() == 2);
+}
@@ -0,0 +1,342 @@
+#include "httpserver.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+std::runtime_error socket_error(const std::string& what)
+{
+	const auto saved_errno = errno;
+	std::string msg("HttpServer: ");
+	msg += what;
+	msg += " failed: (";
+	msg += std::to_string(saved_errno);
+	msg += ") ";
+	msg += ::strerror(saved_errno);
+	return std::runtime_error(msg);
+}
+
+bool receive(int fd, std::string& buffer)
+{
+	char chunk[16 * 1024];
+	const auto received = ::recv(fd, chunk, sizeof(chunk), 0);
+	if (received <= 0) {
+		return false;
+	}
+	buffer.append(chunk, received);
+	return true;
+}
+
+bool send_all(int fd, const std::string& data)
+{
+	std::size_t sent = 0;
+	while (sent < data.size()) {
+		const auto n = ::send(fd, data.data() + sent, data.size() - sent,
+				SEND_FLAGS);
+		if (n <= 0) {
+			return false;
+		}
+		sent += n;
+	}
+	return true;
+}
+
+std::string to_lower(std::string s)
+{
+	std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
+		return std::tolower(c);
+	});
+	return s;
+}
+
+std::string trim(const std::string& s)
+{
+	const auto first = s.find_first_not_of(" \t");
+	if (first == std::string::npos) {
+		return {};
+	}
+	return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+}
+
+std::string status_text(int status)
+{
+	switch (status) {
+	case 200:
+		return "OK";
+	case 204:
+		return "No Content";
+	case 206:
+		return "Partial Content";
+	case 304:
+		return "Not Modified";
+	case 400:
+		return "Bad Request";
+	case 401:
+		return "Unauthorized";
+	case 404:
+		return "Not Found";
+	case 500:
+		return "Internal Server Error";
+	default:
+		return "Status";
+	}
+}
+
+} // namespace
+
+test_helpers::HttpServer::HttpServer(Handler handler)
+	: handler(std::move(handler))
+	, listen_fd(-1)
+	, port(0)
+	, latency_ms(0)
+	, requests_answered(0)
+	, body_bytes_sent(0)
+	, stopping(false)
+{
+	listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd == -1) {
+		throw socket_error("socket()");
+	}
+
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	socklen_t addr_len = sizeof(addr);
+	if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+		|| ::listen(listen_fd, 64) != 0
+		|| ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr),
+			&addr_len) != 0) {
+		const auto error = socket_error("listening on the loopback interface");
+		::close(listen_fd);
+		throw error;
+	}
+	port = ntohs(addr.sin_port);
+
+	acceptor = std::thread(&HttpServer::accept_connections, this);
+}
+
+test_helpers::HttpServer::~HttpServer()
+{
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		stopping = true;
+		// Wakes up the threads that wait for the next request.
+		for (const int fd : open_fds) {
+			::shutdown(fd, SHUT_RDWR);
+		}
+	}
+	acceptor.join();
+	::close(listen_fd);
+
+	for (auto& thread : connection_threads) {
+		thread.join();
+	}
+}
+
+std::string test_helpers::HttpServer::get_url() const
+{
+	return "http://127.0.0.1:" + std::to_string(port);
+}
+
+void test_helpers::HttpServer::set_latency(std::chrono::milliseconds latency)
+{
+	latency_ms = latency.count();
+}
+
+std::uint64_t test_helpers::HttpServer::request_count() const
+{
+	return requests_answered;
+}
+
+std::uint64_t test_helpers::HttpServer::bytes_sent() const
+{
+	return body_bytes_sent;
+}
+
+std::vector<std::string> test_helpers::HttpServer::requests() const
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return request_log;
+}
+
+std::string test_helpers::HttpServer::unescape(const std::string& s,
+	bool plus_is_space)
+{
+	std::string result;
+	result.reserve(s.size());
+	for (std::size_t i = 0; i < s.size(); i++) {
+		if (s[i] == '%' && i + 2 < s.size()
+			&& std::isxdigit(static_cast<unsigned char>(s[i + 1]))
+			&& std::isxdigit(static_cast<unsigned char>(s[i + 2]))) {
+			result.push_back(static_cast<char>(
+					std::strtol(s.substr(i + 1, 2).c_str(), nullptr, 16)));
+			i += 2;
+		} else if (s[i] == '+' && plus_is_space) {
+			result.push_back(' ');
+		} else {
+			result.push_back(s[i]);
+		}
+	}
+	return result;
+}
+
+void test_helpers::HttpServer::accept_connections()
+{
+	while (true) {
+		// Polling with a timeout, rather than blocking in accept(), lets
+		// the destructor stop this thread without platform-specific tricks.
+		pollfd pfd{};
+		pfd.fd = listen_fd;
+		pfd.events = POLLIN;
+		const int ready = ::poll(&pfd, 1, 50);
+
+		std::lock_guard<std::mutex> guard(mtx);
+		if (stopping) {
+			return;
+		}
+		if (ready <= 0) {
+			continue;
+		}
+
+		const int fd = ::accept(listen_fd, nullptr, nullptr);
+		if (fd == -1) {
+			continue;
+		}
+		open_fds.push_back(fd);
+		connection_threads.emplace_back(&HttpServer::serve, this, fd);
+	}
+}
+
+void test_helpers::HttpServer::serve(int fd)
+{
+	std::string buffer;
+	bool keep_alive = true;
+	while (keep_alive) {
+		std::string::size_type header_end;
+		while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+			if (!receive(fd, buffer)) {
+				keep_alive = false;
+				break;
+			}
+		}
+		if (!keep_alive) {
+			break;
+		}
+
+		Request request;
+		std::string::size_type line_start = 0;
+		std::string::size_type line_end = buffer.find("\r\n");
+		const std::string request_line = buffer.substr(0, line_end);
+		const auto method_end = request_line.find(' ');
+		const auto target_end = request_line.find(' ', method_end + 1);
+		if (method_end == std::string::npos || target_end == std::string::npos) {
+			break;
+		}
+		request.method = request_line.substr(0, method_end);
+		const std::string target =
+			request_line.substr(method_end + 1, target_end - method_end - 1);
+
+		const auto question_mark = target.find('?');
+		request.path = unescape(target.substr(0, question_mark), false);
+		if (question_mark != std::string::npos) {
+			std::string::size_type start = question_mark + 1;
+			while (start <= target.size()) {
+				auto end = target.find('&', start);
+				if (end == std::string::npos) {
+					end = target.size();
+				}
+				const std::string param = target.substr(start, end - start);
+				const auto equals = param.find('=');
+				if (!param.empty()) {
+					request.query[unescape(param.substr(0, equals), true)] =
+						equals == std::string::npos
+						? std::string()
+						: unescape(param.substr(equals + 1), true);
+				}
+				start = end + 1;
+			}
+		}
+
+		while (line_end < header_end) {
+			line_start = line_end + 2;
+			line_end = buffer.find("\r\n", line_start);
+			const std::string line = buffer.substr(line_start, line_end - line_start);
+			const auto colon = line.find(':');
+			if (colon != std::string::npos) {
+				request.headers[to_lower(trim(line.substr(0, colon)))] =
+					trim(line.substr(colon + 1));
+			}
+		}
+		buffer.erase(0, header_end + 4);
+
+		if (to_lower(request.headers["expect"]) == "100-continue"
+			&& !send_all(fd, "HTTP/1.1 100 Continue\r\n\r\n")) {
+			break;
+		}
+		const std::size_t content_length =
+			std::strtoull(request.headers["content-length"].c_str(), nullptr, 10);
+		while (buffer.size() < content_length && receive(fd, buffer)) {
+		}
+		if (buffer.size() < content_length) {
+			break;
+		}
+		request.body = buffer.substr(0, content_length);
+		buffer.erase(0, content_length);
+		keep_alive = to_lower(request.headers["connection"]) != "close";
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(latency_ms.load()));
+
+		Response response;
+		try {
+			response = handler(request);
+		} catch (const std::exception& e) {
+			response.status = 400;
+			response.content_type = "text/plain";
+			response.body = e.what();
+		}
+
+		std::string reply = "HTTP/1.1 " + std::to_string(response.status) + " "
+			+ status_text(response.status) + "\r\n";
+		reply += "Content-Type: " + response.content_type + "\r\n";
+		reply += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+		for (const auto& header : response.headers) {
+			reply += header.first + ": " + header.second + "\r\n";
+		}
+		reply += keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+		reply += "\r\n";
+		reply += response.body;
+
+		{
+			std::lock_guard<std::mutex> guard(mtx);
+			request_log.push_back(request.method + " " + request.path);
+		}
+		requests_answered++;
+		body_bytes_sent += response.body.size();
+
+		if (!send_all(fd, reply)) {
+			break;
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(mtx);
+	open_fds.erase(std::remove(open_fds.begin(), open_fds.end(), fd),
+		open_fds.end());
+	::close(fd);
+}
@@ -0,0 +1,96 @@
+#ifndef NEWSBOAT_TEST_HELPERS_HTTPSERVER_H_
+#define NEWSBOAT_TEST_HELPERS_HTTPSERVER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace test_helpers {
+
+/* \brief A minimal HTTP/1.1 server on the loopback interface.
+ *
+ * Every request is passed to a handler function, which is called from the
+ * thread serving the connection; connections are kept alive, so clients can
+ * reuse them like they would with a real server. The server listens on a
+ * port picked by the OS as soon as it's constructed, and shuts down when
+ * the object is destroyed.
+ */
+class HttpServer {
+public:
+	struct Request {
+		std::string method;
+		/// Path with percent-escapes decoded, without the query string.
+		std::string path;
+		/// Decoded query parameters; a parameter given several times keeps
+		/// the last value.
+		std::map<std::string, std::string> query;
+		/// Header names are lowercase.
+		std::map<std::string, std::string> headers;
+		std::string body;
+	};
+
+	struct Response {
+		int status = 200;
+		std::string content_type = "application/json";
+		/// Sent in addition to Content-Type, Content-Length and Connection.
+		std::map<std::string, std::string> headers;
+		std::string body;
+	};
+
+	using Handler = std::function<Response(const Request&)>;
+
+	explicit HttpServer(Handler handler);
+	~HttpServer();
+
+	HttpServer(const HttpServer&) = delete;
+	HttpServer& operator=(const HttpServer&) = delete;
+
+	/// URL of the server, like "http://127.0.0.1:12345", without a slash at
+	/// the end.
+	std::string get_url() const;
+
+	/// Delay added before every response, to simulate a remote server.
+	void set_latency(std::chrono::milliseconds latency);
+
+	/// Number of requests answered so far.
+	std::uint64_t request_count() const;
+
+	/// Number of bytes of response bodies sent so far.
+	std::uint64_t bytes_sent() const;
+
+	/// Method and path of every request answered so far, like
+	/// "GET /v1/feeds", in the order they came in.
+	std::vector<std::string> requests() const;
+
+	/// Decodes percent-escapes and, if \a plus_is_space is true, pluses.
+	static std::string unescape(const std::string& s, bool plus_is_space);
+
+private:
+	void accept_connections();
+	void serve(int fd);
+
+	Handler handler;
+	int listen_fd;
+	unsigned short port;
+
+	std::atomic<long long> latency_ms;
+	std::atomic<std::uint64_t> requests_answered;
+	std::atomic<std::uint64_t> body_bytes_sent;
+
+	mutable std::mutex mtx;
+	bool stopping;
+	std::vector<std::string> request_log;
+	std::vector<int> open_fds;
+	std::vector<std::thread> connection_threads;
+	std::thread acceptor;
+};
+
+} // namespace test_helpers
+
+#endif /* NEWSBOAT_TEST_HELPERS_HTTPSERVER_H_ */
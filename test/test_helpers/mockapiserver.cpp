@@ -0,0 +1,1011 @@
+#include "mockapiserver.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+
+#include "3rd-party/json.hpp"
+#include "configcontainer.h"
+#include "feedbinapi.h"
+#include "feedhqapi.h"
+#include "freshrssapi.h"
+#include "inoreaderapi.h"
+#include "minifluxapi.h"
+#include "newsblurapi.h"
+#include "ocnewsapi.h"
+#include "oldreaderapi.h"
+#include "ttrssapi.h"
+
+using json = nlohmann::json;
+using Request = test_helpers::HttpServer::Request;
+using Response = test_helpers::HttpServer::Response;
+
+namespace {
+
+const std::string GREADER_READ = "user/-/state/com.google/read";
+const std::string GREADER_READING_LIST = "user/-/state/com.google/reading-list";
+const std::string OCNEWS_PREFIX = "/index.php/apps/news/api/v1-2/";
+
+/// Articles are numbered from the newest one in each feed, starting at 0.
+struct Article {
+	unsigned int feed;
+	unsigned int index;
+};
+
+std::uint64_t article_id(const test_helpers::MockAccount& account,
+	const Article& article)
+{
+	// Like on the real servers, newer articles get higher IDs.
+	return static_cast<std::uint64_t>(article.feed) * account.articles_per_feed
+		+ (account.articles_per_feed - article.index);
+}
+
+std::time_t published(const test_helpers::MockAccount& account,
+	const Article& article)
+{
+	// Articles of different feeds are a second apart, so that every
+	// article has its own timestamp.
+	return account.newest_article - static_cast<std::time_t>(article.index) * 3600
+		- article.feed;
+}
+
+bool is_unread(const test_helpers::MockAccount& account, const Article& article)
+{
+	return account.unread_every != 0 && article.index % account.unread_every == 0;
+}
+
+std::string content(const test_helpers::MockAccount& account,
+	const Article& article)
+{
+	std::string result = "Article " + std::to_string(article_id(account,
+				article)) + ". ";
+	const std::string filler = "Lorem ipsum dolor sit amet. ";
+	while (result.size() < account.content_size) {
+		result += filler;
+	}
+	result.resize(account.content_size);
+	return result;
+}
+
+std::string feed_title(unsigned int feed)
+{
+	return "Feed " + std::to_string(feed + 1);
+}
+
+std::string feed_url(unsigned int feed)
+{
+	return "https://example.com/feed" + std::to_string(feed + 1) + ".xml";
+}
+
+std::string article_url(const test_helpers::MockAccount& account,
+	const Article& article)
+{
+	return "https://example.com/feed" + std::to_string(article.feed + 1)
+		+ "/article" + std::to_string(article_id(account, article));
+}
+
+/// 0 if the feed has no category, otherwise the 1-based category ID.
+unsigned int category_of(const test_helpers::MockAccount& account,
+	unsigned int feed)
+{
+	return account.categories == 0 ? 0 : feed % account.categories + 1;
+}
+
+std::string category_title(unsigned int category)
+{
+	return "Category " + std::to_string(category);
+}
+
+std::string format_time(std::time_t t, const char* format)
+{
+	struct tm tm {};
+	gmtime_r(&t, &tm);
+	char buffer[64];
+	std::strftime(buffer, sizeof(buffer), format, &tm);
+	return buffer;
+}
+
+/// Articles of \a feed, newest first.
+std::vector<Article> feed_articles(const test_helpers::MockAccount& account,
+	unsigned int feed)
+{
+	std::vector<Article> articles;
+	articles.reserve(account.articles_per_feed);
+	for (unsigned int i = 0; i < account.articles_per_feed; i++) {
+		articles.push_back(Article{feed, i});
+	}
+	return articles;
+}
+
+/// Articles of all feeds, newest first.
+std::vector<Article> all_articles(const test_helpers::MockAccount& account)
+{
+	std::vector<Article> articles;
+	articles.reserve(static_cast<std::size_t>(account.feeds) *
+		account.articles_per_feed);
+	for (unsigned int i = 0; i < account.articles_per_feed; i++) {
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			articles.push_back(Article{feed, i});
+		}
+	}
+	return articles;
+}
+
+/// Parses a 1-based feed ID, or returns false if there's no such feed.
+bool parse_feed_id(const test_helpers::MockAccount& account,
+	const std::string& id,
+	unsigned int& feed)
+{
+	try {
+		const unsigned long value = std::stoul(id);
+		if (value == 0 || value > account.feeds) {
+			return false;
+		}
+		feed = value - 1;
+		return true;
+	} catch (const std::logic_error&) {
+		return false;
+	}
+}
+
+std::string param(const Request& request, const std::string& name,
+	const std::string& fallback = "")
+{
+	const auto found = request.query.find(name);
+	return found == request.query.end() ? fallback : found->second;
+}
+
+std::uint64_t param_as_number(const Request& request, const std::string& name,
+	std::uint64_t fallback)
+{
+	const std::string value = param(request, name);
+	return value.empty() ? fallback : std::stoull(value);
+}
+
+bool starts_with(const std::string& s, const std::string& prefix)
+{
+	return s.compare(0, prefix.length(), prefix) == 0;
+}
+
+Response json_response(const json& body, int status = 200)
+{
+	Response response;
+	response.status = status;
+	response.body = body.dump();
+	return response;
+}
+
+Response text_response(const std::string& body)
+{
+	Response response;
+	response.content_type = "text/plain";
+	response.body = body;
+	return response;
+}
+
+Response not_found()
+{
+	Response response;
+	response.status = 404;
+	response.content_type = "text/plain";
+	response.body = "Not Found";
+	return response;
+}
+
+std::string greader_item_id(const test_helpers::MockAccount& account,
+	const Article& article)
+{
+	char id[64];
+	std::snprintf(id, sizeof(id), "tag:google.com,2005:reader/item/%016" PRIx64,
+		article_id(account, article));
+	return id;
+}
+
+json greader_item(const test_helpers::MockAccount& account,
+	const Article& article)
+{
+	const std::time_t time = published(account, article);
+	json categories = json::array({GREADER_READING_LIST});
+	if (!is_unread(account, article)) {
+		categories.push_back(GREADER_READ);
+	}
+	const unsigned int category = category_of(account, article.feed);
+	if (category != 0) {
+		categories.push_back("user/-/label/" + category_title(category));
+	}
+
+	return json{
+		{"id", greader_item_id(account, article)},
+		{"crawlTimeMsec", std::to_string(time * 1000)},
+		{"timestampUsec", std::to_string(time * 1000000)},
+		{"published", time},
+		{"title", "Article " + std::to_string(article_id(account, article))},
+		{"canonical", json::array({{{"href", article_url(account, article)}}})},
+		{"alternate", json::array({{
+					{"href", article_url(account, article)},
+					{"type", "text/html"},
+				}
+			})
+		},
+		{"categories", categories},
+		{"origin", {
+				{"streamId", "feed/" + std::to_string(article.feed + 1)},
+				{"title", feed_title(article.feed)},
+				{"htmlUrl", feed_url(article.feed)},
+			}
+		},
+		{"summary", {{"content", content(account, article)}}},
+		{"author", "Author " + std::to_string(article.feed + 1)},
+	};
+}
+
+std::string atom_entry(const test_helpers::MockAccount& account,
+	const Article& article)
+{
+	const std::string time = format_time(published(account, article),
+			"%Y-%m-%dT%H:%M:%SZ");
+	std::string entry = "<entry>";
+	entry += "<id>" + greader_item_id(account, article) + "</id>";
+	entry += "<title type=\"html\">Article "
+		+ std::to_string(article_id(account, article)) + "</title>";
+	entry += "<published>" + time + "</published>";
+	entry += "<updated>" + time + "</updated>";
+	entry += "<link rel=\"alternate\" href=\"" + article_url(account, article)
+		+ "\" type=\"text/html\"/>";
+	entry += "<summary type=\"html\">" + content(account, article) + "</summary>";
+	entry += "<author><name>Author " + std::to_string(article.feed + 1)
+		+ "</name></author>";
+	if (!is_unread(account, article)) {
+		entry += "<category term=\"" + GREADER_READ
+			+ "\" scheme=\"http://www.google.com/reader/\" label=\"read\"/>";
+	}
+	entry += "</entry>";
+	return entry;
+}
+
+json ttrss_reply(const json& content, int status = 0)
+{
+	return json{
+		{"seq", 0},
+		{"status", status},
+		{"content", content},
+	};
+}
+
+} // namespace
+
+test_helpers::MockApiServer::MockApiServer(MockBackend backend,
+	const MockAccount& account)
+	: backend(backend)
+	, account(account)
+	, server(std::bind(&MockApiServer::handle, this, std::placeholders::_1))
+{
+}
+
+void test_helpers::MockApiServer::configure(newsboat::ConfigContainer& cfg)
+const
+{
+	const std::string backend_name = name(backend);
+	cfg.set_configvalue("urls-source", backend_name);
+	cfg.set_configvalue(backend_name + "-login", "user");
+	cfg.set_configvalue(backend_name + "-password", "password");
+
+	// Where Newsboat only asks for the latest articles of each feed, have it
+	// ask for all of them.
+	switch (backend) {
+	case MockBackend::FRESHRSS:
+	case MockBackend::INOREADER:
+	case MockBackend::NEWSBLUR:
+	case MockBackend::MINIFLUX:
+	case MockBackend::OLDREADER:
+	case MockBackend::FEEDHQ:
+		cfg.set_configvalue(backend_name + "-min-items",
+			std::to_string(account.articles_per_feed));
+		break;
+	default:
+		break;
+	}
+
+	switch (backend) {
+	case MockBackend::INOREADER:
+	case MockBackend::OLDREADER:
+		// Their server is passed to the constructor.
+		break;
+	case MockBackend::NEWSBLUR:
+		cfg.set_configvalue("newsblur-url", server.get_url());
+		cfg.set_configvalue("cookie-cache", cookie_cache.get_path());
+		break;
+	default:
+		cfg.set_configvalue(backend_name + "-url", server.get_url());
+		break;
+	}
+}
+
+std::unique_ptr<newsboat::RemoteApi> test_helpers::MockApiServer::create_api(
+	newsboat::ConfigContainer& cfg) const
+{
+	switch (backend) {
+	case MockBackend::TTRSS:
+		return std::unique_ptr<newsboat::RemoteApi>(new newsboat::TtRssApi(cfg));
+	case MockBackend::FRESHRSS:
+		return std::unique_ptr<newsboat::RemoteApi>(new newsboat::FreshRssApi(cfg));
+	case MockBackend::INOREADER:
+		return std::unique_ptr<newsboat::RemoteApi>(
+				new newsboat::InoreaderApi(cfg, server.get_url()));
+	case MockBackend::NEWSBLUR:
+		return std::unique_ptr<newsboat::RemoteApi>(new newsboat::NewsBlurApi(cfg));
+	case MockBackend::MINIFLUX:
+		return std::unique_ptr<newsboat::RemoteApi>(new newsboat::MinifluxApi(cfg));
+	case MockBackend::FEEDBIN:
+		return std::unique_ptr<newsboat::RemoteApi>(new newsboat::FeedbinApi(cfg));
+	case MockBackend::OCNEWS:
+		return std::unique_ptr<newsboat::RemoteApi>(new newsboat::OcNewsApi(cfg));
+	case MockBackend::OLDREADER:
+		return std::unique_ptr<newsboat::RemoteApi>(
+				new newsboat::OldReaderApi(cfg, server.get_url()));
+	case MockBackend::FEEDHQ:
+		return std::unique_ptr<newsboat::RemoteApi>(new newsboat::FeedHqApi(cfg));
+	}
+	return nullptr;
+}
+
+std::string test_helpers::MockApiServer::name(MockBackend backend)
+{
+	switch (backend) {
+	case MockBackend::TTRSS:
+		return "ttrss";
+	case MockBackend::FRESHRSS:
+		return "freshrss";
+	case MockBackend::INOREADER:
+		return "inoreader";
+	case MockBackend::NEWSBLUR:
+		return "newsblur";
+	case MockBackend::MINIFLUX:
+		return "miniflux";
+	case MockBackend::FEEDBIN:
+		return "feedbin";
+	case MockBackend::OCNEWS:
+		return "ocnews";
+	case MockBackend::OLDREADER:
+		return "oldreader";
+	case MockBackend::FEEDHQ:
+		return "feedhq";
+	}
+	return "";
+}
+
+std::vector<test_helpers::MockBackend>
+test_helpers::MockApiServer::all_backends()
+{
+	return {
+		MockBackend::TTRSS,
+		MockBackend::FRESHRSS,
+		MockBackend::INOREADER,
+		MockBackend::NEWSBLUR,
+		MockBackend::MINIFLUX,
+		MockBackend::FEEDBIN,
+		MockBackend::OCNEWS,
+		MockBackend::OLDREADER,
+		MockBackend::FEEDHQ,
+	};
+}
+
+void test_helpers::MockApiServer::fail_requests(const std::string& path_prefix)
+{
+	std::lock_guard<std::mutex> guard(failing_mtx);
+	failing_path_prefix = path_prefix;
+}
+
+Response test_helpers::MockApiServer::handle(const Request& request) const
+{
+	{
+		std::lock_guard<std::mutex> guard(failing_mtx);
+		if (!failing_path_prefix.empty()
+			&& starts_with(request.path, failing_path_prefix)) {
+			return json_response({{"error", "mock failure"}}, 500);
+		}
+	}
+
+	switch (backend) {
+	case MockBackend::TTRSS:
+		return handle_ttrss(request);
+	case MockBackend::FRESHRSS:
+	case MockBackend::INOREADER:
+	case MockBackend::OLDREADER:
+	case MockBackend::FEEDHQ:
+		return handle_greader(request);
+	case MockBackend::NEWSBLUR:
+		return handle_newsblur(request);
+	case MockBackend::MINIFLUX:
+		return handle_miniflux(request);
+	case MockBackend::FEEDBIN:
+		return handle_feedbin(request);
+	case MockBackend::OCNEWS:
+		return handle_ocnews(request);
+	}
+	return not_found();
+}
+
+Response test_helpers::MockApiServer::handle_ttrss(const Request& request)
+const
+{
+	if (request.path != "/api/") {
+		return not_found();
+	}
+
+	// Newsboat passes all arguments as strings.
+	const json args = json::parse(request.body);
+	const auto arg = [&](const std::string& key) -> std::string {
+		return args.contains(key) ? args[key].get<std::string>() : "";
+	};
+	const std::string op = arg("op");
+
+	if (op == "login") {
+		return json_response(ttrss_reply({
+			{"session_id", "mock-session"},
+			{"api_level", 15},
+		}));
+	} else if (op == "getApiLevel") {
+		return json_response(ttrss_reply({{"level", 15}}));
+	} else if (op == "getCategories") {
+		json categories = json::array();
+		for (unsigned int c = 1; c <= account.categories; c++) {
+			categories.push_back({
+				{"id", std::to_string(c)},
+				{"title", category_title(c)},
+				{"order_id", c},
+			});
+		}
+		return json_response(ttrss_reply(categories));
+	} else if (op == "getFeeds") {
+		const int cat_id = std::stoi(arg("cat_id"));
+		json feeds = json::array();
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			const unsigned int category = category_of(account, feed);
+			if (cat_id >= 0 && static_cast<unsigned int>(cat_id) != category) {
+				continue;
+			}
+			feeds.push_back({
+				{"id", feed + 1},
+				{"title", feed_title(feed)},
+				{"feed_url", feed_url(feed)},
+				{"cat_id", category},
+				{"has_icon", false},
+			});
+		}
+		return json_response(ttrss_reply(feeds));
+	} else if (op == "getHeadlines") {
+		unsigned int feed;
+		if (!parse_feed_id(account, arg("feed_id"), feed)) {
+			return json_response(ttrss_reply(json::array()));
+		}
+		// Like the real thing, return 60 articles unless asked for more,
+		// and never more than 200.
+		const std::string limit_arg = arg("limit");
+		const std::size_t limit = std::min<std::size_t>(200,
+				limit_arg.empty() ? 60 : std::stoul(limit_arg));
+		const std::string skip_arg = arg("skip");
+		const std::size_t skip = skip_arg.empty() ? 0 : std::stoul(skip_arg);
+		const std::string since_id_arg = arg("since_id");
+		const std::uint64_t since_id = since_id_arg.empty()
+			? 0 : std::stoull(since_id_arg);
+		const bool unread_only = arg("view_mode") == "unread";
+
+		std::vector<Article> articles = feed_articles(account, feed);
+		articles.erase(std::remove_if(articles.begin(), articles.end(),
+		[&](const Article& article) {
+			return article_id(account, article) <= since_id
+				|| (unread_only && !is_unread(account, article));
+		}), articles.end());
+
+		json headlines = json::array();
+		for (std::size_t i = skip; i < articles.size() && headlines.size() < limit;
+			i++) {
+			const Article& article = articles[i];
+			headlines.push_back({
+				{"id", article_id(account, article)},
+				{"unread", is_unread(account, article)},
+				{"marked", false},
+				{"published", false},
+				{"updated", published(account, article)},
+				{"title", "Article " + std::to_string(article_id(account, article))},
+				{"link", article_url(account, article)},
+				{"feed_id", std::to_string(feed + 1)},
+				{"author", "Author " + std::to_string(feed + 1)},
+				{"content", content(account, article)},
+				{"attachments", json::array()},
+			});
+		}
+		return json_response(ttrss_reply(headlines));
+	} else if (op == "updateArticle") {
+		return json_response(ttrss_reply({{"status", "OK"}, {"updated", 1}}));
+	} else if (op == "catchupFeed") {
+		return json_response(ttrss_reply({{"status", "OK"}}));
+	}
+	return json_response(ttrss_reply({{"error", "UNKNOWN_METHOD"}}, 1));
+}
+
+Response test_helpers::MockApiServer::handle_greader(const Request& request)
+const
+{
+	const std::string api = "/reader/api/0/";
+	const std::string stream_contents = api + "stream/contents/";
+	const std::string atom = "/reader/atom/";
+
+	if (request.path == "/accounts/ClientLogin") {
+		return text_response("SID=mock\nLSID=mock\nAuth=mock-auth\n");
+	} else if (request.path == api + "token") {
+		return text_response("mock-token");
+	} else if (request.path == api + "edit-tag"
+		|| request.path == api + "mark-all-as-read") {
+		return text_response("OK");
+	} else if (request.path == api + "subscription/list") {
+		// The list only depends on these numbers, so they make a good ETag.
+		const std::string etag = "\"" + std::to_string(account.feeds) + "-"
+			+ std::to_string(account.categories) + "\"";
+		const auto if_none_match = request.headers.find("if-none-match");
+		if (if_none_match != request.headers.cend()
+			&& if_none_match->second == etag) {
+			Response response;
+			response.status = 304;
+			response.headers["ETag"] = etag;
+			return response;
+		}
+
+		json subscriptions = json::array();
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			json categories = json::array();
+			const unsigned int category = category_of(account, feed);
+			if (category != 0) {
+				categories.push_back({
+					{"id", "user/-/label/" + category_title(category)},
+					{"label", category_title(category)},
+				});
+			}
+			subscriptions.push_back({
+				{"id", "feed/" + std::to_string(feed + 1)},
+				{"title", feed_title(feed)},
+				{"categories", categories},
+				{"url", feed_url(feed)},
+				{"htmlUrl", feed_url(feed)},
+				{"iconUrl", ""},
+			});
+		}
+		Response response = json_response({{"subscriptions", subscriptions}});
+		response.headers["ETag"] = etag;
+		return response;
+	}
+
+	// Both kinds of stream list the newest articles first, unless asked for
+	// the oldest ones (`r=o`), and skip those older than `ot`.
+	const auto select_articles = [&](const std::string& stream,
+	std::vector<Article>& articles) {
+		unsigned int feed;
+		if (stream == GREADER_READING_LIST) {
+			articles = all_articles(account);
+		} else if (starts_with(stream, "feed/")
+			&& parse_feed_id(account, stream.substr(5), feed)) {
+			articles = feed_articles(account, feed);
+		} else {
+			return false;
+		}
+
+		const std::string oldest = param(request, "ot");
+		if (!oldest.empty()) {
+			const std::time_t ot = std::stoll(oldest);
+			articles.erase(std::remove_if(articles.begin(), articles.end(),
+			[&](const Article& article) {
+				return published(account, article) <= ot;
+			}), articles.end());
+		}
+		if (param(request, "r") == "o") {
+			std::reverse(articles.begin(), articles.end());
+		}
+		return true;
+	};
+
+	std::vector<Article> articles;
+	if (backend == MockBackend::FRESHRSS
+		&& starts_with(request.path, stream_contents)) {
+		if (!select_articles(request.path.substr(stream_contents.length()),
+				articles)) {
+			return not_found();
+		}
+		const std::size_t count = param_as_number(request, "n", 20);
+		const std::size_t offset = param_as_number(request, "c", 0);
+
+		json items = json::array();
+		for (std::size_t i = offset; i < articles.size() && i < offset + count; i++) {
+			items.push_back(greader_item(account, articles[i]));
+		}
+		json reply = {
+			{"id", request.path.substr(stream_contents.length())},
+			{"updated", account.newest_article},
+			{"items", items},
+		};
+		if (offset + count < articles.size()) {
+			reply["continuation"] = std::to_string(offset + count);
+		}
+		return json_response(reply);
+	} else if ((backend == MockBackend::FRESHRSS
+			|| backend == MockBackend::INOREADER)
+		&& request.path == api + "stream/items/ids") {
+		if (!select_articles(param(request, "s"), articles)) {
+			return not_found();
+		}
+		const bool unread_only = param(request, "xt") == GREADER_READ;
+		const std::size_t count = param_as_number(request, "n", 20);
+
+		json refs = json::array();
+		for (const auto& article : articles) {
+			if (refs.size() >= count) {
+				break;
+			}
+			if (unread_only && !is_unread(account, article)) {
+				continue;
+			}
+			refs.push_back({{"id", std::to_string(article_id(account, article))}});
+		}
+		return json_response({{"itemRefs", refs}});
+	} else if (backend != MockBackend::FRESHRSS
+		&& starts_with(request.path, atom)) {
+		if (!select_articles(request.path.substr(atom.length()), articles)) {
+			return not_found();
+		}
+		const std::size_t count = param_as_number(request, "n", 20);
+		const std::string stream = request.path.substr(atom.length());
+
+		Response response;
+		response.content_type = "application/atom+xml";
+		response.body = "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+			"<feed xmlns=\"http://www.w3.org/2005/Atom\""
+			" xmlns:gr=\"http://www.google.com/schemas/reader/atom/\">";
+		response.body += "<id>tag:google.com,2005:reader/" + stream + "</id>";
+		response.body += "<title>" + stream + "</title>";
+		response.body += "<updated>"
+			+ format_time(account.newest_article, "%Y-%m-%dT%H:%M:%SZ")
+			+ "</updated>";
+		for (std::size_t i = 0; i < articles.size() && i < count; i++) {
+			response.body += atom_entry(account, articles[i]);
+		}
+		response.body += "</feed>";
+		return response;
+	}
+	return not_found();
+}
+
+Response test_helpers::MockApiServer::handle_newsblur(const Request& request)
+const
+{
+	// NewsBlur always returns six stories per page.
+	const std::size_t page_size = 6;
+	const std::string feed_prefix = "/reader/feed/";
+
+	if (request.path == "/api/login") {
+		return json_response({
+			{"authenticated", true},
+			{"code", 1},
+			{"result", "ok"},
+		});
+	} else if (request.path == "/reader/feeds/") {
+		json feeds = json::object();
+		json folders = json::array();
+		std::vector<json> folder_feeds(account.categories + 1, json::array());
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			feeds[std::to_string(feed + 1)] = {
+				{"id", feed + 1},
+				{"feed_title", feed_title(feed)},
+				{"feed_address", feed_url(feed)},
+				{"feed_link", feed_url(feed)},
+			};
+			folder_feeds[category_of(account, feed)].push_back(feed + 1);
+		}
+		// Feeds that aren't in a folder are listed by their bare IDs.
+		for (const auto& id : folder_feeds[0]) {
+			folders.push_back(id);
+		}
+		for (unsigned int c = 1; c <= account.categories; c++) {
+			folders.push_back({{category_title(c), folder_feeds[c]}});
+		}
+		return json_response({
+			{"feeds", feeds},
+			{"folders", folders},
+			{"result", "ok"},
+		});
+	} else if (starts_with(request.path, feed_prefix)) {
+		unsigned int feed;
+		if (!parse_feed_id(account, request.path.substr(feed_prefix.length()),
+				feed)) {
+			return not_found();
+		}
+		const std::size_t page = std::max<std::uint64_t>(1,
+				param_as_number(request, "page", 1));
+
+		json stories = json::array();
+		for (const auto& article : feed_articles(account, feed)) {
+			if (article.index < (page - 1) * page_size) {
+				continue;
+			}
+			if (stories.size() >= page_size) {
+				break;
+			}
+			stories.push_back({
+				{"id", std::to_string(article_id(account, article))},
+				{"story_feed_id", feed + 1},
+				{"story_title", "Article " + std::to_string(article_id(account, article))},
+				{"story_authors", "Author " + std::to_string(feed + 1)},
+				{"story_permalink", article_url(account, article)},
+				{"story_content", content(account, article)},
+				{"story_date", format_time(published(account, article), "%Y-%m-%d %H:%M:%S")},
+				{"read_status", is_unread(account, article) ? 0 : 1},
+			});
+		}
+		return json_response({{"stories", stories}, {"result", "ok"}});
+	} else if (starts_with(request.path, "/reader/mark_")) {
+		return json_response({{"result", "ok"}});
+	}
+	return not_found();
+}
+
+Response test_helpers::MockApiServer::handle_miniflux(const Request& request)
+const
+{
+	const std::string feed_prefix = "/v1/feeds/";
+	const std::string entries_suffix = "/entries";
+
+	if (request.path == "/v1/me") {
+		return json_response({{"id", 1}, {"username", "user"}});
+	} else if (request.path == "/v1/categories") {
+		json categories = json::array();
+		for (unsigned int c = 1; c <= account.categories; c++) {
+			categories.push_back({{"id", c}, {"title", category_title(c)}});
+		}
+		return json_response(categories);
+	} else if (request.path == "/v1/feeds") {
+		json feeds = json::array();
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			const unsigned int category = category_of(account, feed);
+			feeds.push_back({
+				{"id", feed + 1},
+				{"title", feed_title(feed)},
+				{"feed_url", feed_url(feed)},
+				{"site_url", feed_url(feed)},
+				{"category", {
+						{"id", category},
+						{"title", category == 0 ? "All" : category_title(category)},
+					}
+				},
+			});
+		}
+		return json_response(feeds);
+	} else if (request.path == "/v1/entries" && request.method == "PUT") {
+		Response response;
+		response.status = 204;
+		return response;
+	} else if (starts_with(request.path, feed_prefix)
+		&& request.path.length() > feed_prefix.length() + entries_suffix.length()
+		&& request.path.compare(request.path.length() - entries_suffix.length(),
+			entries_suffix.length(), entries_suffix) == 0) {
+		unsigned int feed;
+		if (!parse_feed_id(account, request.path.substr(feed_prefix.length(),
+					request.path.length() - feed_prefix.length()
+					- entries_suffix.length()), feed)) {
+			return not_found();
+		}
+
+		std::vector<Article> articles = feed_articles(account, feed);
+		const std::string changed_after = param(request, "changed_after");
+		if (!changed_after.empty()) {
+			const std::time_t after = std::stoll(changed_after);
+			articles.erase(std::remove_if(articles.begin(), articles.end(),
+			[&](const Article& article) {
+				return published(account, article) <= after;
+			}), articles.end());
+		}
+		if (param(request, "direction") == "asc") {
+			std::reverse(articles.begin(), articles.end());
+		}
+		const std::size_t limit = param_as_number(request, "limit", 100);
+		const std::size_t offset = param_as_number(request, "offset", 0);
+
+		json entries = json::array();
+		for (std::size_t i = offset; i < articles.size() && i < offset + limit; i++) {
+			const Article& article = articles[i];
+			const std::string time = format_time(published(account, article),
+					"%Y-%m-%dT%H:%M:%SZ");
+			entries.push_back({
+				{"id", article_id(account, article)},
+				{"feed_id", feed + 1},
+				{"status", is_unread(account, article) ? "unread" : "read"},
+				{"title", "Article " + std::to_string(article_id(account, article))},
+				{"url", article_url(account, article)},
+				{"author", "Author " + std::to_string(feed + 1)},
+				{"content", content(account, article)},
+				{"published_at", time},
+				{"created_at", time},
+				{"changed_at", time},
+				{"starred", false},
+			});
+		}
+		return json_response({{"total", articles.size()}, {"entries", entries}});
+	}
+	return not_found();
+}
+
+Response test_helpers::MockApiServer::handle_feedbin(const Request& request)
+const
+{
+	const std::string feed_prefix = "/v2/feeds/";
+	const std::string entries_suffix = "/entries.json";
+	const auto feedbin_time = [&](const Article& article) {
+		return format_time(published(account, article), "%Y-%m-%dT%H:%M:%S.000000Z");
+	};
+
+	if (request.path == "/v2/authentication.json") {
+		return text_response("");
+	} else if (request.path == "/v2/taggings.json") {
+		json taggings = json::array();
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			const unsigned int category = category_of(account, feed);
+			if (category != 0) {
+				taggings.push_back({
+					{"id", feed + 1},
+					{"feed_id", feed + 1},
+					{"name", category_title(category)},
+				});
+			}
+		}
+		return json_response(taggings);
+	} else if (request.path == "/v2/subscriptions.json") {
+		json subscriptions = json::array();
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			subscriptions.push_back({
+				{"id", feed + 1},
+				{"feed_id", feed + 1},
+				{"title", feed_title(feed)},
+				{"feed_url", feed_url(feed)},
+				{"site_url", feed_url(feed)},
+			});
+		}
+		return json_response(subscriptions);
+	} else if (request.path == "/v2/unread_entries.json"
+		|| request.path == "/v2/starred_entries.json") {
+		if (request.method != "GET") {
+			return json_response(json::array());
+		}
+		json ids = json::array();
+		if (request.path == "/v2/unread_entries.json") {
+			for (const auto& article : all_articles(account)) {
+				if (is_unread(account, article)) {
+					ids.push_back(article_id(account, article));
+				}
+			}
+		}
+		return json_response(ids);
+	} else if (starts_with(request.path, feed_prefix)
+		&& request.path.length() > feed_prefix.length() + entries_suffix.length()
+		&& request.path.compare(request.path.length() - entries_suffix.length(),
+			entries_suffix.length(), entries_suffix) == 0) {
+		unsigned int feed;
+		if (!parse_feed_id(account, request.path.substr(feed_prefix.length(),
+					request.path.length() - feed_prefix.length()
+					- entries_suffix.length()), feed)) {
+			return not_found();
+		}
+
+		std::vector<Article> articles = feed_articles(account, feed);
+		const std::string since = param(request, "since");
+		if (!since.empty()) {
+			articles.erase(std::remove_if(articles.begin(), articles.end(),
+			[&](const Article& article) {
+				return feedbin_time(article) <= since;
+			}), articles.end());
+		}
+		const std::size_t per_page = param_as_number(request, "per_page", 100);
+		const std::size_t page = std::max<std::uint64_t>(1,
+				param_as_number(request, "page", 1));
+
+		json entries = json::array();
+		for (std::size_t i = (page - 1) * per_page;
+			i < articles.size() && i < page * per_page;
+			i++) {
+			const Article& article = articles[i];
+			entries.push_back({
+				{"id", article_id(account, article)},
+				{"feed_id", feed + 1},
+				{"title", "Article " + std::to_string(article_id(account, article))},
+				{"url", article_url(account, article)},
+				{"author", "Author " + std::to_string(feed + 1)},
+				{"content", content(account, article)},
+				{"published", feedbin_time(article)},
+				{"created_at", feedbin_time(article)},
+			});
+		}
+		return json_response(entries);
+	}
+	return not_found();
+}
+
+Response test_helpers::MockApiServer::handle_ocnews(const Request& request)
+const
+{
+	if (!starts_with(request.path, OCNEWS_PREFIX)) {
+		return not_found();
+	}
+	const std::string path = request.path.substr(OCNEWS_PREFIX.length());
+
+	if (request.method == "PUT") {
+		return text_response("");
+	} else if (path == "status") {
+		return json_response({{"version", "25.0.0"}});
+	} else if (path == "folders") {
+		json folders = json::array();
+		for (unsigned int c = 1; c <= account.categories; c++) {
+			folders.push_back({{"id", c}, {"name", category_title(c)}});
+		}
+		return json_response({{"folders", folders}});
+	} else if (path == "feeds") {
+		json feeds = json::array();
+		for (unsigned int feed = 0; feed < account.feeds; feed++) {
+			feeds.push_back({
+				{"id", feed + 1},
+				{"url", feed_url(feed)},
+				{"title", feed_title(feed)},
+				{"folderId", category_of(account, feed)},
+				{"link", feed_url(feed)},
+			});
+		}
+		return json_response({{"feeds", feeds}, {"starredCount", 0}});
+	} else if (path == "items" || path == "items/updated") {
+		// Type 0 is a feed, 1 a folder, 2 the starred items and 3 all of
+		// them. Nothing is starred.
+		const std::uint64_t type = param_as_number(request, "type", 3);
+		const std::string id = param(request, "id", "0");
+		std::vector<Article> articles;
+		unsigned int feed;
+		if (type == 3) {
+			articles = all_articles(account);
+		} else if (type == 0 && parse_feed_id(account, id, feed)) {
+			articles = feed_articles(account, feed);
+		} else if (type == 1) {
+			for (const auto& article : all_articles(account)) {
+				if (std::to_string(category_of(account, article.feed)) == id) {
+					articles.push_back(article);
+				}
+			}
+		}
+
+		const std::string last_modified = param(request, "lastModified");
+		if (path == "items/updated" && !last_modified.empty()) {
+			const std::time_t since = std::stoll(last_modified);
+			articles.erase(std::remove_if(articles.begin(), articles.end(),
+			[&](const Article& article) {
+				return published(account, article) <= since;
+			}), articles.end());
+		}
+
+		json items = json::array();
+		for (const auto& article : articles) {
+			const std::string guid = article_url(account, article);
+			items.push_back({
+				{"id", article_id(account, article)},
+				{"guid", guid},
+				{"url", guid},
+				{"title", "Article " + std::to_string(article_id(account, article))},
+				{"author", "Author " + std::to_string(article.feed + 1)},
+				{"pubDate", published(account, article)},
+				{"body", content(account, article)},
+				{"enclosureMime", nullptr},
+				{"enclosureLink", nullptr},
+				{"feedId", article.feed + 1},
+				{"unread", is_unread(account, article)},
+				{"starred", false},
+				{"lastModified", published(account, article)},
+			});
+		}
+		return json_response({{"items", items}});
+	}
+	return not_found();
+}
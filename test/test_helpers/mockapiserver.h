@@ -0,0 +1,115 @@
+#ifndef NEWSBOAT_TEST_HELPERS_MOCKAPISERVER_H_
+#define NEWSBOAT_TEST_HELPERS_MOCKAPISERVER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "httpserver.h"
+#include "tempfile.h"
+
+namespace newsboat {
+class ConfigContainer;
+class RemoteApi;
+}
+
+namespace test_helpers {
+
+/// Services whose API MockApiServer can speak.
+enum class MockBackend {
+	TTRSS,
+	FRESHRSS,
+	INOREADER,
+	NEWSBLUR,
+	MINIFLUX,
+	FEEDBIN,
+	OCNEWS,
+	OLDREADER,
+	FEEDHQ,
+};
+
+/// The synthetic account that MockApiServer serves. Feeds and articles are
+/// generated on the fly from these numbers, so accounts of any size take
+/// no memory.
+struct MockAccount {
+	unsigned int feeds = 5;
+	/// Feeds are spread evenly over these; 0 leaves them uncategorized.
+	unsigned int categories = 2;
+	unsigned int articles_per_feed = 10;
+	/// Every n-th article of a feed, starting with the newest, is unread;
+	/// 0 means all are read.
+	unsigned int unread_every = 3;
+	/// Length of each article's content, in bytes.
+	std::size_t content_size = 500;
+	/// Publication time of the newest article of each feed. The others are
+	/// an hour apart.
+	std::time_t newest_article = 1700000000;
+};
+
+/* \brief Stands in for the server of a remote API backend, so that syncs can
+ * be tested and benchmarked without a real account.
+ *
+ * The server answers the requests that Newsboat makes with the data of a
+ * synthetic account, following each service's API closely enough for all
+ * articles to be fetched (e.g. it pages through articles and honours sync
+ * cursors where the real service does). Authentication always succeeds,
+ * and changes to read state and flags are accepted but not applied.
+ */
+class MockApiServer {
+public:
+	MockApiServer(MockBackend backend, const MockAccount& account);
+
+	/// Points \a cfg at this server: sets `urls-source`, the server URL and
+	/// credentials.
+	void configure(newsboat::ConfigContainer& cfg) const;
+
+	/// Creates the RemoteApi for this backend, talking to this server.
+	std::unique_ptr<newsboat::RemoteApi> create_api(
+		newsboat::ConfigContainer& cfg) const;
+
+	HttpServer& http()
+	{
+		return server;
+	}
+
+	/// Answers requests whose (decoded) path starts with \a path_prefix with
+	/// an internal server error from now on. An empty prefix lets all
+	/// requests through again.
+	void fail_requests(const std::string& path_prefix);
+
+	/// Name of the backend, as used by `urls-source`.
+	static std::string name(MockBackend backend);
+
+	/// All backends, in the order they're listed above.
+	static std::vector<MockBackend> all_backends();
+
+private:
+	HttpServer::Response handle(const HttpServer::Request& request) const;
+
+	HttpServer::Response handle_ttrss(const HttpServer::Request& request) const;
+	HttpServer::Response handle_greader(const HttpServer::Request& request)
+	const;
+	HttpServer::Response handle_newsblur(const HttpServer::Request& request)
+	const;
+	HttpServer::Response handle_miniflux(const HttpServer::Request& request)
+	const;
+	HttpServer::Response handle_feedbin(const HttpServer::Request& request)
+	const;
+	HttpServer::Response handle_ocnews(const HttpServer::Request& request) const;
+
+	const MockBackend backend;
+	const MockAccount account;
+	mutable std::mutex failing_mtx;
+	std::string failing_path_prefix;
+	/// NewsBlur keeps its session in a cookie jar.
+	TempFile cookie_cache;
+	HttpServer server;
+};
+
+} // namespace test_helpers
+
+#endif /* NEWSBOAT_TEST_HELPERS_MOCKAPISERVER_H_ */